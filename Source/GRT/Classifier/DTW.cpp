@@ -1,7 +1,89 @@
 ﻿#include "../GRT.h"
 #include "DTW.h"
+#include "../Utility/ThreadPool.h"
+#include <algorithm>
+#include <cstring>
+#include <numeric>
+#include <random>
+#include <unordered_map>
 
 namespace GRT {
+// The binary model format (see DTW::saveBinary).  All sections start on a
+// DTW_BINARY_ALIGNMENT byte boundary so the template data can be used in place
+// once the file is mapped into memory
+#define DTW_BINARY_MAGIC "GRTDTWB"
+#define DTW_BINARY_VERSION 1
+#define DTW_BINARY_BYTE_ORDER 0x01020304
+#define DTW_BINARY_ALIGNMENT 64
+
+struct DTWBinaryHeader {
+  char   magic[8];            // DTW_BINARY_MAGIC
+  uint32 version;             // DTW_BINARY_VERSION
+  uint32 byteOrder;           // DTW_BINARY_BYTE_ORDER as written by the saver
+  uint32 numTemplates;
+  uint32 numClasses;
+  uint32 numInputDimensions;
+  uint32 numRanges;
+  uint64 settingsOffset;      // Offset of the DTWBinarySettings
+  uint64 classTableOffset;    // Offset of the class labels and the ranges
+  uint64 templateTableOffset; // Offset of the DTWBinaryTemplate table
+  uint64 fileSize;
+};
+
+// The same settings as the V2.0 text format
+struct DTWBinarySettings {
+  uint32 trained;
+  uint32 useScaling;
+  uint32 numOutputDimensions;
+  uint32 numTrainingIterationsToConverge;
+  uint32 minNumEpochs;
+  uint32 maxNumEpochs;
+  uint32 validationSetSize;
+  float  learningRate;
+  float  minChange;
+  uint32 useValidationSet;
+  uint32 randomiseTrainingOrder;
+  uint32 useNullRejection;
+  uint32 classifierMode;
+  float  nullRejectionCoeff;
+  uint32 distanceMethod;
+  uint32 useSmoothing;
+  uint32 smoothingFactor;
+  uint32 useZNormalisation;
+  uint32 offsetUsingFirstSample;
+  uint32 constrainWarpingPath;
+  float  radius;
+  uint32 rejectionMode;
+  uint32 averageTemplateLength;
+  uint32 reserved;
+};
+
+struct DTWBinaryTemplate {
+  uint32 classLabel;
+  uint32 timeSeriesLength;
+  float  threshold;
+  float  trainingMu;
+  float  trainingSigma;
+  uint32 averageTemplateLength;
+  uint64 dataOffset; // Offset of the [timeSeriesLength numInputDimensions] data
+};
+
+static_assert(sizeof(DTWBinaryHeader) == 64, "Unexpected DTWBinaryHeader size");
+static_assert(sizeof(DTWBinarySettings) == 96, "Unexpected DTWBinarySettings size");
+static_assert(sizeof(DTWBinaryTemplate) == 32, "Unexpected DTWBinaryTemplate size");
+
+static uint64 alignBinaryOffset(const uint64 offset) {
+  return (offset + DTW_BINARY_ALIGNMENT - 1) / DTW_BINARY_ALIGNMENT *
+         DTW_BINARY_ALIGNMENT;
+}
+
+static void writeBinaryPadding(std::fstream& file, const uint64 offset) {
+  const char zeros[DTW_BINARY_ALIGNMENT] = { 0 };
+  const uint64 position = (uint64)file.tellp();
+
+  if (offset > position) file.write(zeros, (std::streamsize)(offset - position));
+}
+
 // Define the string that will be used to identify the object
 const FString DTW::id = "DTW";
 FString DTW::getId() {
@@ -39,14 +121,47 @@ DTW::DTW(bool   useScaling,
   constrainZNorm        = false;
   trimTrainingData      = false;
 
-  zNormConstrainThreshold = 0.2;
+  useDistanceCache         = false;
+  cacheInterClassDistances = false;
+  useIncrementalTraining   = false;
+
+  zNormConstrainThreshold = 0.01;
   trimThreshold           = 0.1;
   maximumTrimPercentage   = 90;
 
   numTemplates   = 0;
   distanceMethod = EUCLIDEAN_DIST;
 
-  averageTemplateLength = 0;
+  templateSelectionMethod = EXACT_TEMPLATE_SELECTION;
+  numReferenceSamples     = 64;
+  maxNumCandidates        = 32;
+  templateSelectionSeed   = 0;
+
+  predictionSchedulingMode = FULL_PREDICTION;
+  predictionBudget         = 500;
+  scheduledSecondsPerCell  = 0;
+  resetPredictionSchedule();
+
+  averageTemplateLength        = 0;
+  numSamplesInSmoothingBlock   = 0;
+  numStreamSamples             = 0;
+  samplesSinceStreamPrediction = 0;
+  streamWindowChanged          = false;
+
+  useEarlyClassification   = false;
+  earlyMargin              = 0.25;
+  earlyMinTemplateProgress = 0.3;
+  earlyMaxMatchCost        = 0;
+  lastEarlyDecisionSample  = 0;
+  earlyClassLabel          = 0;
+  earlyTemplateProgress    = 0;
+  earlyMatchCost           = 0;
+  earlyMatchMargin         = 0;
+
+  useMotionGating         = false;
+  motionGateEvent         = MotionEnergyGate::NO_EVENT;
+  numEvaluatedPredictions = 0;
+  numSkippedPredictions   = 0;
 
   classifierMode = TIMESERIES_CLASSIFIER_MODE;
 }
@@ -61,15 +176,49 @@ DTW::~DTW(void) {}
 DTW& DTW::operator=(const DTW& rhs) {
   if (this != &rhs) {
     this->templatesBuffer                  = rhs.templatesBuffer;
+    copyTemplateData(rhs);
     this->distanceMatrices                 = rhs.distanceMatrices;
     this->warpPaths                        = rhs.warpPaths;
     this->continuousInputDataBuffer        = rhs.continuousInputDataBuffer;
+    this->continuousInputStats             = rhs.continuousInputStats;
+    this->smoothedInputDataBuffer          = rhs.smoothedInputDataBuffer;
+    this->smoothingAccumulator             = rhs.smoothingAccumulator;
+    this->numSamplesInSmoothingBlock       = rhs.numSamplesInSmoothingBlock;
+    this->numStreamSamples                 = rhs.numStreamSamples;
+    this->samplesSinceStreamPrediction     = rhs.samplesSinceStreamPrediction;
+    this->streamWindowChanged              = rhs.streamWindowChanged;
+    this->openEndMatches                   = rhs.openEndMatches;
+    this->earlySample                      = rhs.earlySample;
+    this->lastEarlyDecisionSample          = rhs.lastEarlyDecisionSample;
+    this->earlyClassLabel                  = rhs.earlyClassLabel;
+    this->earlyTemplateProgress            = rhs.earlyTemplateProgress;
+    this->earlyMatchCost                   = rhs.earlyMatchCost;
+    this->earlyMatchMargin                 = rhs.earlyMatchMargin;
+    this->earlyMargin                      = rhs.earlyMargin;
+    this->earlyMinTemplateProgress         = rhs.earlyMinTemplateProgress;
+    this->earlyMaxMatchCost                = rhs.earlyMaxMatchCost;
+    this->useEarlyClassification           = rhs.useEarlyClassification;
+    this->motionGate                       = rhs.motionGate;
+    this->motionGateEvent                  = rhs.motionGateEvent;
+    this->motionSegment                    = rhs.motionSegment;
+    this->lastMotionSegment                = rhs.lastMotionSegment;
+    this->numEvaluatedPredictions          = rhs.numEvaluatedPredictions;
+    this->numSkippedPredictions            = rhs.numSkippedPredictions;
+    this->useMotionGating                  = rhs.useMotionGating;
     this->numTemplates                     = rhs.numTemplates;
     this->useSmoothing                     = rhs.useSmoothing;
     this->useZNormalisation                = rhs.useZNormalisation;
     this->constrainZNorm                   = rhs.constrainZNorm;
     this->constrainWarpingPath             = rhs.constrainWarpingPath;
     this->trimTrainingData                 = rhs.trimTrainingData;
+    this->useDistanceCache                 = rhs.useDistanceCache;
+    this->cacheInterClassDistances         = rhs.cacheInterClassDistances;
+
+    // The training caches are shared until either model changes them, so
+    // copies made for prediction or evaluation do not copy them
+    this->distanceCache                    = rhs.distanceCache;
+    this->useIncrementalTraining           = rhs.useIncrementalTraining;
+    this->trainingClasses                  = rhs.trainingClasses;
     this->zNormConstrainThreshold          = rhs.zNormConstrainThreshold;
     this->radius                           = rhs.radius;
     this->offsetUsingFirstSample           = rhs.offsetUsingFirstSample;
@@ -77,9 +226,17 @@ DTW& DTW::operator=(const DTW& rhs) {
     this->maximumTrimPercentage            = rhs.maximumTrimPercentage;
     this->smoothingFactor                  = rhs.smoothingFactor;
     this->distanceMethod                   = rhs.distanceMethod;
+    this->templateSelectionMethod          = rhs.templateSelectionMethod;
+    this->numReferenceSamples              = rhs.numReferenceSamples;
+    this->maxNumCandidates                 = rhs.maxNumCandidates;
+    this->templateSelectionSeed            = rhs.templateSelectionSeed;
+    this->predictionSchedulingMode         = rhs.predictionSchedulingMode;
+    this->predictionBudget                 = rhs.predictionBudget;
+    this->scheduledSecondsPerCell          = rhs.scheduledSecondsPerCell;
     this->rejectionMode                    = rhs.rejectionMode;
     this->nullRejectionLikelihoodThreshold = rhs.nullRejectionLikelihoodThreshold;
     this->averageTemplateLength            = rhs.averageTemplateLength;
+    resetPredictionSchedule();
 
     // Copy the classifier variables
     copyBaseVariables((Classifier *)&rhs);
@@ -94,15 +251,48 @@ bool DTW::deepCopyFrom(const Classifier *classifier) {
   if (this->getClassifierType() == classifier->getClassifierType()) {
     DTW *ptr = (DTW *)classifier;
     this->templatesBuffer                  = ptr->templatesBuffer;
+    copyTemplateData(*ptr);
     this->distanceMatrices                 = ptr->distanceMatrices;
     this->warpPaths                        = ptr->warpPaths;
     this->continuousInputDataBuffer        = ptr->continuousInputDataBuffer;
+    this->continuousInputStats             = ptr->continuousInputStats;
+    this->smoothedInputDataBuffer          = ptr->smoothedInputDataBuffer;
+    this->smoothingAccumulator             = ptr->smoothingAccumulator;
+    this->numSamplesInSmoothingBlock       = ptr->numSamplesInSmoothingBlock;
+    this->numStreamSamples                 = ptr->numStreamSamples;
+    this->samplesSinceStreamPrediction     = ptr->samplesSinceStreamPrediction;
+    this->streamWindowChanged              = ptr->streamWindowChanged;
+    this->openEndMatches                   = ptr->openEndMatches;
+    this->earlySample                      = ptr->earlySample;
+    this->lastEarlyDecisionSample          = ptr->lastEarlyDecisionSample;
+    this->earlyClassLabel                  = ptr->earlyClassLabel;
+    this->earlyTemplateProgress            = ptr->earlyTemplateProgress;
+    this->earlyMatchCost                   = ptr->earlyMatchCost;
+    this->earlyMatchMargin                 = ptr->earlyMatchMargin;
+    this->earlyMargin                      = ptr->earlyMargin;
+    this->earlyMinTemplateProgress         = ptr->earlyMinTemplateProgress;
+    this->earlyMaxMatchCost                = ptr->earlyMaxMatchCost;
+    this->useEarlyClassification           = ptr->useEarlyClassification;
+    this->motionGate                       = ptr->motionGate;
+    this->motionGateEvent                  = ptr->motionGateEvent;
+    this->motionSegment                    = ptr->motionSegment;
+    this->lastMotionSegment                = ptr->lastMotionSegment;
+    this->numEvaluatedPredictions          = ptr->numEvaluatedPredictions;
+    this->numSkippedPredictions            = ptr->numSkippedPredictions;
+    this->useMotionGating                  = ptr->useMotionGating;
     this->numTemplates                     = ptr->numTemplates;
     this->useSmoothing                     = ptr->useSmoothing;
     this->useZNormalisation                = ptr->useZNormalisation;
     this->constrainZNorm                   = ptr->constrainZNorm;
     this->constrainWarpingPath             = ptr->constrainWarpingPath;
     this->trimTrainingData                 = ptr->trimTrainingData;
+    this->useDistanceCache                 = ptr->useDistanceCache;
+    this->cacheInterClassDistances         = ptr->cacheInterClassDistances;
+
+    // The training caches are shared until either model changes them
+    this->distanceCache                    = ptr->distanceCache;
+    this->useIncrementalTraining           = ptr->useIncrementalTraining;
+    this->trainingClasses                  = ptr->trainingClasses;
     this->zNormConstrainThreshold          = ptr->zNormConstrainThreshold;
     this->radius                           = ptr->radius;
     this->offsetUsingFirstSample           = ptr->offsetUsingFirstSample;
@@ -110,10 +300,18 @@ bool DTW::deepCopyFrom(const Classifier *classifier) {
     this->maximumTrimPercentage            = ptr->maximumTrimPercentage;
     this->smoothingFactor                  = ptr->smoothingFactor;
     this->distanceMethod                   = ptr->distanceMethod;
+    this->templateSelectionMethod          = ptr->templateSelectionMethod;
+    this->numReferenceSamples              = ptr->numReferenceSamples;
+    this->maxNumCandidates                 = ptr->maxNumCandidates;
+    this->templateSelectionSeed            = ptr->templateSelectionSeed;
+    this->predictionSchedulingMode         = ptr->predictionSchedulingMode;
+    this->predictionBudget                 = ptr->predictionBudget;
+    this->scheduledSecondsPerCell          = ptr->scheduledSecondsPerCell;
     this->rejectionMode                    = ptr->rejectionMode;
     this->nullRejectionLikelihoodThreshold =
       ptr->nullRejectionLikelihoodThreshold;
     this->averageTemplateLength = ptr->averageTemplateLength;
+    resetPredictionSchedule();
 
     // Copy the classifier variables
     return copyBaseVariables(classifier);
@@ -124,35 +322,60 @@ bool DTW::deepCopyFrom(const Classifier *classifier) {
 
 ////////////////////////// TRAINING FUNCTIONS //////////////////////////
 bool DTW::train_(TimeSeriesClassificationData& data) {
+  // Pack the samples into one arena, the rest of the training only reads it
+  ContiguousTimeSeriesClassificationData contiguousData(data);
+
+  return train_(contiguousData);
+}
+
+bool DTW::train_(ContiguousTimeSeriesClassificationData& data) {
+  // The distance cache is keyed by the data as it was given, before trimming
+  const uint64 datasetHash = useDistanceCache ? data.getHash() : 0;
+
+  if (!trimTrainingData) return trainTrimmedData(data, datasetHash);
+
+  // Only the rows kept by the trimming are copied, into a new arena
+  TimeSeriesClassificationSampleTrimmer timeSeriesTrimmer(trimThreshold,
+                                                          maximumTrimPercentage);
+  ContiguousTimeSeriesClassificationData trimmedData(data.getNumDimensions());
+  uint32 firstRow = 0;
+  uint32 numRows  = 0;
+
+  trimmedData.setExternalRanges(data.getExternalRanges(),
+                                data.getUseExternalRanges());
+
+  for (uint32 i = 0; i < data.getNumSamples(); i++) {
+    const TimeSeriesSampleView sample = data[i];
+
+    if (timeSeriesTrimmer.findTrimRange(sample.getData(), firstRow, numRows)) {
+      trimmedData.addSample(sample.getClassLabel(),
+                            sample.getData().getRows(firstRow, numRows));
+    }
+    else {
+      UE_LOG(GRTModule, Log,
+             TEXT(
+               "Removing training sample %d from the dataset as it could not be trimmed!"),
+             i);
+    }
+  }
+
+  return trainTrimmedData(trimmedData, datasetHash);
+}
+
+bool DTW::trainTrimmedData(const ContiguousTimeSeriesClassificationData& data,
+                           const uint64                                  datasetHash) {
   uint32 bestIndex = 0;
 
   // Cleanup Memory
   templatesBuffer.clear();
+  templateViews.clear();
+  modelFile.close();
   classLabels.clear();
+  trainingClasses.reset();
   trained = false;
   continuousInputDataBuffer.clear();
-
-  if (trimTrainingData) {
-    TimeSeriesClassificationSampleTrimmer timeSeriesTrimmer(trimThreshold,
-                                                            maximumTrimPercentage);
-    TimeSeriesClassificationData tempData;
-    tempData.setNumDimensions(data.getNumDimensions());
-
-    for (uint32 i = 0; i < data.getNumSamples(); i++) {
-      if (timeSeriesTrimmer.trimTimeSeries(data[i])) {
-        tempData.addSample(data[i].getClassLabel(), data[i].getData());
-      }
-      else {
-        UE_LOG(GRTModule, Log,
-               TEXT(
-                 "Removing training sample %d from the dataset as it could not be trimmed!"),
-               i);
-      }
-    }
-
-    // Overwrite the original training data with the trimmed dataset
-    data = tempData;
-  }
+  continuousInputStats.clear();
+  smoothedInputDataBuffer.clear();
 
   if (data.getNumSamples() == 0) {
     UE_LOG(GRTModule, Error,
@@ -169,27 +392,65 @@ bool DTW::train_(TimeSeriesClassificationData& data) {
   nullRejectionThresholds.resize(numClasses);
   averageTemplateLength = 0;
 
-  // Need to copy the labelled training data in case we need to scale it or
-  // znorm it
-  TimeSeriesClassificationData trainingData(data);
+  if (useIncrementalTraining) trainingClasses.edit().resize(numClasses);
+
+  // The labelled training data only needs to be copied if we need to scale
+  // it or znorm it, otherwise the templates are found straight from data
+  ContiguousTimeSeriesClassificationData  normalizedData;
+  const ContiguousTimeSeriesClassificationData *trainingData = &data;
 
   // Perform any scaling or normalization
-  ranges = trainingData.getRanges();
+  ranges = data.getRanges();
+
+  if (useScaling || useZNormalisation) {
+    normalizeData(data, normalizedData);
+    trainingData = &normalizedData;
+  }
 
-  if (useScaling) scaleData(trainingData);
+  // Group the samples by class, in the order of the class tracker.  Each
+  // class is a subset of the arena, so only its indexs are copied
+  const Vector<ClassTracker>& classTracker = data.getClassTracker();
+  Vector<Vector<uint32> > classIndexs(numClasses);
+  std::unordered_map<uint32, uint32> classIndexMap;
 
-  if (useZNormalisation) znormData(trainingData);
+  for (uint32 k = 0; k < numClasses; k++) {
+    classIndexMap.emplace(classTracker[k].classLabel, k);
+  }
+
+  for (uint32 i = 0; i < data.getNumSamples(); i++) {
+    auto iter = classIndexMap.find(data[i].getClassLabel());
+
+    if (iter != classIndexMap.end()) classIndexs[iter->second].push_back(i);
+  }
+
+  // Reuse the cached distances if they were computed from the same data with
+  // the same settings, otherwise compute them all now
+  if (useDistanceCache &&
+      (!distanceCache->isValid(datasetHash, getDistanceSettingsHash()) ||
+       (distanceCache->getNumSamples() != trainingData->getNumSamples()) ||
+       (cacheInterClassDistances && !distanceCache->hasInterClassDistances))) {
+    computeDistanceCache(*trainingData, datasetHash);
+  }
 
   // For each class, run a one-to-one DTW and find the template the best
   // describes the data
   for (uint32 k = 0; k < numTemplates; k++) {
+    // Stop if an asynchronous training has been cancelled
+    if (!updateTrainingProgress(float(k) / numTemplates)) {
+      UE_LOG(GRTModule, Warning,
+             TEXT("%s::%s::%d  Training was cancelled!"),
+             *FString(__FILENAME__), *FString(__FUNCTION__), __LINE__);
+      return false;
+    }
+
     // Get the class label for the c th class
-    uint32 classLabel =
-      trainingData.getClassTracker()[k].classLabel;
-    TimeSeriesClassificationData classData =
-      trainingData.getClassData(classLabel);
+    uint32 classLabel = classTracker[k].classLabel;
+    const ContiguousTimeSeriesClassificationData classData =
+      trainingData->getSubset(classIndexs[k]);
     uint32 numExamples = classData.getNumSamples();
-    bestIndex = 0;
+    MatrixFloat distances(1, 1);
+    distances[0][0] = 0;
+    bestIndex       = 0;
 
     // Set the class label of this template
     templatesBuffer[k].classLabel = classLabel;
@@ -224,10 +485,18 @@ bool DTW::train_(TimeSeriesClassificationData& data) {
       bestIndex                  = 0;
       nullRejectionThresholds[k] = 0.0; // TODO-We need a better way of
                                         // calculating this!
+      templatesBuffer[k].averageTemplateLength = classData[0].getLength();
     }
     else {
       // Search for the best training example for this class
-      if (!train_NDDTW(classData, templatesBuffer[k], bestIndex)) {
+      if (!train_NDDTW(classData, classIndexs[k], templatesBuffer[k],
+                       bestIndex, distances)) {
+        if (isTrainingCancelled()) {
+          UE_LOG(GRTModule, Warning,
+                 TEXT("%s::%s::%d  Training was cancelled!"),
+                 *FString(__FILENAME__), *FString(__FUNCTION__), __LINE__);
+          return false;
+        }
         UE_LOG(GRTModule, Error,
                TEXT(
                  "%s::%s::%d  Failed to train template for class with label: %d."),
@@ -244,7 +513,7 @@ bool DTW::train_(TimeSeriesClassificationData& data) {
 
     switch (trainingMethod) {
     case (0): // Standard Training
-      templatesBuffer[k].timeSeries = classData[bestIndex].getData();
+      classData[bestIndex].getData().copyTo(templatesBuffer[k].timeSeries);
       break;
 
     case (1): // Training using Smoothing
@@ -271,6 +540,28 @@ bool DTW::train_(TimeSeriesClassificationData& data) {
     // Add the average length of the training examples for this template to the
     // overall averageTemplateLength
     averageTemplateLength += templatesBuffer[k].averageTemplateLength;
+
+    // Keep the samples and their distances so the template can be updated
+    if (useIncrementalTraining) {
+      DTWTrainingClass& trainingClass = trainingClasses.edit()[k];
+
+      trainingClass.classLabel = classLabel;
+      trainingClass.samples.resize(numExamples);
+      trainingClass.timeSeries.resize(numExamples);
+      trainingClass.rowSums.resize(numExamples);
+      trainingClass.distances = distances;
+
+      for (uint32 m = 0; m < numExamples; m++) {
+        data[classIndexs[k][m]].getData().copyTo(trainingClass.samples[m]);
+        prepareTrainingTimeSeries(classData[m].getData(),
+                                  trainingClass.timeSeries[m]);
+        trainingClass.rowSums[m] = 0;
+
+        for (uint32 n = 0; n < numExamples; n++) {
+          if (m != n) trainingClass.rowSums[m] += distances[m][n];
+        }
+      }
+    }
   }
 
   // Flag that the models have been trained
@@ -283,9 +574,8 @@ bool DTW::train_(TimeSeriesClassificationData& data) {
 
   // Resize the prediction results to make sure it is setup for realtime
   // prediction
-  continuousInputDataBuffer.clear();
-  continuousInputDataBuffer.resize(averageTemplateLength,
-                                   VectorFloat(numInputDimensions, 0));
+  updateTemplateViews();
+  resizeInputBuffers();
   classLikelihoods.resize(numTemplates, DEFAULT_NULL_LIKELIHOOD_VALUE);
   classDistances.resize(numTemplates, 0);
   predictedClassLabel = GRT_DEFAULT_NULL_CLASS_LABEL;
@@ -295,64 +585,130 @@ bool DTW::train_(TimeSeriesClassificationData& data) {
   return trained;
 }
 
-bool DTW::train_NDDTW(TimeSeriesClassificationData& trainingData,
-                      DTWTemplate                 & dtwTemplate,
-                      uint32                      & bestIndex) {
+bool DTW::train_NDDTW(const ContiguousTimeSeriesClassificationData& trainingData,
+                      const Vector<uint32>                        & sampleIndexs,
+                      DTWTemplate                                 & dtwTemplate,
+                      uint32                                      & bestIndex,
+                      MatrixFloat                                 & distanceResults) {
   uint32 numExamples = trainingData.getNumSamples();
-  VectorFloat results(numExamples, 0.0);
-  MatrixFloat distanceResults(numExamples, numExamples);
 
   dtwTemplate.averageTemplateLength = 0;
 
   for (uint32 m = 0; m < numExamples; m++) {
-    MatrixFloat templateA; // The m th template
-    MatrixFloat templateB; // The n th template
     dtwTemplate.averageTemplateLength += trainingData[m].getLength();
+  }
 
-    // Smooth the data if required
-    if (useSmoothing) smoothData(
-        trainingData[m].getData(), smoothingFactor, templateA);
-    else templateA = trainingData[m].getData();
+  // The distance cache and incremental training need all the distances, so
+  // they always use the exact template selection
+  const bool sampleTemplate =
+    (templateSelectionMethod == SAMPLED_TEMPLATE_SELECTION) &&
+    !useDistanceCache && !useIncrementalTraining &&
+    (numExamples > numReferenceSamples + maxNumCandidates);
 
-    if (offsetUsingFirstSample) {
-      offsetTimeseries(templateA);
+  if (sampleTemplate) {
+    Vector<MatrixFloat> timeSeries(numExamples);
+
+    for (uint32 m = 0; m < numExamples; m++) {
+      prepareTrainingTimeSeries(trainingData[m].getData(), timeSeries[m]);
     }
 
-    for (uint32 n = 0; n < numExamples; n++) {
-      if (m != n) {
-        // Smooth the data if required
-        if (useSmoothing) smoothData(
-            trainingData[n].getData(), smoothingFactor, templateB);
-        else templateB = trainingData[n].getData();
-
-        if (offsetUsingFirstSample) {
-          offsetTimeseries(templateB);
+    if (!findSampledTemplate(timeSeries, bestIndex, dtwTemplate.trainingMu,
+                             dtwTemplate.trainingSigma)) return false;
+  }
+  else {
+    distanceResults.resize(numExamples, numExamples);
+
+    if (useDistanceCache) {
+      // The distances were computed by computeDistanceCache
+      for (uint32 m = 0; m < numExamples; m++) {
+        for (uint32 n = 0; n < numExamples; n++) {
+          distanceResults[m][n] =
+            distanceCache->distances[sampleIndexs[m]][sampleIndexs[n]];
         }
+      }
+    }
+    else {
+      // Smooth and offset each example once, before they are compared
+      Vector<MatrixFloat> timeSeries(numExamples);
+
+      for (uint32 m = 0; m < numExamples; m++) {
+        prepareTrainingTimeSeries(trainingData[m].getData(), timeSeries[m]);
+      }
 
-        // Compute the distance between the two time series
-        MatrixFloat distanceMatrix(templateA.getNumRows(),
-                                   templateB.getNumRows());
-        Vector<IndexDist> warpPath;
-        float dist = computeDistance(templateA,
-                                     templateB,
-                                     distanceMatrix,
-                                     warpPath);
-        UE_LOG(GRTModule, Log, TEXT(
-                 "Template: %d  Timeseries: %d  Dist: %f"), m, n, dist);
-
-        // Update the results values
-        distanceResults[m][n] = dist;
-        results[m]           += dist;
+      MatrixFloat distanceMatrix;
+      Vector<IndexDist> warpPath;
+
+      for (uint32 m = 0; m < numExamples; m++) {
+        // Large classes take a while, so a cancelled training stops early
+        if (isTrainingCancelled()) return false;
+
+        for (uint32 n = 0; n < numExamples; n++) {
+          if (m != n) {
+            // Compute the distance between the two time series
+            float dist = computeDistance(timeSeries[m],
+                                         timeSeries[n],
+                                         distanceMatrix,
+                                         warpPath);
+            UE_LOG(GRTModule, Log, TEXT(
+                     "Template: %d  Timeseries: %d  Dist: %f"), m, n, dist);
+
+            distanceResults[m][n] = dist;
+          }
+          else distanceResults[m][n] = 0; // The distance is zero because the
+                                          // two timeseries are the same
+        }
       }
-      else distanceResults[m][n] = 0; // The distance is zero because the two
-                                      // timeseries are the same
     }
+
+    // Find the best average result, this is the result with the minimum value
+    Vector<uint32> indexs(numExamples);
+    std::iota(indexs.begin(), indexs.end(), 0);
+    findBestTemplate(distanceResults, indexs, bestIndex,
+                     dtwTemplate.trainingMu, dtwTemplate.trainingSigma);
+  }
+
+  if (numExamples <= 2) {
+    UE_LOG(GRTModule, Warning,
+           TEXT(
+             "%s::%s::%d  There are not enough examples to compute the trainingMu and trainingSigma for the template for class %d"),
+           *FString(__FILENAME__), *FString(
+             __FUNCTION__), __LINE__, dtwTemplate.classLabel);
   }
 
-  for (uint32 m = 0; m < numExamples; m++) results[m] /= (numExamples - 1);
+  // Set the average length of the training examples
+  dtwTemplate.averageTemplateLength =
+    (uint32)(dtwTemplate.averageTemplateLength / float(numExamples));
+
+  UE_LOG(GRTModule, Log, TEXT(
+           "AverageTemplateLength: %d"), dtwTemplate.averageTemplateLength);
+
+  // Flag that the training was successfully
+  return true;
+}
+
+void DTW::findBestTemplate(const MatrixFloat   & distances,
+                           const Vector<uint32>& indexs,
+                           uint32              & bestIndex,
+                           float               & trainingMu,
+                           float               & trainingSigma) {
+  const uint32 numExamples = (uint32)indexs.size();
+
+  bestIndex     = 0;
+  trainingMu    = 0.0;
+  trainingSigma = 0.0;
+
+  if (numExamples < 2) return;
+
+  // The average distance of each sample to all the other samples
+  VectorFloat results(numExamples, 0.0);
+
+  for (uint32 m = 0; m < numExamples; m++) {
+    for (uint32 n = 0; n < numExamples; n++) {
+      if (m != n) results[m] += distances[indexs[m]][indexs[n]];
+    }
+    results[m] /= (numExamples - 1);
+  }
 
-  // Find the best average result, this is the result with the minimum value
-  bestIndex = 0;
   float bestAverage = results[0];
 
   for (uint32 m = 1; m < numExamples; m++) {
@@ -364,258 +720,1369 @@ bool DTW::train_NDDTW(TimeSeriesClassificationData& trainingData,
 
   if (numExamples > 2) {
     // Work out the threshold value for the best template
-    dtwTemplate.trainingMu    = results[bestIndex];
-    dtwTemplate.trainingSigma = 0.0;
+    trainingMu = results[bestIndex];
 
     for (uint32 n = 0; n < numExamples; n++) {
       if (n != bestIndex) {
-        dtwTemplate.trainingSigma += SQR(
-          distanceResults[bestIndex][n] - dtwTemplate.trainingMu);
+        trainingSigma += SQR(distances[indexs[bestIndex]][indexs[n]] -
+                             trainingMu);
       }
     }
-    dtwTemplate.trainingSigma =
-      sqrt(dtwTemplate.trainingSigma / float(numExamples - 2));
+    trainingSigma = sqrt(trainingSigma / float(numExamples - 2));
   }
-  else {
-    UE_LOG(GRTModule, Warning,
-           TEXT(
-             "%s::%s::%d  There are not enough examples to compute the trainingMu and trainingSigma for the template for class %d"),
-           *FString(__FILENAME__), *FString(
-             __FUNCTION__), __LINE__, dtwTemplate.classLabel);
-    dtwTemplate.trainingMu    = 0.0;
-    dtwTemplate.trainingSigma = 0.0;
+}
+
+bool DTW::findSampledTemplate(const Vector<MatrixFloat>& timeSeries,
+                              uint32                   & bestIndex,
+                              float                    & trainingMu,
+                              float                    & trainingSigma) {
+  const uint32 numExamples = (uint32)timeSeries.size();
+
+  // Choose the random reference samples
+  std::mt19937 generator(templateSelectionSeed);
+  Vector<uint32> referenceIndexs(numExamples);
+  std::iota(referenceIndexs.begin(), referenceIndexs.end(), 0);
+  std::shuffle(referenceIndexs.begin(), referenceIndexs.end(), generator);
+  referenceIndexs.resize(std::min(numReferenceSamples, numExamples));
+
+  // Estimate the average distance of each sample to the others, and the
+  // standard error of the estimate.  An estimate that can not be made (less
+  // than 2 reference samples, or an infinite distance) is left as NAN
+  VectorFloat estimates(numExamples, NAN), errors(numExamples, NAN);
+
+  ThreadPool::getInstance().parallelFor(numExamples, [&](uint32 m) {
+    if (isTrainingCancelled()) return;
+
+    MatrixFloat distanceMatrix;
+    Vector<IndexDist> warpPath;
+    double sum        = 0;
+    double sumSquares = 0;
+    uint32 count      = 0;
+
+    for (uint32 r = 0; r < referenceIndexs.size(); r++) {
+      if (referenceIndexs[r] == m) continue;
+
+      const double dist = computeDistance(timeSeries[m],
+                                          timeSeries[referenceIndexs[r]],
+                                          distanceMatrix, warpPath);
+      sum        += dist;
+      sumSquares += dist * dist;
+      count++;
+    }
+
+    // The variance needs at least 2 distances
+    if (count < 2) return;
+
+    const double mean     = sum / count;
+    const double variance = (sumSquares - count * mean * mean) / (count - 1);
+    const double error    = 3.0 * sqrt(std::max(variance, 0.0) / count);
+
+    if (grt_isnan(mean - mean) || grt_isnan(error - error)) return;
+
+    estimates[m] = (float)mean;
+    errors[m]    = (float)error;
+  });
+
+  if (isTrainingCancelled()) return false;
+
+  // Any sample whose lower bound is under the smallest upper bound could be
+  // the template, the most likely ones are compared with the whole class
+  float bestUpperBound = INFINITY;
+
+  for (uint32 m = 0; m < numExamples; m++) {
+    if (!grt_isnan(estimates[m])) {
+      bestUpperBound = std::min(bestUpperBound, estimates[m] + errors[m]);
+    }
   }
 
-  // Set the average length of the training examples
-  dtwTemplate.averageTemplateLength =
-    (uint32)(dtwTemplate.averageTemplateLength / float(numExamples));
+  Vector<uint32> candidates;
 
-  UE_LOG(GRTModule, Log, TEXT(
-           "AverageTemplateLength: %d"), dtwTemplate.averageTemplateLength);
+  for (uint32 m = 0; m < numExamples; m++) {
+    if (!grt_isnan(estimates[m]) &&
+        (estimates[m] - errors[m] <= bestUpperBound)) candidates.push_back(m);
+  }
 
-  // Flag that the training was successfully
+  std::stable_sort(candidates.begin(), candidates.end(),
+                   [&](const uint32 a, const uint32 b) {
+    return estimates[a] < estimates[b];
+  });
+
+  if (candidates.size() > maxNumCandidates) candidates.resize(maxNumCandidates);
+
+  const uint32 numCandidates = (uint32)candidates.size();
+
+  // Without any usable estimate every sample is compared with the whole class
+  if (numCandidates == 0) {
+    MatrixFloat distances(numExamples, numExamples);
+
+    ThreadPool::getInstance().parallelFor(numExamples, [&](uint32 m) {
+      if (isTrainingCancelled()) return;
+
+      MatrixFloat distanceMatrix;
+      Vector<IndexDist> warpPath;
+
+      for (uint32 n = 0; n < numExamples; n++) {
+        distances[m][n] = m == n ? 0 : computeDistance(timeSeries[m],
+                                                       timeSeries[n],
+                                                       distanceMatrix,
+                                                       warpPath);
+      }
+    });
+
+    if (isTrainingCancelled()) return false;
+
+    Vector<uint32> indexs(numExamples);
+    std::iota(indexs.begin(), indexs.end(), 0);
+    findBestTemplate(distances, indexs, bestIndex, trainingMu, trainingSigma);
+
+    UE_LOG(GRTModule, Log,
+           TEXT("Sampled template selection: no usable estimates, all %d samples compared with the whole class"),
+           numExamples);
+    return true;
+  }
+
+  std::vector<VectorFloat> candidateDistances(numCandidates);
+
+  ThreadPool::getInstance().parallelFor(numCandidates, [&](uint32 c) {
+    if (isTrainingCancelled()) return;
+
+    MatrixFloat distanceMatrix;
+    Vector<IndexDist> warpPath;
+    const uint32 m = candidates[c];
+
+    candidateDistances[c].resize(numExamples, 0);
+
+    for (uint32 n = 0; n < numExamples; n++) {
+      if (n != m) {
+        candidateDistances[c][n] = computeDistance(timeSeries[m],
+                                                   timeSeries[n],
+                                                   distanceMatrix, warpPath);
+      }
+    }
+  });
+
+  if (isTrainingCancelled()) return false;
+
+  // Use the candidate with the smallest average distance, the first sample
+  // wins a tie like findBestTemplate
+  uint32 bestCandidate = 0;
+  double bestSum       = 0;
+
+  for (uint32 c = 0; c < numCandidates; c++) {
+    double sum = 0;
+
+    for (uint32 n = 0; n < numExamples; n++) sum += candidateDistances[c][n];
+
+    if ((c == 0) || (sum < bestSum) ||
+        ((sum == bestSum) && (candidates[c] < candidates[bestCandidate]))) {
+      bestCandidate = c;
+      bestSum       = sum;
+    }
+  }
+
+  bestIndex     = candidates[bestCandidate];
+  trainingMu    = (float)(bestSum / (numExamples - 1));
+  trainingSigma = 0.0;
+
+  for (uint32 n = 0; n < numExamples; n++) {
+    if (n != bestIndex) {
+      trainingSigma += SQR(candidateDistances[bestCandidate][n] - trainingMu);
+    }
+  }
+  trainingSigma = sqrt(trainingSigma / float(numExamples - 2));
+
+  UE_LOG(GRTModule, Log,
+         TEXT("Sampled template selection: %d of %d samples compared with the whole class"),
+         numCandidates, numExamples);
   return true;
 }
 
-bool DTW::predict_(MatrixFloat& inputTimeSeries) {
-  if (!trained) {
-    UE_LOG(GRTModule, Error,
-           TEXT("%s::%s::%d   The DTW templates have not been trained!"),
-           *FString(__FILENAME__), *FString(__FUNCTION__), __LINE__);
-    return false;
+void DTW::prepareTrainingTimeSeries(const MatrixView& data,
+                                    MatrixFloat     & timeSeries) {
+  // Smooth the data if required
+  if (useSmoothing) smoothData(data, smoothingFactor, timeSeries);
+  else data.copyTo(timeSeries);
+
+  if (offsetUsingFirstSample) {
+    offsetTimeseries(timeSeries);
   }
+}
 
-  if (classLikelihoods.size() != numTemplates) classLikelihoods.resize(
-      numTemplates);
+uint64 DTW::getDistanceSettingsHash() const {
+  // Only the settings that change the training samples or the warping are
+  // used, so the null rejection settings can change without losing the cache
+  const uint32 flags[] = {
+    useScaling, useZNormalisation, constrainZNorm, useSmoothing,
+    smoothingFactor, offsetUsingFirstSample, constrainWarpingPath,
+    distanceMethod, trimTrainingData
+  };
+  const float values[] = {
+    zNormConstrainThreshold, radius, trimThreshold, maximumTrimPercentage
+  };
+
+  return Util::hash(values, sizeof(values), Util::hash(flags, sizeof(flags)));
+}
 
-  if (classDistances.size() != numTemplates) classDistances.resize(numTemplates);
+void DTW::computeDistanceCache(
+  const ContiguousTimeSeriesClassificationData& trainingData,
+  const uint64                                  datasetHash) {
+  const uint32 N = trainingData.getNumSamples();
+  Vector<uint32> sampleLabels(N);
+  Vector<MatrixFloat> timeSeries(N);
 
-  predictedClassLabel = 0;
-  maxLikelihood       = DEFAULT_NULL_LIKELIHOOD_VALUE;
+  for (uint32 i = 0; i < N; i++) {
+    sampleLabels[i] = trainingData[i].getClassLabel();
+    prepareTrainingTimeSeries(trainingData[i].getData(), timeSeries[i]);
+  }
 
-  for (uint32 k = 0; k < classLikelihoods.size(); k++) {
-    classLikelihoods[k] = 0;
-    classDistances[k]   = DEFAULT_NULL_LIKELIHOOD_VALUE;
+  // A cache shared with a copy of the model is left to the copy rather than
+  // copied and then overwritten
+  DTWDistanceCache& cache = distanceCache.reset();
+
+  cache.reset(datasetHash, getDistanceSettingsHash(), sampleLabels);
+  cache.hasInterClassDistances = cacheInterClassDistances;
+
+  // Each row is filled by one task, computeDistance only writes to the
+  // matrices it is given
+  ThreadPool::getInstance().parallelFor(N, [&](uint32 m) {
+    MatrixFloat distanceMatrix;
+    Vector<IndexDist> warpPath;
+    float *row = cache.distances[m];
+
+    for (uint32 n = 0; n < N; n++) {
+      if (m == n) row[n] = 0;
+      else if (cacheInterClassDistances ||
+               (sampleLabels[m] == sampleLabels[n])) {
+        row[n] = computeDistance(timeSeries[m], timeSeries[n], distanceMatrix,
+                                 warpPath);
+      }
+    }
+  });
+}
+
+bool DTW::computeLeaveOneOutDistances(Vector<uint32>& templateLabels,
+                                      MatrixFloat   & sampleDistances,
+                                      MatrixFloat   & templateMus,
+                                      MatrixFloat   & templateSigmas) const {
+  const DTWDistanceCache& cache = *distanceCache;
+  const uint32 N                 = cache.getNumSamples();
+
+  if ((N == 0) || !cache.hasInterClassDistances) {
+    UE_LOG(GRTModule, Error,
+           TEXT(
+             "%s::%s::%d  The distance cache does not hold the distances between all the samples, train the model with enableDistanceCache(true, true) first!"),
+           *FString(__FILENAME__), *FString(__FUNCTION__), __LINE__);
+    return false;
   }
 
-  if (numInputDimensions != inputTimeSeries.getNumCols()) {
+  // The distances change with the preprocessing and warping settings, so they
+  // can not be used after those have been changed
+  if (cache.settingsHash != getDistanceSettingsHash()) {
     UE_LOG(GRTModule, Error,
            TEXT(
-             "%s::%s::%d  The number of features in the model (%d) do not match that of the input time series (%d)"),
-           *FString(__FILENAME__), *FString(
-             __FUNCTION__), __LINE__, numInputDimensions,
-           inputTimeSeries.getNumCols());
+             "%s::%s::%d  The distance cache was computed with different DTW settings, retrain the model first!"),
+           *FString(__FILENAME__), *FString(__FUNCTION__), __LINE__);
     return false;
   }
 
-  // Perform any preprocessing if required
-  MatrixFloat *timeSeriesPtr = &inputTimeSeries;
-  MatrixFloat  processedTimeSeries;
-  MatrixFloat  tempMatrix;
+  // Group the samples by class, in the order the classes first appear
+  const Vector<uint32>& sampleLabels = cache.sampleLabels;
+  Vector<Vector<uint32> > classIndexs;
+  Vector<uint32> sampleClasses(N);
+  std::unordered_map<uint32, uint32> classIndexMap;
 
-  if (useScaling) {
-    scaleData(*timeSeriesPtr, processedTimeSeries);
-    timeSeriesPtr = &processedTimeSeries;
-  }
+  templateLabels.clear();
 
-  // Normalize the data if needed
-  if (useZNormalisation) {
-    znormData(*timeSeriesPtr, processedTimeSeries);
-    timeSeriesPtr = &processedTimeSeries;
+  for (uint32 i = 0; i < N; i++) {
+    auto iter = classIndexMap.find(sampleLabels[i]);
+
+    if (iter == classIndexMap.end()) {
+      iter = classIndexMap.emplace(sampleLabels[i],
+                                   (uint32)templateLabels.size()).first;
+      templateLabels.push_back(sampleLabels[i]);
+      classIndexs.push_back(Vector<uint32>());
+    }
+    classIndexs[iter->second].push_back(i);
+    sampleClasses[i] = iter->second;
   }
 
-  // Smooth the data if required
-  if (useSmoothing) {
-    smoothData(*timeSeriesPtr, smoothingFactor, tempMatrix);
-    timeSeriesPtr = &tempMatrix;
+  // The templates of the other classes do not depend on the left out sample
+  const uint32 K = (uint32)templateLabels.size();
+  Vector<uint32> templateIndexs(K);
+  VectorFloat mus(K), sigmas(K);
+
+  for (uint32 k = 0; k < K; k++) {
+    uint32 bestIndex = 0;
+    findBestTemplate(cache.distances, classIndexs[k], bestIndex, mus[k],
+                     sigmas[k]);
+    templateIndexs[k] = classIndexs[k][bestIndex];
   }
 
-  // Offset the timeseries if required
-  if (offsetUsingFirstSample) {
-    offsetTimeseries(*timeSeriesPtr);
+  sampleDistances.resize(N, K);
+  templateMus.resize(N, K);
+  templateSigmas.resize(N, K);
+
+  for (uint32 i = 0; i < N; i++) {
+    for (uint32 k = 0; k < K; k++) {
+      if (k != sampleClasses[i]) {
+        sampleDistances[i][k] = cache.distances[templateIndexs[k]][i];
+        templateMus[i][k]     = mus[k];
+        templateSigmas[i][k]  = sigmas[k];
+        continue;
+      }
+
+      // Choose the template of the sample's own class without the sample
+      Vector<uint32> indexs;
+      indexs.reserve(classIndexs[k].size());
+
+      for (uint32 n = 0; n < classIndexs[k].size(); n++) {
+        if (classIndexs[k][n] != i) indexs.push_back(classIndexs[k][n]);
+      }
+
+      if (indexs.size() == 0) {
+        sampleDistances[i][k] = NAN;
+        templateMus[i][k]     = 0;
+        templateSigmas[i][k]  = 0;
+        continue;
+      }
+
+      uint32 bestIndex = 0;
+      findBestTemplate(cache.distances, indexs, bestIndex,
+                       templateMus[i][k], templateSigmas[i][k]);
+      sampleDistances[i][k] = cache.distances[indexs[bestIndex]][i];
+    }
   }
 
-  // Make the prediction by finding the closest template
-  float sum = 0;
+  return true;
+}
 
-  if (distanceMatrices.size() != numTemplates) distanceMatrices.resize(
-      numTemplates);
+bool DTW::computeLeaveOneOutAccuracy(float         & accuracy,
+                                     Vector<uint32>& predictedClassLabels) const
+{
+  accuracy = 0;
+  predictedClassLabels.clear();
 
-  if (warpPaths.size() != numTemplates) warpPaths.resize(numTemplates);
+  Vector<uint32> templateLabels;
+  MatrixFloat sampleDistances, templateMus, templateSigmas;
 
-  // Test the timeSeries against all the templates in the timeSeries buffer
-  for (uint32 k = 0; k < numTemplates; k++) {
-    // Perform DTW
-    classDistances[k] = computeDistance(templatesBuffer[k].timeSeries,
-                                        *timeSeriesPtr,
-                                        distanceMatrices[k],
-                                        warpPaths[k]);
+  if (!computeLeaveOneOutDistances(templateLabels, sampleDistances, templateMus,
+                                   templateSigmas)) return false;
 
-    if (classDistances[k] > 1e-8)
-    {
-      classLikelihoods[k] = 1.0 / classDistances[k];
+  const uint32 N = sampleDistances.getNumRows();
+  const uint32 K = sampleDistances.getNumCols();
+  uint32 numCorrect = 0;
+
+  predictedClassLabels.resize(N, GRT_DEFAULT_NULL_CLASS_LABEL);
+
+  // Classify each sample the same way as predict, using the templates that
+  // were made without it
+  for (uint32 i = 0; i < N; i++) {
+    const float *distances = sampleDistances[i];
+    VectorFloat likelihoods(K, 0);
+    uint32 closestTemplateIndex = K;
+    uint32 maxLikelihoodIndex   = K;
+    float  sum                  = 0;
+    float  maxLikelihood        = 0;
+
+    for (uint32 k = 0; k < K; k++) {
+      if (grt_isnan(distances[k])) continue;
+
+      likelihoods[k] = distances[k] > 1e-8 ? 1.0 / distances[k] : 1e8;
+      sum           += likelihoods[k];
+
+      if ((closestTemplateIndex == K) ||
+          (distances[k] < distances[closestTemplateIndex])) {
+        closestTemplateIndex = k;
+      }
     }
-    else
-    {
-      classLikelihoods[k] = 1e8;
+
+    if (closestTemplateIndex == K) continue;
+
+    if (sum > 0) {
+      for (uint32 k = 0; k < K; k++) {
+        if (likelihoods[k] / sum > maxLikelihood) {
+          maxLikelihood      = likelihoods[k] / sum;
+          maxLikelihoodIndex = k;
+        }
+      }
+    }
+
+    const bool withinThreshold = distances[closestTemplateIndex] <=
+                                 templateMus[i][closestTemplateIndex] +
+                                 templateSigmas[i][closestTemplateIndex] *
+                                 nullRejectionCoeff;
+    const bool likely = (maxLikelihoodIndex < K) &&
+                        (maxLikelihood >= nullRejectionLikelihoodThreshold);
+    uint32 predictedIndex = closestTemplateIndex;
+
+    if (useNullRejection) {
+      switch (rejectionMode) {
+      case TEMPLATE_THRESHOLDS:
+
+        if (!withinThreshold) predictedIndex = K;
+        break;
+
+      case CLASS_LIKELIHOODS:
+        predictedIndex = likely ? maxLikelihoodIndex : K;
+        break;
+
+      case THRESHOLDS_AND_LIKELIHOODS:
+
+        if (!withinThreshold || !likely) predictedIndex = K;
+        break;
+
+      default:
+        UE_LOG(GRTModule, Error, TEXT(
+                 "%s::%s::%d  Unknown RejectionMode!"), *FString(__FILENAME__),
+               *FString(__FUNCTION__), __LINE__);
+        predictedClassLabels.clear();
+        return false;
+      }
+    }
+
+    if (predictedIndex < K) predictedClassLabels[i] = templateLabels[predictedIndex];
+
+    if (predictedClassLabels[i] == distanceCache->sampleLabels[i]) numCorrect++;
+  }
+
+  accuracy = float(numCorrect) / float(N);
+  return true;
+}
+
+bool DTW::computeRejectionCurve(const VectorFloat& nullRejectionCoeffs,
+                                VectorFloat      & truePositiveRates,
+                                VectorFloat      & falsePositiveRates) const {
+  truePositiveRates.clear();
+  falsePositiveRates.clear();
+
+  Vector<uint32> templateLabels;
+  MatrixFloat sampleDistances, templateMus, templateSigmas;
+
+  if (!computeLeaveOneOutDistances(templateLabels, sampleDistances, templateMus,
+                                   templateSigmas)) return false;
+
+  const uint32 N = sampleDistances.getNumRows();
+  const uint32 K = sampleDistances.getNumCols();
+  const uint32 C = nullRejectionCoeffs.getSize();
+
+  truePositiveRates.resize(C, 0);
+  falsePositiveRates.resize(C, 0);
+
+  for (uint32 c = 0; c < C; c++) {
+    uint32 numPositives = 0, numNegatives = 0;
+    uint32 numTruePositives = 0, numFalsePositives = 0;
+
+    for (uint32 i = 0; i < N; i++) {
+      for (uint32 k = 0; k < K; k++) {
+        if (grt_isnan(sampleDistances[i][k])) continue;
+
+        const bool accepted = sampleDistances[i][k] <=
+                              templateMus[i][k] + templateSigmas[i][k] *
+                              nullRejectionCoeffs[c];
+
+        if (templateLabels[k] == distanceCache->sampleLabels[i]) {
+          numPositives++;
+
+          if (accepted) numTruePositives++;
+        }
+        else {
+          numNegatives++;
+
+          if (accepted) numFalsePositives++;
+        }
+      }
+    }
+
+    truePositiveRates[c] = numPositives > 0 ?
+                           float(numTruePositives) / numPositives : 0;
+    falsePositiveRates[c] = numNegatives > 0 ?
+                            float(numFalsePositives) / numNegatives : 0;
+  }
+
+  return true;
+}
+
+bool DTW::predict_(MatrixFloat& inputTimeSeries) {
+  return predict_(MatrixView(inputTimeSeries));
+}
+
+bool DTW::predict_(const MatrixView& inputTimeSeries) {
+  return predictTimeSeries(inputTimeSeries, NULL);
+}
+
+bool DTW::predictTimeSeries(const MatrixView       & inputTimeSeries,
+                            const RunningStatistics *inputStats,
+                            const bool               smoothInput) {
+  if (!trained) {
+    UE_LOG(GRTModule, Error,
+           TEXT("%s::%s::%d   The DTW templates have not been trained!"),
+           *FString(__FILENAME__), *FString(__FUNCTION__), __LINE__);
+    return false;
+  }
+
+  if (classLikelihoods.size() != numTemplates) classLikelihoods.resize(
+      numTemplates);
+
+  if (classDistances.size() != numTemplates) classDistances.resize(numTemplates);
+
+  predictedClassLabel = 0;
+  maxLikelihood       = DEFAULT_NULL_LIKELIHOOD_VALUE;
+
+  for (uint32 k = 0; k < classLikelihoods.size(); k++) {
+    classLikelihoods[k] = 0;
+    classDistances[k]   = DEFAULT_NULL_LIKELIHOOD_VALUE;
+  }
+
+  if (numInputDimensions != inputTimeSeries.getNumCols()) {
+    UE_LOG(GRTModule, Error,
+           TEXT(
+             "%s::%s::%d  The number of features in the model (%d) do not match that of the input time series (%d)"),
+           *FString(__FILENAME__), *FString(
+             __FUNCTION__), __LINE__, numInputDimensions,
+           inputTimeSeries.getNumCols());
+    return false;
+  }
+
+  // Perform any preprocessing if required, the input view is never modified
+  MatrixView timeSeries;
+
+  if (!preparePredictionInput(inputTimeSeries, inputStats, smoothInput,
+                              timeSeries)) return false;
+
+  if (distanceMatrices.size() != numTemplates) distanceMatrices.resize(
+      numTemplates);
+
+  if (warpPaths.size() != numTemplates) warpPaths.resize(numTemplates);
+
+  // Test the timeSeries against all the templates in the timeSeries buffer
+  for (uint32 k = 0; k < numTemplates; k++) {
+    // Perform DTW
+    classDistances[k] = computeDistance(templateViews[k],
+                                        timeSeries,
+                                        distanceMatrices[k],
+                                        warpPaths[k]);
+  }
+
+  return updatePredictedClass();
+}
+
+bool DTW::preparePredictionInput(const MatrixView       & inputTimeSeries,
+                                 const RunningStatistics *inputStats,
+                                 const bool               smoothInput,
+                                 MatrixView             & timeSeries) {
+  timeSeries = inputTimeSeries;
+
+  if (useScaling || useZNormalisation || useSmoothing || offsetUsingFirstSample) {
+    if (!preprocessTimeSeries(inputTimeSeries, preprocessedTimeSeries,
+                              inputStats, smoothInput)) {
+      UE_LOG(GRTModule, Error,
+             TEXT("%s::%s::%d  Failed to preprocess the input time series!"),
+             *FString(__FILENAME__), *FString(__FUNCTION__), __LINE__);
+      return false;
+    }
+    timeSeries = preprocessedTimeSeries;
+  }
+  return true;
+}
+
+bool DTW::updatePredictedClass() {
+  // Make the prediction by finding the closest template
+  float sum = 0;
+
+  for (uint32 k = 0; k < numTemplates; k++) {
+    if (classDistances[k] > 1e-8)
+    {
+      classLikelihoods[k] = 1.0 / classDistances[k];
+    }
+    else
+    {
+      classLikelihoods[k] = 1e8;
+    }
+
+    sum += classLikelihoods[k];
+  }
+
+  // See which gave the min distance
+  uint32 closestTemplateIndex = 0;
+  bestDistance = classDistances[0];
+
+  for (uint32 k = 1; k < numTemplates; k++) {
+    if (classDistances[k] < bestDistance) {
+      bestDistance         = classDistances[k];
+      closestTemplateIndex = k;
+    }
+  }
+
+  // Normalize the class likelihoods and check which class has the maximum
+  // likelihood
+  uint32 maxLikelihoodIndex = 0;
+  maxLikelihood = 0;
+
+  if (sum > 0) {
+    for (uint32 k = 0; k < numTemplates; k++) {
+      classLikelihoods[k] /= sum;
+
+      if (classLikelihoods[k] > maxLikelihood) {
+        maxLikelihood      = classLikelihoods[k];
+        maxLikelihoodIndex = k;
+      }
+    }
+  }
+
+  if (useNullRejection) {
+    switch (rejectionMode) {
+    case TEMPLATE_THRESHOLDS:
+
+      if (bestDistance <=
+          nullRejectionThresholds[closestTemplateIndex]) predictedClassLabel =
+          templatesBuffer[closestTemplateIndex].classLabel;
+      else predictedClassLabel = GRT_DEFAULT_NULL_CLASS_LABEL;
+      break;
+
+    case CLASS_LIKELIHOODS:
+
+      if (maxLikelihood >=
+          nullRejectionLikelihoodThreshold)  predictedClassLabel =
+          templatesBuffer[maxLikelihoodIndex].classLabel;
+      else predictedClassLabel = GRT_DEFAULT_NULL_CLASS_LABEL;
+      break;
+
+    case THRESHOLDS_AND_LIKELIHOODS:
+
+      if ((bestDistance <= nullRejectionThresholds[closestTemplateIndex]) &&
+          (maxLikelihood >=
+           nullRejectionLikelihoodThreshold)) predictedClassLabel =
+          templatesBuffer[closestTemplateIndex].classLabel;
+      else predictedClassLabel = GRT_DEFAULT_NULL_CLASS_LABEL;
+      break;
+
+    default:
+      UE_LOG(GRTModule, Error, TEXT(
+               "%s::%s::%d  Unknown RejectionMode!"), *FString(__FILENAME__),
+             *FString(__FUNCTION__), __LINE__);
+      return false;
+
+      break;
+    }
+  }
+  else predictedClassLabel = templatesBuffer[closestTemplateIndex].classLabel;
+  return true;
+}
+
+bool DTW::predict_(VectorFloat& inputVector) {
+  if (!trained) {
+    UE_LOG(GRTModule, Error, TEXT(
+             "%s::%s::%d  The model has not been trained!"), *FString(
+             __FILENAME__), *FString(__FUNCTION__), __LINE__);
+    return false;
+  }
+
+  if (numInputDimensions != inputVector.getSize()) {
+    UE_LOG(GRTModule, Error,
+           TEXT(
+             "%s::%s::%d  The number of features in the model %d does not match that of the input Vector %d"),
+           *FString(__FILENAME__), *FString(
+             __FUNCTION__), __LINE__, numInputDimensions, inputVector.size());
+    return false;
+  }
+
+  // If the input is smoothed, the prediction from the last smoothed sample is
+  // kept until the next one
+  if (addStreamSample(&inputVector[0]) && !predictStreamWindow()) return false;
+
+  if (getMotionSegmentEnded()) finishMotionSegment();
+
+  return true;
+}
+
+bool DTW::pushSamples(const MatrixView      & block,
+                      Vector<DTWDetection>  & detections,
+                      const uint32            stride,
+                      Vector<MotionSegment> *segments) {
+  detections.clear();
+
+  if (segments) segments->clear();
+
+  if (!trained) {
+    UE_LOG(GRTModule, Error, TEXT(
+             "%s::%s::%d  The model has not been trained!"), *FString(
+             __FILENAME__), *FString(__FUNCTION__), __LINE__);
+    return false;
+  }
+
+  if (numInputDimensions != block.getNumCols()) {
+    UE_LOG(GRTModule, Error,
+           TEXT(
+             "%s::%s::%d  The number of features in the model %d does not match that of the input block %d"),
+           *FString(__FILENAME__), *FString(
+             __FUNCTION__), __LINE__, numInputDimensions, block.getNumCols());
+    return false;
+  }
+
+  const uint32 numSamples = block.getNumRows();
+
+  for (uint32 i = 0; i < numSamples; i++) {
+    if (addStreamSample(block[i])) streamWindowChanged = true;
+
+    if (earlyClassLabel != GRT_DEFAULT_NULL_CLASS_LABEL) {
+      detections.push_back(DTWDetection(earlyClassLabel, i,
+                                        numStreamSamples - 1, earlyMatchMargin,
+                                        earlyMatchCost, earlyTemplateProgress,
+                                        true));
+    }
+
+    samplesSinceStreamPrediction++;
+
+    // A segment of motion that has just ended is always evaluated, so it is
+    // classified whatever the stride
+    const bool segmentEnded = getMotionSegmentEnded();
+    const bool evaluate = segmentEnded || (stride > 0 ?
+                                           samplesSinceStreamPrediction >=
+                                           stride : i + 1 == numSamples);
+
+    if (evaluate && streamWindowChanged) {
+      streamWindowChanged          = false;
+      samplesSinceStreamPrediction = 0;
+
+      if (!predictStreamWindow()) return false;
+
+      if (continuousInputDataBuffer.getBufferFilled() &&
+          (predictedClassLabel != GRT_DEFAULT_NULL_CLASS_LABEL)) {
+        detections.push_back(DTWDetection(predictedClassLabel, i,
+                                          numStreamSamples - 1, maxLikelihood,
+                                          bestDistance));
+      }
+    }
+
+    if (segmentEnded) {
+      finishMotionSegment();
+
+      if (segments) segments->push_back(lastMotionSegment);
+    }
+  }
+  return true;
+}
+
+bool DTW::addStreamSample(const float *sample) {
+  numStreamSamples++;
+  earlyClassLabel = GRT_DEFAULT_NULL_CLASS_LABEL;
+
+  // Remove the sample that is about to be overwritten from the running
+  // statistics, then add the new input to the circular buffer
+  if (useZNormalisation && continuousInputDataBuffer.getBufferFilled()) {
+    continuousInputStats.pop(continuousInputDataBuffer[0]);
+  }
+
+  continuousInputDataBuffer.push_back(sample);
+
+  if (useZNormalisation) {
+    continuousInputStats.push(sample);
+
+    // Recompute the statistics every so often to stop rounding errors from
+    // building up, each sample is pushed and popped once per window
+    if (continuousInputStats.getNumUpdates() >=
+        2 * continuousInputDataBuffer.getSize()) {
+      continuousInputStats.recompute(continuousInputDataBuffer.getView());
+    }
+  }
+
+  // Follow the motion of the raw input, the matches and the schedule are
+  // restarted when the input starts moving as they are not updated while it
+  // is idle.  A split segment ended at the previous sample, which was still
+  // evaluated as part of it, so the new segment starts at this one
+  const bool segmentSplit = motionGateEvent == MotionEnergyGate::SEGMENT_SPLIT;
+
+  motionGateEvent = useMotionGating ?
+                    motionGate.update(sample, numStreamSamples - 1) :
+                    MotionEnergyGate::NO_EVENT;
+
+  if (segmentSplit || (motionGateEvent == MotionEnergyGate::SEGMENT_STARTED)) {
+    resetOpenEndMatches(openEndMatches);
+    resetPredictionSchedule();
+    motionSegment = MotionSegment();
+  }
+  else if (motionGateEvent == MotionEnergyGate::SEGMENT_DISCARDED) {
+    motionSegment = MotionSegment();
+  }
+
+  // If the input is smoothed then average it as it arrives, a new smoothed
+  // sample is emitted every smoothingFactor inputs and the prediction from
+  // the last emission is kept until then
+  if (smoothedInputDataBuffer.getInit()) {
+    for (uint32 j = 0; j < numInputDimensions; j++) {
+      smoothingAccumulator[j] += sample[j];
+    }
+
+    if (++numSamplesInSmoothingBlock < smoothingFactor) return false;
+
+    for (uint32 j = 0; j < numInputDimensions; j++) {
+      smoothingAccumulator[j] /= smoothingFactor;
+    }
+    smoothedInputDataBuffer.push_back(smoothingAccumulator);
+    std::fill(smoothingAccumulator.begin(), smoothingAccumulator.end(), 0);
+    numSamplesInSmoothingBlock = 0;
+  }
+
+  // Extend the open-end matches with the newest (smoothed) sample, and make
+  // an early decision if one class is far enough ahead
+  if (useEarlyClassification && !useZNormalisation &&
+      !offsetUsingFirstSample && (!useMotionGating || motionGate.getActive())) {
+    const float *newest = smoothedInputDataBuffer.getInit() ?
+                          smoothedInputDataBuffer[smoothedInputDataBuffer.
+                                                  getNumValuesInBuffer() - 1] :
+                          sample;
+    uint32 classLabel = 0;
+    float  ratio = 0, cost = 0, progress = 0;
+
+    scaleSample(newest, &earlySample[0]);
+    updateOpenEndMatches(openEndMatches, &earlySample[0], numStreamSamples);
+
+    if (findEarlyDecision(openEndMatches, lastEarlyDecisionSample, classLabel,
+                          ratio, cost, progress) &&
+        (ratio <= 1 - earlyMargin) &&
+        ((earlyMaxMatchCost <= 0) || (cost <= earlyMaxMatchCost))) {
+      earlyClassLabel         = classLabel;
+      earlyTemplateProgress   = progress;
+      earlyMatchCost          = cost;
+      earlyMatchMargin        = 1 - ratio;
+      lastEarlyDecisionSample = numStreamSamples;
+    }
+  }
+  return true;
+}
+
+bool DTW::predictStreamWindow() {
+  // While the input is idle the templates are not evaluated, the sample that
+  // closes a segment of motion is still evaluated
+  const bool gated = useMotionGating && !motionGate.getActive() &&
+                     !getMotionSegmentEnded();
+
+  if (gated && continuousInputDataBuffer.getBufferFilled()) {
+    numSkippedPredictions++;
+  }
+
+  if (!continuousInputDataBuffer.getBufferFilled() || gated) {
+    // We haven't got enough samples yet, or the input is idle, so don't do
+    // the prediction
+    predictedClassLabel = 0;
+    maxLikelihood       = DEFAULT_NULL_LIKELIHOOD_VALUE;
+    std::fill(classLikelihoods.begin(),
+              classLikelihoods.end(),
+              DEFAULT_NULL_LIKELIHOOD_VALUE);
+    std::fill(classDistances.begin(), classDistances.end(), 0);
+    return true;
+  }
+
+  const RunningStatistics *inputStats = useZNormalisation ?
+                                        &continuousInputStats : NULL;
+
+  // Run the prediction directly on the buffer window, no copy is needed
+  const bool smoothInput = !smoothedInputDataBuffer.getInit();
+  const MatrixView window = smoothInput ?
+                            continuousInputDataBuffer.getView() :
+                            smoothedInputDataBuffer.getView();
+
+  const bool predicted = predictionSchedulingMode != FULL_PREDICTION ?
+                         predictScheduled(window, inputStats, smoothInput) :
+                         predictTimeSeries(window, inputStats, smoothInput);
+
+  numEvaluatedPredictions++;
+
+  // Keep the most likely class of the open segment of motion
+  if (predicted && useMotionGating &&
+      (predictedClassLabel != GRT_DEFAULT_NULL_CLASS_LABEL) &&
+      (maxLikelihood > motionSegment.maxLikelihood)) {
+    motionSegment.classLabel    = predictedClassLabel;
+    motionSegment.maxLikelihood = maxLikelihood;
+  }
+  return predicted;
+}
+
+void DTW::finishMotionSegment() {
+  lastMotionSegment               = motionGate.getEndedSegment();
+  lastMotionSegment.classLabel    = motionSegment.classLabel;
+  lastMotionSegment.maxLikelihood = motionSegment.maxLikelihood;
+  motionSegment                   = MotionSegment();
+}
+
+bool DTW::predictScheduled(const MatrixView       & inputTimeSeries,
+                           const RunningStatistics *inputStats,
+                           const bool               smoothInput) {
+  const double startTime = FPlatformTime::Seconds();
+  const double budget    = predictionBudget * 1.0e-6;
+  const bool   timeSliced = predictionSchedulingMode == TIME_SLICED_PREDICTION;
+
+  if (classLikelihoods.size() != numTemplates) classLikelihoods.resize(
+      numTemplates);
+
+  if (classDistances.size() != numTemplates) classDistances.resize(numTemplates);
+
+  if (distanceMatrices.size() != numTemplates) distanceMatrices.resize(
+      numTemplates);
+
+  if (warpPaths.size() != numTemplates) warpPaths.resize(numTemplates);
+
+  // Start again if the templates have changed, e.g. by incremental training
+  if (scheduledDistances.size() != numTemplates) {
+    resetPredictionSchedule();
+    scheduledDistances.resize(numTemplates, 0);
+    scheduledLowerBounds.resize(numTemplates, 0);
+    scheduledWindows.resize(numTemplates, 0);
+    scheduledOrder.resize(numTemplates, 0);
+  }
+
+  // Windows are counted from 1, so a template with a window of 0 has not
+  // been evaluated yet
+  numScheduledWindows++;
+
+  MatrixView timeSeries;
+
+  if (timeSliced) {
+    // Start a new pass on a copy of the newest window, as the input buffer
+    // moves on before the pass is finished
+    if (scheduledWindow == 0) {
+      if (!preparePredictionInput(inputTimeSeries, inputStats, smoothInput,
+                                  timeSeries)) return false;
+
+      timeSeries.copyTo(scheduledTimeSeries);
+      scheduledWindow = numScheduledWindows;
+      orderScheduledTemplates(scheduledTimeSeries, 0);
+    }
+    timeSeries = scheduledTimeSeries;
+  }
+  else {
+    if (!preparePredictionInput(inputTimeSeries, inputStats, smoothInput,
+                                timeSeries)) return false;
+
+    orderScheduledTemplates(timeSeries, numTemplates);
+  }
+
+  // Evaluate the templates until the next one is expected to go over the
+  // budget, at least one is evaluated so the prediction always moves on
+  uint32 numEvaluated = 0;
+
+  while (nextScheduledTemplate < numTemplates) {
+    const uint32 k        = scheduledOrder[nextScheduledTemplate];
+    const double numCells = double(templateViews[k].getNumRows()) *
+                            timeSeries.getNumRows();
+    const double templateStartTime = FPlatformTime::Seconds();
+
+    if ((numEvaluated > 0) &&
+        (templateStartTime - startTime + numCells * scheduledSecondsPerCell >
+         budget)) break;
+
+    scheduledDistances[k] = computeDistance(templateViews[k],
+                                            timeSeries,
+                                            distanceMatrices[k],
+                                            warpPaths[k]);
+    scheduledWindows[k] = timeSliced ? scheduledWindow : numScheduledWindows;
+
+    // Keep a running estimate of the time per distance matrix cell
+    const double secondsPerCell = (FPlatformTime::Seconds() -
+                                   templateStartTime) / std::max(numCells, 1.0);
+    scheduledSecondsPerCell = scheduledSecondsPerCell > 0 ?
+                              0.8 * scheduledSecondsPerCell + 0.2 *
+                              secondsPerCell : secondsPerCell;
+    nextScheduledTemplate++;
+    numEvaluated++;
+  }
+
+  if (timeSliced) {
+    // Keep the last prediction until the pass is finished
+    if (nextScheduledTemplate < numTemplates) {
+      if (scheduledPredictionReady) predictionAge++;
+      return true;
+    }
+    predictionAge   = uint32(numScheduledWindows - scheduledWindow);
+    scheduledWindow = 0;
+  }
+  else {
+    uint64 oldestWindow = numScheduledWindows;
+
+    for (uint32 k = 0; k < numTemplates; k++) {
+      oldestWindow = std::min(oldestWindow, scheduledWindows[k]);
+    }
+
+    // Wait until every template has been evaluated once
+    if (oldestWindow == 0) return true;
+
+    predictionAge = uint32(numScheduledWindows - oldestWindow);
+  }
+
+  for (uint32 k = 0; k < numTemplates; k++) {
+    classDistances[k] = scheduledDistances[k];
+  }
+  scheduledPredictionReady = true;
+
+  return updatePredictedClass();
+}
+
+float DTW::computeLowerBound(const MatrixView& timeSeriesA,
+                             const MatrixView& timeSeriesB) const {
+  const uint32 M = timeSeriesA.getNumRows();
+  const uint32 N = timeSeriesB.getNumRows();
+
+  if ((M == 0) || (N == 0)) return 0;
+
+  // computeDistance returns the average cost along the warping path.  Every
+  // cost includes the distance of the first samples, and the cost at the end
+  // of the path also includes the distance of the last samples, and the path
+  // has at most M + N - 1 cells
+  const float first = computeSampleDistance(timeSeriesA[0], timeSeriesB[0], N);
+
+  if (M + N == 2) return first;
+
+  return first + computeSampleDistance(timeSeriesA[M - 1],
+                                       timeSeriesB[N - 1], N) / (M + N - 1);
+}
+
+float DTW::computeSampleDistance(const float *a,
+                                 const float *b,
+                                 const uint32 N) const {
+  float dist = 0;
+
+  for (uint32 k = 0; k < numInputDimensions; k++) {
+    if (distanceMethod == EUCLIDEAN_DIST) dist += SQR(a[k] - b[k]);
+    else dist += fabs(a[k] - b[k]);
+  }
+
+  if (distanceMethod == EUCLIDEAN_DIST) return sqrt(dist);
+
+  if (distanceMethod == NORM_ABSOLUTE_DIST) return dist / N;
+
+  return dist;
+}
+
+void DTW::scaleSample(const float *input,
+                      float       *output) const {
+  for (uint32 j = 0; j < numInputDimensions; j++) {
+    if (!useScaling) output[j] = input[j];
+    else if (ranges[j].minValue != ranges[j].maxValue) {
+      output[j] = (input[j] - ranges[j].minValue) /
+                  (ranges[j].maxValue - ranges[j].minValue);
+    }
+    else output[j] = 0;
+  }
+}
+
+void DTW::resetOpenEndMatches(Vector<DTWOpenEndMatch>& matches) const {
+  matches.resize(templateViews.size());
+
+  for (uint32 k = 0; k < matches.size(); k++) {
+    const uint32 M = templateViews[k].getNumRows();
+    matches[k].costs.resize(M, INFINITY);
+    std::fill(matches[k].costs.begin(), matches[k].costs.end(), INFINITY);
+    matches[k].lengths.resize(M, 0);
+    matches[k].starts.resize(M, 0);
+    matches[k].bestCost     = INFINITY;
+    matches[k].bestProgress = 0;
+    matches[k].bestStart    = 0;
+  }
+}
+
+void DTW::updateOpenEndMatches(Vector<DTWOpenEndMatch>& matches,
+                               const float             *sample,
+                               const uint64             sampleIndex) const {
+  if (matches.size() != templateViews.size()) resetOpenEndMatches(matches);
+
+  const uint32 N = std::max(averageTemplateLength, 1u);
+
+  for (uint32 k = 0; k < matches.size(); k++) {
+    const MatrixView& timeSeries = templateViews[k];
+    DTWOpenEndMatch & match      = matches[k];
+    const uint32 M               = timeSeries.getNumRows();
+    const uint32 minRows         = std::max(
+      uint32(ceil(earlyMinTemplateProgress * M)), 1u);
+
+    if (match.costs.getSize() != M) resetOpenEndMatches(matches);
+
+    match.bestCost     = INFINITY;
+    match.bestProgress = 0;
+    match.bestStart    = 0;
+
+    // Each row can be reached from the same row, or from one or two rows
+    // before, at the last sample, so the rows are updated from the last one
+    // down and the costs of the last sample are still there when needed
+    for (int i = int(M) - 1; i >= 0; i--) {
+      const float dist  = computeSampleDistance(timeSeries[i], sample, N);
+      float  bestValue  = INFINITY;
+      float  cost       = 0;
+      uint32 length     = 0;
+      uint64 start      = sampleIndex;
+
+      // A new match can start at the first row with any sample
+      if (i == 0) bestValue = dist;
+
+      for (int r = i; (r >= 0) && (r >= i - 2); r--) {
+        if (grt_isinf(match.costs[r])) continue;
+
+        const float value = (match.costs[r] + dist) / (match.lengths[r] + 1);
+
+        if (value < bestValue) {
+          bestValue = value;
+          cost      = match.costs[r];
+          length    = match.lengths[r];
+          start     = match.starts[r];
+        }
+      }
+
+      // The row can not be reached yet
+      if (grt_isinf(bestValue)) continue;
+
+      match.costs[i]   = cost + dist;
+      match.lengths[i] = length + 1;
+      match.starts[i]  = start;
+
+      if ((uint32(i) + 1 >= minRows) && (bestValue < match.bestCost)) {
+        match.bestCost     = bestValue;
+        match.bestProgress = float(i + 1) / M;
+        match.bestStart    = start;
+      }
     }
+  }
+}
 
-    sum += classLikelihoods[k];
+bool DTW::findEarlyDecision(const Vector<DTWOpenEndMatch>& matches,
+                            const uint64                   minStart,
+                            uint32                       & classLabel,
+                            float                        & ratio,
+                            float                        & cost,
+                            float                        & progress) const {
+  uint32 bestIndex = 0;
+
+  for (uint32 k = 1; k < matches.size(); k++) {
+    if (matches[k].bestCost < matches[bestIndex].bestCost) bestIndex = k;
   }
 
-  // See which gave the min distance
-  uint32 closestTemplateIndex = 0;
-  bestDistance = classDistances[0];
+  if (matches.empty() || grt_isinf(matches[bestIndex].bestCost) ||
+      (matches[bestIndex].bestStart <= minStart)) return false;
 
-  for (uint32 k = 1; k < numTemplates; k++) {
-    if (classDistances[k] < bestDistance) {
-      bestDistance         = classDistances[k];
-      closestTemplateIndex = k;
-    }
+  // The best match of any other class
+  float nextCost = INFINITY;
+
+  classLabel = templatesBuffer[bestIndex].classLabel;
+  cost       = matches[bestIndex].bestCost;
+  progress   = matches[bestIndex].bestProgress;
+
+  for (uint32 k = 0; k < matches.size(); k++) {
+    if ((templatesBuffer[k].classLabel != classLabel) &&
+        (matches[k].bestCost < nextCost)) nextCost = matches[k].bestCost;
   }
 
-  // Normalize the class likelihoods and check which class has the maximum
-  // likelihood
-  uint32 maxLikelihoodIndex = 0;
-  maxLikelihood = 0;
+  if (grt_isinf(nextCost)) ratio = 0;
+  else ratio = nextCost > 0 ? cost / nextCost : 1;
+  return true;
+}
 
-  if (sum > 0) {
-    for (uint32 k = 0; k < numTemplates; k++) {
-      classLikelihoods[k] /= sum;
+bool DTW::computeEarlyClassificationCurve(
+  const TimeSeriesClassificationData& data,
+  const VectorFloat                 & margins,
+  VectorFloat                       & accuracies,
+  VectorFloat                       & decisionRates,
+  VectorFloat                       & observedFractions) const {
+  if (!trained || (data.getNumDimensions() != numInputDimensions) ||
+      useZNormalisation || offsetUsingFirstSample) {
+    UE_LOG(GRTModule, Error,
+           TEXT(
+             "%s::%s::%d  The model is not trained, the data does not match it, or it uses z-normalization or offsetting!"),
+           *FString(__FILENAME__), *FString(__FUNCTION__), __LINE__);
+    return false;
+  }
 
-      if (classLikelihoods[k] > maxLikelihood) {
-        maxLikelihood      = classLikelihoods[k];
-        maxLikelihoodIndex = k;
+  const uint32 numSamples = data.getNumSamples();
+  const uint32 numMargins = margins.getSize();
+  const uint32 blockSize  = getDecimateInput() ? smoothingFactor : 1;
+
+  // The first early decision of each time series for each margin, a fraction
+  // of -1 means no decision was made
+  Vector<uint32> decisionLabels(numSamples * numMargins, 0);
+  VectorFloat    decisionFractions(numSamples * numMargins, -1);
+
+  ThreadPool::getInstance().parallelFor(numSamples, [&](uint32 n) {
+    const MatrixFloat& timeSeries = data[n].getData();
+    const uint32 M = timeSeries.getNumRows();
+    Vector<DTWOpenEndMatch> matches;
+    VectorFloat smoothed(numInputDimensions);
+    VectorFloat scaled(numInputDimensions);
+    uint32 numDecided = 0;
+
+    resetOpenEndMatches(matches);
+
+    // Feed the samples as the realtime input does, only whole smoothing
+    // blocks make a new sample
+    for (uint32 end = blockSize; (end <= M) && (numDecided < numMargins);
+         end += blockSize) {
+      std::fill(smoothed.begin(), smoothed.end(), 0);
+
+      for (uint32 i = end - blockSize; i < end; i++) {
+        for (uint32 j = 0; j < numInputDimensions; j++) {
+          smoothed[j] += timeSeries[i][j];
+        }
       }
-    }
-  }
 
-  if (useNullRejection) {
-    switch (rejectionMode) {
-    case TEMPLATE_THRESHOLDS:
+      for (uint32 j = 0; j < numInputDimensions; j++) smoothed[j] /= blockSize;
 
-      if (bestDistance <=
-          nullRejectionThresholds[closestTemplateIndex]) predictedClassLabel =
-          templatesBuffer[closestTemplateIndex].classLabel;
-      else predictedClassLabel = GRT_DEFAULT_NULL_CLASS_LABEL;
-      break;
+      scaleSample(&smoothed[0], &scaled[0]);
+      updateOpenEndMatches(matches, &scaled[0], end);
 
-    case CLASS_LIKELIHOODS:
+      uint32 classLabel = 0;
+      float  ratio = 0, cost = 0, progress = 0;
 
-      if (maxLikelihood >=
-          nullRejectionLikelihoodThreshold)  predictedClassLabel =
-          templatesBuffer[maxLikelihoodIndex].classLabel;
-      else predictedClassLabel = GRT_DEFAULT_NULL_CLASS_LABEL;
-      break;
+      if (!findEarlyDecision(matches, 0, classLabel, ratio, cost,
+                             progress)) continue;
 
-    case THRESHOLDS_AND_LIKELIHOODS:
+      if ((earlyMaxMatchCost > 0) && (cost > earlyMaxMatchCost)) continue;
 
-      if ((bestDistance <= nullRejectionThresholds[closestTemplateIndex]) &&
-          (maxLikelihood >=
-           nullRejectionLikelihoodThreshold)) predictedClassLabel =
-          templatesBuffer[closestTemplateIndex].classLabel;
-      else predictedClassLabel = GRT_DEFAULT_NULL_CLASS_LABEL;
-      break;
+      for (uint32 m = 0; m < numMargins; m++) {
+        const uint32 index = n * numMargins + m;
 
-    default:
-      UE_LOG(GRTModule, Error, TEXT(
-               "%s::%s::%d  Unknown RejectionMode!"), *FString(__FILENAME__),
-             *FString(__FUNCTION__), __LINE__);
-      return false;
+        if ((decisionFractions[index] < 0) && (ratio <= 1 - margins[m])) {
+          decisionLabels[index]    = classLabel;
+          decisionFractions[index] = float(end) / M;
+          numDecided++;
+        }
+      }
+    }
+  });
 
-      break;
+  accuracies.resize(numMargins);
+  decisionRates.resize(numMargins);
+  observedFractions.resize(numMargins);
+
+  for (uint32 m = 0; m < numMargins; m++) {
+    uint32 numDecided = 0, numCorrect = 0;
+    float  sumFractions = 0;
+
+    for (uint32 n = 0; n < numSamples; n++) {
+      const uint32 index = n * numMargins + m;
+
+      if (decisionFractions[index] < 0) continue;
+
+      numDecided++;
+      sumFractions += decisionFractions[index];
+
+      if (decisionLabels[index] == data[n].getClassLabel()) numCorrect++;
     }
+    accuracies[m]        = numDecided > 0 ? float(numCorrect) / numDecided : 0;
+    decisionRates[m]     = numSamples > 0 ? float(numDecided) / numSamples : 0;
+    observedFractions[m] = numDecided > 0 ? sumFractions / numDecided : 0;
   }
-  else predictedClassLabel = templatesBuffer[closestTemplateIndex].classLabel;
   return true;
 }
 
-bool DTW::predict_(VectorFloat& inputVector) {
-  if (!trained) {
-    UE_LOG(GRTModule, Error, TEXT(
-             "%s::%s::%d  The model has not been trained!"), *FString(
-             __FILENAME__), *FString(__FUNCTION__), __LINE__);
-    return false;
+void DTW::orderScheduledTemplates(const MatrixView& timeSeries,
+                                  const uint64      maxAge) {
+  for (uint32 k = 0; k < numTemplates; k++) {
+    scheduledLowerBounds[k] = computeLowerBound(templateViews[k], timeSeries);
+    scheduledOrder[k]       = k;
   }
-  predictedClassLabel = 0;
-  maxLikelihood       = DEFAULT_NULL_LIKELIHOOD_VALUE;
-  std::fill(classLikelihoods.begin(),
-            classLikelihoods.end(),
-            DEFAULT_NULL_LIKELIHOOD_VALUE);
-  std::fill(classDistances.begin(), classDistances.end(), 0);
 
-  if (numInputDimensions != inputVector.getSize()) {
-    UE_LOG(GRTModule, Error,
-           TEXT(
-             "%s::%s::%d  The number of features in the model %d does not match that of the input Vector %d"),
-           *FString(__FILENAME__), *FString(
-             __FUNCTION__), __LINE__, numInputDimensions, inputVector.size());
-    return false;
-  }
+  auto isOld = [&](const uint32 k) {
+    return (maxAge > 0) &&
+           ((scheduledWindows[k] == 0) ||
+            (numScheduledWindows - scheduledWindows[k] >= maxAge));
+  };
 
-  // Add the new input to the circular buffer
-  continuousInputDataBuffer.push_back(inputVector);
+  std::stable_sort(scheduledOrder.begin(), scheduledOrder.end(),
+                   [&](const uint32 a, const uint32 b) {
+    const bool oldA = isOld(a);
+    const bool oldB = isOld(b);
 
-  if (continuousInputDataBuffer.getNumValuesInBuffer() < averageTemplateLength) {
-    // We haven't got enough samples yet so can't do the prediction
-    return true;
-  }
+    if (oldA != oldB) return oldA;
 
-  // Copy the data into a temporary matrix
-  const uint32 M = continuousInputDataBuffer.getSize();
-  const uint32 N = numInputDimensions;
-  MatrixFloat  predictionTimeSeries(M, N);
+    if (oldA) return scheduledWindows[a] < scheduledWindows[b];
 
-  for (uint32 i = 0; i < M; i++) {
-    for (uint32 j = 0; j < N; j++) {
-      predictionTimeSeries[i][j] = continuousInputDataBuffer[i][j];
-    }
-  }
+    return scheduledLowerBounds[a] < scheduledLowerBounds[b];
+  });
+  nextScheduledTemplate = 0;
+}
 
-  // Run the prediction
-  return predict(predictionTimeSeries);
+void DTW::resetPredictionSchedule() {
+  scheduledTimeSeries.clear();
+  scheduledDistances.clear();
+  scheduledLowerBounds.clear();
+  scheduledWindows.clear();
+  scheduledOrder.clear();
+  nextScheduledTemplate    = 0;
+  numScheduledWindows      = 0;
+  scheduledWindow          = 0;
+  predictionAge            = 0;
+  scheduledPredictionReady = false;
 }
 
 bool DTW::reset() {
   continuousInputDataBuffer.clear();
+  continuousInputStats.clear();
+  smoothedInputDataBuffer.clear();
 
   if (trained) {
-    continuousInputDataBuffer.resize(averageTemplateLength,
-                                     VectorFloat(numInputDimensions, 0));
+    resizeInputBuffers();
     recomputeNullRejectionThresholds();
   }
   return true;
 }
 
+void DTW::resizeInputBuffers() {
+  // If the input is smoothed then it is decimated as it arrives, so the raw
+  // window is rounded up to a whole number of smoothing blocks
+  const bool decimateInput = getDecimateInput();
+  const uint32 numSmoothedSamples = decimateInput ?
+                                    (averageTemplateLength + smoothingFactor - 1) /
+                                    smoothingFactor : 0;
+  const uint32 windowLength = decimateInput ?
+                              numSmoothedSamples * smoothingFactor :
+                              averageTemplateLength;
+
+  continuousInputDataBuffer.clear();
+  continuousInputDataBuffer.resize(windowLength, numInputDimensions);
+  continuousInputStats.resize(numInputDimensions);
+
+  smoothedInputDataBuffer.clear();
+
+  if (decimateInput) smoothedInputDataBuffer.resize(numSmoothedSamples,
+                                                    numInputDimensions);
+
+  smoothingAccumulator.resize(numInputDimensions);
+  std::fill(smoothingAccumulator.begin(), smoothingAccumulator.end(), 0);
+  numSamplesInSmoothingBlock   = 0;
+  numStreamSamples             = 0;
+  samplesSinceStreamPrediction = 0;
+  streamWindowChanged          = false;
+  resetPredictionSchedule();
+
+  resetOpenEndMatches(openEndMatches);
+  earlySample.resize(numInputDimensions);
+  lastEarlyDecisionSample = 0;
+  earlyClassLabel         = 0;
+
+  motionGate.resize(numInputDimensions);
+  motionGateEvent         = MotionEnergyGate::NO_EVENT;
+  motionSegment           = MotionSegment();
+  lastMotionSegment       = MotionSegment();
+  numEvaluatedPredictions = 0;
+  numSkippedPredictions   = 0;
+}
+
+bool DTW::getDecimateInput() const {
+  return useSmoothing && (smoothingFactor > 1) &&
+         (averageTemplateLength >= smoothingFactor);
+}
+
 bool DTW::clear() {
   // Clear the Classifier variables
   Classifier::clear();
 
   // Clear the DTW model
   templatesBuffer.clear();
+  templateViews.clear();
+  trainingClasses.reset();
+  modelFile.close();
   distanceMatrices.clear();
   warpPaths.clear();
   continuousInputDataBuffer.clear();
+  continuousInputStats.clear();
+  smoothedInputDataBuffer.clear();
+  resetPredictionSchedule();
 
   return true;
 }
@@ -637,10 +2104,47 @@ bool DTW::recomputeNullRejectionThresholds() {
   return true;
 }
 
+Vector<DTWTemplate>DTW::getModels() const {
+  Vector<DTWTemplate> models = templatesBuffer;
+
+  // Templates loaded from a binary model file only live in the mapped file
+  for (uint32 i = 0; i < models.size(); i++) {
+    if ((models[i].timeSeries.getNumRows() == 0) && (i < templateViews.size())) {
+      templateViews[i].copyTo(models[i].timeSeries);
+    }
+  }
+  return models;
+}
+
+void DTW::updateTemplateViews() {
+  templateViews.resize(templatesBuffer.size());
+
+  for (uint32 i = 0; i < templatesBuffer.size(); i++) {
+    templateViews[i] = templatesBuffer[i].timeSeries;
+  }
+}
+
+void DTW::copyTemplateData(const DTW& rhs) {
+  // The views of rhs may point into its mapped model file, which this model
+  // does not share, so copy any mapped templates into templatesBuffer
+  for (uint32 i = 0; i < templatesBuffer.size(); i++) {
+    if ((templatesBuffer[i].timeSeries.getNumRows() == 0) &&
+        (i < rhs.templateViews.size())) {
+      rhs.templateViews[i].copyTo(templatesBuffer[i].timeSeries);
+    }
+  }
+  modelFile.close();
+  updateTemplateViews();
+}
+
 bool DTW::setModels(Vector<DTWTemplate>newTemplates) {
   if (newTemplates.size() == templatesBuffer.size()) {
     templatesBuffer = newTemplates;
 
+    // The new templates own their data, so any mapped model is not needed
+    modelFile.close();
+    updateTemplateViews();
+
     // Make sure the class labels have not changed
     classLabels.resize(templatesBuffer.size());
 
@@ -655,8 +2159,8 @@ bool DTW::setModels(Vector<DTWTemplate>newTemplates) {
 ////////////////////////// computeDistance
 // ///////////////////////////////////////////
 
-float DTW::computeDistance(MatrixFloat      & timeSeriesA,
-                           MatrixFloat      & timeSeriesB,
+float DTW::computeDistance(const MatrixView & timeSeriesA,
+                           const MatrixView & timeSeriesB,
                            MatrixFloat      & distanceMatrix,
                            Vector<IndexDist>& warpPath) {
   const int M = timeSeriesA.getNumRows();
@@ -933,14 +2437,40 @@ inline float DTW::MIN_(float a, float b, float c) {
 ////////////////////////// SCALING AND NORMALISATION FUNCTIONS
 // //////////////////////////
 
-void DTW::scaleData(TimeSeriesClassificationData& trainingData) {
-  // Scale the data using the min and max values
-  for (uint32 i = 0; i < trainingData.getNumSamples(); i++) {
-    scaleData(trainingData[i].getData(), trainingData[i].getData());
+void DTW::normalizeData(
+  const ContiguousTimeSeriesClassificationData& data,
+  ContiguousTimeSeriesClassificationData      & normalizedData) {
+  const uint32 N = data.getNumSamples();
+  uint64 numRows = 0;
+
+  for (uint32 i = 0; i < N; i++) numRows += data[i].getLength();
+
+  // The scaled and z-normalized samples are written to a new arena, in the
+  // same order as data
+  normalizedData = ContiguousTimeSeriesClassificationData(
+    data.getNumDimensions());
+  normalizedData.reserve(N, numRows);
+
+  MatrixFloat sample;
+
+  for (uint32 i = 0; i < N; i++) {
+    const TimeSeriesSampleView view = data[i];
+
+    if (view.getLength() == 0) {
+      normalizedData.addSample(view.getClassLabel(), MatrixView());
+      continue;
+    }
+
+    if (useScaling) scaleData(view.getData(), sample);
+    else view.getData().copyTo(sample);
+
+    if (useZNormalisation) znormData(sample, sample);
+
+    normalizedData.addSample(view.getClassLabel(), sample);
   }
 }
 
-void DTW::scaleData(MatrixFloat& data, MatrixFloat& scaledData) {
+void DTW::scaleData(const MatrixView& data, MatrixFloat& scaledData) {
   const uint32 R = data.getNumRows();
   const uint32 C = data.getNumCols();
 
@@ -957,13 +2487,7 @@ void DTW::scaleData(MatrixFloat& data, MatrixFloat& scaledData) {
                                                                 1.0f);
 }
 
-void DTW::znormData(TimeSeriesClassificationData& trainingData) {
-  for (uint32 i = 0; i < trainingData.getNumSamples(); i++) {
-    znormData(trainingData[i].getData(), trainingData[i].getData());
-  }
-}
-
-void DTW::znormData(MatrixFloat& data, MatrixFloat& normData) {
+void DTW::znormData(const MatrixView& data, MatrixFloat& normData) {
   const uint32 R = data.getNumRows();
   const uint32 C = data.getNumCols();
 
@@ -983,7 +2507,7 @@ void DTW::znormData(MatrixFloat& data, MatrixFloat& normData) {
     for (uint32 i = 0; i < R; i++) stdDev += grt_sqr(data[i][j] - mean);
     stdDev = grt_sqrt(stdDev / (R - 1.0));
 
-    if (constrainZNorm && (stdDev < 0.01)) {
+    if (constrainZNorm && (stdDev < zNormConstrainThreshold)) {
       // Normalize the data to 0 mean
       for (uint32 i = 0; i < R; i++) normData[i][j] = (data[i][j] - mean);
     }
@@ -1036,20 +2560,20 @@ void DTW::smoothData(VectorFloat& data,
   }
 }
 
-void DTW::smoothData(MatrixFloat& data,
-                     uint32       smoothFactor,
-                     MatrixFloat& resultsData) {
+void DTW::smoothData(const MatrixView& data,
+                     uint32            smoothFactor,
+                     MatrixFloat     & resultsData) {
   const uint32 M = data.getNumRows();
   const uint32 C = data.getNumCols();
   const uint32 N = (uint32)floor(float(M) / float(smoothFactor));
 
-  resultsData.resize(N, C);
-
   if ((smoothFactor == 1) || (M < smoothFactor)) {
-    resultsData = data;
+    data.copyTo(resultsData);
     return;
   }
 
+  resultsData.resize(N, C);
+
   for (uint32 i = 0; i < N; i++) {
     for (uint32 j = 0; j < C; j++) {
       float mean  = 0.0;
@@ -1082,6 +2606,135 @@ void DTW::smoothData(MatrixFloat& data,
   }
 }
 
+bool DTW::preprocessTimeSeries(const MatrixView       & input,
+                               MatrixFloat            & output,
+                               const RunningStatistics *inputStats,
+                               const bool               smoothInput) {
+  const uint32 M = input.getNumRows();
+  const uint32 C = input.getNumCols();
+
+  if ((M == 0) || (C == 0)) return false;
+
+  // Rows are averaged in blocks of smoothingFactor, the last block holds any
+  // rows that do not fill a whole block (this matches smoothData)
+  const uint32 blockSize =
+    (smoothInput && useSmoothing && (smoothingFactor > 1) &&
+     (M >= smoothingFactor)) ? smoothingFactor : 1;
+  const uint32 N = (M + blockSize - 1) / blockSize;
+
+  if ((output.getNumRows() != N) || (output.getNumCols() != C)) {
+    if (!output.resize(N, C)) return false;
+  }
+
+  // Each value is mapped by ((x - scaleMin) / scaleRange) * scaleGain and then
+  // by (x - mean) / stdDev.  Disabled stages use the identity coefficients so
+  // the inner loops run the same straight line code over every dimension
+  if ((preprocessingCoeffs.getNumRows() != 6) ||
+      (preprocessingCoeffs.getNumCols() != C)) {
+    preprocessingCoeffs.resize(6, C);
+  }
+  float *scaleMin   = preprocessingCoeffs[0];
+  float *scaleRange = preprocessingCoeffs[1];
+  float *scaleGain  = preprocessingCoeffs[2];
+  float *mean       = preprocessingCoeffs[3];
+  float *stdDev     = preprocessingCoeffs[4];
+  float *offset     = preprocessingCoeffs[5];
+
+  for (uint32 j = 0; j < C; j++) {
+    if (useScaling && (ranges[j].minValue != ranges[j].maxValue)) {
+      scaleMin[j]   = ranges[j].minValue;
+      scaleRange[j] = ranges[j].maxValue - ranges[j].minValue;
+      scaleGain[j]  = 1.0;
+    }
+    else {
+      // A flat range scales to 0, as grt_scale does
+      scaleMin[j]   = 0.0;
+      scaleRange[j] = 1.0;
+      scaleGain[j]  = useScaling ? 0.0 : 1.0;
+    }
+    mean[j]   = 0.0;
+    stdDev[j] = 0.0;
+  }
+
+  // If the statistics of the input are already known then map them through
+  // the scaling, otherwise compute the mean and variance of the scaled data in
+  // a first pass using Welford's method so the input only has to be read once
+  // (if the input has already been smoothed then the statistics describe the
+  // raw samples, the scaling and z-normalization commute with the average)
+  const uint32 numRawSamples = smoothInput ? M : M * smoothingFactor;
+
+  if (useZNormalisation && (inputStats != NULL) &&
+      (inputStats->getCount() == numRawSamples) &&
+      (inputStats->getNumDimensions() == C)) {
+    for (uint32 j = 0; j < C; j++) {
+      mean[j] = float(((inputStats->getMean(j) - scaleMin[j]) / scaleRange[j]) *
+                      scaleGain[j]);
+      stdDev[j] = float((inputStats->getStdDev(j) / scaleRange[j]) * scaleGain[j]);
+
+      if (constrainZNorm && (stdDev[j] < zNormConstrainThreshold)) stdDev[j] = 1.0;
+    }
+  }
+  else if (useZNormalisation) {
+    for (uint32 i = 0; i < M; i++) {
+      const float *row = input[i];
+      const float  n   = float(i + 1);
+
+      for (uint32 j = 0; j < C; j++) {
+        const float x     = ((row[j] - scaleMin[j]) / scaleRange[j]) * scaleGain[j];
+        const float delta = x - mean[j];
+        mean[j]   += delta / n;
+        stdDev[j] += delta * (x - mean[j]);
+      }
+    }
+
+    for (uint32 j = 0; j < C; j++) {
+      stdDev[j] = grt_sqrt(stdDev[j] / (M - 1.0));
+
+      // Only remove the mean if the standard deviation is too small
+      if (constrainZNorm && (stdDev[j] < zNormConstrainThreshold)) stdDev[j] = 1.0;
+    }
+  }
+  else {
+    for (uint32 j = 0; j < C; j++) stdDev[j] = 1.0;
+  }
+
+  // Second pass, scale, normalize and average each block of rows straight
+  // into the output row, then remove the offset of the first output row
+  for (uint32 i = 0; i < N; i++) {
+    const uint32 start = i * blockSize;
+    const uint32 end   = start + blockSize < M ? start + blockSize : M;
+    float *out         = output[i];
+
+    for (uint32 j = 0; j < C; j++) out[j] = 0.0;
+
+    for (uint32 r = start; r < end; r++) {
+      const float *row = input[r];
+
+      for (uint32 j = 0; j < C; j++) {
+        out[j] +=
+          (((row[j] - scaleMin[j]) / scaleRange[j]) * scaleGain[j] - mean[j]) /
+          stdDev[j];
+      }
+    }
+
+    if (blockSize > 1) {
+      const float length = float(end - start);
+
+      for (uint32 j = 0; j < C; j++) out[j] /= length;
+    }
+
+    if (offsetUsingFirstSample) {
+      if (i == 0) {
+        for (uint32 j = 0; j < C; j++) offset[j] = out[j];
+      }
+
+      for (uint32 j = 0; j < C; j++) out[j] -= offset[j];
+    }
+  }
+
+  return true;
+}
+
 bool DTW::setDistanceMethod(uint32 _distanceMethod) {
   if ((_distanceMethod == ABSOLUTE_DIST) || (_distanceMethod == EUCLIDEAN_DIST) ||
       (_distanceMethod == NORM_ABSOLUTE_DIST)) {
@@ -1146,8 +2799,7 @@ bool DTW::save(std::fstream& file) const {
       file << "***************TEMPLATE***************" << std::endl;
       file << "Template: " << i + 1 << std::endl;
       file << "ClassLabel: " << templatesBuffer[i].classLabel << std::endl;
-      file << "TimeSeriesLength: " <<
-        templatesBuffer[i].timeSeries.getNumRows() << std::endl;
+      file << "TimeSeriesLength: " << templateViews[i].getNumRows() << std::endl;
       file << "TemplateThreshold: " << nullRejectionThresholds[i] << std::endl;
       file << "TrainingMu: " << templatesBuffer[i].trainingMu << std::endl;
       file << "TrainingSigma: " << templatesBuffer[i].trainingSigma << std::endl;
@@ -1155,15 +2807,301 @@ bool DTW::save(std::fstream& file) const {
         templatesBuffer[i].averageTemplateLength << std::endl;
       file << "TimeSeries: " << std::endl;
 
-      for (uint32 k = 0; k < templatesBuffer[i].timeSeries.getNumRows(); k++) {
-        for (uint32 j = 0; j < templatesBuffer[i].timeSeries.getNumCols(); j++) {
-          file << templatesBuffer[i].timeSeries[k][j] << "\t";
-        }
-        file << std::endl;
-      }
+      for (uint32 k = 0; k < templateViews[i].getNumRows(); k++) {
+        for (uint32 j = 0; j < templateViews[i].getNumCols(); j++) {
+          file << templateViews[i][k][j] << "\t";
+        }
+        file << std::endl;
+      }
+    }
+  }
+
+  return true;
+}
+
+bool DTW::load(const FString& filename) {
+  // Binary models are mapped straight into memory, anything else is parsed as
+  // a text model
+  char magic[sizeof(DTWBinaryHeader::magic)] = { 0 };
+  std::fstream file;
+
+  file.open(TCHAR_TO_UTF8(*filename), std::ios::in | std::ios::binary);
+  file.read(magic, sizeof(magic));
+  file.close();
+
+  if (memcmp(magic, DTW_BINARY_MAGIC, sizeof(magic)) == 0) {
+    return loadBinary(filename);
+  }
+  return MLBase::load(filename);
+}
+
+bool DTW::saveBinary(const FString& filename) const {
+  std::fstream file;
+
+  file.open(TCHAR_TO_UTF8(*filename),
+            std::ios::out | std::ios::binary | std::ios::trunc);
+
+  if (!file.is_open()) {
+    UE_LOG(GRTModule, Error, TEXT(
+             "%s::%s::%d  Could not open file to save data"), *FString(
+             __FILENAME__), *FString(__FUNCTION__), __LINE__);
+    return false;
+  }
+
+  const uint32 numSavedTemplates = trained ? numTemplates : 0;
+  const uint32 numSavedClasses   = trained ? (uint32)classLabels.size() : 0;
+  const uint32 numSavedRanges    = trained && useScaling ? (uint32)ranges.size() : 0;
+
+  // Work out where each section will go
+  DTWBinaryHeader header;
+  memset(&header, 0, sizeof(header));
+  memcpy(header.magic, DTW_BINARY_MAGIC, sizeof(header.magic));
+  header.version             = DTW_BINARY_VERSION;
+  header.byteOrder           = DTW_BINARY_BYTE_ORDER;
+  header.numTemplates        = numSavedTemplates;
+  header.numClasses          = numSavedClasses;
+  header.numInputDimensions  = numInputDimensions;
+  header.numRanges           = numSavedRanges;
+  header.settingsOffset      = alignBinaryOffset(sizeof(DTWBinaryHeader));
+  header.classTableOffset    = alignBinaryOffset(header.settingsOffset +
+                                                 sizeof(DTWBinarySettings));
+  header.templateTableOffset = alignBinaryOffset(
+    header.classTableOffset + sizeof(uint32) * numSavedClasses +
+    2 * sizeof(float) * numSavedRanges);
+
+  Vector<DTWBinaryTemplate> templateTable(numSavedTemplates);
+  uint64 offset = header.templateTableOffset + sizeof(DTWBinaryTemplate) *
+                  numSavedTemplates;
+
+  for (uint32 i = 0; i < numSavedTemplates; i++) {
+    DTWBinaryTemplate& entry = templateTable[i];
+    entry.classLabel            = templatesBuffer[i].classLabel;
+    entry.timeSeriesLength      = templateViews[i].getNumRows();
+    entry.threshold             = nullRejectionThresholds[i];
+    entry.trainingMu            = templatesBuffer[i].trainingMu;
+    entry.trainingSigma         = templatesBuffer[i].trainingSigma;
+    entry.averageTemplateLength = templatesBuffer[i].averageTemplateLength;
+    entry.dataOffset            = alignBinaryOffset(offset);
+    offset                      = entry.dataOffset + sizeof(float) *
+                                  entry.timeSeriesLength * numInputDimensions;
+  }
+  header.fileSize = offset;
+
+  DTWBinarySettings settings;
+  memset(&settings, 0, sizeof(settings));
+  settings.trained                         = trained;
+  settings.useScaling                      = useScaling;
+  settings.numOutputDimensions             = numOutputDimensions;
+  settings.numTrainingIterationsToConverge = numTrainingIterationsToConverge;
+  settings.minNumEpochs                    = minNumEpochs;
+  settings.maxNumEpochs                    = maxNumEpochs;
+  settings.validationSetSize               = validationSetSize;
+  settings.learningRate                    = learningRate;
+  settings.minChange                       = minChange;
+  settings.useValidationSet                = useValidationSet;
+  settings.randomiseTrainingOrder          = randomiseTrainingOrder;
+  settings.useNullRejection                = useNullRejection;
+  settings.classifierMode                  = classifierMode;
+  settings.nullRejectionCoeff              = nullRejectionCoeff;
+  settings.distanceMethod                  = distanceMethod;
+  settings.useSmoothing                    = useSmoothing;
+  settings.smoothingFactor                 = smoothingFactor;
+  settings.useZNormalisation               = useZNormalisation;
+  settings.offsetUsingFirstSample          = offsetUsingFirstSample;
+  settings.constrainWarpingPath            = constrainWarpingPath;
+  settings.radius                          = radius;
+  settings.rejectionMode                   = rejectionMode;
+  settings.averageTemplateLength           = averageTemplateLength;
+
+  // Write the sections in order, padding each one to its offset
+  file.write((const char *)&header, sizeof(header));
+  writeBinaryPadding(file, header.settingsOffset);
+  file.write((const char *)&settings, sizeof(settings));
+  writeBinaryPadding(file, header.classTableOffset);
+
+  for (uint32 i = 0; i < numSavedClasses; i++) {
+    file.write((const char *)&classLabels[i], sizeof(uint32));
+  }
+
+  for (uint32 i = 0; i < numSavedRanges; i++) {
+    const float range[2] = { ranges[i].minValue, ranges[i].maxValue };
+    file.write((const char *)range, sizeof(range));
+  }
+  writeBinaryPadding(file, header.templateTableOffset);
+
+  if (numSavedTemplates > 0) {
+    file.write((const char *)&templateTable[0],
+               sizeof(DTWBinaryTemplate) * numSavedTemplates);
+  }
+
+  for (uint32 i = 0; i < numSavedTemplates; i++) {
+    const MatrixView& timeSeries = templateViews[i];
+    writeBinaryPadding(file, templateTable[i].dataOffset);
+
+    for (uint32 k = 0; k < timeSeries.getNumRows(); k++) {
+      file.write((const char *)timeSeries[k],
+                 sizeof(float) * timeSeries.getNumCols());
+    }
+  }
+
+  if (!file.good()) {
+    UE_LOG(GRTModule, Error, TEXT("%s::%s::%d  Failed to write the model!"),
+           *FString(__FILENAME__), *FString(__FUNCTION__), __LINE__);
+    return false;
+  }
+  file.close();
+
+  return true;
+}
+
+bool DTW::loadBinary(const FString& filename) {
+  // Clear any previous model, this also closes any previous model file
+  clear();
+
+  if (!modelFile.open(filename)) {
+    UE_LOG(GRTModule, Error, TEXT("%s::%s::%d  Failed to open file!"),
+           *FString(__FILENAME__), *FString(__FUNCTION__), __LINE__);
+    return false;
+  }
+
+  const char  *data = modelFile.getData();
+  const uint64 size = modelFile.getSize();
+
+  DTWBinaryHeader header;
+  DTWBinarySettings settings;
+
+  if (size < sizeof(header)) {
+    clear();
+    UE_LOG(GRTModule, Error, TEXT("%s::%s::%d  Unknown file header!"),
+           *FString(__FILENAME__), *FString(__FUNCTION__), __LINE__);
+    return false;
+  }
+  memcpy(&header, data, sizeof(header));
+
+  if ((memcmp(header.magic, DTW_BINARY_MAGIC, sizeof(header.magic)) != 0) ||
+      (header.version != DTW_BINARY_VERSION) ||
+      (header.byteOrder != DTW_BINARY_BYTE_ORDER)) {
+    clear();
+    UE_LOG(GRTModule, Error,
+           TEXT(
+             "%s::%s::%d  Unknown file header, version or byte order!"),
+           *FString(__FILENAME__), *FString(__FUNCTION__), __LINE__);
+    return false;
+  }
+
+  // Make sure every section is inside the file before touching it
+  const uint64 classTableSize = sizeof(uint32) * (uint64)header.numClasses +
+                                2 * sizeof(float) * (uint64)header.numRanges;
+  const uint64 templateTableSize = sizeof(DTWBinaryTemplate) *
+                                   (uint64)header.numTemplates;
+
+  if ((header.fileSize != size) ||
+      (header.settingsOffset + sizeof(settings) > size) ||
+      (header.classTableOffset + classTableSize > size) ||
+      (header.templateTableOffset + templateTableSize > size) ||
+      (header.templateTableOffset % sizeof(uint64) != 0)) {
+    clear();
+    UE_LOG(GRTModule, Error,
+           TEXT("%s::%s::%d  The file is truncated or corrupt!"),
+           *FString(__FILENAME__), *FString(__FUNCTION__), __LINE__);
+    return false;
+  }
+  memcpy(&settings, data + header.settingsOffset, sizeof(settings));
+
+  trained                         = settings.trained != 0;
+  useScaling                      = settings.useScaling != 0;
+  numInputDimensions              = header.numInputDimensions;
+  numOutputDimensions             = settings.numOutputDimensions;
+  numTrainingIterationsToConverge = settings.numTrainingIterationsToConverge;
+  minNumEpochs                    = settings.minNumEpochs;
+  maxNumEpochs                    = settings.maxNumEpochs;
+  validationSetSize               = settings.validationSetSize;
+  learningRate                    = settings.learningRate;
+  minChange                       = settings.minChange;
+  useValidationSet                = settings.useValidationSet != 0;
+  randomiseTrainingOrder          = settings.randomiseTrainingOrder != 0;
+  useNullRejection                = settings.useNullRejection != 0;
+  classifierMode                  = settings.classifierMode;
+  nullRejectionCoeff              = settings.nullRejectionCoeff;
+  distanceMethod                  = settings.distanceMethod;
+  useSmoothing                    = settings.useSmoothing != 0;
+  smoothingFactor                 = settings.smoothingFactor;
+  useZNormalisation               = settings.useZNormalisation != 0;
+  offsetUsingFirstSample          = settings.offsetUsingFirstSample != 0;
+  constrainWarpingPath            = settings.constrainWarpingPath != 0;
+  radius                          = settings.radius;
+  rejectionMode                   = settings.rejectionMode;
+
+  if (!trained) return true;
+
+  if ((header.numRanges != 0) && (header.numRanges != numInputDimensions)) {
+    clear();
+    UE_LOG(GRTModule, Error, TEXT("%s::%s::%d  Invalid number of ranges!"),
+           *FString(__FILENAME__), *FString(__FUNCTION__), __LINE__);
+    return false;
+  }
+
+  // Load the class labels and ranges
+  const char *classTable = data + header.classTableOffset;
+  numClasses = header.numClasses;
+  classLabels.resize(numClasses);
+
+  if (numClasses > 0) {
+    memcpy(&classLabels[0], classTable, sizeof(uint32) * numClasses);
+  }
+  classTable += sizeof(uint32) * numClasses;
+
+  ranges.resize(header.numRanges);
+
+  for (uint32 i = 0; i < header.numRanges; i++) {
+    float range[2];
+    memcpy(range, classTable + sizeof(range) * i, sizeof(range));
+    ranges[i].minValue = range[0];
+    ranges[i].maxValue = range[1];
+  }
+
+  // Load the templates, the template data is used in place
+  const DTWBinaryTemplate *templateTable =
+    (const DTWBinaryTemplate *)(data + header.templateTableOffset);
+
+  numTemplates          = header.numTemplates;
+  averageTemplateLength = settings.averageTemplateLength;
+  templatesBuffer.resize(numTemplates);
+  templateViews.resize(numTemplates);
+  nullRejectionThresholds.resize(numTemplates);
+
+  for (uint32 i = 0; i < numTemplates; i++) {
+    const DTWBinaryTemplate& entry = templateTable[i];
+    const uint64 dataSize = sizeof(float) * (uint64)entry.timeSeriesLength *
+                            numInputDimensions;
+
+    if ((entry.dataOffset % sizeof(float) != 0) ||
+        (entry.dataOffset + dataSize > size)) {
+      clear();
+      UE_LOG(GRTModule, Error,
+             TEXT("%s::%s::%d  Invalid data offset for template %d!"),
+             *FString(__FILENAME__), *FString(__FUNCTION__), __LINE__, i + 1);
+      return false;
     }
+
+    templatesBuffer[i].classLabel            = entry.classLabel;
+    templatesBuffer[i].trainingMu            = entry.trainingMu;
+    templatesBuffer[i].trainingSigma         = entry.trainingSigma;
+    templatesBuffer[i].averageTemplateLength = entry.averageTemplateLength;
+    nullRejectionThresholds[i]               = entry.threshold;
+    templateViews[i]                         = MatrixView(
+      (const float *)(data + entry.dataOffset), entry.timeSeriesLength,
+      numInputDimensions);
   }
 
+  // Resize the prediction results to make sure it is setup for realtime
+  // prediction
+  resizeInputBuffers();
+  maxLikelihood = DEFAULT_NULL_LIKELIHOOD_VALUE;
+  bestDistance  = DEFAULT_NULL_DISTANCE_VALUE;
+  classLikelihoods.resize(numClasses, DEFAULT_NULL_LIKELIHOOD_VALUE);
+  classDistances.resize(numClasses, DEFAULT_NULL_DISTANCE_VALUE);
+
   return true;
 }
 
@@ -1446,9 +3384,8 @@ bool DTW::load(std::fstream& file) {
 
     // Resize the prediction results to make sure it is setup for realtime
     // prediction
-    continuousInputDataBuffer.clear();
-    continuousInputDataBuffer.resize(averageTemplateLength,
-                                     VectorFloat(numInputDimensions, 0));
+    updateTemplateViews();
+    resizeInputBuffers();
     maxLikelihood = DEFAULT_NULL_LIKELIHOOD_VALUE;
     bestDistance  = DEFAULT_NULL_DISTANCE_VALUE;
     classLikelihoods.resize(numClasses, DEFAULT_NULL_LIKELIHOOD_VALUE);
@@ -1458,6 +3395,105 @@ bool DTW::load(std::fstream& file) {
   return true;
 }
 
+bool DTW::setTemplateSelectionMethod(uint32 _templateSelectionMethod,
+                                     uint32 _numReferenceSamples,
+                                     uint32 _maxNumCandidates,
+                                     uint32 _seed) {
+  if (((_templateSelectionMethod != EXACT_TEMPLATE_SELECTION) &&
+       (_templateSelectionMethod != SAMPLED_TEMPLATE_SELECTION)) ||
+      (_numReferenceSamples < 2) || (_maxNumCandidates < 1)) {
+    UE_LOG(GRTModule, Error,
+           TEXT(
+             "%s::%s::%d  Unknown template selection method %d, or there are less than 2 reference samples or no candidates!"),
+           *FString(__FILENAME__), *FString(__FUNCTION__), __LINE__,
+           _templateSelectionMethod);
+    return false;
+  }
+
+  this->templateSelectionMethod = _templateSelectionMethod;
+  this->numReferenceSamples     = _numReferenceSamples;
+  this->maxNumCandidates        = _maxNumCandidates;
+  this->templateSelectionSeed   = _seed;
+  return true;
+}
+
+bool DTW::setPredictionScheduling(uint32 _predictionSchedulingMode,
+                                  float  _budgetMicroseconds) {
+  if ((_predictionSchedulingMode > ROTATING_SUBSET_PREDICTION) ||
+      !(_budgetMicroseconds > 0)) {
+    UE_LOG(GRTModule, Error,
+           TEXT(
+             "%s::%s::%d  Unknown prediction scheduling mode %d, or the budget is not greater than zero!"),
+           *FString(__FILENAME__), *FString(__FUNCTION__), __LINE__,
+           _predictionSchedulingMode);
+    return false;
+  }
+
+  if (_predictionSchedulingMode != predictionSchedulingMode) {
+    resetPredictionSchedule();
+  }
+  this->predictionSchedulingMode = _predictionSchedulingMode;
+  this->predictionBudget         = _budgetMicroseconds;
+  return true;
+}
+
+bool DTW::enableEarlyClassification(bool  _useEarlyClassification,
+                                    float _margin,
+                                    float _minTemplateProgress,
+                                    float _maxMatchCost) {
+  if ((_margin < 0) || (_margin >= 1) || (_minTemplateProgress <= 0) ||
+      (_minTemplateProgress > 1)) {
+    UE_LOG(GRTModule, Error,
+           TEXT(
+             "%s::%s::%d  The margin must be in [0 1) and the template progress in (0 1]!"),
+           *FString(__FILENAME__), *FString(__FUNCTION__), __LINE__);
+    return false;
+  }
+
+  if (_useEarlyClassification && (useZNormalisation || offsetUsingFirstSample)) {
+    UE_LOG(GRTModule, Error,
+           TEXT(
+             "%s::%s::%d  Early classification can not be used with z-normalization or offsetting by the first sample!"),
+           *FString(__FILENAME__), *FString(__FUNCTION__), __LINE__);
+    return false;
+  }
+
+  this->useEarlyClassification   = _useEarlyClassification;
+  this->earlyMargin              = _margin;
+  this->earlyMinTemplateProgress = _minTemplateProgress;
+  this->earlyMaxMatchCost        = _maxMatchCost;
+  resetOpenEndMatches(openEndMatches);
+  lastEarlyDecisionSample = 0;
+  earlyClassLabel         = GRT_DEFAULT_NULL_CLASS_LABEL;
+  return true;
+}
+
+bool DTW::enableMotionGating(bool   _useMotionGating,
+                             float  _startThreshold,
+                             float  _stopThreshold,
+                             uint32 _stopDelay,
+                             uint32 _energyWindow,
+                             uint32 _minSegmentLength,
+                             uint32 _maxSegmentLength) {
+  const float stopThreshold = _stopThreshold > 0 ? _stopThreshold :
+                              _startThreshold * 0.5f;
+
+  if (!motionGate.setup(numInputDimensions, _startThreshold, stopThreshold,
+                        _energyWindow, _stopDelay, _minSegmentLength,
+                        _maxSegmentLength)) {
+    UE_LOG(GRTModule, Error,
+           TEXT(
+             "%s::%s::%d  The start threshold must be greater than zero and not less than the stop threshold, the energy window must be greater than zero and the maximum segment length not less than the minimum!"),
+           *FString(__FILENAME__), *FString(__FUNCTION__), __LINE__);
+    return false;
+  }
+
+  this->useMotionGating = _useMotionGating;
+  motionGateEvent       = MotionEnergyGate::NO_EVENT;
+  motionSegment         = MotionSegment();
+  return true;
+}
+
 bool DTW::setRejectionMode(uint32 _rejectionMode) {
   if ((_rejectionMode == TEMPLATE_THRESHOLDS) ||
       (_rejectionMode == CLASS_LIKELIHOODS) ||
@@ -1495,6 +3531,31 @@ bool DTW::enableZNormalization(bool _useZNormalisation, bool _constrainZNorm) {
   return true;
 }
 
+bool DTW::enableSmoothing(bool _useSmoothing, uint32 _smoothingFactor) {
+  if (_smoothingFactor == 0) {
+    UE_LOG(GRTModule, Warning,
+           TEXT(
+             "%s::%s::%d   Failed to set smoothing. The smoothingFactor must be greater than zero"),
+           *FString(__FILENAME__), *FString(__FUNCTION__), __LINE__);
+    return false;
+  }
+  this->useSmoothing    = _useSmoothing;
+  this->smoothingFactor = _smoothingFactor;
+  return true;
+}
+
+bool DTW::setZNormConstrainThreshold(float _zNormConstrainThreshold) {
+  if (_zNormConstrainThreshold < 0) {
+    UE_LOG(GRTModule, Warning,
+           TEXT(
+             "%s::%s::%d   Failed to set zNormConstrainThreshold. The threshold must be greater than or equal to zero"),
+           *FString(__FILENAME__), *FString(__FUNCTION__), __LINE__);
+    return false;
+  }
+  this->zNormConstrainThreshold = _zNormConstrainThreshold;
+  return true;
+}
+
 bool DTW::enableTrimTrainingData(bool  _trimTrainingData,
                                  float _trimThreshold,
                                  float _maximumTrimPercentage) {
@@ -1520,12 +3581,403 @@ bool DTW::enableTrimTrainingData(bool  _trimTrainingData,
   return true;
 }
 
+bool DTW::enableDistanceCache(bool useDistanceCache,
+                              bool includeInterClassDistances) {
+  this->useDistanceCache         = useDistanceCache;
+  this->cacheInterClassDistances = includeInterClassDistances;
+
+  if (!useDistanceCache) distanceCache.reset();
+  return true;
+}
+
+bool DTW::setDistanceCache(const DTWDistanceCache& distanceCache) {
+  this->distanceCache.set(distanceCache);
+  return true;
+}
+
+bool DTW::enableIncrementalTraining(bool useIncrementalTraining) {
+  this->useIncrementalTraining = useIncrementalTraining;
+
+  if (!useIncrementalTraining) trainingClasses.reset();
+  return true;
+}
+
+bool DTW::addTrainingSample(const uint32 classLabel, const MatrixFloat& sample) {
+  if (!trained || (trainingClasses->size() != numTemplates)) {
+    UE_LOG(GRTModule, Error,
+           TEXT(
+             "%s::%s::%d  The model must be trained with incremental training enabled first!"),
+           *FString(__FILENAME__), *FString(__FUNCTION__), __LINE__);
+    return false;
+  }
+
+  if (sample.getNumCols() != numInputDimensions) {
+    UE_LOG(GRTModule, Error,
+           TEXT(
+             "%s::%s::%d  The number of features in the model (%d) do not match that of the sample (%d)"),
+           *FString(__FILENAME__), *FString(__FUNCTION__), __LINE__,
+           numInputDimensions, sample.getNumCols());
+    return false;
+  }
+
+  // Trim the sample the same way train does
+  TimeSeriesClassificationSample trimmedSample(classLabel, sample);
+
+  if (trimTrainingData) {
+    TimeSeriesClassificationSampleTrimmer timeSeriesTrimmer(trimThreshold,
+                                                            maximumTrimPercentage);
+
+    if (!timeSeriesTrimmer.trimTimeSeries(trimmedSample)) {
+      UE_LOG(GRTModule, Warning,
+             TEXT("%s::%s::%d  The sample could not be trimmed!"),
+             *FString(__FILENAME__), *FString(__FUNCTION__), __LINE__);
+      return false;
+    }
+  }
+
+  const MatrixFloat& newSample = trimmedSample.getData();
+  uint32 k = getTrainingClassIndex(classLabel);
+
+  // The training classes are copied here if a copy of the model shares them
+  Vector<DTWTrainingClass>& classes = trainingClasses.edit();
+
+  if (k == classes.size()) {
+    // Like train, a class needs more than 1 example to use null rejection
+    if (useNullRejection) {
+      UE_LOG(GRTModule, Error,
+             TEXT(
+               "%s::%s::%d  Can not add class %d as it would only have 1 example. Turn off null rejection if you want to use DTW with only 1 training sample per class."),
+             *FString(__FILENAME__), *FString(__FUNCTION__), __LINE__,
+             classLabel);
+      return false;
+    }
+    classes.push_back(DTWTrainingClass());
+    classes[k].classLabel = classLabel;
+    templatesBuffer.push_back(DTWTemplate());
+    templatesBuffer[k].classLabel = classLabel;
+    classLabels.push_back(classLabel);
+  }
+
+  // The cached distances are of the samples the model was trained with
+  distanceCache.reset();
+
+  // If the sample is outside the ranges then the scaling of every sample
+  // changes, so all the distances have to be recomputed
+  if (useScaling) {
+    bool insideRanges = true;
+
+    for (uint32 i = 0; i < newSample.getNumRows() && insideRanges; i++) {
+      for (uint32 j = 0; j < numInputDimensions; j++) {
+        if ((newSample[i][j] < ranges[j].minValue) ||
+            (newSample[i][j] > ranges[j].maxValue)) {
+          insideRanges = false;
+          break;
+        }
+      }
+    }
+
+    if (!insideRanges) {
+      classes[k].samples.push_back(newSample);
+      return retrainTrainingClasses();
+    }
+  }
+
+  // Preprocess the sample the same way train does
+  MatrixFloat normalizedSample = newSample;
+  MatrixFloat timeSeries;
+
+  if (useScaling) scaleData(normalizedSample, normalizedSample);
+
+  if (useZNormalisation) znormData(normalizedSample, normalizedSample);
+  prepareTrainingTimeSeries(normalizedSample, timeSeries);
+
+  // Only the distances between the new sample and the other samples of its
+  // class are computed
+  DTWTrainingClass& trainingClass = classes[k];
+  const uint32 N = (uint32)trainingClass.timeSeries.size();
+  VectorFloat distancesFromNew(N), distancesToNew(N);
+
+  ThreadPool::getInstance().parallelFor(N, [&](uint32 n) {
+    MatrixFloat distanceMatrix;
+    Vector<IndexDist> warpPath;
+
+    distancesFromNew[n] = computeDistance(timeSeries,
+                                          trainingClass.timeSeries[n],
+                                          distanceMatrix, warpPath);
+    distancesToNew[n] = computeDistance(trainingClass.timeSeries[n],
+                                        timeSeries, distanceMatrix, warpPath);
+  });
+
+  MatrixFloat distances(N + 1, N + 1);
+  double rowSum = 0;
+
+  for (uint32 m = 0; m < N; m++) {
+    for (uint32 n = 0; n < N; n++) {
+      distances[m][n] = trainingClass.distances[m][n];
+    }
+    distances[m][N]             = distancesToNew[m];
+    distances[N][m]             = distancesFromNew[m];
+    trainingClass.rowSums[m]   += distancesToNew[m];
+    rowSum                     += distancesFromNew[m];
+  }
+  distances[N][N] = 0;
+
+  trainingClass.distances = distances;
+  trainingClass.rowSums.push_back(rowSum);
+  trainingClass.samples.push_back(newSample);
+  trainingClass.timeSeries.push_back(timeSeries);
+
+  updateTrainingClassTemplate(k);
+  finishIncrementalUpdate();
+  return true;
+}
+
+bool DTW::removeTrainingSample(const uint32 classLabel,
+                               const uint32 sampleIndex) {
+  const uint32 k = getTrainingClassIndex(classLabel);
+
+  if (!trained || (k == trainingClasses->size()) ||
+      (sampleIndex >= (*trainingClasses)[k].samples.size())) {
+    UE_LOG(GRTModule, Error,
+           TEXT(
+             "%s::%s::%d  There is no training sample %d of class %d, the model must be trained with incremental training enabled first!"),
+           *FString(__FILENAME__), *FString(__FUNCTION__), __LINE__,
+           sampleIndex, classLabel);
+    return false;
+  }
+
+  DTWTrainingClass& trainingClass = trainingClasses.edit()[k];
+  const uint32 N = (uint32)trainingClass.samples.size();
+
+  if (N == 1) return removeTrainingClass(classLabel);
+
+  // The cached distances are of the samples the model was trained with
+  distanceCache.reset();
+
+  // Remove the row and the column of the sample
+  MatrixFloat distances(N - 1, N - 1);
+
+  for (uint32 m = 0, i = 0; m < N; m++) {
+    if (m == sampleIndex) continue;
+
+    for (uint32 n = 0, j = 0; n < N; n++) {
+      if (n != sampleIndex) distances[i][j++] = trainingClass.distances[m][n];
+    }
+    trainingClass.rowSums[m] -= trainingClass.distances[m][sampleIndex];
+    i++;
+  }
+
+  const MatrixFloat removedSample = trainingClass.samples[sampleIndex];
+
+  trainingClass.distances = distances;
+  trainingClass.rowSums.erase(trainingClass.rowSums.begin() + sampleIndex);
+  trainingClass.samples.erase(trainingClass.samples.begin() + sampleIndex);
+  trainingClass.timeSeries.erase(trainingClass.timeSeries.begin() +
+                                 sampleIndex);
+
+  if (useScaling &&
+      haveTrainingRangesChanged(Vector<MatrixFloat>(1, removedSample))) {
+    return retrainTrainingClasses();
+  }
+
+  updateTrainingClassTemplate(k);
+  finishIncrementalUpdate();
+  return true;
+}
+
+bool DTW::removeTrainingClass(const uint32 classLabel) {
+  const uint32 k = getTrainingClassIndex(classLabel);
+
+  if (!trained || (k == trainingClasses->size())) {
+    UE_LOG(GRTModule, Error,
+           TEXT(
+             "%s::%s::%d  There are no training samples of class %d, the model must be trained with incremental training enabled first!"),
+           *FString(__FILENAME__), *FString(__FUNCTION__), __LINE__,
+           classLabel);
+    return false;
+  }
+
+  Vector<DTWTrainingClass>& classes   = trainingClasses.edit();
+  const DTWTrainingClass removedClass = classes[k];
+
+  // The cached distances are of the samples the model was trained with
+  distanceCache.reset();
+
+  classes.erase(classes.begin() + k);
+  templatesBuffer.erase(templatesBuffer.begin() + k);
+  classLabels.erase(classLabels.begin() + k);
+
+  if (classes.size() == 0) {
+    clear();
+    return true;
+  }
+
+  if (useScaling && haveTrainingRangesChanged(removedClass.samples)) {
+    return retrainTrainingClasses();
+  }
+
+  finishIncrementalUpdate();
+  return true;
+}
+
+uint32 DTW::getNumTrainingSamples(const uint32 classLabel) const {
+  const uint32 k = getTrainingClassIndex(classLabel);
+
+  return k < trainingClasses->size() ?
+         (uint32)(*trainingClasses)[k].samples.size() : 0;
+}
+
+uint32 DTW::getTrainingClassIndex(const uint32 classLabel) const {
+  uint32 k = 0;
+
+  while ((k < trainingClasses->size()) &&
+         ((*trainingClasses)[k].classLabel != classLabel)) k++;
+  return k;
+}
+
+bool DTW::haveTrainingRangesChanged(
+  const Vector<MatrixFloat>& removedSamples) const {
+  bool onLimit = false;
+
+  for (uint32 m = 0; m < removedSamples.size() && !onLimit; m++) {
+    const MatrixFloat& sample = removedSamples[m];
+
+    for (uint32 i = 0; i < sample.getNumRows() && !onLimit; i++) {
+      for (uint32 j = 0; j < numInputDimensions; j++) {
+        if ((sample[i][j] == ranges[j].minValue) ||
+            (sample[i][j] == ranges[j].maxValue)) {
+          onLimit = true;
+          break;
+        }
+      }
+    }
+  }
+
+  if (!onLimit) return false;
+
+  // Recompute the ranges from the kept samples
+  const Vector<DTWTrainingClass>& classes = *trainingClasses;
+  Vector<MinMax> classRanges(numInputDimensions);
+  bool first = true;
+
+  for (uint32 k = 0; k < classes.size(); k++) {
+    for (uint32 m = 0; m < classes[k].samples.size(); m++) {
+      const MatrixFloat& sample = classes[k].samples[m];
+
+      for (uint32 i = 0; i < sample.getNumRows(); i++) {
+        for (uint32 j = 0; j < numInputDimensions; j++) {
+          if (first) classRanges[j] = MinMax(sample[i][j], sample[i][j]);
+          else classRanges[j].updateMinMax(sample[i][j]);
+        }
+        first = false;
+      }
+    }
+  }
+
+  for (uint32 j = 0; j < numInputDimensions; j++) {
+    if ((classRanges[j].minValue != ranges[j].minValue) ||
+        (classRanges[j].maxValue != ranges[j].maxValue)) return true;
+  }
+  return false;
+}
+
+void DTW::updateTrainingClassTemplate(const uint32 k) {
+  const DTWTrainingClass& trainingClass = (*trainingClasses)[k];
+  DTWTemplate& dtwTemplate              = templatesBuffer[k];
+  const uint32 N                        = (uint32)trainingClass.samples.size();
+  uint32 bestIndex                      = 0;
+
+  // The template is the sample with the smallest average distance to the
+  // other samples, which is also the smallest row sum
+  for (uint32 m = 1; m < N; m++) {
+    if (trainingClass.rowSums[m] < trainingClass.rowSums[bestIndex]) {
+      bestIndex = m;
+    }
+  }
+
+  dtwTemplate.classLabel    = trainingClass.classLabel;
+  dtwTemplate.timeSeries    = trainingClass.timeSeries[bestIndex];
+  dtwTemplate.trainingMu    = 0.0;
+  dtwTemplate.trainingSigma = 0.0;
+
+  if (N > 2) {
+    dtwTemplate.trainingMu = (float)(trainingClass.rowSums[bestIndex] / (N - 1));
+
+    for (uint32 n = 0; n < N; n++) {
+      if (n != bestIndex) {
+        dtwTemplate.trainingSigma += SQR(
+          trainingClass.distances[bestIndex][n] - dtwTemplate.trainingMu);
+      }
+    }
+    dtwTemplate.trainingSigma =
+      sqrt(dtwTemplate.trainingSigma / float(N - 2));
+  }
+
+  // Set the average length of the training examples
+  float totalLength = 0;
+
+  for (uint32 m = 0; m < N; m++) {
+    totalLength += trainingClass.samples[m].getNumRows();
+  }
+  dtwTemplate.averageTemplateLength = (uint32)(totalLength / float(N));
+}
+
+void DTW::finishIncrementalUpdate() {
+  const uint32 previousTemplateLength = averageTemplateLength;
+
+  numClasses            = (uint32)trainingClasses->size();
+  numTemplates          = (uint32)trainingClasses->size();
+  averageTemplateLength = 0;
+
+  for (uint32 k = 0; k < numTemplates; k++) {
+    averageTemplateLength += templatesBuffer[k].averageTemplateLength;
+  }
+  averageTemplateLength = averageTemplateLength / numTemplates;
+
+  recomputeNullRejectionThresholds();
+  updateTemplateViews();
+  classLikelihoods.resize(numTemplates, DEFAULT_NULL_LIKELIHOOD_VALUE);
+  classDistances.resize(numTemplates, 0);
+
+  // The realtime input is only cleared if the window length has changed
+  if (averageTemplateLength != previousTemplateLength) resizeInputBuffers();
+}
+
+bool DTW::retrainTrainingClasses() {
+  // The kept samples have already been trimmed
+  const Vector<DTWTrainingClass>& classes = *trainingClasses;
+  ContiguousTimeSeriesClassificationData data(numInputDimensions);
+
+  for (uint32 k = 0; k < classes.size(); k++) {
+    for (uint32 m = 0; m < classes[k].samples.size(); m++) {
+      data.addSample(classes[k].classLabel, classes[k].samples[m]);
+    }
+  }
+
+  return trainTrimmedData(data, useDistanceCache ? data.getHash() : 0);
+}
+
 void DTW::offsetTimeseries(MatrixFloat& timeseries) {
+  offsetTimeseries(timeseries, timeseries);
+}
+
+void DTW::offsetTimeseries(const MatrixView& timeseries,
+                           MatrixFloat     & offsetData) {
+  const uint32 R = timeseries.getNumRows();
+  const uint32 C = timeseries.getNumCols();
+
+  if (R == 0) return;
+
+  // Copy the first row before writing, offsetData may point to the same data
   VectorFloat firstRow = timeseries.getRow(0);
 
-  for (uint32 i = 0; i < timeseries.getNumRows(); i++) {
-    for (uint32 j = 0; j < timeseries.getNumCols(); j++) {
-      timeseries[i][j] -= firstRow[j];
+  if ((offsetData.getNumRows() != R) || (offsetData.getNumCols() != C)) {
+    offsetData.resize(R, C);
+  }
+
+  for (uint32 i = 0; i < R; i++) {
+    for (uint32 j = 0; j < C; j++) {
+      offsetData[i][j] = timeseries[i][j] - firstRow[j];
     }
   }
 }
@@ -1839,9 +4291,8 @@ bool DTW::loadLegacyModelFromFile(std::fstream& file) {
 
   // Resize the prediction results to make sure it is setup for realtime
   // prediction
-  continuousInputDataBuffer.clear();
-  continuousInputDataBuffer.resize(averageTemplateLength,
-                                   VectorFloat(numInputDimensions, 0));
+  updateTemplateViews();
+  resizeInputBuffers();
   maxLikelihood = DEFAULT_NULL_LIKELIHOOD_VALUE;
   bestDistance  = DEFAULT_NULL_DISTANCE_VALUE;
   classLikelihoods.resize(numClasses, DEFAULT_NULL_LIKELIHOOD_VALUE);
@@ -2,8 +2,14 @@
 
 #include "../GRT.h"
 #include "../Core/Classifier.h"
+#include "../Types/MatrixView.h"
 #include "../Utility/TimeSeriesClassificationSampleTrimmer.h"
-#include "../Utility/CircularBuffer.h"
+#include "../Utility/TimeSeriesCircularBuffer.h"
+#include "../Utility/RunningStatistics.h"
+#include "../Utility/MotionEnergyGate.h"
+#include "../Utility/MappedFile.h"
+#include "../Utility/SharedCopyOnWrite.h"
+#include "DTWDistanceCache.h"
 
 namespace GRT {
 class GRT_API IndexDist {
@@ -54,6 +60,77 @@ public:
                                 // train this template
 };
 
+///////////////// DTW Detection /////////////////
+class GRT_API DTWDetection {
+public:
+
+  DTWDetection(uint32 classLabel = 0, uint32 sampleIndex = 0,
+               uint64 streamIndex = 0, float maxLikelihood = 0,
+               float bestDistance = 0, float templateProgress = 1,
+               bool early = false) {
+    this->classLabel       = classLabel;
+    this->sampleIndex      = sampleIndex;
+    this->streamIndex      = streamIndex;
+    this->maxLikelihood    = maxLikelihood;
+    this->bestDistance     = bestDistance;
+    this->templateProgress = templateProgress;
+    this->early            = early;
+  }
+
+  ~DTWDetection() {}
+
+  uint32 classLabel;      // The predicted class label
+  uint32 sampleIndex;     // The row of the block the prediction was made at
+  uint64 streamIndex;     // The index of that sample in the whole input stream
+  float maxLikelihood;    // The likelihood of the predicted class, or for an
+                          // early detection its margin over the next class
+  float bestDistance;     // The distance of the closest template, or for an
+                          // early detection its prefix cost per sample
+  float templateProgress; // The fraction of the template that was matched
+  bool early;             // True if this is an early detection
+};
+
+///////////////// DTW Open End Match /////////////////
+class GRT_API DTWOpenEndMatch {
+public:
+
+  DTWOpenEndMatch() {
+    bestCost     = INFINITY;
+    bestProgress = 0;
+    bestStart    = 0;
+  }
+
+  ~DTWOpenEndMatch() {}
+
+  VectorFloat costs;     // The cost of the best path ending at each row of the
+                         // template with the newest input sample
+  Vector<uint32> lengths; // The number of input samples on each path
+  Vector<uint64> starts; // The input sample each path started at
+  float bestCost;        // The smallest cost per input sample of the prefixes
+                         // that are long enough to be scored
+  float bestProgress;    // The fraction of the template matched by that prefix
+  uint64 bestStart;      // The input sample that prefix started at
+};
+
+///////////////// DTW Training Class /////////////////
+class GRT_API DTWTrainingClass {
+public:
+
+  DTWTrainingClass() {
+    classLabel = 0;
+  }
+
+  ~DTWTrainingClass() {}
+
+  uint32 classLabel;              // The class of the training samples
+  Vector<MatrixFloat> samples;    // The trimmed training samples
+  Vector<MatrixFloat> timeSeries; // The samples after they have been scaled,
+                                  // z-normalized, smoothed and offset
+  MatrixFloat distances;          // The distances between the time series,
+                                  // [m][n] is sample n to template m
+  Vector<double> rowSums;         // The sum of each row of distances
+};
+
 /**
    @brief This class implements Dynamic Time Warping.  Dynamic Time Warping
       (DTW) is a powerful classifier that
@@ -91,6 +168,10 @@ public:
   enum DistanceMethods { ABSOLUTE_DIST = 0, EUCLIDEAN_DIST, NORM_ABSOLUTE_DIST };
   enum RejectionModes { TEMPLATE_THRESHOLDS = 0, CLASS_LIKELIHOODS,
                         THRESHOLDS_AND_LIKELIHOODS };
+  enum TemplateSelectionMethods { EXACT_TEMPLATE_SELECTION = 0,
+                                  SAMPLED_TEMPLATE_SELECTION };
+  enum PredictionSchedulingModes { FULL_PREDICTION = 0, TIME_SLICED_PREDICTION,
+                                   ROTATING_SUBSET_PREDICTION };
 
   /**
      Default Constructor
@@ -182,6 +263,18 @@ public:
    */
   virtual bool train_(TimeSeriesClassificationData& trainingData);
 
+  /**
+     This trains the DTW model straight from the arena of the labelled
+        timeseries classification data, so subsets of one dataset (such as
+        the folds of a cross validation) are trained without being copied.
+     The training data is not changed.
+     This overrides the train_ function in the MLBase class.
+
+     @param trainingData: a reference to the training data
+     @return returns true if the DTW model was trained, false otherwise
+   */
+  virtual bool train_(ContiguousTimeSeriesClassificationData& trainingData);
+
   /**
      This predicts the class of the inputVector.
      This overrides the predict function in the Classifier base class.
@@ -200,6 +293,263 @@ public:
    */
   virtual bool predict_(MatrixFloat& timeSeries);
 
+  /**
+     This predicts the class of the timeseries without copying it.  The view
+        can point to a MatrixFloat, a window of a TimeSeriesCircularBuffer or a
+        sub-range of a larger recording.
+     This overrides the predict function in the MLBase base class.
+
+     @param timeSeries: a view of the input timeseries to classify
+     @return returns true if the prediction was performed, false otherwise
+   */
+  virtual bool predict_(const MatrixView& timeSeries);
+
+  /**
+     Adds a block of samples to the realtime input, which gives the same
+        predictions as calling predict with each sample of the block but only
+        evaluates the templates at a few of them.  This avoids the cost of a
+        predict call per sample for high rate sensors.
+
+     If stride is 0, the templates are evaluated once, at the last sample of
+        the block.  Otherwise they are evaluated every stride samples, counted
+        over all the calls.  The templates are not evaluated again until the
+        input window has moved on (e.g. with smoothing, until the next
+        smoothed sample).  The prediction scheduling set with
+        setPredictionScheduling is used for each evaluation.  If motion
+        gating is enabled, the templates are also evaluated at the sample
+        that closes each segment of motion.
+
+     @param block: the [numSamples numInputDimensions] samples, oldest first
+     @param detections: returns an event for each evaluation that predicted a
+        class other than the null class
+     @param stride: the number of samples between evaluations, or 0 to
+        evaluate once per block
+     @param segments: if not NULL, returns the segments of motion that ended
+        in the block, see enableMotionGating
+     @return returns true if the samples were added, false otherwise
+   */
+  bool pushSamples(const MatrixView      & block,
+                   Vector<DTWDetection>  & detections,
+                   const uint32            stride = 0,
+                   Vector<MotionSegment> *segments = NULL);
+
+  /**
+     Gets the number of samples added to the realtime input since the model
+        was trained or reset.
+
+     @return returns the number of samples
+   */
+  uint64 getNumStreamSamples() const {
+    return numStreamSamples;
+  }
+
+  /**
+     Sets if the realtime prediction should also try to classify gestures
+        before they have finished, with an open-end DTW.
+
+     Each new input sample (or smoothed sample) extends a match with every
+        template that can start at any input sample and end at any row of the
+        template, so the cost of the best matching prefix of each template is
+        known as the gesture is performed.  Each input sample can move the
+        match 0, 1 or 2 rows along the template, and the cost of a match is
+        its distance per input sample.  An early decision is made as soon as
+        the best class's cost is below (1 - margin) times the cost of the next
+        best class, using only prefixes that cover at least
+        minTemplateProgress of their template.  A new early decision can only
+        come from a match that started after the last one.
+
+     The early decision is made as well as the normal prediction; it is read
+        with getEarlyClassLabel, and pushSamples returns it as an early
+        DTWDetection.  This needs a model trained without z-normalization or
+        offsetting by the first sample, as those depend on the whole window.
+        Use computeEarlyClassificationCurve to choose the margin.
+
+     @param useEarlyClassification: if true then early decisions are made
+     @param margin: how far ahead of the next class the best class must be,
+        in the range [0 1)
+     @param minTemplateProgress: the smallest fraction of a template that can
+        be scored, in the range (0 1]
+     @param maxMatchCost: if greater than zero, the largest cost per sample
+        an early decision can have
+     @return returns true if early classification was updated successfully,
+        false otherwise
+   */
+  bool enableEarlyClassification(bool  useEarlyClassification,
+                                 float margin = 0.25,
+                                 float minTemplateProgress = 0.3,
+                                 float maxMatchCost = 0);
+
+  /**
+     Gets if early classification is enabled.
+
+     @return returns true if early decisions are made, false otherwise
+   */
+  bool getEarlyClassificationEnabled() const {
+    return useEarlyClassification;
+  }
+
+  /**
+     Gets the class label of the early decision made at the newest input
+        sample.
+
+     @return returns the class label, or 0 if no early decision was made
+   */
+  uint32 getEarlyClassLabel() const {
+    return earlyClassLabel;
+  }
+
+  /**
+     Gets the fraction of the template that had been matched when the early
+        decision at the newest input sample was made.
+
+     @return returns the fraction of the template, in the range (0 1]
+   */
+  float getEarlyTemplateProgress() const {
+    return earlyTemplateProgress;
+  }
+
+  /**
+     Gets the open-end match of each template, its bestCost and bestProgress
+        can be used to follow the confidence of each template as a gesture is
+        performed.
+
+     @return returns the match of each template
+   */
+  const Vector<DTWOpenEndMatch>& getOpenEndMatches() const {
+    return openEndMatches;
+  }
+
+  /**
+     Measures how early classification trades accuracy for latency.  Each
+        time series of the data is fed to the open-end DTW on its own, and the
+        first early decision is kept for each margin.  The data should not be
+        the data the model was trained on.
+
+     @param data: the labelled gestures to test
+     @param margins: the margins to test, see enableEarlyClassification
+     @param accuracies: returns the ratio of early decisions that were
+        correct for each margin
+     @param decisionRates: returns the ratio of the time series that got an
+        early decision for each margin
+     @param observedFractions: returns the average fraction of the time
+        series that had been seen when the decision was made, for each margin
+     @return returns true if the curve was computed, false otherwise
+   */
+  bool computeEarlyClassificationCurve(
+    const TimeSeriesClassificationData& data,
+    const VectorFloat                 & margins,
+    VectorFloat                       & accuracies,
+    VectorFloat                       & decisionRates,
+    VectorFloat                       & observedFractions) const;
+
+  /**
+     Sets if the realtime prediction should only evaluate the templates while
+        the input is moving.
+
+     A MotionEnergyGate follows the motion energy of the input, the mean
+        absolute change of the input per sample over the dimensions (as used
+        to trim the training data), in O(numInputDimensions) per sample.
+        While the gate is closed the input is still buffered but the templates
+        are not evaluated, the prediction is the null class.  A segment of
+        motion opens the gate and it is closed stopDelay + 1 samples after
+        the motion stops, the templates are evaluated a last time at that
+        sample.  Early classification is gated in the same way.
+
+     Each segment that ends is returned by pushSamples, or can be read with
+        getMotionSegment when getMotionSegmentEnded is true, with the most
+        likely class predicted while it was open.
+
+     @param useMotionGating: if true then the prediction is gated
+     @param startThreshold: the energy above which a segment starts, in the
+        units of the input before scaling
+     @param stopThreshold: the energy below which a segment can end, 0 uses
+        half of startThreshold
+     @param stopDelay: the number of samples the templates are still
+        evaluated after the motion stops
+     @param energyWindow: the time constant in samples of the smoothing of
+        the energy
+     @param minSegmentLength: segments of motion shorter than this are not
+        returned
+     @param maxSegmentLength: if greater than zero, segments of motion are
+        split at this length
+     @return returns true if motion gating was updated successfully, false
+        otherwise
+   */
+  bool enableMotionGating(bool   useMotionGating,
+                          float  startThreshold,
+                          float  stopThreshold = 0,
+                          uint32 stopDelay = 10,
+                          uint32 energyWindow = 4,
+                          uint32 minSegmentLength = 0,
+                          uint32 maxSegmentLength = 0);
+
+  /**
+     Gets if motion gating is enabled.
+
+     @return returns true if the prediction is gated, false otherwise
+   */
+  bool getMotionGatingEnabled() const {
+    return useMotionGating;
+  }
+
+  /**
+     Gets if the motion gate is open at the newest input sample.
+
+     @return returns true if the templates are being evaluated, false if the
+        input is idle or motion gating is disabled
+   */
+  bool getMotionGateActive() const {
+    return useMotionGating && motionGate.getActive();
+  }
+
+  /**
+     Gets the smoothed motion energy of the newest input sample.
+
+     @return returns the energy, 0 if motion gating is disabled
+   */
+  float getMotionEnergy() const {
+    return useMotionGating ? motionGate.getEnergy() : 0;
+  }
+
+  /**
+     Returns true if a segment of motion ended at the newest input sample.
+
+     @return returns true if getMotionSegment holds a new segment
+   */
+  bool getMotionSegmentEnded() const {
+    return (motionGateEvent == MotionEnergyGate::SEGMENT_ENDED) ||
+           (motionGateEvent == MotionEnergyGate::SEGMENT_SPLIT);
+  }
+
+  /**
+     Gets the last segment of motion that ended.
+
+     @return returns the segment
+   */
+  const MotionSegment& getMotionSegment() const {
+    return lastMotionSegment;
+  }
+
+  /**
+     Gets the number of realtime predictions the templates were evaluated
+        for, since the realtime input was last reset.
+
+     @return returns the number of evaluated predictions
+   */
+  uint64 getNumEvaluatedPredictions() const {
+    return numEvaluatedPredictions;
+  }
+
+  /**
+     Gets the number of realtime predictions that were skipped because the
+        motion gate was closed, since the realtime input was last reset.
+
+     @return returns the number of skipped predictions
+   */
+  uint64 getNumSkippedPredictions() const {
+    return numSkippedPredictions;
+  }
+
   /**
      This resets the DTW classifier.
 
@@ -236,6 +586,38 @@ public:
    */
   virtual bool load(std::fstream& file);
 
+  /**
+     This loads a trained DTW model from a file, which can either be a binary
+        model written by saveBinary or a text model.
+     This overrides the load function in the MLBase class.
+
+     @param filename: the name of the file to load the model from
+     @return returns true if the model was loaded successfully, false otherwise
+   */
+  virtual bool load(const FString& filename);
+
+  /**
+     This saves the DTW model to a binary file.  The file holds a header, the
+        model settings, a table of templates and the template data, with every
+        section aligned so the file can be memory mapped by loadBinary.  The
+        text format written by save should still be used for exporting models.
+
+     @param filename: the name of the file to save the model to
+     @return returns true if the model was saved successfully, false otherwise
+   */
+  bool saveBinary(const FString& filename) const;
+
+  /**
+     This loads a DTW model from a binary file written by saveBinary.  The
+        file is memory mapped and the templates are used in place, so nothing
+        is parsed or copied.  The file stays mapped until the model is cleared,
+        retrained or loaded again.
+
+     @param filename: the name of the file to load the model from
+     @return returns true if the model was loaded successfully, false otherwise
+   */
+  bool loadBinary(const FString& filename);
+
   /**
      This recomputes the null rejection thresholds for each of the classes in
         the DTW model.
@@ -299,6 +681,15 @@ public:
    */
   bool   setContrainWarpingPath(bool constrain);
 
+  /**
+     Gets if the warping path is constrained, see setContrainWarpingPath.
+
+     @return returns true if the warping path is constrained
+   */
+  bool   getConstrainWarpingPath() const {
+    return constrainWarpingPath;
+  }
+
   /**
      Sets the warping radius, this is used to constrain the warping path within
         a specific radius from the main diagonal of the cost matrix.
@@ -321,6 +712,130 @@ public:
     return rejectionMode;
   }
 
+  /**
+     Sets how the template of each class is chosen.  The template is the
+        sample with the smallest average distance to the other samples of its
+        class.  EXACT_TEMPLATE_SELECTION finds it by running DTW on every pair
+        of samples in the class, which is quadratic in the class size.
+
+     SAMPLED_TEMPLATE_SELECTION estimates the average distance of every sample
+        from its distances to numReferenceSamples random samples of the class.
+        Only the samples whose estimate could still be the smallest (within
+        three standard errors of the best one), up to maxNumCandidates of
+        them, are then compared with the whole class, and the best of those is
+        used.  This runs DTW about (numReferenceSamples + maxNumCandidates)
+        times per sample, so training grows linearly with the class size, but
+        the template may not be the exact one.  The mean and standard
+        deviation used for the null rejection threshold are always exact for
+        the chosen template.
+
+     Classes that are too small to save any time, and models that use the
+        distance cache or incremental training (which need all the distances),
+        always use the exact selection.
+
+     @param templateSelectionMethod: one of the TemplateSelectionMethods enums
+     @param numReferenceSamples: the number of random samples used to estimate
+        the average distances, must be at least 2
+     @param maxNumCandidates: the maximum number of samples compared with the
+        whole class, must be at least 1
+     @param seed: the seed used to choose the random samples
+     @return returns true if the template selection was updated successfully,
+        false otherwise
+   */
+  bool setTemplateSelectionMethod(uint32 templateSelectionMethod,
+                                  uint32 numReferenceSamples = 64,
+                                  uint32 maxNumCandidates = 32,
+                                  uint32 seed = 0);
+
+  /**
+     Gets the method used to choose the template of each class.
+
+     @return returns one of the TemplateSelectionMethods enums
+   */
+  uint32 getTemplateSelectionMethod() const {
+    return templateSelectionMethod;
+  }
+
+  /**
+     Sets how the realtime prediction (predict with a VectorFloat) evaluates
+        the templates, so a prediction with many templates can be kept within
+        a fixed time per call.
+
+     FULL_PREDICTION (the default) evaluates every template on every call.
+
+     TIME_SLICED_PREDICTION takes a copy of the input window and evaluates its
+        templates over as many calls as needed, spending at most
+        budgetMicroseconds per call.  The prediction is updated once all the
+        templates of the window have been evaluated, then the next pass starts
+        on the newest window.
+
+     ROTATING_SUBSET_PREDICTION evaluates as many templates as fit in the
+        budget on the newest window each call, and predicts from the newest
+        distance of every template.  Any template that has not been evaluated
+        for numTemplates calls is evaluated first, oldest first, so every
+        distance is refreshed in turn even if it is never a likely winner.
+
+     In both modes the templates are evaluated in order of a lower bound of
+        their distance to the window (from its first and last samples), so
+        the templates most likely to win are evaluated first.  The time of
+        the next template is estimated from the templates already evaluated,
+        and a call stops before it would go over the budget.  At least one
+        template is evaluated per call, so the budget should be larger than
+        the time of one template.  getPredictionAge reports how old the
+        prediction is.
+
+     @param predictionSchedulingMode: one of the PredictionSchedulingModes
+        enums
+     @param budgetMicroseconds: the time each call can spend evaluating
+        templates, must be greater than zero
+     @return returns true if the scheduling was updated successfully, false
+        otherwise
+   */
+  bool setPredictionScheduling(uint32 predictionSchedulingMode,
+                               float  budgetMicroseconds = 500);
+
+  /**
+     Gets how the realtime prediction evaluates the templates.
+
+     @return returns one of the PredictionSchedulingModes enums
+   */
+  uint32 getPredictionSchedulingMode() const {
+    return predictionSchedulingMode;
+  }
+
+  /**
+     Gets the time each realtime prediction can spend evaluating templates.
+
+     @return returns the budget in microseconds
+   */
+  float getPredictionBudget() const {
+    return predictionBudget;
+  }
+
+  /**
+     Gets the age of the last realtime prediction, which is the number of
+        input windows since the oldest window any of its distances was
+        computed on.  This is always zero with FULL_PREDICTION.
+
+     @return returns the age of the prediction in windows
+   */
+  uint32 getPredictionAge() const {
+    return predictionAge;
+  }
+
+  /**
+     Returns true if the last realtime prediction is out of date, because it
+        was made on an older window than the newest input, or if no
+        prediction has been made yet with TIME_SLICED_PREDICTION or
+        ROTATING_SUBSET_PREDICTION.
+
+     @return returns true if the prediction is stale, false otherwise
+   */
+  bool getPredictionIsStale() const {
+    return (predictionSchedulingMode != FULL_PREDICTION) &&
+           (!scheduledPredictionReady || predictionAge > 0);
+  }
+
   /**
      Sets if z-normalization should be used for both training and realtime
         prediction.  This should be called before training the templates.
@@ -335,6 +850,40 @@ public:
   bool enableZNormalization(bool useZNormalization,
                             bool constrainZNorm = true);
 
+  /**
+     Sets the threshold used when z-normalization is constrained.  If the
+        std-dev of a dimension is below this threshold then the dimension is
+        only offset by its mean, instead of being divided by the std-dev.
+
+     @param zNormConstrainThreshold: the new threshold, must be >= 0
+     @return returns true if the threshold was updated successfully, false
+        otherwise
+   */
+  bool setZNormConstrainThreshold(float zNormConstrainThreshold);
+
+  /**
+     Gets if z-normalization is constrained, see enableZNormalization.
+
+     @return returns true if z-normalization is constrained
+   */
+  bool getConstrainZNorm() const {
+    return constrainZNorm;
+  }
+
+  /**
+     Sets if the training and prediction data should be smoothed (i.e.
+        averaged and downsampled).  This should be called before training the
+        templates.
+
+     @param useSmoothing: if true then the data will be smoothed
+     @param smoothingFactor: the number of samples averaged into each smoothed
+        sample, must be greater than 0
+     @return returns true if smoothing was updated successfully, false
+        otherwise
+   */
+  bool enableSmoothing(bool   useSmoothing,
+                       uint32 smoothingFactor = 5);
+
   /**
      Sets if the training data should be trimmed before training the DTW
         templates.  If set to true then any training samples that have very
@@ -370,15 +919,167 @@ public:
                               float trimThreshold,
                               float maximumTrimPercentage);
 
+  /**
+     Sets if the pairwise DTW distances between the training samples should be
+        kept in a distance cache.  Training computes the distances between the
+        samples of each class anyway, so keeping them costs no extra DTW runs.
+        If the model is retrained on the same dataset with the same
+        preprocessing and warping settings (for example after changing the
+        null rejection settings), the cached distances are used and no DTW is
+        run at all.
+
+     The distances between samples of different classes are needed for
+        computeLeaveOneOutAccuracy and computeRejectionCurve.  Computing them
+        makes training run DTW on every pair of samples instead of only the
+        pairs in the same class, so they are only computed if
+        includeInterClassDistances is true.
+
+     @param useDistanceCache: if true the distances are kept and reused
+     @param includeInterClassDistances: if true the distances between samples
+        of different classes are also computed
+     @return returns true if the distance cache settings were updated
+   */
+  bool enableDistanceCache(bool useDistanceCache,
+                           bool includeInterClassDistances = false);
+
+  /**
+     Gets the distance cache filled by the last training, which can be saved
+        with DTWDistanceCache::save.
+
+     @return returns the distance cache
+   */
+  const DTWDistanceCache& getDistanceCache() const {
+    return *distanceCache;
+  }
+
+  /**
+     Sets the distance cache, for example one loaded with
+        DTWDistanceCache::load.  The cache is only used by train if it matches
+        the training dataset and the settings of this model, so training on
+        different data recomputes it.
+
+     @param distanceCache: the new distance cache
+     @return returns true if the distance cache was set
+   */
+  bool setDistanceCache(const DTWDistanceCache& distanceCache);
+
+  /**
+     Sets if the model should keep its training samples and the distances
+        between them, so samples can be added or removed without retraining
+        the whole model.  This should be called before training.
+
+     @param useIncrementalTraining: if true the training samples and their
+        distances are kept by train
+     @return returns true if the setting was updated
+   */
+  bool enableIncrementalTraining(bool useIncrementalTraining);
+
+  /**
+     Adds a training sample to a model trained with incremental training
+        enabled, and updates the template of its class.  Only the DTW
+        distances between the new sample and the other samples of its class
+        are computed, the other templates are not changed.  A sample with a
+        new class label adds a new template, which like train needs null
+        rejection to be disabled as the class only has 1 example.
+
+     If scaling is enabled and the sample is outside the ranges of the
+        training data, the scaling of every sample changes and the whole model
+        is retrained from the kept samples.  The realtime input buffer is only
+        cleared if the average template length changes.  The distance cache no
+        longer matches the training samples, so it is cleared unless the model
+        is retrained.
+
+     @param classLabel: the class label of the sample
+     @param sample: the training sample
+     @return returns true if the sample was added, false otherwise
+   */
+  bool addTrainingSample(const uint32       classLabel,
+                         const MatrixFloat& sample);
+
+  /**
+     Removes a training sample from a model trained with incremental training
+        enabled, and updates the template of its class.  No DTW distances are
+        computed, unless scaling is enabled and removing the sample changes the
+        ranges of the training data, in which case the whole model is
+        retrained.  Like addTrainingSample, this clears the distance cache
+        unless the model is retrained.
+
+     @param classLabel: the class label of the sample
+     @param sampleIndex: the index of the sample within its class, in the
+        order the samples were added
+     @return returns true if the sample was removed, false otherwise
+   */
+  bool removeTrainingSample(const uint32 classLabel,
+                            const uint32 sampleIndex);
+
+  /**
+     Removes all the training samples of a class, and its template, from a
+        model trained with incremental training enabled.  Like
+        addTrainingSample, this clears the distance cache unless the model is
+        retrained.
+
+     @param classLabel: the class label to remove
+     @return returns true if the class was removed, false otherwise
+   */
+  bool removeTrainingClass(const uint32 classLabel);
+
+  /**
+     Gets the number of training samples kept for a class.
+
+     @param classLabel: the class label
+     @return returns the number of samples kept for the class, or 0 if there
+        are none
+   */
+  uint32 getNumTrainingSamples(const uint32 classLabel) const;
+
+  /**
+     Computes the leave-one-out accuracy from the distance cache, without
+        running DTW.  Each sample is classified by templates chosen from all
+        the other samples, using the current null rejection settings, so this
+        can be called after changing the null rejection coefficient, the
+        rejection mode or the likelihood threshold to see their effect.  The
+        model must have been trained with the distance cache and the inter
+        class distances enabled, and the preprocessing and warping settings
+        must not have changed since.
+
+     @param accuracy: returns the ratio of correctly classified samples, [0 1]
+     @param predictedClassLabels: returns the predicted class label of each
+        training sample (after trimming)
+     @return returns true if the accuracy was computed, false otherwise
+   */
+  bool computeLeaveOneOutAccuracy(float         & accuracy,
+                                  Vector<uint32>& predictedClassLabels) const;
+
+  /**
+     Computes the receiver operating characteristic of the template
+        thresholds from the distance cache, without running DTW.  For each
+        null rejection coefficient, every template is tested against every
+        training sample (using leave-one-out templates): the true positive rate
+        is the ratio of samples of the template's class that are within the
+        template's threshold, and the false positive rate is the ratio of
+        samples of the other classes that are within it.  The model must have
+        been trained with the distance cache and the inter class distances
+        enabled, and the preprocessing and warping settings must not have
+        changed since.
+
+     @param nullRejectionCoeffs: the null rejection coefficients to test
+     @param truePositiveRates: returns the true positive rate of each
+        coefficient
+     @param falsePositiveRates: returns the false positive rate of each
+        coefficient
+     @return returns true if the curve was computed, false otherwise
+   */
+  bool computeRejectionCurve(const VectorFloat& nullRejectionCoeffs,
+                             VectorFloat      & truePositiveRates,
+                             VectorFloat      & falsePositiveRates) const;
+
   /**
      Gets the DTW models.
 
      @return returns a vector of DTW templates, or an empty vector if no model
         has been trained.
    */
-  Vector<DTWTemplate>getModels() const {
-    return templatesBuffer;
-  }
+  Vector<DTWTemplate>getModels() const;
 
   /**
      Sets the DTW models, overwriting any previous models. The size of the new
@@ -440,14 +1141,79 @@ public:
 
 protected:
 
-  // Public training and prediction methods
-  bool train_NDDTW(TimeSeriesClassificationData& trainingData,
-                   DTWTemplate                 & dtwTemplate,
-                   uint32                      & bestIndex);
+  /**
+     Trains the templates from training data that has already been trimmed.
+
+     @param data: the trimmed training data
+     @param datasetHash: the hash used to check the distance cache
+     @return returns true if the model was trained, false otherwise
+   */
+  bool trainTrimmedData(const ContiguousTimeSeriesClassificationData& data,
+                        const uint64                                  datasetHash);
+
+  /**
+     Finds the template of one class.
+
+     @param trainingData: the preprocessed samples of the class
+     @param sampleIndexs: the index of each sample of the class in the
+        training data, which is used to read the distance cache
+     @param dtwTemplate: returns the mean and standard deviation of the
+        distances to the template, and the average length of the samples
+     @param bestIndex: returns the index of the template in trainingData
+     @param distances: returns the distances between the samples, unless
+        the template was found with the sampled template selection
+     @return returns true if the template was found, false otherwise
+   */
+  bool train_NDDTW(const ContiguousTimeSeriesClassificationData& trainingData,
+                   const Vector<uint32>                        & sampleIndexs,
+                   DTWTemplate                                 & dtwTemplate,
+                   uint32                                      & bestIndex,
+                   MatrixFloat                                 & distances);
+
+  /**
+     Gets the index of the training class with a class label.
+
+     @param classLabel: the class label
+     @return returns the index of the class, or the number of classes if it
+        was not found
+   */
+  uint32 getTrainingClassIndex(const uint32 classLabel) const;
+
+  /**
+     Checks if removing training samples changed the ranges used to scale the
+        data.  The ranges can only change if a removed sample had a value on
+        one of their limits.
+
+     @param removedSamples: the samples that were removed
+     @return returns true if the ranges of the kept samples are different
+   */
+  bool haveTrainingRangesChanged(
+    const Vector<MatrixFloat>& removedSamples) const;
+
+  /**
+     Chooses the template of a training class from the row sums of its
+        distances and updates its mean and standard deviation.
+
+     @param k: the index of the training class
+   */
+  void updateTrainingClassTemplate(const uint32 k);
+
+  /**
+     Updates the model after the templates of the training classes have
+        changed.
+   */
+  void finishIncrementalUpdate();
+
+  /**
+     Retrains the whole model from the kept training samples.
+
+     @return returns true if the model was trained, false otherwise
+   */
+  bool retrainTrainingClasses();
 
   // The actual DTW function
-  float computeDistance(MatrixFloat      & timeSeriesA,
-                        MatrixFloat      & timeSeriesB,
+  float computeDistance(const MatrixView & timeSeriesA,
+                        const MatrixView & timeSeriesB,
                         MatrixFloat      & distanceMatrix,
                         Vector<IndexDist>& warpPath);
   float d(int          m,
@@ -460,26 +1226,381 @@ protected:
                     float c);
 
   // Scaling and Utility Functions
-  void scaleData(TimeSeriesClassificationData& trainingData);
-  void scaleData(MatrixFloat& data,
-                 MatrixFloat& scaledData);
-  void znormData(TimeSeriesClassificationData& trainingData);
-  void znormData(MatrixFloat& data,
-                 MatrixFloat& normData);
+  void normalizeData(const ContiguousTimeSeriesClassificationData& data,
+                     ContiguousTimeSeriesClassificationData      & normalizedData);
+  void scaleData(const MatrixView& data,
+                 MatrixFloat     & scaledData);
+  void znormData(const MatrixView& data,
+                 MatrixFloat     & normData);
   void smoothData(VectorFloat& data,
                   uint32       smoothFactor,
                   VectorFloat& resultsData);
-  void smoothData(MatrixFloat& data,
-                  uint32       smoothFactor,
-                  MatrixFloat& resultsData);
+  void smoothData(const MatrixView& data,
+                  uint32            smoothFactor,
+                  MatrixFloat     & resultsData);
   void offsetTimeseries(MatrixFloat& timeseries);
+  void offsetTimeseries(const MatrixView& timeseries,
+                        MatrixFloat     & offsetData);
+
+  /**
+     Smooths and offsets a scaled and z-normalized training sample, as is done
+        to each sample before it is compared with the other samples.
+
+     @param data: the training sample
+     @param timeSeries: returns the prepared time series
+   */
+  void prepareTrainingTimeSeries(const MatrixView& data,
+                                 MatrixFloat     & timeSeries);
+
+  /**
+     Gets a hash of the settings that change the distances between the
+        training samples, which is used to check the distance cache.
+
+     @return returns the hash of the settings
+   */
+  uint64 getDistanceSettingsHash() const;
+
+  /**
+     Computes the distance cache of the preprocessed training data.
+
+     @param trainingData: the trimmed, scaled and z-normalized training data
+     @param datasetHash: the hash of the training data before it was
+        preprocessed
+   */
+  void computeDistanceCache(
+    const ContiguousTimeSeriesClassificationData& trainingData,
+    const uint64                                  datasetHash);
+
+  /**
+     Finds the sample with the smallest average distance to the other samples
+        of a set, which is used as the template of the set, and the mean and
+        standard deviation of the distances of the other samples to it.
+
+     @param distances: the pairwise distances between the samples
+     @param indexs: the indexs of the samples of the set in distances
+     @param bestIndex: returns the position in indexs of the template
+     @param trainingMu: returns the mean distance to the template
+     @param trainingSigma: returns the standard deviation of the distance to
+        the template, this is zero if there are less than 3 samples
+   */
+  static void findBestTemplate(const MatrixFloat   & distances,
+                               const Vector<uint32>& indexs,
+                               uint32              & bestIndex,
+                               float               & trainingMu,
+                               float               & trainingSigma);
+
+  /**
+     Finds the template of a set of samples with SAMPLED_TEMPLATE_SELECTION,
+        see setTemplateSelectionMethod.  There should be more than
+        numReferenceSamples + maxNumCandidates samples.  If no sample has a
+        finite estimate of its average distance, the template is found by
+        comparing every sample with the whole class, like
+        EXACT_TEMPLATE_SELECTION.
+
+     @param timeSeries: the samples after they have been smoothed and offset
+     @param bestIndex: returns the index of the template
+     @param trainingMu: returns the mean distance to the template
+     @param trainingSigma: returns the standard deviation of the distance to
+        the template
+     @return returns true if the template was found, false if the training
+        was cancelled
+   */
+  bool findSampledTemplate(const Vector<MatrixFloat>& timeSeries,
+                           uint32                   & bestIndex,
+                           float                    & trainingMu,
+                           float                    & trainingSigma);
+
+  /**
+     Computes the distance of each cached sample to the template of each
+        class, with the sample left out of the templates, and the mean and
+        standard deviation used for the threshold of each template.  A
+        template that could not be made (because its class only has the left
+        out sample) has a distance of NAN.
+
+     @param templateLabels: returns the class label of each template
+     @param sampleDistances: returns the [numSamples numTemplates] distances
+     @param templateMus: returns the [numSamples numTemplates] means
+     @param templateSigmas: returns the [numSamples numTemplates] standard
+        deviations
+     @return returns true if the distances were computed, false otherwise
+   */
+  bool computeLeaveOneOutDistances(Vector<uint32>& templateLabels,
+                                   MatrixFloat   & sampleDistances,
+                                   MatrixFloat   & templateMus,
+                                   MatrixFloat   & templateSigmas) const;
+
+  /**
+     Applies the scaling, z-normalization, smoothing and offset stages enabled
+        in the model to the input in a single fused kernel.  The input is read
+        twice if z-normalization is enabled and once otherwise, and the result
+        is written directly into the output matrix.
+
+     @param input: the time series to preprocess
+     @param output: the matrix the preprocessed time series will be written to,
+        this is only resized if its size changes
+     @param inputStats: if not NULL, the statistics of the input which are
+        used instead of the z-normalization pass
+     @param smoothInput: if false then the input has already been smoothed
+        and the smoothing stage is skipped
+     @return returns true if the time series was preprocessed, false otherwise
+   */
+  bool preprocessTimeSeries(const MatrixView       & input,
+                            MatrixFloat            & output,
+                            const RunningStatistics *inputStats = NULL,
+                            const bool               smoothInput = true);
+
+  /**
+     Runs the prediction on the time series.  If inputStats is not NULL then
+        it should hold the statistics of the raw input, which saves the
+        z-normalization pass over the input.
+
+     @param inputTimeSeries: the time series to classify
+     @param inputStats: the running statistics of the input, or NULL
+     @param smoothInput: if false then the input has already been smoothed
+     @return returns true if the prediction was successful, false otherwise
+   */
+  bool predictTimeSeries(const MatrixView       & inputTimeSeries,
+                         const RunningStatistics *inputStats,
+                         const bool               smoothInput = true);
+
+  /**
+     Runs the realtime prediction on the input window with
+        TIME_SLICED_PREDICTION or ROTATING_SUBSET_PREDICTION, see
+        setPredictionScheduling.
+
+     @param inputTimeSeries: the newest input window
+     @param inputStats: the running statistics of the input, or NULL
+     @param smoothInput: if false then the input has already been smoothed
+     @return returns true if the prediction was successful, false otherwise
+   */
+  bool predictScheduled(const MatrixView       & inputTimeSeries,
+                        const RunningStatistics *inputStats,
+                        const bool               smoothInput);
+
+  /**
+     Applies the preprocessing enabled in the model to the input of a
+        prediction.
+
+     @param inputTimeSeries: the time series to preprocess
+     @param inputStats: the running statistics of the input, or NULL
+     @param smoothInput: if false then the input has already been smoothed
+     @param timeSeries: returns a view of the preprocessed time series, or of
+        the input if there is no preprocessing
+     @return returns true if the time series was preprocessed, false otherwise
+   */
+  bool preparePredictionInput(const MatrixView       & inputTimeSeries,
+                              const RunningStatistics *inputStats,
+                              const bool               smoothInput,
+                              MatrixView             & timeSeries);
+
+  /**
+     Sets the class likelihoods, the best distance and the predicted class
+        label from the distance of each template in classDistances.
+
+     @return returns true if the prediction was successful, false otherwise
+   */
+  bool updatePredictedClass();
+
+  /**
+     Computes a lower bound of the distance computeDistance returns for two
+        time series, from their first and last samples.
+
+     @param timeSeriesA: the first time series, e.g. a template
+     @param timeSeriesB: the second time series, e.g. the input window
+     @return returns the lower bound
+   */
+  float computeLowerBound(const MatrixView& timeSeriesA,
+                          const MatrixView& timeSeriesB) const;
+
+  /**
+     Computes the distance between two samples, as computeDistance does.
+
+     @param a: the first sample
+     @param b: the second sample
+     @param N: the length of the second time series, used by
+        NORM_ABSOLUTE_DIST
+     @return returns the distance
+   */
+  float computeSampleDistance(const float *a,
+                              const float *b,
+                              const uint32 N) const;
+
+  /**
+     Returns true if the realtime input is decimated by the smoothing.
+
+     @return returns true if the input is smoothed in blocks as it arrives
+   */
+  bool getDecimateInput() const;
+
+  /**
+     Clears the open-end match of every template.
+
+     @param matches: the matches to clear, resized to the templates
+   */
+  void resetOpenEndMatches(Vector<DTWOpenEndMatch>& matches) const;
+
+  /**
+     Applies the scaling of the model to one input sample, the other
+        preprocessing stages of the open-end DTW are applied by the caller.
+
+     @param input: the sample
+     @param output: returns the scaled sample
+   */
+  void scaleSample(const float *input,
+                   float       *output) const;
+
+  /**
+     Extends the open-end match of every template with a new input sample.
+
+     @param matches: the matches to update
+     @param sample: the sample, after smoothing and scaling
+     @param sampleIndex: the index of the sample in the input stream
+   */
+  void updateOpenEndMatches(Vector<DTWOpenEndMatch>& matches,
+                            const float             *sample,
+                            const uint64             sampleIndex) const;
+
+  /**
+     Finds the class whose open-end match is the best, and how far ahead of
+        the next class it is.
+
+     @param matches: the open-end matches
+     @param minStart: the best match must have started after this sample
+     @param classLabel: returns the class label of the best match
+     @param ratio: returns the cost of the best match over the cost of the
+        best match of any other class, 0 if there is no other class
+     @param cost: returns the cost of the best match
+     @param progress: returns the fraction of the template matched
+     @return returns true if there is a best match, false otherwise
+   */
+  bool findEarlyDecision(const Vector<DTWOpenEndMatch>& matches,
+                         const uint64                   minStart,
+                         uint32                       & classLabel,
+                         float                        & ratio,
+                         float                        & cost,
+                         float                        & progress) const;
+
+  /**
+     Sets the order scheduledOrder evaluates the templates in, from the lower
+        bound of each template to the time series.  If maxAge is greater than
+        zero, the templates whose distance is at least maxAge windows old are
+        put first, oldest first.
+
+     @param timeSeries: the preprocessed input window
+     @param maxAge: the age at which a template is evaluated first, or 0
+   */
+  void orderScheduledTemplates(const MatrixView& timeSeries,
+                               const uint64      maxAge);
+
+  /**
+     Clears the state of the scheduled realtime prediction.
+   */
+  void resetPredictionSchedule();
+
+  /**
+     Adds a sample to the realtime input buffers and statistics.
+
+     @param sample: the numInputDimensions values of the sample
+     @return returns true if the input window has moved on, false if the
+        sample is waiting in the current smoothing block
+   */
+  bool addStreamSample(const float *sample);
+
+  /**
+     Runs the realtime prediction on the current input window.
+
+     @return returns true if the prediction was successful, or if the window
+        is not full yet, false otherwise
+   */
+  bool predictStreamWindow();
+
+  /**
+     Copies the segment of motion that has just ended into lastMotionSegment,
+        with the class predicted while it was open.
+   */
+  void finishMotionSegment();
+
+  /**
+     Clears and resizes the buffers used for realtime prediction to match the
+        trained model.
+   */
+  void resizeInputBuffers();
+
+  /**
+     Points the template views at the time series in templatesBuffer.
+   */
+  void updateTemplateViews();
+
+  /**
+     Copies the data of any templates that rhs has mapped from a binary model
+        file into templatesBuffer, then updates the template views.  Should be
+        called after templatesBuffer has been copied from rhs.
+
+     @param rhs: the model templatesBuffer was copied from
+   */
+  void copyTemplateData(const DTW& rhs);
   bool loadLegacyModelFromFile(std::fstream& file);
 
   Vector<DTWTemplate> templatesBuffer; // A buffer to store the templates for
                                        // each time series
+  Vector<MatrixView> templateViews;    // The time series of each template,
+                                       // these point into templatesBuffer or
+                                       // into modelFile
+  MappedFile modelFile;                // The binary model file, if the model
+                                       // was loaded with loadBinary
+  // The distances between the training samples, if useDistanceCache is set,
+  // and the training samples of each template, if useIncrementalTraining is
+  // set.  Copies of the model share them until one of the copies changes them
+  SharedCopyOnWrite<DTWDistanceCache> distanceCache;
+  SharedCopyOnWrite<Vector<DTWTrainingClass> > trainingClasses;
   Vector<MatrixFloat> distanceMatrices;
   Vector<Vector<IndexDist> >  warpPaths;
-  CircularBuffer<VectorFloat> continuousInputDataBuffer;
+  MatrixFloat preprocessedTimeSeries;     // Workspace holding the preprocessed
+                                          // input of the last prediction
+  MatrixFloat preprocessingCoeffs;        // Per dimension coefficients used by
+                                          // preprocessTimeSeries
+  TimeSeriesCircularBuffer continuousInputDataBuffer;
+  RunningStatistics continuousInputStats; // Running statistics of the samples
+                                          // in continuousInputDataBuffer
+  TimeSeriesCircularBuffer smoothedInputDataBuffer; // The decimated input, only
+                                                    // used if smoothing is on
+  VectorFloat smoothingAccumulator;       // The sum of the inputs in the
+                                          // current smoothing block
+  uint32 numSamplesInSmoothingBlock;      // The number of inputs in the
+                                          // current smoothing block
+  uint64 numStreamSamples;                // See getNumStreamSamples
+  uint32 samplesSinceStreamPrediction;    // The number of samples pushed since
+                                          // pushSamples last predicted
+  bool streamWindowChanged;               // Set if the input window has moved
+                                          // on since pushSamples last predicted
+  Vector<DTWOpenEndMatch> openEndMatches; // The open-end match of each
+                                          // template
+  VectorFloat earlySample;                // Workspace holding the scaled input
+                                          // of the open-end DTW
+  uint64 lastEarlyDecisionSample;         // The input sample of the last early
+                                          // decision, 0 if there is none
+  uint32 earlyClassLabel;                 // See getEarlyClassLabel
+  float earlyTemplateProgress;            // See getEarlyTemplateProgress
+  float earlyMatchCost;                   // The cost of the match of the
+                                          // early decision at the newest sample
+  float earlyMatchMargin;                 // The margin of that match over the
+                                          // next class
+  float earlyMargin;                      // See enableEarlyClassification
+  float earlyMinTemplateProgress;         // See enableEarlyClassification
+  float earlyMaxMatchCost;                // See enableEarlyClassification
+  bool useEarlyClassification;            // A flag to check if early
+                                          // decisions should be made
+  MotionEnergyGate motionGate;            // Gates the realtime prediction by
+                                          // the motion of the input
+  MotionEnergyGate::GateEvents motionGateEvent; // The event of the newest
+                                                // input sample
+  MotionSegment motionSegment;            // The class predicted for the open
+                                          // segment of motion
+  MotionSegment lastMotionSegment;        // See getMotionSegment
+  uint64 numEvaluatedPredictions;         // See getNumEvaluatedPredictions
+  uint64 numSkippedPredictions;           // See getNumSkippedPredictions
+  bool useMotionGating;                   // A flag to check if the realtime
+                                          // prediction is gated by motion
   uint32 numTemplates;                    // The number of templates in our
                                           // buffer
   uint32 rejectionMode;                   // The rejection mode used to reject
@@ -503,6 +1624,15 @@ protected:
   bool trimTrainingData;                  // A flag to check if we need to trim
                                           // the training data first before
                                           // training
+  bool useDistanceCache;                  // A flag to check if the distances
+                                          // between the training samples
+                                          // should be cached
+  bool cacheInterClassDistances;          // A flag to check if the cache
+                                          // should hold the distances between
+                                          // samples of different classes
+  bool useIncrementalTraining;            // A flag to check if the training
+                                          // samples should be kept so the
+                                          // model can be updated
 
   float zNormConstrainThreshold;          // The threshold value to be used if
                                           // constrainZNorm is turned on
@@ -522,6 +1652,42 @@ protected:
                                           // (should be of enum DISTANCE_METHOD)
   uint32 averageTemplateLength;           // The overall average template length
                                           // (over all the templates)
+  uint32 templateSelectionMethod;         // The method used to choose the
+                                          // templates (should be of enum
+                                          // TemplateSelectionMethods)
+  uint32 numReferenceSamples;             // The number of samples used to
+                                          // estimate the average distances
+  uint32 maxNumCandidates;                // The maximum number of samples
+                                          // compared with the whole class
+  uint32 templateSelectionSeed;           // The seed of the reference samples
+  uint32 predictionSchedulingMode;        // How the realtime prediction
+                                          // evaluates the templates (should be
+                                          // of enum PredictionSchedulingModes)
+  float predictionBudget;                 // The time in microseconds each
+                                          // realtime prediction can spend
+                                          // evaluating templates
+
+  // The state of the scheduled realtime prediction
+  MatrixFloat scheduledTimeSeries;        // The window being evaluated with
+                                          // TIME_SLICED_PREDICTION
+  VectorFloat scheduledDistances;         // The newest distance of each
+                                          // template
+  VectorFloat scheduledLowerBounds;       // The lower bound of each template
+  Vector<uint64> scheduledWindows;        // The window the newest distance of
+                                          // each template was computed on
+  Vector<uint32> scheduledOrder;          // The order the templates are
+                                          // evaluated in
+  uint32 nextScheduledTemplate;           // The position in scheduledOrder of
+                                          // the next template to evaluate
+  uint64 numScheduledWindows;             // The number of input windows seen
+                                          // by the scheduled prediction
+  uint64 scheduledWindow;                 // The window being evaluated with
+                                          // TIME_SLICED_PREDICTION
+  double scheduledSecondsPerCell;         // The estimated time to compute one
+                                          // cell of a distance matrix
+  uint32 predictionAge;                   // See getPredictionAge
+  bool scheduledPredictionReady;          // Set once a scheduled prediction
+                                          // has been made
 
 private:
 
@@ -0,0 +1,160 @@
+﻿#include "../GRT.h"
+#include "DTWDistanceCache.h"
+#include "../Utility/MappedFile.h"
+#include <cstring>
+#include <fstream>
+
+namespace GRT {
+// The binary cache format (see DTWDistanceCache::save), a header followed by
+// the uint32 [numSamples] sample labels and the float [numSamples numSamples]
+// distances
+#define DTW_CACHE_MAGIC "GRTDTWC"
+#define DTW_CACHE_VERSION 1
+#define DTW_CACHE_BYTE_ORDER 0x01020304
+
+struct DTWCacheHeader {
+  char   magic[8];               // DTW_CACHE_MAGIC
+  uint32 version;                // DTW_CACHE_VERSION
+  uint32 byteOrder;              // DTW_CACHE_BYTE_ORDER as written by the saver
+  uint64 datasetHash;
+  uint64 settingsHash;
+  uint32 numSamples;
+  uint32 hasInterClassDistances;
+};
+
+static_assert(sizeof(DTWCacheHeader) == 40, "Unexpected DTWCacheHeader size");
+
+DTWDistanceCache::DTWDistanceCache() {
+  clear();
+}
+
+DTWDistanceCache::~DTWDistanceCache() {}
+
+void DTWDistanceCache::clear() {
+  datasetHash            = 0;
+  settingsHash           = 0;
+  hasInterClassDistances = false;
+  sampleLabels.clear();
+  distances.clear();
+}
+
+void DTWDistanceCache::reset(const uint64          datasetHash,
+                             const uint64          settingsHash,
+                             const Vector<uint32>& sampleLabels) {
+  const uint32 N = (uint32)sampleLabels.size();
+
+  this->datasetHash      = datasetHash;
+  this->settingsHash     = settingsHash;
+  this->sampleLabels     = sampleLabels;
+  hasInterClassDistances = false;
+  distances.clear();
+
+  if (N > 0) distances.resize(N, N, NAN);
+}
+
+bool DTWDistanceCache::isValid(const uint64 datasetHash,
+                               const uint64 settingsHash) const {
+  return (getNumSamples() > 0) && (this->datasetHash == datasetHash) &&
+         (this->settingsHash == settingsHash);
+}
+
+bool DTWDistanceCache::save(const FString& filename) const {
+  std::fstream file;
+
+  file.open(TCHAR_TO_UTF8(*filename),
+            std::ios::out | std::ios::binary | std::ios::trunc);
+
+  if (!file.is_open()) {
+    UE_LOG(GRTModule, Error, TEXT(
+             "%s::%s::%d  Could not open file to save data"), *FString(
+             __FILENAME__), *FString(__FUNCTION__), __LINE__);
+    return false;
+  }
+
+  const uint32 N = getNumSamples();
+
+  DTWCacheHeader header;
+  memset(&header, 0, sizeof(header));
+  memcpy(header.magic, DTW_CACHE_MAGIC, sizeof(header.magic));
+  header.version                = DTW_CACHE_VERSION;
+  header.byteOrder              = DTW_CACHE_BYTE_ORDER;
+  header.datasetHash            = datasetHash;
+  header.settingsHash           = settingsHash;
+  header.numSamples             = N;
+  header.hasInterClassDistances = hasInterClassDistances;
+
+  file.write((const char *)&header, sizeof(header));
+
+  if (N > 0) {
+    file.write((const char *)&sampleLabels[0], sizeof(uint32) * N);
+    file.write((const char *)distances.getData(), sizeof(float) * N * N);
+  }
+
+  const bool saved = !file.fail();
+  file.close();
+
+  if (!saved) {
+    UE_LOG(GRTModule, Error, TEXT(
+             "%s::%s::%d  Failed to write the distance cache!"), *FString(
+             __FILENAME__), *FString(__FUNCTION__), __LINE__);
+  }
+  return saved;
+}
+
+bool DTWDistanceCache::load(const FString& filename) {
+  clear();
+
+  MappedFile file;
+
+  if (!file.open(filename)) {
+    UE_LOG(GRTModule, Error, TEXT(
+             "%s::%s::%d  Could not open file to load data"), *FString(
+             __FILENAME__), *FString(__FUNCTION__), __LINE__);
+    return false;
+  }
+
+  DTWCacheHeader header;
+
+  if (file.getSize() < sizeof(header)) {
+    UE_LOG(GRTModule, Error, TEXT(
+             "%s::%s::%d  The file is too small to be a distance cache!"),
+           *FString(__FILENAME__), *FString(__FUNCTION__), __LINE__);
+    return false;
+  }
+  memcpy(&header, file.getData(), sizeof(header));
+
+  if ((memcmp(header.magic, DTW_CACHE_MAGIC, sizeof(header.magic)) != 0) ||
+      (header.version != DTW_CACHE_VERSION) ||
+      (header.byteOrder != DTW_CACHE_BYTE_ORDER)) {
+    UE_LOG(GRTModule, Error, TEXT(
+             "%s::%s::%d  The file is not a distance cache, or was written on a machine with a different byte order!"),
+           *FString(__FILENAME__), *FString(__FUNCTION__), __LINE__);
+    return false;
+  }
+
+  const uint64 N = header.numSamples;
+
+  if (file.getSize() != sizeof(header) + sizeof(uint32) * N +
+      sizeof(float) * N * N) {
+    UE_LOG(GRTModule, Error, TEXT(
+             "%s::%s::%d  The size of the distance cache is wrong!"), *FString(
+             __FILENAME__), *FString(__FUNCTION__), __LINE__);
+    return false;
+  }
+
+  const char *labelData    = file.getData() + sizeof(header);
+  const char *distanceData = labelData + sizeof(uint32) * N;
+
+  datasetHash            = header.datasetHash;
+  settingsHash           = header.settingsHash;
+  hasInterClassDistances = header.hasInterClassDistances != 0;
+  sampleLabels.resize(N);
+
+  if (N > 0) {
+    memcpy(&sampleLabels[0], labelData, sizeof(uint32) * N);
+    distances.resize(N, N);
+    memcpy(distances.getData(), distanceData, sizeof(float) * N * N);
+  }
+  return true;
+}
+}
@@ -0,0 +1,90 @@
+﻿#pragma once
+
+#include "../GRT.h"
+#include "../Types/MatrixFloat.h"
+
+namespace GRT {
+/**
+   @brief The DTWDistanceCache class holds the pairwise DTW distances between
+      the samples of a training dataset, see DTW::enableDistanceCache.
+
+   The distances are between the samples after they have been trimmed, scaled,
+      z-normalized, smoothed and offset, so they are only valid for the
+      dataset and the DTW settings they were computed with.  Those are
+      recorded as two hashes, which are checked before the cache is used.
+      Distances that have not been computed are NAN.
+ */
+class GRT_API DTWDistanceCache {
+public:
+
+  /**
+     Default Constructor
+   */
+  DTWDistanceCache();
+
+  /**
+     Default Destructor
+   */
+  ~DTWDistanceCache();
+
+  /**
+     Removes all the distances.
+   */
+  void clear();
+
+  /**
+     Resets the cache for a new dataset, with all the distances set to NAN.
+
+     @param datasetHash: the hash of the dataset
+     @param settingsHash: the hash of the DTW settings
+     @param sampleLabels: the class label of each sample
+   */
+  void reset(const uint64          datasetHash,
+             const uint64          settingsHash,
+             const Vector<uint32>& sampleLabels);
+
+  /**
+     Returns true if the cache holds the distances of a dataset and DTW
+        settings.
+
+     @param datasetHash: the hash of the dataset
+     @param settingsHash: the hash of the DTW settings
+     @return returns true if the cache matches the dataset and the settings
+   */
+  bool isValid(const uint64 datasetHash,
+               const uint64 settingsHash) const;
+
+  /**
+     Gets the number of samples in the cache.
+
+     @return returns the number of samples
+   */
+  uint32 getNumSamples() const {
+    return (uint32)sampleLabels.size();
+  }
+
+  /**
+     Saves the cache to a binary file.
+
+     @param filename: the name of the file to save the cache to
+     @return returns true if the cache was saved, false otherwise
+   */
+  bool save(const FString& filename) const;
+
+  /**
+     Loads a cache from a binary file written by save.
+
+     @param filename: the name of the file to load the cache from
+     @return returns true if the cache was loaded, false otherwise
+   */
+  bool load(const FString& filename);
+
+  uint64 datasetHash;            ///< The hash of the dataset
+  uint64 settingsHash;           ///< The hash of the DTW settings
+  bool   hasInterClassDistances; ///< True if the distances between samples
+                                 // of different classes were computed
+  Vector<uint32> sampleLabels;   ///< The class label of each sample
+  MatrixFloat    distances;      ///< distances[m][n] is the distance of sample
+                                 // n to sample m used as a template
+};
+}
@@ -0,0 +1,301 @@
+﻿#include "../GRT.h"
+#include "DTWParameterSearch.h"
+#include "../Utility/ThreadPool.h"
+#include <algorithm>
+#include <memory>
+#include <random>
+
+namespace GRT {
+DTWParameterSearch::DTWParameterSearch() {
+  radii.push_back(0.2);
+  smoothingFactors.push_back(0);
+  zNormalisationOptions.push_back(false);
+  distanceMethods.push_back(DTW::EUCLIDEAN_DIST);
+  nullRejectionCoeffs.push_back(3.0);
+  maxNumConfigurations = 0;
+  seed                 = 0;
+  numLatencySamples    = 20;
+}
+
+DTWParameterSearch::~DTWParameterSearch() {}
+
+bool DTWParameterSearch::setRadii(const VectorFloat& radii) {
+  if (radii.size() == 0) {
+    UE_LOG(GRTModule, Error,
+           TEXT("setRadii(...) - There must be at least one radius!"));
+    return false;
+  }
+  this->radii = radii;
+  return true;
+}
+
+bool DTWParameterSearch::setSmoothingFactors(
+  const Vector<uint32>& smoothingFactors) {
+  if (smoothingFactors.size() == 0) {
+    UE_LOG(GRTModule, Error,
+           TEXT(
+             "setSmoothingFactors(...) - There must be at least one smoothing factor!"));
+    return false;
+  }
+
+  // Factors of 0 and 1 both turn smoothing off, so they are only kept once
+  this->smoothingFactors.clear();
+
+  for (uint32 i = 0; i < smoothingFactors.size(); i++) {
+    const uint32 factor = smoothingFactors[i] > 1 ? smoothingFactors[i] : 0;
+
+    if (std::find(this->smoothingFactors.begin(), this->smoothingFactors.end(),
+                  factor) == this->smoothingFactors.end()) {
+      this->smoothingFactors.push_back(factor);
+    }
+  }
+  return true;
+}
+
+bool DTWParameterSearch::setZNormalisationOptions(const bool testWithout,
+                                                  const bool testWith) {
+  if (!testWithout && !testWith) {
+    UE_LOG(GRTModule, Error,
+           TEXT(
+             "setZNormalisationOptions(...) - At least one of the options must be tested!"));
+    return false;
+  }
+
+  zNormalisationOptions.clear();
+
+  if (testWithout) zNormalisationOptions.push_back(false);
+
+  if (testWith) zNormalisationOptions.push_back(true);
+  return true;
+}
+
+bool DTWParameterSearch::setDistanceMethods(
+  const Vector<uint32>& distanceMethods) {
+  if (distanceMethods.size() == 0) {
+    UE_LOG(GRTModule, Error,
+           TEXT(
+             "setDistanceMethods(...) - There must be at least one distance method!"));
+    return false;
+  }
+
+  for (uint32 i = 0; i < distanceMethods.size(); i++) {
+    if (distanceMethods[i] > DTW::NORM_ABSOLUTE_DIST) {
+      UE_LOG(GRTModule, Error,
+             TEXT("setDistanceMethods(...) - Unknown distance method: %d"),
+             distanceMethods[i]);
+      return false;
+    }
+  }
+  this->distanceMethods = distanceMethods;
+  return true;
+}
+
+bool DTWParameterSearch::setNullRejectionCoeffs(
+  const VectorFloat& nullRejectionCoeffs) {
+  if (nullRejectionCoeffs.size() == 0) {
+    UE_LOG(GRTModule, Error,
+           TEXT(
+             "setNullRejectionCoeffs(...) - There must be at least one coefficient!"));
+    return false;
+  }
+
+  for (uint32 i = 0; i < nullRejectionCoeffs.size(); i++) {
+    if (nullRejectionCoeffs[i] <= 0) {
+      UE_LOG(GRTModule, Error,
+             TEXT(
+               "setNullRejectionCoeffs(...) - The coefficients must be greater than zero!"));
+      return false;
+    }
+  }
+  this->nullRejectionCoeffs = nullRejectionCoeffs;
+  return true;
+}
+
+bool DTWParameterSearch::setMaxNumConfigurations(
+  const uint32 maxNumConfigurations,
+  const uint32 seed) {
+  this->maxNumConfigurations = maxNumConfigurations;
+  this->seed                 = seed;
+  return true;
+}
+
+bool DTWParameterSearch::setNumLatencySamples(const uint32 numLatencySamples) {
+  if (numLatencySamples == 0) {
+    UE_LOG(GRTModule, Error,
+           TEXT(
+             "setNumLatencySamples(...) - The number of samples must be greater than zero!"));
+    return false;
+  }
+  this->numLatencySamples = numLatencySamples;
+  return true;
+}
+
+bool DTWParameterSearch::search(const DTW                         & dtw,
+                                const TimeSeriesClassificationData& data,
+                                const bool                          useMultipleThreads)
+{
+  results.clear();
+
+  const uint32 N = data.getNumSamples();
+
+  if (N == 0) {
+    UE_LOG(GRTModule, Error,
+           TEXT("search(...) - There are no samples in the dataset!"));
+    return false;
+  }
+
+  // The radius only changes the distances if the warping path is constrained
+  const uint32 numRadii = dtw.getConstrainWarpingPath() ?
+                          (uint32)radii.size() : 1;
+  Vector<DTWSearchResult> configurations;
+
+  for (uint32 r = 0; r < numRadii; r++) {
+    for (uint32 s = 0; s < smoothingFactors.size(); s++) {
+      for (uint32 z = 0; z < zNormalisationOptions.size(); z++) {
+        for (uint32 m = 0; m < distanceMethods.size(); m++) {
+          DTWSearchResult configuration;
+          configuration.radius             = radii[r];
+          configuration.smoothingFactor    = smoothingFactors[s];
+          configuration.useZNormalisation  = zNormalisationOptions[z];
+          configuration.distanceMethod     = distanceMethods[m];
+          configuration.nullRejectionCoeff = dtw.getNullRejectionCoeff();
+          configurations.push_back(configuration);
+        }
+      }
+    }
+  }
+
+  // Search a random subset of the grid if it is too big
+  if ((maxNumConfigurations > 0) &&
+      (configurations.size() > maxNumConfigurations)) {
+    std::mt19937 generator(seed);
+    std::shuffle(configurations.begin(), configurations.end(), generator);
+    configurations.resize(maxNumConfigurations);
+  }
+
+  const uint32 C = (uint32)configurations.size();
+  const uint32 K = (uint32)nullRejectionCoeffs.size();
+  std::vector<std::unique_ptr<DTW> > models(C);
+  Vector<VectorFloat> accuracies(C, VectorFloat(K, 0));
+  Vector<uint8> configurationTrained(C, 0);
+
+  // The samples are packed into one arena, which each configuration trains
+  // from without copying it
+  const ContiguousTimeSeriesClassificationData contiguousData(data);
+
+  // Train each configuration with the distance cache, then score each null
+  // rejection coefficient from the cache
+  ThreadPool::getInstance().parallelFor(C, [&](uint32 c) {
+    models[c].reset(new DTW(dtw));
+    DTW& model = *models[c];
+
+    if (!configurations[c].apply(model)) return;
+
+    model.enableDistanceCache(true, true);
+
+    if (!model.train(contiguousData)) return;
+
+    for (uint32 k = 0; k < K; k++) {
+      Vector<uint32> predictedClassLabels;
+      model.setNullRejectionCoeff(nullRejectionCoeffs[k]);
+
+      if (!model.computeLeaveOneOutAccuracy(accuracies[c][k],
+                                            predictedClassLabels)) return;
+    }
+
+    // The cache is no longer needed, and can be large
+    model.enableDistanceCache(false);
+    configurationTrained[c] = 1;
+  }, 0, useMultipleThreads);
+
+  // Time the predictions of each configuration on its own, so they are not
+  // slowed down by the other configurations
+  Vector<uint32> latencyIndexs(std::min(numLatencySamples, N));
+
+  for (uint32 i = 0; i < latencyIndexs.size(); i++) {
+    latencyIndexs[i] = (uint32)((uint64)i * N / latencyIndexs.size());
+  }
+
+  const TimeSeriesClassificationDataView latencyData = data.getSubsetView(
+    latencyIndexs);
+
+  for (uint32 c = 0; c < C; c++) {
+    EvaluationResult evaluation;
+
+    if (!configurationTrained[c] ||
+        !models[c]->evaluate(latencyData, evaluation, false, false)) {
+      UE_LOG(GRTModule, Warning,
+             TEXT(
+               "search(...) - Failed to train configuration %d (radius: %f smoothingFactor: %d useZNormalisation: %d distanceMethod: %d), it is skipped"),
+             c, configurations[c].radius, configurations[c].smoothingFactor,
+             configurations[c].useZNormalisation,
+             configurations[c].distanceMethod);
+      continue;
+    }
+
+    for (uint32 k = 0; k < K; k++) {
+      DTWSearchResult result = configurations[c];
+      result.nullRejectionCoeff = nullRejectionCoeffs[k];
+      result.accuracy           = accuracies[c][k];
+      result.meanLatency        = evaluation.meanLatency;
+      results.push_back(result);
+    }
+    models[c].reset();
+  }
+
+  if (results.size() == 0) {
+    UE_LOG(GRTModule, Error,
+           TEXT("search(...) - None of the configurations could be trained!"));
+    return false;
+  }
+
+  // Flag the results that are not beaten on both accuracy and time
+  for (uint32 i = 0; i < results.size(); i++) {
+    results[i].paretoOptimal = true;
+
+    for (uint32 j = 0; j < results.size(); j++) {
+      if ((results[j].accuracy >= results[i].accuracy) &&
+          (results[j].meanLatency <= results[i].meanLatency) &&
+          ((results[j].accuracy > results[i].accuracy) ||
+           (results[j].meanLatency < results[i].meanLatency))) {
+        results[i].paretoOptimal = false;
+        break;
+      }
+    }
+  }
+
+  return true;
+}
+
+Vector<DTWSearchResult>DTWParameterSearch::getParetoFront() const {
+  Vector<DTWSearchResult> front;
+
+  for (uint32 i = 0; i < results.size(); i++) {
+    if (results[i].paretoOptimal) front.push_back(results[i]);
+  }
+
+  std::stable_sort(front.begin(), front.end(),
+                   [](const DTWSearchResult& a, const DTWSearchResult& b) {
+    return a.meanLatency < b.meanLatency;
+  });
+  return front;
+}
+
+bool DTWParameterSearch::getFastestConfiguration(const float      minAccuracy,
+                                                 DTWSearchResult& result) const
+{
+  bool found = false;
+
+  for (uint32 i = 0; i < results.size(); i++) {
+    if (results[i].accuracy < minAccuracy) continue;
+
+    if (!found || (results[i].meanLatency < result.meanLatency) ||
+        ((results[i].meanLatency == result.meanLatency) &&
+         (results[i].accuracy > result.accuracy))) {
+      result = results[i];
+      found  = true;
+    }
+  }
+  return found;
+}
+}
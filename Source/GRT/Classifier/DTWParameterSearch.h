@@ -0,0 +1,221 @@
+﻿#pragma once
+
+#include "../GRT.h"
+#include "DTW.h"
+
+namespace GRT {
+/**
+   @brief The DTWSearchResult class holds one configuration tested by a
+      DTWParameterSearch and its results.
+ */
+class GRT_API DTWSearchResult {
+public:
+
+  DTWSearchResult() {
+    radius             = 0;
+    smoothingFactor    = 0;
+    useZNormalisation  = false;
+    distanceMethod     = DTW::EUCLIDEAN_DIST;
+    nullRejectionCoeff = 0;
+    accuracy           = 0;
+    meanLatency        = 0;
+    paretoOptimal      = false;
+  }
+
+  ~DTWSearchResult() {}
+
+  /**
+     Applies the configuration to a DTW model, the model needs to be trained
+        afterwards.
+
+     @param dtw: the model to configure
+     @return returns true if the configuration was applied, false otherwise
+   */
+  bool apply(DTW& dtw) const {
+    return dtw.setWarpingRadius(radius) &&
+           dtw.enableSmoothing(smoothingFactor > 1,
+                               smoothingFactor > 1 ? smoothingFactor : 1) &&
+           dtw.enableZNormalization(useZNormalisation,
+                                    dtw.getConstrainZNorm()) &&
+           dtw.setDistanceMethod(distanceMethod) &&
+           dtw.setNullRejectionCoeff(nullRejectionCoeff);
+  }
+
+  float  radius;             ///< The warping radius
+  uint32 smoothingFactor;    ///< The smoothing factor, 0 or 1 if smoothing
+                             // is off
+  bool   useZNormalisation;  ///< True if the data is z-normalized
+  uint32 distanceMethod;     ///< The DTW::DistanceMethods value
+  float  nullRejectionCoeff; ///< The null rejection coefficient
+  float  accuracy;           ///< The leave-one-out accuracy, [0 1]
+  float  meanLatency;        ///< The mean time of one prediction in
+                             // milliseconds
+  bool   paretoOptimal;      ///< True if no other configuration is both at
+                             // least as accurate and at least as fast
+};
+
+/**
+   @brief The DTWParameterSearch class searches for the DTW settings that give
+      the best trade off between accuracy and prediction time.
+
+   Each configuration of the warping radius, smoothing factor,
+      z-normalization and distance method is trained on the dataset with the
+      distance cache enabled (see DTW::enableDistanceCache), and the
+      configurations are run in parallel.  The null rejection coefficients do
+      not change the distances, so each coefficient is scored from the cache
+      of its configuration with DTW::computeLeaveOneOutAccuracy, without
+      running DTW again.  Values that cannot change the distances are only
+      tested once: the radii if the model does not constrain the warping
+      path, and the smoothing factors of 0 and 1 (which both turn smoothing
+      off).
+
+   The mean prediction time of each configuration is measured after the
+      configurations have been trained, one configuration at a time, so the
+      times are not skewed by the other configurations.
+
+   All the other settings (the scaling, null rejection, rejection mode,
+      trimming and so on) are taken from the model given to search.
+ */
+class GRT_API DTWParameterSearch {
+public:
+
+  /**
+     Default Constructor, the search space holds the current settings of a
+        default DTW.
+   */
+  DTWParameterSearch();
+
+  /**
+     Default Destructor
+   */
+  ~DTWParameterSearch();
+
+  /**
+     Sets the warping radii to search.
+
+     @param radii: the radii, each should be in the range [0 1]
+     @return returns true if the radii were set, false otherwise
+   */
+  bool setRadii(const VectorFloat& radii);
+
+  /**
+     Sets the smoothing factors to search, a factor of 0 or 1 turns smoothing
+        off.
+
+     @param smoothingFactors: the smoothing factors
+     @return returns true if the smoothing factors were set, false otherwise
+   */
+  bool setSmoothingFactors(const Vector<uint32>& smoothingFactors);
+
+  /**
+     Sets if the search should test the configurations with and without
+        z-normalization, or only one of them.
+
+     @param testWithout: if true the configurations without z-normalization
+        are tested
+     @param testWith: if true the configurations with z-normalization are
+        tested
+     @return returns true if the options were set, false if both are false
+   */
+  bool setZNormalisationOptions(const bool testWithout,
+                                const bool testWith);
+
+  /**
+     Sets the distance methods to search.
+
+     @param distanceMethods: the DTW::DistanceMethods values
+     @return returns true if the distance methods were set, false otherwise
+   */
+  bool setDistanceMethods(const Vector<uint32>& distanceMethods);
+
+  /**
+     Sets the null rejection coefficients to search.
+
+     @param nullRejectionCoeffs: the null rejection coefficients, each should
+        be greater than zero
+     @return returns true if the coefficients were set, false otherwise
+   */
+  bool setNullRejectionCoeffs(const VectorFloat& nullRejectionCoeffs);
+
+  /**
+     Sets the maximum number of configurations to train.  If the grid has more
+        configurations than this, a random subset of them is searched
+        instead.  Every null rejection coefficient is tested for each
+        configuration, as they cost almost nothing.
+
+     @param maxNumConfigurations: the maximum number of configurations, 0
+        searches the full grid
+     @param seed: the seed used to choose the random subset
+     @return returns true if the maximum was set
+   */
+  bool setMaxNumConfigurations(const uint32 maxNumConfigurations,
+                               const uint32 seed = 0);
+
+  /**
+     Sets the number of samples used to measure the prediction time of each
+        configuration.
+
+     @param numLatencySamples: the number of samples, must be greater than 0
+     @return returns true if the number of samples was set, false otherwise
+   */
+  bool setNumLatencySamples(const uint32 numLatencySamples);
+
+  /**
+     Runs the search.
+
+     @param dtw: the model whose other settings are used for every
+        configuration, it is not changed
+     @param data: the labelled dataset the configurations are scored on
+     @param useMultipleThreads: if true the configurations are trained in
+        parallel
+     @return returns true if the search was run, false otherwise
+   */
+  bool search(const DTW                         & dtw,
+              const TimeSeriesClassificationData& data,
+              const bool                          useMultipleThreads = true);
+
+  /**
+     Gets the results of the last search, one for each configuration and null
+        rejection coefficient.
+
+     @return returns the results of the last search
+   */
+  const Vector<DTWSearchResult>& getResults() const {
+    return results;
+  }
+
+  /**
+     Gets the Pareto front of the last search, the results that no other
+        result beats on both accuracy and prediction time, sorted from the
+        fastest to the slowest.
+
+     @return returns the Pareto optimal results
+   */
+  Vector<DTWSearchResult>getParetoFront() const;
+
+  /**
+     Gets the fastest configuration of the last search that is at least as
+        accurate as minAccuracy.
+
+     @param minAccuracy: the minimum accuracy, [0 1]
+     @param result: returns the fastest configuration
+     @return returns true if a configuration was found, false otherwise
+   */
+  bool getFastestConfiguration(const float      minAccuracy,
+                               DTWSearchResult& result) const;
+
+protected:
+
+  VectorFloat    radii;                 // The warping radii to search
+  Vector<uint32> smoothingFactors;      // The smoothing factors to search
+  Vector<bool>   zNormalisationOptions; // The z-normalization options
+  Vector<uint32> distanceMethods;       // The distance methods to search
+  VectorFloat    nullRejectionCoeffs;   // The null rejection coefficients
+  uint32 maxNumConfigurations;          // The maximum number of
+                                        // configurations, 0 for the full grid
+  uint32 seed;                          // The seed of the random subset
+  uint32 numLatencySamples;             // The number of samples used to
+                                        // measure the prediction time
+  Vector<DTWSearchResult> results;      // The results of the last search
+};
+}
@@ -1,9 +1,13 @@
 ﻿#include "../GRT.h"
 #include "Classifier.h"
+#include "ClassifierTask.h"
+#include "../Utility/ThreadPool.h"
+#include <algorithm>
+#include <memory>
 
 namespace GRT {
 Classifier::StringClassifierMap *Classifier::stringClassifierMap = NULL;
-uint32 Classifier::numClassifierInstances                        = 0;
+std::atomic<uint32> Classifier::numClassifierInstances(0);
 
 Classifier * Classifier::create(const FString& id) {
   // This function maps the input string and returns a pointer to a new instance
@@ -35,6 +39,414 @@ Classifier * Classifier::deepCopy() const {
   return newInstance;
 }
 
+bool Classifier::evaluate(const TimeSeriesClassificationData& testData,
+                          EvaluationResult                  & result,
+                          const bool                          notifyTestResults,
+                          const bool                          useMultipleThreads) {
+  return evaluate(testData.getView(), result, notifyTestResults,
+                  useMultipleThreads);
+}
+
+bool Classifier::evaluate(const TimeSeriesClassificationDataView& testData,
+                          EvaluationResult                      & result,
+                          const bool                              notifyTestResults,
+                          const bool                              useMultipleThreads)
+{
+  result.clear();
+
+  if (!trained) {
+    UE_LOG(GRTModule, Error,
+           TEXT("evaluate(...) - The classifier has not been trained!"));
+    return false;
+  }
+
+  if (testData.getNumDimensions() != numInputDimensions) {
+    UE_LOG(GRTModule, Error,
+           TEXT(
+             "evaluate(...) - The dimensionality of the test data ( %d ) does not match that of the classifier ( %d )!"),
+           testData.getNumDimensions(), numInputDimensions);
+    return false;
+  }
+
+  const uint32 N = testData.getNumSamples();
+
+  // Each block of samples is predicted by its own copy of the classifier, as
+  // predicting changes the state of a classifier.  There are a few blocks per
+  // core so the threads stay busy when the samples have different lengths
+  const uint32 numCores =
+    (uint32)FPlatformMisc::NumberOfCoresIncludingHyperthreads();
+  const uint32 numBlocks = useMultipleThreads ?
+                           std::max(1u, std::min(N, numCores * 4)) : 1;
+  Vector<uint32> predictedLabels(N, GRT_DEFAULT_NULL_CLASS_LABEL);
+  Vector<float>  latencies(N, 0);
+  Vector<TestInstanceResult> testResults(notifyTestResults ? N : 0);
+  Vector<uint8> blockFailed(numBlocks, 0);
+
+  // The copies are made up front, so a failed copy is reported before any
+  // samples are predicted
+  std::vector<std::unique_ptr<Classifier> > classifiers(numBlocks);
+
+  for (uint32 block = 0; block < numBlocks; block++) {
+    classifiers[block].reset(deepCopy());
+
+    if (!classifiers[block]) {
+      UE_LOG(GRTModule, Error,
+             TEXT("evaluate(...) - Failed to copy the classifier!"));
+      return false;
+    }
+  }
+
+  ThreadPool::getInstance().parallelFor(numBlocks, [&](uint32 block) {
+    Classifier *classifier = classifiers[block].get();
+    const uint32 begin = (uint32)((uint64)N * block / numBlocks);
+    const uint32 end   = (uint32)((uint64)N * (block + 1) / numBlocks);
+
+    for (uint32 i = begin; i < end; i++) {
+      const double startTime = FPlatformTime::Seconds();
+
+      if (!classifier->predict(MatrixView(testData[i].getData()))) {
+        blockFailed[block] = 1;
+        return;
+      }
+      latencies[i] = (float)((FPlatformTime::Seconds() - startTime) * 1000.0);
+      predictedLabels[i] = classifier->getPredictedClassLabel();
+
+      if (notifyTestResults) {
+        testResults[i].setClassificationResult(i, testData[i].getClassLabel(),
+                                               predictedLabels[i],
+                                               predictedLabels[i],
+                                               classifier->getClassLikelihoods(),
+                                               classifier->getClassDistances());
+      }
+    }
+  }, 0, useMultipleThreads);
+
+  for (uint32 block = 0; block < numBlocks; block++) {
+    if (blockFailed[block]) {
+      result.clear();
+      UE_LOG(GRTModule, Error,
+             TEXT("evaluate(...) - Failed to predict the test samples!"));
+      return false;
+    }
+  }
+
+  // The rows and columns of the confusion matrix are the null class (if it
+  // can be predicted), the classes of the model, then any other class label in
+  // the test data
+  if (useNullRejection) {
+    result.classLabels.push_back(GRT_DEFAULT_NULL_CLASS_LABEL);
+  }
+
+  for (uint32 k = 0; k < classLabels.size(); k++) {
+    if (std::find(result.classLabels.begin(), result.classLabels.end(),
+                  classLabels[k]) == result.classLabels.end()) {
+      result.classLabels.push_back(classLabels[k]);
+    }
+  }
+
+  std::map<uint32, uint32> labelIndexs;
+
+  for (uint32 k = 0; k < result.classLabels.size(); k++) {
+    labelIndexs[result.classLabels[k]] = k;
+  }
+
+  for (uint32 i = 0; i < N; i++) {
+    const uint32 labels[2] = { testData[i].getClassLabel(), predictedLabels[i] };
+
+    for (uint32 n = 0; n < 2; n++) {
+      if (labelIndexs.count(labels[n]) == 0) {
+        labelIndexs[labels[n]] = (uint32)result.classLabels.size();
+        result.classLabels.push_back(labels[n]);
+      }
+    }
+  }
+
+  const uint32 K = (uint32)result.classLabels.size();
+  result.confusionMatrix.resize(K, K, 0);
+
+  for (uint32 i = 0; i < N; i++) {
+    const uint32 classLabel = testData[i].getClassLabel();
+    const uint32 row        = labelIndexs[classLabel];
+    const uint32 col        = labelIndexs[predictedLabels[i]];
+
+    result.confusionMatrix[row][col]++;
+
+    if (predictedLabels[i] == classLabel) result.numCorrect++;
+  }
+
+  result.numSamples = N;
+  result.accuracy   = N > 0 ? result.numCorrect / float(N) : 0;
+
+  // Work out the precision, recall and F1 score of each class
+  result.precision.resize(K, 0);
+  result.recall.resize(K, 0);
+  result.f1.resize(K, 0);
+
+  for (uint32 k = 0; k < K; k++) {
+    float numPredicted = 0;
+    float numActual    = 0;
+
+    for (uint32 n = 0; n < K; n++) {
+      numPredicted += result.confusionMatrix[n][k];
+      numActual    += result.confusionMatrix[k][n];
+    }
+
+    const float truePositives = result.confusionMatrix[k][k];
+
+    if (numPredicted > 0) result.precision[k] = truePositives / numPredicted;
+
+    if (numActual > 0) result.recall[k] = truePositives / numActual;
+
+    if (result.precision[k] + result.recall[k] > 0) {
+      result.f1[k] = 2 * result.precision[k] * result.recall[k] /
+                     (result.precision[k] + result.recall[k]);
+    }
+  }
+
+  // Summarize the prediction times
+  if (N > 0) {
+    Vector<float> sortedLatencies = latencies;
+    std::sort(sortedLatencies.begin(), sortedLatencies.end());
+
+    double sum = 0;
+
+    for (uint32 i = 0; i < N; i++) sum += sortedLatencies[i];
+
+    result.meanLatency   = (float)(sum / N);
+    result.minLatency    = sortedLatencies[0];
+    result.maxLatency    = sortedLatencies[N - 1];
+    result.medianLatency = sortedLatencies[(N - 1) / 2];
+    result.latency95     = sortedLatencies[(uint32)((N - 1) * 0.95)];
+    result.latency99     = sortedLatencies[(uint32)((N - 1) * 0.99)];
+  }
+
+  // Notify the observers of all the results on this thread, in sample order
+  for (uint32 i = 0; i < testResults.size(); i++) {
+    notifyTestResultsObservers(testResults[i]);
+  }
+
+  return true;
+}
+
+bool Classifier::crossValidate(TimeSeriesClassificationData& data,
+                               const uint32                  K,
+                               CrossValidationResult       & result,
+                               const bool                    useStratifiedSampling,
+                               const bool                    useMultipleThreads,
+                               const std::atomic<bool>      *cancel) {
+  result.clear();
+
+  if (!data.spiltDataIntoKFolds(K, useStratifiedSampling)) {
+    UE_LOG(GRTModule, Error,
+           TEXT("crossValidate(...) - Failed to split the data into %d folds!"),
+           K);
+    return false;
+  }
+
+  // Each fold is trained by its own copy of this classifier
+  std::vector<std::unique_ptr<Classifier> > classifiers(K);
+
+  for (uint32 k = 0; k < K; k++) {
+    classifiers[k].reset(deepCopy());
+
+    if (!classifiers[k]) {
+      UE_LOG(GRTModule, Error,
+             TEXT("crossValidate(...) - Failed to copy the classifier!"));
+      return false;
+    }
+
+    // The cancel flag also stops a fold that is being trained
+    classifiers[k]->trainingCancelFlag = cancel;
+  }
+
+  // The samples are packed into one arena, each training fold is a subset of
+  // it, so only the sample indexs of a fold are copied
+  const ContiguousTimeSeriesClassificationData contiguousData(data);
+
+  enum FoldStatus { FOLD_NOT_RUN = 0, FOLD_FINISHED, FOLD_FAILED };
+  Vector<uint8> foldStatus(K, FOLD_NOT_RUN);
+
+  result.foldResults.resize(K);
+
+  ThreadPool::getInstance().parallelFor(K, [&](uint32 k) {
+    if (cancel && *cancel) return;
+
+    ContiguousTimeSeriesClassificationData trainingData =
+      contiguousData.getSubset(data.getTrainingFoldView(k).getSampleIndices());
+
+    if (!classifiers[k]->train_(trainingData)) {
+      if (!(cancel && *cancel)) foldStatus[k] = FOLD_FAILED;
+      return;
+    }
+
+    if (cancel && *cancel) return;
+
+    // The folds already run in parallel, so each fold is tested on one thread
+    if (!classifiers[k]->evaluate(data.getTestFoldView(k),
+                                  result.foldResults[k], false, false)) {
+      foldStatus[k] = FOLD_FAILED;
+      return;
+    }
+    foldStatus[k] = FOLD_FINISHED;
+  }, 0, useMultipleThreads);
+
+  for (uint32 k = 0; k < K; k++) {
+    if (foldStatus[k] == FOLD_FAILED) {
+      result.clear();
+      UE_LOG(GRTModule, Error,
+             TEXT("crossValidate(...) - Failed to train or test fold %d!"), k);
+      return false;
+    }
+
+    if (foldStatus[k] == FOLD_NOT_RUN) {
+      result.clear();
+      result.cancelled = true;
+      UE_LOG(GRTModule, Warning,
+             TEXT("crossValidate(...) - The cross validation was cancelled!"));
+      return false;
+    }
+  }
+
+  // Notify the observers of each fold on this thread, in fold order
+  for (uint32 k = 0; k < K; k++) {
+    TrainingResult progress;
+    progress.setClassificationResult(k + 1, result.foldResults[k].accuracy,
+                                     this);
+    notifyTrainingResultsObservers(progress);
+  }
+
+  result.numFolds = K;
+
+  // Collect the class labels of all the folds, in the order they first appear
+  std::map<uint32, uint32> labelIndexs;
+
+  for (uint32 k = 0; k < K; k++) {
+    const Vector<uint32>& foldLabels = result.foldResults[k].classLabels;
+
+    for (uint32 n = 0; n < foldLabels.size(); n++) {
+      if (labelIndexs.count(foldLabels[n]) == 0) {
+        labelIndexs[foldLabels[n]] = (uint32)result.classLabels.size();
+        result.classLabels.push_back(foldLabels[n]);
+      }
+    }
+  }
+
+  const uint32 C = (uint32)result.classLabels.size();
+  Vector<uint32> numClassFolds(C, 0);
+
+  result.confusionMatrix.resize(C, C, 0);
+  result.precision.resize(C, 0);
+  result.precisionVariance.resize(C, 0);
+  result.recall.resize(C, 0);
+  result.recallVariance.resize(C, 0);
+  result.f1.resize(C, 0);
+  result.f1Variance.resize(C, 0);
+
+  // Sum the metrics (and their squares) over the folds
+  for (uint32 k = 0; k < K; k++) {
+    const EvaluationResult& fold = result.foldResults[k];
+
+    result.accuracy         += fold.accuracy;
+    result.accuracyVariance += fold.accuracy * fold.accuracy;
+
+    for (uint32 n = 0; n < fold.classLabels.size(); n++) {
+      const uint32 c = labelIndexs[fold.classLabels[n]];
+
+      for (uint32 m = 0; m < fold.classLabels.size(); m++) {
+        result.confusionMatrix[c][labelIndexs[fold.classLabels[m]]] +=
+          fold.confusionMatrix[n][m];
+      }
+
+      numClassFolds[c]++;
+      result.precision[c]         += fold.precision[n];
+      result.precisionVariance[c] += fold.precision[n] * fold.precision[n];
+      result.recall[c]            += fold.recall[n];
+      result.recallVariance[c]    += fold.recall[n] * fold.recall[n];
+      result.f1[c]                += fold.f1[n];
+      result.f1Variance[c]        += fold.f1[n] * fold.f1[n];
+    }
+  }
+
+  // Turn the sums into the means and sample variances
+  auto toMeanAndVariance = [](float& mean, float& variance, const uint32 n) {
+    if (n == 0) return;
+
+    const float sum = mean;
+    mean     = sum / n;
+    variance = n > 1 ? (variance - sum * mean) / (n - 1) : 0;
+
+    if (variance < 0) variance = 0;
+  };
+
+  toMeanAndVariance(result.accuracy, result.accuracyVariance, K);
+
+  for (uint32 c = 0; c < C; c++) {
+    toMeanAndVariance(result.precision[c], result.precisionVariance[c],
+                      numClassFolds[c]);
+    toMeanAndVariance(result.recall[c], result.recallVariance[c],
+                      numClassFolds[c]);
+    toMeanAndVariance(result.f1[c], result.f1Variance[c], numClassFolds[c]);
+  }
+
+  return true;
+}
+
+TSharedPtr<ClassifierTask, ESPMode::ThreadSafe>Classifier::trainAsync(
+  const TimeSeriesClassificationData& data) const {
+  TSharedPtr<TimeSeriesClassificationData, ESPMode::ThreadSafe> trainingData =
+    MakeShared<TimeSeriesClassificationData, ESPMode::ThreadSafe>(data);
+
+  return trainAsync([trainingData](TimeSeriesClassificationData& data) {
+    data = *trainingData;
+    return true;
+  });
+}
+
+TSharedPtr<ClassifierTask, ESPMode::ThreadSafe>Classifier::trainAsync(
+  std::function<bool(TimeSeriesClassificationData&)> loadData) const {
+  Classifier *classifier = deepCopy();
+
+  if (classifier == NULL) {
+    UE_LOG(GRTModule, Error,
+           TEXT("trainAsync(...) - Failed to copy the classifier!"));
+    return nullptr;
+  }
+
+  TSharedPtr<ClassifierTask, ESPMode::ThreadSafe> task =
+    MakeShared<ClassifierTask, ESPMode::ThreadSafe>(classifier);
+
+  task->start([loadData](Classifier& classifier) {
+    TimeSeriesClassificationData trainingData;
+
+    if (!loadData(trainingData)) {
+      UE_LOG(GRTModule, Error,
+             TEXT("trainAsync(...) - Failed to load the training data!"));
+      return false;
+    }
+    return classifier.train_(trainingData);
+  });
+  return task;
+}
+
+TSharedPtr<ClassifierTask, ESPMode::ThreadSafe>Classifier::loadAsync(
+  const FString& filename) const {
+  Classifier *classifier = create();
+
+  if (classifier == NULL) {
+    UE_LOG(GRTModule, Error,
+           TEXT("loadAsync(...) - Failed to create the classifier!"));
+    return nullptr;
+  }
+
+  TSharedPtr<ClassifierTask, ESPMode::ThreadSafe> task =
+    MakeShared<ClassifierTask, ESPMode::ThreadSafe>(classifier);
+
+  task->start([filename](Classifier& classifier) {
+    return classifier.load(filename);
+  });
+  return task;
+}
+
 const Classifier * Classifier::getClassifierPointer() const {
   return this;
 }
@@ -66,6 +478,8 @@ Classifier::Classifier(const FString& id) : MLBase(id, MLBase::CLASSIFIER)
   phase                 = 0;
   trainingSetAccuracy   = 0;
   nullRejectionCoeff    = 5;
+  trainingTask          = NULL;
+  trainingCancelFlag    = NULL;
   numClassifierInstances++;
 }
 
@@ -251,6 +665,19 @@ const Classifier& Classifier::getBaseClassifier() const {
   return *this;
 }
 
+bool Classifier::updateTrainingProgress(const float progress) {
+  if (trainingCancelFlag && *trainingCancelFlag) return false;
+
+  if (trainingTask == NULL) return true;
+
+  return trainingTask->setProgress(progress);
+}
+
+bool Classifier::isTrainingCancelled() const {
+  return (trainingTask != NULL && trainingTask->isCancelled()) ||
+         (trainingCancelFlag != NULL && *trainingCancelFlag);
+}
+
 bool Classifier::saveBaseSettingsToFile(std::fstream& file) const {
   if (!file.is_open()) {
     UE_LOG(GRTModule, Error,
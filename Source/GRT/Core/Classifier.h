@@ -2,7 +2,11 @@
 
 #include "../GRT.h"
 #include "MLBase.h"
+#include "../Utility/EvaluationResult.h"
+#include "../Utility/CrossValidationResult.h"
 #include <map>
+#include <atomic>
+#include <functional>
 
 #ifndef GRT_CLASSIFIER_HEADER
 # define GRT_CLASSIFIER_HEADER
@@ -11,6 +15,8 @@
 #endif // GRT_CLASSIFIER_HEADER
 
 namespace GRT {
+class ClassifierTask;
+
 /**
    @brief This is the main base class that all GRT Classification algorithms
       should inherit from.
@@ -334,6 +340,128 @@ public:
    */
   Classifier          * deepCopy() const;
 
+  /**
+     Evaluates the trained classifier on a labelled test dataset, giving the
+        accuracy, the confusion matrix, the precision, recall and F1 score of
+        each class and the distribution of the prediction times.
+
+     The samples are split into blocks that are predicted in parallel, each
+        block by its own deep copy of this classifier, so the state of this
+        instance is not changed.  If notifyTestResults is true, a
+        TestInstanceResult is kept for every sample and the test results
+        observers are notified of all of them, in sample order, once the
+        predictions have finished.
+
+     @param testData: the labelled test dataset
+     @param result: returns the results of the evaluation
+     @param notifyTestResults: if true the test results observers are notified
+        of the result of each sample
+     @param useMultipleThreads: if true the samples are predicted in parallel
+     @return returns true if the classifier was evaluated, false otherwise
+   */
+  bool evaluate(const TimeSeriesClassificationData& testData,
+                EvaluationResult                  & result,
+                const bool                          notifyTestResults = false,
+                const bool                          useMultipleThreads = true);
+
+  /**
+     Evaluates the trained classifier on a view of a labelled test dataset,
+        see evaluate above.
+
+     @param testData: the view of the labelled test dataset
+     @param result: returns the results of the evaluation
+     @param notifyTestResults: if true the test results observers are notified
+        of the result of each sample
+     @param useMultipleThreads: if true the samples are predicted in parallel
+     @return returns true if the classifier was evaluated, false otherwise
+   */
+  bool evaluate(const TimeSeriesClassificationDataView& testData,
+                EvaluationResult                      & result,
+                const bool                              notifyTestResults =
+                  false,
+                const bool                              useMultipleThreads =
+                  true);
+
+  /**
+     Runs a k-fold cross validation of this classifier, using the current
+        settings of this classifier.  The dataset is split with
+        spiltDataIntoKFolds, then each fold is trained and tested by its own
+        deep copy of this classifier, with the folds running in parallel.
+        The dataset is packed into one ContiguousTimeSeriesClassificationData,
+        the training folds are subsets of it and the test folds are views of
+        the dataset, so no fold copies any samples (unless the classifier only
+        trains from a TimeSeriesClassificationData, see MLBase::train_).
+        This classifier is not trained.
+
+     Once all the folds have finished, the training results observers are
+        notified on the calling thread, in fold order, with a TrainingResult
+        holding the number of the fold and its accuracy.
+
+     @param data: the labelled dataset to cross validate on
+     @param K: the number of folds
+     @param result: returns the results of each fold and their mean and
+        variance
+     @param useStratifiedSampling: if true each fold has the same ratio of
+        classes as the dataset
+     @param useMultipleThreads: if true the folds are run in parallel
+     @param cancel: an optional flag, setting it to true from another thread
+        stops the cross validation.  The folds that have not started are
+        skipped, and a fold being trained stops the next time it checks
+        isTrainingCancelled
+     @return returns true if all the folds were run, false if the cross
+        validation failed or was cancelled
+   */
+  bool crossValidate(TimeSeriesClassificationData& data,
+                     const uint32                  K,
+                     CrossValidationResult       & result,
+                     const bool                    useStratifiedSampling = false,
+                     const bool                    useMultipleThreads = true,
+                     const std::atomic<bool>      *cancel = NULL);
+
+  /**
+     Trains a deep copy of this classifier on the thread pool, so the calling
+        thread (e.g. the game thread) is not blocked.  This classifier is not
+        changed and can keep predicting while the copy trains.  When the
+        returned task has succeeded, ClassifierTask::releaseClassifier gives
+        the trained copy.
+
+     The dataset is copied on the calling thread, use the overload that takes
+        a function to also make the dataset in the background.  If the thread
+        pool runs its own threads and has none (on a single core machine) the
+        copy is trained before this returns.
+
+     @param data: the labelled training data
+     @return returns the task training the copy, or an invalid pointer if the
+        copy could not be made
+   */
+  TSharedPtr<ClassifierTask, ESPMode::ThreadSafe> trainAsync(
+    const TimeSeriesClassificationData& data) const;
+
+  /**
+     Trains a deep copy of this classifier on the thread pool, with a dataset
+        made by loadData on the same background thread (for example loaded
+        from a file or generated).
+
+     @param loadData: fills the dataset it is given, returning true if it
+        succeeded
+     @return returns the task training the copy, or an invalid pointer if the
+        copy could not be made
+   */
+  TSharedPtr<ClassifierTask, ESPMode::ThreadSafe> trainAsync(
+    std::function<bool(TimeSeriesClassificationData&)> loadData) const;
+
+  /**
+     Loads a model from a file into a new classifier of the same type as this
+        one, on the thread pool.  When the returned task has succeeded,
+        ClassifierTask::releaseClassifier gives the loaded classifier.
+
+     @param filename: the name of the file to load the model from
+     @return returns the task loading the model, or an invalid pointer if the
+        classifier could not be made
+   */
+  TSharedPtr<ClassifierTask, ESPMode::ThreadSafe> loadAsync(
+    const FString& filename) const;
+
   /**
      Returns a pointer to the classifier.
 
@@ -374,6 +502,30 @@ protected:
    */
   bool loadBaseSettingsFromFile(std::fstream& file);
 
+  /**
+     Reports the progress of training, if this classifier is being trained by
+        trainAsync.  Classifiers should call this as they train, and stop
+        training if it returns false.
+
+     @param progress: the progress of the training, in the range [0 1]
+     @return returns false if the training has been cancelled, true otherwise
+   */
+  bool updateTrainingProgress(const float progress);
+
+  /**
+     Returns true if this classifier is being trained by trainAsync and the
+        training has been cancelled, or if it is training a fold of
+        crossValidate and the cross validation has been cancelled.
+
+     @return returns true if the training has been cancelled, false otherwise
+   */
+  bool isTrainingCancelled() const;
+
+  friend class ClassifierTask;
+
+  ClassifierTask *trainingTask; // The task training this classifier, or NULL
+  const std::atomic<bool> *trainingCancelFlag; // Cancels the training of a
+                                               // crossValidate fold, or NULL
   bool   supportsNullRejection;
   bool   useNullRejection;
   uint32 numClasses;
@@ -405,7 +557,7 @@ protected:
 private:
 
   static StringClassifierMap *stringClassifierMap;
-  static uint32 numClassifierInstances;
+  static std::atomic<uint32> numClassifierInstances;
 };
 
 template<typename T>
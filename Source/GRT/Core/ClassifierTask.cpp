@@ -0,0 +1,55 @@
+﻿#include "ClassifierTask.h"
+#include "Classifier.h"
+
+namespace GRT {
+ClassifierTask::ClassifierTask(Classifier *classifier) : classifier(classifier)
+{
+  state     = TASK_RUNNING;
+  progress  = 0;
+  cancelled = false;
+}
+
+ClassifierTask::~ClassifierTask() {
+  cancel();
+  group.wait();
+}
+
+void ClassifierTask::cancel() {
+  cancelled = true;
+}
+
+bool ClassifierTask::wait() {
+  group.wait();
+  return state == TASK_SUCCEEDED;
+}
+
+Classifier * ClassifierTask::releaseClassifier() {
+  if (state != TASK_SUCCEEDED) return NULL;
+
+  return classifier.release();
+}
+
+bool ClassifierTask::setProgress(const float progress) {
+  this->progress = progress;
+  return !cancelled;
+}
+
+void ClassifierTask::start(std::function<bool(Classifier&)> work) {
+  group.run([this, work]() {
+    bool succeeded = false;
+
+    if (!cancelled) {
+      classifier->trainingTask = this;
+      succeeded                = work(*classifier);
+      classifier->trainingTask = NULL;
+    }
+
+    if (cancelled) state = TASK_CANCELLED;
+    else if (succeeded) {
+      progress = 1;
+      state    = TASK_SUCCEEDED;
+    }
+    else state = TASK_FAILED;
+  });
+}
+}
@@ -0,0 +1,129 @@
+﻿#pragma once
+
+#include "../GRT.h"
+#include "../Utility/ThreadPool.h"
+#include <atomic>
+#include <functional>
+#include <memory>
+
+namespace GRT {
+class Classifier;
+
+/**
+   @brief The ClassifierTask class is the handle of a classifier being trained
+      or loaded in the background, see Classifier::trainAsync and
+      Classifier::loadAsync.
+
+   The task owns its own copy of the classifier, so the classifier it was
+      started from can keep predicting while the task runs.  Once the task
+      has succeeded, releaseClassifier hands the new classifier over so it can
+      be swapped in.  All the functions can be called from any thread, and
+      none of them block apart from wait and the destructor.
+ */
+class GRT_API ClassifierTask {
+public:
+
+  enum TaskStates { TASK_RUNNING = 0, TASK_SUCCEEDED, TASK_FAILED,
+                    TASK_CANCELLED };
+
+  /**
+     Default Constructor
+
+     @param classifier: the classifier the task trains or loads, the task
+        takes ownership of it
+   */
+  ClassifierTask(Classifier *classifier);
+
+  /**
+     Default Destructor, cancels the task and waits for it to stop
+   */
+  ~ClassifierTask();
+
+  /**
+     Cancels the task.  Training stops at the next point the classifier
+        reports its progress, and the task ends as TASK_CANCELLED.
+   */
+  void cancel();
+
+  /**
+     Returns true if the task has been cancelled.
+
+     @return returns true if the task has been cancelled, false otherwise
+   */
+  bool isCancelled() const {
+    return cancelled;
+  }
+
+  /**
+     Returns true if the task has finished, whether it succeeded or not.
+
+     @return returns true if the task has finished, false otherwise
+   */
+  bool isDone() const {
+    return state != TASK_RUNNING;
+  }
+
+  /**
+     Gets the state of the task.
+
+     @return returns one of the TaskStates enums
+   */
+  uint32 getState() const {
+    return state;
+  }
+
+  /**
+     Gets the progress of the task, as reported by the classifier.
+
+     @return returns the progress, in the range [0 1]
+   */
+  float getProgress() const {
+    return progress;
+  }
+
+  /**
+     Blocks until the task has finished.
+
+     @return returns true if the task succeeded, false otherwise
+   */
+  bool wait();
+
+  /**
+     Hands over the trained or loaded classifier.  The caller is responsible
+        for deleting it.
+
+     @return returns the classifier if the task succeeded and it has not been
+        released yet, NULL otherwise
+   */
+  Classifier* releaseClassifier();
+
+  /**
+     Sets the progress of the task, this is called by the classifier while it
+        trains.
+
+     @param progress: the progress, in the range [0 1]
+     @return returns false if the task has been cancelled, true otherwise
+   */
+  bool setProgress(const float progress);
+
+protected:
+
+  friend class Classifier;
+
+  /**
+     Starts running work on the thread pool.
+
+     @param work: trains or loads the classifier, returning true if it
+        succeeded
+   */
+  void start(std::function<bool(Classifier&)> work);
+
+  std::unique_ptr<Classifier> classifier; // The classifier the task trains
+  std::atomic<uint32> state;              // The TaskStates value
+  std::atomic<float>  progress;           // The progress of the task [0 1]
+  std::atomic<bool>   cancelled;          // Set by cancel
+  TaskGroup group;                        // Runs the task, this is destroyed
+                                          // first so the task stops before the
+                                          // classifier is deleted
+};
+}
@@ -82,6 +82,18 @@ bool MLBase::train_(TimeSeriesClassificationData& trainingData) {
   return false;
 }
 
+bool MLBase::train(ContiguousTimeSeriesClassificationData trainingData) {
+  return train_(trainingData);
+}
+
+bool MLBase::train_(ContiguousTimeSeriesClassificationData& trainingData) {
+  TimeSeriesClassificationData data;
+
+  if (!trainingData.copyTo(data)) return false;
+
+  return train_(data);
+}
+
 bool MLBase::train(MatrixFloat data) {
   return train_(data);
 }
@@ -106,6 +118,18 @@ bool MLBase::predict_(MatrixFloat& inputMatrix) {
   return false;
 }
 
+bool MLBase::predict(const MatrixView& inputMatrix) {
+  return predict_(inputMatrix);
+}
+
+bool MLBase::predict_(const MatrixView& inputMatrix) {
+  MatrixFloat data;
+
+  if (!inputMatrix.copyTo(data)) return false;
+
+  return predict_(data);
+}
+
 bool MLBase::map(VectorFloat inputVector) {
   return map_(inputVector);
 }
@@ -8,6 +8,8 @@
 #include "../Utility/TestInstanceResult.h"
 #include "../Utility/DataType.h"
 #include "../Types/TimeSeriesClassificationData.h"
+#include "../Types/ContiguousTimeSeriesClassificationData.h"
+#include "../Types/MatrixView.h"
 
 #ifndef GRT_MLBASE_HEADER
 # define GRT_MLBASE_HEADER
@@ -123,6 +125,32 @@ public:
    */
   virtual bool    train_(TimeSeriesClassificationData& trainingData);
 
+  /**
+     This is the main training interface for
+        ContiguousTimeSeriesClassificationData.
+     By default it will call the train_ function, unless it is overwritten by
+        the derived class.
+
+     @param trainingData: the training data that will be used to train the ML
+        model, copying it only copies its sample indices
+     @return returns true if the classifier was successfully trained, false
+        otherwise
+   */
+  virtual bool    train(ContiguousTimeSeriesClassificationData trainingData);
+
+  /**
+     This is the main training interface for referenced
+        ContiguousTimeSeriesClassificationData.  By default the data is copied
+        into a TimeSeriesClassificationData and trained with its train_, a
+        derived class can overwrite this to train straight from the arena.
+
+     @param trainingData: a reference to the training data that will be used to
+        train the ML model
+     @return returns true if the classifier was successfully trained, false
+        otherwise
+   */
+  virtual bool    train_(ContiguousTimeSeriesClassificationData& trainingData);
+
   /**
      This is the main training interface for MatrixFloat data.
      By default it will call the train_ function, unless it is overwritten by
@@ -189,6 +217,31 @@ public:
    */
   virtual bool    predict_(MatrixFloat& inputMatrix);
 
+  /**
+     This is the prediction interface for time series data that is not owned
+        by the caller, such as a sub-range of a larger recording or an external
+        sensor buffer.
+     By default it will call the predict_ function, unless it is overwritten by
+        the derived class.
+
+     @param inputMatrix: a view of the input matrix for prediction
+     @return returns true if the prediction was completed successfully, false
+        otherwise (the base class always returns false)
+   */
+  virtual bool    predict(const MatrixView& inputMatrix);
+
+  /**
+     This is the prediction interface for a view of time series data. By
+        default the view is copied into a MatrixFloat and passed to
+        predict_(MatrixFloat&), derived classes that can work on the view
+        directly should overwrite this function.
+
+     @param inputMatrix: a view of the input matrix for prediction
+     @return returns true if the prediction was completed successfully, false
+        otherwise
+   */
+  virtual bool    predict_(const MatrixView& inputMatrix);
+
   /**
      This is the main mapping interface for all the GRT machine learning
         algorithms.
@@ -0,0 +1,159 @@
+﻿#include "StreamingRecognizer.h"
+#include <cstring>
+
+namespace GRT {
+StreamingRecognizer::StreamingRecognizer(const uint32 numDimensions,
+                                         const uint32 queueSize) {
+  uint32 size = 1;
+
+  while (size < queueSize) size <<= 1;
+
+  this->numDimensions = numDimensions;
+  queueMask           = size - 1;
+  queuedSamples.resize(size * numDimensions, 0);
+  queuedFrames.resize(size, 0);
+  queuedTimestamps.resize(size, 0);
+  queueHead           = 0;
+  queueTail           = 0;
+  numDroppedSamples   = 0;
+  pendingClassifier   = NULL;
+  inputSample.resize(numDimensions, 0);
+  numSamplesPredicted = 0;
+  backResult          = 0;
+  frontResult         = 1;
+  middleResult        = 2;
+  jobRunning          = false;
+  stopping            = false;
+}
+
+StreamingRecognizer::~StreamingRecognizer() {
+  stopping = true;
+  group.wait();
+  delete pendingClassifier.exchange(NULL);
+}
+
+bool StreamingRecognizer::setClassifier(Classifier *classifier) {
+  if (classifier && classifier->getTrained() &&
+      (classifier->getNumInputDimensions() != numDimensions)) {
+    UE_LOG(GRTModule, Error,
+           TEXT(
+             "setClassifier(...) - The number of dimensions of the classifier (%d) does not match the recognizer (%d)!"),
+           classifier->getNumInputDimensions(), numDimensions);
+    delete classifier;
+    return false;
+  }
+
+  // A classifier that was never swapped in is replaced
+  delete pendingClassifier.exchange(classifier);
+  return true;
+}
+
+bool StreamingRecognizer::pushSample(const float *sample,
+                                     const uint64 frameNumber,
+                                     const double timestamp) {
+  const uint32 tail = queueTail.load(std::memory_order_relaxed);
+
+  if (tail - queueHead.load(std::memory_order_acquire) > queueMask) {
+    numDroppedSamples++;
+    return false;
+  }
+
+  const uint32 slot = tail & queueMask;
+  memcpy(&queuedSamples[slot * numDimensions], sample,
+         sizeof(float) * numDimensions);
+  queuedFrames[slot]     = frameNumber;
+  queuedTimestamps[slot] = timestamp;
+  queueTail.store(tail + 1, std::memory_order_release);
+
+  // Start a job if there is not one already, a running job picks the sample
+  // up before it finishes
+  if (!jobRunning.exchange(true)) {
+    group.run([this]() {
+      runJob();
+    });
+  }
+  return true;
+}
+
+bool StreamingRecognizer::pushSample(const VectorFloat& sample,
+                                     const uint64       frameNumber,
+                                     const double       timestamp) {
+  if (sample.getSize() != numDimensions) {
+    UE_LOG(GRTModule, Error,
+           TEXT(
+             "pushSample(...) - The size of the sample (%d) does not match the number of dimensions (%d)!"),
+           sample.getSize(), numDimensions);
+    return false;
+  }
+  return pushSample(&sample[0], frameNumber, timestamp);
+}
+
+const RecognitionResult& StreamingRecognizer::getLatestResult() {
+  if (middleResult.load(std::memory_order_acquire) & NEW_RESULT_FLAG) {
+    frontResult = middleResult.exchange(frontResult,
+                                        std::memory_order_acq_rel) &
+                  ~NEW_RESULT_FLAG;
+  }
+  return results[frontResult];
+}
+
+void StreamingRecognizer::runJob() {
+  do {
+    uint64 frameNumber = 0;
+    double timestamp   = 0;
+
+    while (!stopping && popSample(inputSample, frameNumber, timestamp)) {
+      // Swap in a new classifier before the next sample
+      Classifier *newClassifier = pendingClassifier.exchange(NULL);
+
+      if (newClassifier) classifier.reset(newClassifier);
+
+      if (!classifier || !classifier->getTrained()) continue;
+
+      if (classifier->predict_(inputSample)) {
+        numSamplesPredicted++;
+        publishResult(frameNumber, timestamp);
+      }
+    }
+
+    jobRunning = false;
+
+    // A sample pushed after the queue was emptied, but before jobRunning was
+    // cleared, did not start a job so it is picked up here
+  } while (!stopping && (queueHead != queueTail) && !jobRunning.exchange(true));
+}
+
+bool StreamingRecognizer::popSample(VectorFloat& sample,
+                                    uint64     & frameNumber,
+                                    double     & timestamp) {
+  const uint32 head = queueHead.load(std::memory_order_relaxed);
+
+  if (head == queueTail.load(std::memory_order_acquire)) return false;
+
+  const uint32 slot = head & queueMask;
+  memcpy(&sample[0], &queuedSamples[slot * numDimensions],
+         sizeof(float) * numDimensions);
+  frameNumber = queuedFrames[slot];
+  timestamp   = queuedTimestamps[slot];
+  queueHead.store(head + 1, std::memory_order_release);
+  return true;
+}
+
+void StreamingRecognizer::publishResult(const uint64 frameNumber,
+                                        const double timestamp) {
+  RecognitionResult& result = results[backResult];
+
+  result.frameNumber         = frameNumber;
+  result.timestamp           = timestamp;
+  result.numSamples          = numSamplesPredicted;
+  result.predictedClassLabel = classifier->getPredictedClassLabel();
+  result.maxLikelihood       = classifier->getMaximumLikelihood();
+  result.bestDistance        = classifier->getBestDistance();
+  result.classLikelihoods    = classifier->getClassLikelihoods();
+  result.classDistances      = classifier->getClassDistances();
+
+  backResult = middleResult.exchange(backResult | NEW_RESULT_FLAG,
+                                     std::memory_order_acq_rel) &
+               ~NEW_RESULT_FLAG;
+}
+}
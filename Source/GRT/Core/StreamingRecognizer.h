@@ -0,0 +1,185 @@
+﻿#pragma once
+
+#include "../GRT.h"
+#include "Classifier.h"
+#include "../Utility/ThreadPool.h"
+#include <atomic>
+#include <memory>
+
+namespace GRT {
+/**
+   @brief The RecognitionResult class holds the prediction a
+      StreamingRecognizer made for one input sample.
+ */
+class GRT_API RecognitionResult {
+public:
+
+  RecognitionResult() {
+    frameNumber         = 0;
+    timestamp           = 0;
+    numSamples          = 0;
+    predictedClassLabel = GRT_DEFAULT_NULL_CLASS_LABEL;
+    maxLikelihood       = 0;
+    bestDistance        = 0;
+  }
+
+  ~RecognitionResult() {}
+
+  uint64 frameNumber;          ///< The frame number the sample was pushed with
+  double timestamp;            ///< The timestamp the sample was pushed with
+  uint64 numSamples;           ///< The number of samples predicted so far, 0
+                               // if there is no prediction yet
+  uint32 predictedClassLabel;  ///< The predicted class label
+  float  maxLikelihood;        ///< The likelihood of the predicted class
+  float  bestDistance;         ///< The distance of the predicted class
+  VectorFloat classLikelihoods; ///< The likelihood of each class
+  VectorFloat classDistances;  ///< The distance of each class
+};
+
+/**
+   @brief The StreamingRecognizer class runs the realtime prediction of a
+      classifier off the calling thread, so it does not add to the frame time
+      of a game.
+
+   Each frame, pushSample copies the new input sample into a fixed size queue.
+      If the recognizer is idle, a job is started on the thread pool that
+      predicts the queued samples in order, and publishes the result of each
+      one.  getLatestResult returns the newest published result, which
+      usually belongs to the sample pushed on the previous frame; the frame
+      number and timestamp of the sample are kept with the result so the
+      delay is known.
+
+   The queue and the results are lock free, with one thread pushing and
+      reading (e.g. the game thread) and one job predicting.  pushSample
+      copies the sample and updates an atomic index, and only queues a job
+      when the last one has finished.  getLatestResult is an atomic load, and
+      an atomic exchange when there is a new result; it never copies or
+      allocates.
+
+   If the pool runs its own threads and has none (a single core machine), the
+      job runs inside pushSample, as all the pool's tasks do.
+ */
+class GRT_API StreamingRecognizer {
+public:
+
+  /**
+     Default Constructor
+
+     @param numDimensions: the number of dimensions of the input samples
+     @param queueSize: the maximum number of samples waiting to be predicted,
+        this is rounded up to a power of two
+   */
+  StreamingRecognizer(const uint32 numDimensions,
+                      const uint32 queueSize = 256);
+
+  /**
+     Default Destructor, waits for the running job to stop
+   */
+  ~StreamingRecognizer();
+
+  /**
+     Sets the classifier used for prediction, the recognizer takes ownership
+        of it.  The classifier is swapped in by the job before the next sample
+        is predicted, so this can be called while a job is running.
+
+     @param classifier: the trained classifier, NULL stops predicting
+     @return returns true if the classifier was set, false if it does not
+        match the number of dimensions
+   */
+  bool setClassifier(Classifier *classifier);
+
+  /**
+     Queues an input sample to be predicted.  The queue holds queueSize
+        samples, if the job falls that far behind the sample is dropped.
+
+     @param sample: the numDimensions values of the sample
+     @param frameNumber: the frame number of the sample, returned with its
+        result
+     @param timestamp: the time of the sample, returned with its result
+     @return returns true if the sample was queued, false if it was dropped
+   */
+  bool pushSample(const float *sample,
+                  const uint64 frameNumber,
+                  const double timestamp);
+
+  /**
+     Queues an input sample to be predicted, see pushSample above.
+
+     @param sample: the sample, it must have numDimensions values
+     @param frameNumber: the frame number of the sample
+     @param timestamp: the time of the sample
+     @return returns true if the sample was queued, false otherwise
+   */
+  bool pushSample(const VectorFloat& sample,
+                  const uint64       frameNumber,
+                  const double       timestamp);
+
+  /**
+     Gets the newest prediction.  The result is owned by the recognizer and
+        stays valid until the next call, it is only safe to call this from the
+        thread that pushes the samples.
+
+     @return returns the newest result, its numSamples is 0 if nothing has
+        been predicted yet
+   */
+  const RecognitionResult& getLatestResult();
+
+  /**
+     Gets the number of samples that were dropped because the queue was full.
+
+     @return returns the number of dropped samples
+   */
+  uint64 getNumDroppedSamples() const {
+    return numDroppedSamples;
+  }
+
+  /**
+     Gets the number of dimensions of the input samples.
+
+     @return returns the number of dimensions
+   */
+  uint32 getNumDimensions() const {
+    return numDimensions;
+  }
+
+protected:
+
+  void runJob();
+  bool popSample(VectorFloat& sample,
+                 uint64     & frameNumber,
+                 double     & timestamp);
+  void publishResult(const uint64 frameNumber,
+                     const double timestamp);
+
+  // The bit of middleResult set when it holds a result the reader has not
+  // taken yet
+  static const uint32 NEW_RESULT_FLAG = 4;
+
+  uint32 numDimensions;           // The number of input dimensions
+  uint32 queueMask;               // The queue size minus one
+  Vector<float>  queuedSamples;   // [queueSize numDimensions] samples
+  Vector<uint64> queuedFrames;    // The frame number of each queued sample
+  Vector<double> queuedTimestamps; // The timestamp of each queued sample
+  std::atomic<uint32> queueHead;  // The next sample the job predicts
+  std::atomic<uint32> queueTail;  // The next free slot of the queue
+  std::atomic<uint64> numDroppedSamples; // Samples dropped as the queue was
+                                         // full
+
+  std::unique_ptr<Classifier> classifier;    // Only used by the job
+  std::atomic<Classifier *> pendingClassifier; // Swapped in by the next job
+  VectorFloat inputSample;        // The sample being predicted by the job
+  uint64 numSamplesPredicted;     // Only used by the job
+
+  // The results are triple buffered: the job fills results[backResult],
+  // then swaps it with middleResult; the reader swaps frontResult with
+  // middleResult when there is a new result
+  RecognitionResult results[3];
+  uint32 backResult;              // Only used by the job
+  uint32 frontResult;             // Only used by the reader
+  std::atomic<uint32> middleResult;
+
+  std::atomic<bool> jobRunning;   // Set while a job is queued or running
+  std::atomic<bool> stopping;     // Set by the destructor
+  TaskGroup group;                // Runs the jobs
+};
+}
@@ -4,9 +4,14 @@
 
 #include "Types/VectorFloat.h"
 #include "Types/MatrixFloat.h"
+#include "Types/MatrixView.h"
 #include "Types/TimeSeriesClassificationData.h"
 
 #include "Core/GRTBase.h"
 #include "Core/Classifier.h"
+#include "Core/ClassifierTask.h"
+#include "Core/StreamingRecognizer.h"
+
+#include "Utility/ThreadPool.h"
 
 #include "Classifier/DTW.h"
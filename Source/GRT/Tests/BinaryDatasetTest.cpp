@@ -0,0 +1,169 @@
+﻿#include "../GRT.h"
+#include "../Types/MappedTimeSeriesClassificationData.h"
+#include "../Types/TimeSeriesClassificationData.h"
+#include "HAL/FileManager.h"
+#include "Misc/AutomationTest.h"
+#include "Misc/Paths.h"
+#include <random>
+
+#if WITH_DEV_AUTOMATION_TESTS
+
+namespace {
+using namespace GRT;
+
+// The size of the generated dataset
+const uint32 NUM_CLASSES           = 4;
+const uint32 NUM_SAMPLES_PER_CLASS = 100;
+const uint32 NUM_DIMENSIONS        = 6;
+
+// Fills the data with random walks of 80 to 140 rows, a different drift for
+// each class
+void makeRandomWalks(TimeSeriesClassificationData& data) {
+  std::mt19937 generator(13);
+  std::uniform_real_distribution<float> drift(-0.05f, 0.05f);
+  std::uniform_real_distribution<float> step(-0.2f, 0.2f);
+
+  data.setNumDimensions(NUM_DIMENSIONS);
+  data.setDatasetName(TEXT("BinaryDatasetTest"));
+  data.setInfoText(TEXT("Random walks"));
+
+  for (uint32 k = 0; k < NUM_CLASSES; k++) {
+    VectorFloat classDrift(NUM_DIMENSIONS);
+
+    for (uint32 j = 0; j < NUM_DIMENSIONS; j++) {
+      classDrift[j] = drift(generator);
+    }
+
+    for (uint32 x = 0; x < NUM_SAMPLES_PER_CLASS; x++) {
+      const uint32 length = 80 + generator() % 61;
+      VectorFloat  sample(NUM_DIMENSIONS, 0);
+      MatrixFloat  trainingSample;
+
+      for (uint32 i = 0; i < length; i++) {
+        for (uint32 j = 0; j < NUM_DIMENSIONS; j++) {
+          sample[j] += classDrift[j] + step(generator);
+        }
+        trainingSample.push_back(sample);
+      }
+      data.addSample(k + 1, trainingSample);
+    }
+  }
+}
+
+// Returns the number of samples of the mapped file that differ from the
+// loaded dataset, in their label, length or any value
+uint32 countDifferentSamples(const TimeSeriesClassificationData     & data,
+                             const MappedTimeSeriesClassificationData& mapped)
+{
+  uint32 numDifferent = 0;
+
+  for (uint32 n = 0; n < data.getNumSamples(); n++) {
+    const MatrixFloat& sample = data[n].getData();
+    const MatrixView   view   = mapped.getSample(n);
+    bool isSame = (data[n].getClassLabel() == mapped.getClassLabel(n)) &&
+                  (sample.getNumRows() == view.getNumRows()) &&
+                  (sample.getNumCols() == view.getNumCols());
+
+    for (uint32 i = 0; isSame && i < sample.getNumRows(); i++) {
+      for (uint32 j = 0; j < sample.getNumCols(); j++) {
+        if (sample[i][j] != view[i][j]) isSame = false;
+      }
+    }
+
+    if (!isSame) numDifferent++;
+  }
+  return numDifferent;
+}
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FGRTBinaryDatasetTest,
+                                 "GRT.Dataset.BinaryFile",
+                                 EAutomationTestFlags::ApplicationContextMask |
+                                 EAutomationTestFlags::PerfFilter)
+
+bool FGRTBinaryDatasetTest::RunTest(const FString& Parameters) {
+  const FString directory  = FPaths::AutomationTransientDir();
+  const FString textFile   = directory + TEXT("BinaryDatasetTest.grt");
+  const FString binaryFile = directory + TEXT("BinaryDatasetTest.bin");
+
+  // Write the generated dataset as text and convert it with the converter
+  {
+    TimeSeriesClassificationData generated;
+    makeRandomWalks(generated);
+
+    if (!TestTrue(TEXT("The text dataset was saved"),
+                  generated.saveDatasetToFile(textFile))) return false;
+  }
+
+  const bool isConverted =
+    MappedTimeSeriesClassificationData::convertTextFile(textFile, binaryFile);
+
+  if (!TestTrue(TEXT("The text dataset was converted"), isConverted)) {
+    IFileManager::Get().Delete(*textFile);
+    return false;
+  }
+
+  // Time parsing the text file against opening the binary file in place
+  TimeSeriesClassificationData parsed, loaded;
+  MappedTimeSeriesClassificationData mapped;
+
+  const double parseStart = FPlatformTime::Seconds();
+  const bool   isParsed   = parsed.loadDatasetFromFile(textFile);
+  const double parseTime  = FPlatformTime::Seconds() - parseStart;
+
+  const double loadStart = FPlatformTime::Seconds();
+  const bool   isLoaded  = loaded.loadDatasetFromBinaryFile(binaryFile);
+  const double loadTime  = FPlatformTime::Seconds() - loadStart;
+
+  const double openStart = FPlatformTime::Seconds();
+  const bool   isOpen    = mapped.open(binaryFile);
+  const double openTime  = FPlatformTime::Seconds() - openStart;
+
+  bool succeeded = TestTrue(TEXT("The text file was parsed"), isParsed) &&
+                   TestTrue(TEXT("The binary file was loaded"), isLoaded) &&
+                   TestTrue(TEXT("The binary file was opened"), isOpen);
+
+  if (succeeded) {
+    AddInfo(FString::Printf(TEXT(
+                              "%d samples of %d dimensions: text parse %.2f ms, binary load %.2f ms, mapped open %.3f ms"),
+                            parsed.getNumSamples(), parsed.getNumDimensions(),
+                            parseTime * 1.0e3, loadTime * 1.0e3,
+                            openTime * 1.0e3));
+
+    // The converted file must hold exactly the samples of the text file
+    TestEqual(TEXT("The number of samples"), mapped.getNumSamples(),
+              parsed.getNumSamples());
+    TestEqual(TEXT("The number of dimensions"), mapped.getNumDimensions(),
+              parsed.getNumDimensions());
+    TestEqual(TEXT("The number of classes"), mapped.getNumClasses(),
+              parsed.getNumClasses());
+    TestTrue(TEXT("The dataset name"),
+             mapped.getDatasetName() == parsed.getDatasetName());
+
+    if (mapped.getNumSamples() == parsed.getNumSamples()) {
+      TestEqual(TEXT("Mapped samples that differ from the text file"),
+                countDifferentSamples(parsed, mapped), 0u);
+
+      if (loaded.getNumSamples() == parsed.getNumSamples()) {
+        TestEqual(TEXT("Loaded samples that differ from the text file"),
+                  countDifferentSamples(loaded, mapped), 0u);
+      }
+      else {
+        AddError(TEXT("The loaded binary file has a different number of samples"));
+      }
+    }
+
+    if (openTime >= parseTime) {
+      AddError(TEXT("Opening the binary file was not faster than parsing the text file"));
+    }
+    succeeded = !HasAnyErrors();
+  }
+
+  // The mapped file must be released before it is deleted
+  mapped.close();
+  IFileManager::Get().Delete(*textFile);
+  IFileManager::Get().Delete(*binaryFile);
+  return succeeded;
+}
+
+#endif // WITH_DEV_AUTOMATION_TESTS
@@ -0,0 +1,142 @@
+﻿#include "../GRT.h"
+#include "../Classifier/DTW.h"
+#include "../Core/ClassifierTask.h"
+#include "../Utility/ThreadPool.h"
+#include "Misc/AutomationTest.h"
+#include <random>
+
+#if WITH_DEV_AUTOMATION_TESTS
+
+namespace {
+using namespace GRT;
+
+// The length of a simulated frame of the game loop, in seconds
+const float FRAME_TIME = 1.0f / 60;
+
+// A frame must not spend longer than this starting or polling the training,
+// so the game loop does not hitch
+const double MAXIMUM_FRAME_WORK = FRAME_TIME / 4;
+
+// Fills the data with 10 classes of 20 random walks in 3 dimensions, like
+// the sample component does
+bool makeRandomWalks(TimeSeriesClassificationData& data) {
+  std::mt19937 generator(3);
+  std::uniform_real_distribution<float> start(-1, 1), step(-0.1f, 0.1f);
+
+  data.setNumDimensions(3);
+
+  for (uint32 k = 0; k < 10; k++) {
+    VectorFloat startPos(3);
+
+    for (uint32 j = 0; j < 3; j++) startPos[j] = start(generator);
+
+    for (uint32 x = 0; x < 20; x++) {
+      const uint32 length = 90 + generator() % 21;
+      VectorFloat  sample = startPos;
+      MatrixFloat  trainingSample;
+
+      for (uint32 i = 0; i < length; i++) {
+        for (uint32 j = 0; j < 3; j++) sample[j] += step(generator);
+        trainingSample.push_back(sample);
+      }
+      data.addSample(k + 1, trainingSample);
+    }
+  }
+  return true;
+}
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FGRTClassifierTrainAsyncTest,
+                                 "GRT.Classifier.TrainAsync",
+                                 EAutomationTestFlags::ApplicationContextMask |
+                                 EAutomationTestFlags::PerfFilter)
+
+bool FGRTClassifierTrainAsyncTest::RunTest(const FString& Parameters) {
+  TimeSeriesClassificationData data;
+  GRT::DTW blocking;
+
+  makeRandomWalks(data);
+
+  // The time the game thread would be blocked by training in place
+  const double blockingStart = FPlatformTime::Seconds();
+  blocking.train(data);
+  const double blockingTime = FPlatformTime::Seconds() - blockingStart;
+
+  // Start the training the way the sample component does, then run a game
+  // loop that polls it once a frame until it is done
+  GRT::DTW settings;
+  const double startTime = FPlatformTime::Seconds();
+  TSharedPtr<ClassifierTask, ESPMode::ThreadSafe> task =
+    settings.trainAsync(&makeRandomWalks);
+  const double taskStartTime = FPlatformTime::Seconds() - startTime;
+
+  if (!task.IsValid()) {
+    AddError(TEXT("The training could not be started"));
+    return false;
+  }
+
+  double maxPollTime = 0;
+  uint32 numFrames   = 0;
+  bool   done        = false;
+
+  while (!done) {
+    const double pollStart = FPlatformTime::Seconds();
+    task->getProgress();
+    done = task->isDone();
+    maxPollTime = std::max(maxPollTime, FPlatformTime::Seconds() - pollStart);
+    numFrames++;
+
+    if (!done) FPlatformProcess::Sleep(FRAME_TIME);
+  }
+
+  AddInfo(FString::Printf(TEXT(
+                            "Blocking train %.1f ms, trainAsync start %.3f ms, %d frames, max poll %.4f ms"),
+                          blockingTime * 1.0e3, taskStartTime * 1.0e3,
+                          numFrames, maxPollTime * 1.0e3));
+
+  // Without background threads the training runs inside trainAsync, so the
+  // start time is only checked when there are threads to run it on
+  const ThreadPool& pool = ThreadPool::getInstance();
+  bool succeeded         = true;
+
+  if ((pool.getUseEngineTaskGraph() || (pool.getNumThreads() > 0)) &&
+      (taskStartTime > MAXIMUM_FRAME_WORK)) {
+    AddError(FString::Printf(TEXT(
+                               "trainAsync blocked the game thread for %.3f ms"),
+                             taskStartTime * 1.0e3));
+    succeeded = false;
+  }
+
+  if (maxPollTime > MAXIMUM_FRAME_WORK) {
+    AddError(FString::Printf(TEXT(
+                               "Polling the training blocked the game thread for %.3f ms"),
+                             maxPollTime * 1.0e3));
+    succeeded = false;
+  }
+
+  // The model trained in the background must predict like the blocking one
+  Classifier *trained = task->releaseClassifier();
+
+  if (!TestTrue(TEXT("The background training succeeded"),
+                (trained != NULL) && trained->getTrained())) {
+    delete trained;
+    return false;
+  }
+
+  uint32 numMismatches = 0;
+
+  for (uint32 i = 0; i < data.getNumSamples(); i += 7) {
+    blocking.predict(data[i].getData());
+    trained->predict(data[i].getData());
+
+    if (blocking.getPredictedClassLabel() !=
+        trained->getPredictedClassLabel()) numMismatches++;
+  }
+  delete trained;
+
+  TestEqual(TEXT("Predictions that differ from the blocking training"),
+            numMismatches, 0u);
+  return succeeded && (numMismatches == 0);
+}
+
+#endif // WITH_DEV_AUTOMATION_TESTS
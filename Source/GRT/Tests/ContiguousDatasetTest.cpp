@@ -0,0 +1,149 @@
+﻿#include "../GRT.h"
+#include "../Classifier/DTW.h"
+#include "../Types/ContiguousTimeSeriesClassificationData.h"
+#include "../Types/TimeSeriesClassificationData.h"
+#include "Misc/AutomationTest.h"
+#include <random>
+
+#if WITH_DEV_AUTOMATION_TESTS
+
+namespace {
+using namespace GRT;
+
+// The size of the generated dataset
+const uint32 NUM_CLASSES           = 4;
+const uint32 NUM_SAMPLES_PER_CLASS = 15;
+
+// Fills the data with noisy 3 dimensional gestures between idle periods, so
+// the trimming has rows to remove
+void makeGestures(TimeSeriesClassificationData& data) {
+  std::mt19937 generator(17);
+  std::normal_distribution<float> noise(0, 0.05f);
+
+  data.setNumDimensions(3);
+
+  for (uint32 x = 0; x < NUM_CLASSES * NUM_SAMPLES_PER_CLASS; x++) {
+    const uint32 k      = x % NUM_CLASSES;
+    const uint32 idle   = 5 + generator() % 6;
+    const uint32 length = 30 + generator() % 15;
+    MatrixFloat  gesture(idle + length + idle, 3);
+
+    for (uint32 i = 0; i < gesture.getNumRows(); i++) {
+      const bool  isIdle = (i < idle) || (i >= idle + length);
+      const float t      = isIdle ? 0 : float(i - idle) / length;
+
+      gesture[i][0] = sin(6.283f * t * (1 + k % 3)) * 2 + noise(generator);
+      gesture[i][1] = (isIdle ? 0 : cos(6.283f * t * (1 + k % 2))) +
+                      noise(generator);
+      gesture[i][2] = t * (k + 1) + 5 + noise(generator);
+    }
+    data.addSample(k + 1, gesture);
+  }
+}
+
+// Returns the number of templates that differ between the two models
+uint32 countDifferentTemplates(const DTW& a, const DTW& b) {
+  const Vector<DTWTemplate> templatesA = a.getModels();
+  const Vector<DTWTemplate> templatesB = b.getModels();
+
+  if (templatesA.size() != templatesB.size()) {
+    return (uint32)std::max(templatesA.size(), templatesB.size());
+  }
+
+  uint32 numDifferent = 0;
+
+  for (uint32 k = 0; k < templatesA.size(); k++) {
+    const MatrixFloat& ta = templatesA[k].timeSeries;
+    const MatrixFloat& tb = templatesB[k].timeSeries;
+    bool isSame = (templatesA[k].classLabel == templatesB[k].classLabel) &&
+                  (templatesA[k].trainingMu == templatesB[k].trainingMu) &&
+                  (ta.getNumRows() == tb.getNumRows()) &&
+                  (ta.getNumCols() == tb.getNumCols());
+
+    for (uint32 i = 0; isSame && i < ta.getNumRows(); i++) {
+      for (uint32 j = 0; j < ta.getNumCols(); j++) {
+        if (ta[i][j] != tb[i][j]) isSame = false;
+      }
+    }
+
+    if (!isSame) numDifferent++;
+  }
+  return numDifferent;
+}
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FGRTContiguousDatasetTest,
+                                 "GRT.Dataset.Contiguous",
+                                 EAutomationTestFlags::ApplicationContextMask |
+                                 EAutomationTestFlags::PerfFilter)
+
+bool FGRTContiguousDatasetTest::RunTest(const FString& Parameters) {
+  TimeSeriesClassificationData data;
+
+  makeGestures(data);
+
+  const ContiguousTimeSeriesClassificationData contiguousData(data);
+
+  TestEqual(TEXT("The number of samples"), contiguousData.getNumSamples(),
+            data.getNumSamples());
+  TestTrue(TEXT("The hash matches the hash of the packed dataset"),
+           contiguousData.getHash() == data.getHash());
+
+  // A subset shares the arena, and adding to it leaves the arena unchanged
+  Vector<uint32> sampleIndexs;
+
+  for (uint32 i = 0; i < data.getNumSamples(); i += 3) {
+    sampleIndexs.push_back(i);
+  }
+
+  ContiguousTimeSeriesClassificationData subset =
+    contiguousData.getSubset(sampleIndexs);
+  const uint64 arenaSize = contiguousData.getArenaSize();
+
+  TestTrue(TEXT("The subset shares the arena"),
+           subset.getArenaSize() == arenaSize);
+
+  subset.addSample(1, data[0].getData());
+
+  TestTrue(TEXT("Adding to the subset does not change the shared arena"),
+           (contiguousData.getArenaSize() == arenaSize) &&
+           (contiguousData.getHash() == data.getHash()));
+
+  // Training from the arena gives the same model as training from a copy,
+  // and does not change the data
+  bool succeeded = true;
+
+  for (uint32 cfg = 0; cfg < 4; cfg++) {
+    GRT::DTW fromCopy(cfg & 1, true);
+    GRT::DTW fromArena(cfg & 1, true);
+
+    fromCopy.enableTrimTrainingData(cfg & 2, 0.1f, 90);
+    fromArena.enableTrimTrainingData(cfg & 2, 0.1f, 90);
+
+    ContiguousTimeSeriesClassificationData trainingData(contiguousData);
+
+    if (!fromCopy.train(data) || !fromArena.train_(trainingData)) {
+      AddError(FString::Printf(TEXT("Configuration %d could not be trained"),
+                               cfg));
+      succeeded = false;
+      continue;
+    }
+
+    const uint32 numDifferent = countDifferentTemplates(fromCopy, fromArena);
+
+    AddInfo(FString::Printf(TEXT(
+                              "Configuration %d: %d templates differ between the copy and the arena"),
+                            cfg, numDifferent));
+
+    if ((numDifferent > 0) || (trainingData.getHash() != data.getHash()) ||
+        (trainingData.getArenaSize() != arenaSize)) {
+      AddError(FString::Printf(TEXT(
+                                 "Configuration %d: training from the arena changed the model or the data"),
+                               cfg));
+      succeeded = false;
+    }
+  }
+  return succeeded && !HasAnyErrors();
+}
+
+#endif // WITH_DEV_AUTOMATION_TESTS
@@ -0,0 +1,192 @@
+﻿#include "../GRT.h"
+#include "../Classifier/DTW.h"
+#include "HAL/FileManager.h"
+#include "Misc/AutomationTest.h"
+#include "Misc/FileHelper.h"
+#include "Misc/Paths.h"
+#include <random>
+
+#if WITH_DEV_AUTOMATION_TESTS
+
+namespace {
+using namespace GRT;
+
+// The number of gesture classes, and the gestures of each class used for
+// training and for testing
+const uint32 NUM_CLASSES          = 5;
+const uint32 NUM_TRAINING_SAMPLES = 10;
+const uint32 NUM_TEST_SAMPLES     = 20;
+
+// Makes a noisy 3 dimensional gesture of the given class, about 50 samples
+// long at a random speed
+MatrixFloat makeGesture(const uint32 k, std::mt19937& generator) {
+  std::uniform_real_distribution<float> speed(0.8f, 1.25f);
+  std::normal_distribution<float> noise(0, 0.05f);
+  const uint32 length = uint32(50 * speed(generator));
+  MatrixFloat gesture(length, 3);
+
+  for (uint32 i = 0; i < length; i++) {
+    const float t = float(i) / length;
+
+    gesture[i][0] = sin(6.283f * t * (1 + k % 3)) + noise(generator);
+    gesture[i][1] = cos(6.283f * t * (1 + k % 2)) * (k % 2 ? 1 : -1) +
+                    noise(generator);
+    gesture[i][2] = t * (k % 4) + noise(generator);
+  }
+  return gesture;
+}
+
+// Returns the number of templates that differ between the two models, in any
+// of their values
+uint32 countDifferentTemplates(const DTW& a, const DTW& b) {
+  const Vector<DTWTemplate> templatesA = a.getModels();
+  const Vector<DTWTemplate> templatesB = b.getModels();
+
+  if (templatesA.size() != templatesB.size()) {
+    return (uint32)std::max(templatesA.size(), templatesB.size());
+  }
+
+  uint32 numDifferent = 0;
+
+  for (uint32 k = 0; k < templatesA.size(); k++) {
+    const DTWTemplate& ta = templatesA[k];
+    const DTWTemplate& tb = templatesB[k];
+    bool isSame = (ta.classLabel == tb.classLabel) &&
+                  (ta.trainingMu == tb.trainingMu) &&
+                  (ta.trainingSigma == tb.trainingSigma) &&
+                  (ta.averageTemplateLength == tb.averageTemplateLength) &&
+                  (ta.timeSeries.getNumRows() == tb.timeSeries.getNumRows()) &&
+                  (ta.timeSeries.getNumCols() == tb.timeSeries.getNumCols());
+
+    for (uint32 i = 0; isSame && i < ta.timeSeries.getNumRows(); i++) {
+      for (uint32 j = 0; j < ta.timeSeries.getNumCols(); j++) {
+        if (ta.timeSeries[i][j] != tb.timeSeries[i][j]) isSame = false;
+      }
+    }
+
+    if (!isSame) numDifferent++;
+  }
+  return numDifferent;
+}
+
+// Returns true if the two models have the same settings that can be read
+// back, the others are compared through the text the models save
+bool isSameSettings(const DTW& a, const DTW& b) {
+  const Vector<MinMax> rangesA = a.getRanges();
+  const Vector<MinMax> rangesB = b.getRanges();
+
+  if (rangesA.size() != rangesB.size()) return false;
+
+  for (uint32 j = 0; j < rangesA.size(); j++) {
+    if ((rangesA[j].minValue != rangesB[j].minValue) ||
+        (rangesA[j].maxValue != rangesB[j].maxValue)) return false;
+  }
+
+  return (a.getNumInputDimensions() == b.getNumInputDimensions()) &&
+         (a.getClassLabels() == b.getClassLabels()) &&
+         (a.getNullRejectionEnabled() == b.getNullRejectionEnabled()) &&
+         (a.getNullRejectionCoeff() == b.getNullRejectionCoeff()) &&
+         (a.getRejectionMode() == b.getRejectionMode()) &&
+         (a.getConstrainWarpingPath() == b.getConstrainWarpingPath()) &&
+         (a.getConstrainZNorm() == b.getConstrainZNorm()) &&
+         (a.getNumTemplates() == b.getNumTemplates()) &&
+         (a.getTemplateSelectionMethod() == b.getTemplateSelectionMethod());
+}
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FGRTDTWBinaryModelTest,
+                                 "GRT.DTW.BinaryModel",
+                                 EAutomationTestFlags::ApplicationContextMask |
+                                 EAutomationTestFlags::PerfFilter)
+
+bool FGRTDTWBinaryModelTest::RunTest(const FString& Parameters) {
+  std::mt19937 generator(11);
+  TimeSeriesClassificationData trainingData(3);
+  Vector<MatrixFloat> testGestures;
+
+  for (uint32 k = 0; k < NUM_CLASSES; k++) {
+    for (uint32 i = 0; i < NUM_TRAINING_SAMPLES; i++) {
+      trainingData.addSample(k + 1, makeGesture(k, generator));
+    }
+
+    for (uint32 i = 0; i < NUM_TEST_SAMPLES; i++) {
+      testGestures.push_back(makeGesture(k, generator));
+    }
+  }
+
+  // A scaled, smoothed model with null rejection, so every section of the
+  // binary file is used
+  GRT::DTW trained(true, true, 3.0f, GRT::DTW::TEMPLATE_THRESHOLDS, true, 0.2f,
+                   false, true, 3);
+
+  if (!TestTrue(TEXT("The model was trained"), trained.train(trainingData))) {
+    return false;
+  }
+
+  const FString directory     = FPaths::AutomationTransientDir();
+  const FString textFile      = directory + TEXT("DTWBinaryModelTest.grt");
+  const FString binaryFile    = directory + TEXT("DTWBinaryModelTest.bin");
+  const FString roundTripFile = directory +
+                                TEXT("DTWBinaryModelTest_RoundTrip.grt");
+
+  // Text -> binary -> text
+  GRT::DTW textModel, binaryModel;
+  bool     succeeded = true;
+
+  if (!TestTrue(TEXT("The text model was saved and loaded"),
+                trained.save(textFile) && textModel.load(textFile)) ||
+      !TestTrue(TEXT("The binary model was saved and memory mapped"),
+                textModel.saveBinary(binaryFile) &&
+                binaryModel.loadBinary(binaryFile)) ||
+      !TestTrue(TEXT("The memory mapped model was saved as text"),
+                binaryModel.save(roundTripFile))) {
+    succeeded = false;
+  }
+
+  if (succeeded) {
+    FString text, roundTripText;
+
+    FFileHelper::LoadFileToString(text, *textFile);
+    FFileHelper::LoadFileToString(roundTripText, *roundTripFile);
+
+    TestTrue(TEXT("The text written after the round trip is identical"),
+             text == roundTripText);
+    TestEqual(TEXT("Templates that differ after the round trip"),
+              countDifferentTemplates(textModel, binaryModel), 0u);
+    TestTrue(TEXT("The null rejection thresholds are identical"),
+             textModel.getNullRejectionThresholds() ==
+             binaryModel.getNullRejectionThresholds());
+    TestTrue(TEXT("The settings are identical"),
+             isSameSettings(textModel, binaryModel));
+
+    // The memory mapped templates must predict like the parsed ones
+    uint32 numMismatches = 0;
+
+    for (uint32 i = 0; i < testGestures.size(); i++) {
+      textModel.predict(testGestures[i]);
+      binaryModel.predict(testGestures[i]);
+
+      if ((textModel.getPredictedClassLabel() !=
+           binaryModel.getPredictedClassLabel()) ||
+          (textModel.getBestDistance() != binaryModel.getBestDistance()) ||
+          (textModel.getClassLikelihoods() !=
+           binaryModel.getClassLikelihoods())) numMismatches++;
+    }
+
+    AddInfo(FString::Printf(TEXT(
+                              "%d test gestures, %d predictions differ between the text and the memory mapped model"),
+                            (int32)testGestures.size(), numMismatches));
+    TestEqual(TEXT("Predictions that differ from the text model"),
+              numMismatches, 0u);
+    succeeded = !HasAnyErrors();
+  }
+
+  // The memory mapped file must be released before it is deleted
+  binaryModel.clear();
+  IFileManager::Get().Delete(*textFile);
+  IFileManager::Get().Delete(*binaryFile);
+  IFileManager::Get().Delete(*roundTripFile);
+  return succeeded;
+}
+
+#endif // WITH_DEV_AUTOMATION_TESTS
@@ -0,0 +1,194 @@
+﻿#include "../GRT.h"
+#include "../Classifier/DTW.h"
+#include "Misc/AutomationTest.h"
+#include <random>
+
+#if WITH_DEV_AUTOMATION_TESTS
+
+namespace {
+using namespace GRT;
+
+// The number of gesture classes, and the gestures of each class used for
+// training and for testing
+const uint32 NUM_CLASSES          = 6;
+const uint32 NUM_TRAINING_SAMPLES = 10;
+const uint32 NUM_TEST_SAMPLES     = 30;
+
+// The margin the accuracy is checked at, and the accuracy it must reach
+const float CHECKED_MARGIN   = 0.5f;
+const float MINIMUM_ACCURACY = 0.95f;
+
+// Makes a noisy 3 dimensional gesture of the given class, about 60 samples
+// long at a random speed
+MatrixFloat makeGesture(const uint32 k, std::mt19937& generator) {
+  std::uniform_real_distribution<float> speed(0.8f, 1.25f);
+  std::normal_distribution<float> noise(0, 0.05f);
+  const uint32 length = uint32(60 * speed(generator));
+  MatrixFloat gesture(length, 3);
+
+  for (uint32 i = 0; i < length; i++) {
+    const float t = float(i) / length;
+
+    gesture[i][0] = sin(6.283f * t * (1 + k % 3)) * (1 + 0.3f * (k / 3)) +
+                    noise(generator);
+    gesture[i][1] = cos(6.283f * t * (1 + (k + 1) % 2)) * (k % 2 ? 1 : -1) +
+                    noise(generator);
+    gesture[i][2] = t * (k % 4) - 0.5f * (k % 3) + noise(generator);
+  }
+  return gesture;
+}
+
+// Runs the early classification curve and a stream of gestures through the
+// model, and adds the results to the test
+bool measureEarlyClassification(FAutomationTestBase& test,
+                                DTW                & dtw,
+                                const TCHAR         *modelName,
+                                std::mt19937       & generator) {
+  TimeSeriesClassificationData trainingData(3), testData(3);
+
+  for (uint32 k = 0; k < NUM_CLASSES; k++) {
+    for (uint32 i = 0; i < NUM_TRAINING_SAMPLES; i++) {
+      trainingData.addSample(k + 1, makeGesture(k, generator));
+    }
+
+    for (uint32 i = 0; i < NUM_TEST_SAMPLES; i++) {
+      testData.addSample(k + 1, makeGesture(k, generator));
+    }
+  }
+
+  if (!dtw.train(trainingData) || !dtw.enableEarlyClassification(true)) {
+    test.AddError(FString::Printf(TEXT("%s: the model could not be trained"),
+                                  modelName));
+    return false;
+  }
+
+  // The accuracy, decision rate and observed fraction of the gestures of the
+  // first early decision for each margin
+  VectorFloat margins, accuracies, decisionRates, observedFractions;
+
+  for (uint32 m = 0; m <= 6; m++) margins.push_back(0.1f * m);
+
+  if (!dtw.computeEarlyClassificationCurve(testData, margins, accuracies,
+                                           decisionRates, observedFractions)) {
+    test.AddError(FString::Printf(TEXT("%s: the curve could not be computed"),
+                                  modelName));
+    return false;
+  }
+
+  bool succeeded = true;
+
+  for (uint32 m = 0; m < margins.size(); m++) {
+    test.AddInfo(FString::Printf(TEXT(
+                                   "%s: margin %.1f accuracy %.3f decided %.3f after %.0f%% of the gesture"),
+                                 modelName, margins[m], accuracies[m],
+                                 decisionRates[m], observedFractions[m] * 100));
+
+    if ((fabs(margins[m] - CHECKED_MARGIN) < 1.0e-3f) &&
+        ((accuracies[m] < MINIMUM_ACCURACY) || (decisionRates[m] < 1) ||
+         (observedFractions[m] >= 0.5f))) {
+      test.AddError(FString::Printf(TEXT(
+                                      "%s: at margin %.1f the early decisions should be accurate and made in the first half of the gesture"),
+                                    modelName, margins[m]));
+      succeeded = false;
+    }
+  }
+
+  // A stream of gestures between idle periods, pushed in blocks, must give
+  // the same early decisions as one sample at a time
+  std::normal_distribution<float> noise(0, 0.05f);
+  MatrixFloat stream;
+  VectorFloat idle(3);
+
+  for (uint32 r = 0; r < 4 * NUM_CLASSES; r++) {
+    for (uint32 i = 0; i < 40; i++) {
+      for (uint32 j = 0; j < 3; j++) idle[j] = 1.5f + noise(generator);
+      stream.push_back(idle);
+    }
+
+    const MatrixFloat gesture = makeGesture(r % NUM_CLASSES, generator);
+
+    for (uint32 i = 0; i < gesture.getNumRows(); i++) {
+      stream.push_back(gesture.getRow(i));
+    }
+  }
+
+  const uint32 blockSize = 16;
+  DTW single(dtw);
+  Vector<DTWDetection> detections;
+  uint32 numDecisions = 0, numMismatches = 0;
+
+  dtw.reset();
+  single.reset();
+
+  for (uint32 start = 0; start < stream.getNumRows(); start += blockSize) {
+    const uint32 numSamples = std::min(blockSize, stream.getNumRows() - start);
+
+    dtw.pushSamples(MatrixView(stream.getData() + start * 3, numSamples, 3),
+                    detections, blockSize);
+
+    for (uint32 i = 0; i < numSamples; i++) {
+      uint32 earlyClassLabel = 0;
+
+      single.predict(stream.getRow(start + i));
+
+      for (uint32 d = 0; d < detections.size(); d++) {
+        if (detections[d].early && (detections[d].sampleIndex == i)) {
+          earlyClassLabel = detections[d].classLabel;
+        }
+      }
+
+      if (earlyClassLabel != single.getEarlyClassLabel()) numMismatches++;
+
+      if (earlyClassLabel != 0) numDecisions++;
+    }
+  }
+
+  test.AddInfo(FString::Printf(TEXT(
+                                 "%s: stream of %d samples, %d early decisions"),
+                               modelName, stream.getNumRows(), numDecisions));
+
+  if ((numMismatches > 0) || (numDecisions == 0)) {
+    test.AddError(FString::Printf(TEXT(
+                                    "%s: %d of the early decisions of pushSamples differ from predict"),
+                                  modelName, numMismatches));
+    succeeded = false;
+  }
+  return succeeded;
+}
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FGRTDTWEarlyClassificationTest,
+                                 "GRT.DTW.EarlyClassification",
+                                 EAutomationTestFlags::ApplicationContextMask |
+                                 EAutomationTestFlags::PerfFilter)
+
+bool FGRTDTWEarlyClassificationTest::RunTest(const FString& Parameters) {
+  std::mt19937 generator(5);
+  bool succeeded = true;
+
+  {
+    GRT::DTW dtw;
+    succeeded = measureEarlyClassification(*this, dtw, TEXT("Unscaled"),
+                                           generator) && succeeded;
+  }
+
+  {
+    GRT::DTW dtw(true);
+    dtw.enableSmoothing(true, 3);
+    succeeded = measureEarlyClassification(*this, dtw,
+                                           TEXT("Scaled and smoothed"),
+                                           generator) && succeeded;
+  }
+
+  // The open-end matches can not follow a window that is normalised as a
+  // whole, so early classification is refused
+  {
+    GRT::DTW dtw;
+    dtw.enableZNormalization(true);
+    TestTrue(TEXT("Early classification is refused with z-normalisation"),
+             !dtw.enableEarlyClassification(true));
+  }
+  return succeeded;
+}
+
+#endif // WITH_DEV_AUTOMATION_TESTS
@@ -0,0 +1,157 @@
+﻿#include "../GRT.h"
+#include "../Classifier/DTW.h"
+#include "Misc/AutomationTest.h"
+#include <random>
+
+#if WITH_DEV_AUTOMATION_TESTS
+
+namespace {
+using namespace GRT;
+
+// The number of gesture classes and the number of samples of each class,
+// enough for the sampled selection to be used with the default settings
+const uint32 NUM_CLASSES = 6;
+const uint32 NUM_SAMPLES = 120;
+
+// The ratio of the classes whose sampled template must be the exact one
+const float MINIMUM_MATCH_RATE = 0.8f;
+
+// Makes the samples of a class: noisy 3 dimensional drifts at random speeds,
+// with every 7th sample much noisier so the choice of template matters
+void addGestures(const uint32                  classLabel,
+                 TimeSeriesClassificationData& data,
+                 std::mt19937                & generator) {
+  std::uniform_real_distribution<float> direction(-0.1f, 0.1f);
+  std::uniform_real_distribution<float> speed(0.6f, 1.4f);
+  std::uniform_real_distribution<float> noise(-0.3f, 0.3f);
+  VectorFloat drift(3);
+
+  for (uint32 j = 0; j < 3; j++) drift[j] = direction(generator);
+
+  for (uint32 x = 0; x < NUM_SAMPLES; x++) {
+    const uint32 length      = 25 + generator() % 10;
+    const float  sampleSpeed = speed(generator);
+    const float  noiseScale  = x % 7 == 0 ? 3.0f : 1.0f;
+    VectorFloat  sample(3, 0);
+    MatrixFloat  gesture;
+
+    for (uint32 i = 0; i < length; i++) {
+      for (uint32 j = 0; j < 3; j++) {
+        sample[j] += drift[j] * sampleSpeed + noise(generator) * noiseScale;
+      }
+      gesture.push_back(sample);
+    }
+    data.addSample(classLabel, gesture);
+  }
+}
+
+// Returns true if the two templates hold the same time series
+bool isSameTemplate(const DTWTemplate& a, const DTWTemplate& b) {
+  if ((a.timeSeries.getNumRows() != b.timeSeries.getNumRows()) ||
+      (a.timeSeries.getNumCols() != b.timeSeries.getNumCols())) return false;
+
+  for (uint32 i = 0; i < a.timeSeries.getNumRows(); i++) {
+    for (uint32 j = 0; j < a.timeSeries.getNumCols(); j++) {
+      if (a.timeSeries[i][j] != b.timeSeries[i][j]) return false;
+    }
+  }
+  return true;
+}
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FGRTDTWTemplateSelectionTest,
+                                 "GRT.DTW.TemplateSelection",
+                                 EAutomationTestFlags::ApplicationContextMask |
+                                 EAutomationTestFlags::PerfFilter)
+
+bool FGRTDTWTemplateSelectionTest::RunTest(const FString& Parameters) {
+  std::mt19937 generator(7);
+  TimeSeriesClassificationData data(3);
+
+  for (uint32 k = 0; k < NUM_CLASSES; k++) addGestures(k + 1, data, generator);
+
+  // Train the same classes with both template selection methods
+  GRT::DTW exact(false, true, 2.0f);
+  GRT::DTW sampled(false, true, 2.0f);
+
+  sampled.setTemplateSelectionMethod(GRT::DTW::SAMPLED_TEMPLATE_SELECTION);
+
+  const double exactStart   = FPlatformTime::Seconds();
+  const bool   exactTrained = exact.train(data);
+  const double exactTime    = FPlatformTime::Seconds() - exactStart;
+
+  const double sampledStart   = FPlatformTime::Seconds();
+  const bool   sampledTrained = sampled.train(data);
+  const double sampledTime    = FPlatformTime::Seconds() - sampledStart;
+
+  if (!TestTrue(TEXT("Both models were trained"),
+                exactTrained && sampledTrained)) return false;
+
+  // The exact template has the smallest average distance, so a sampled
+  // template can only match it or be further from the rest of its class
+  const Vector<DTWTemplate> exactTemplates   = exact.getModels();
+  const Vector<DTWTemplate> sampledTemplates = sampled.getModels();
+  uint32 numMatches = 0;
+  bool   succeeded  = true;
+
+  for (uint32 k = 0; k < NUM_CLASSES; k++) {
+    const bool isMatch = isSameTemplate(exactTemplates[k], sampledTemplates[k]);
+
+    if (isMatch) numMatches++;
+
+    AddInfo(FString::Printf(TEXT(
+                              "Class %d: %s, mean distance exact %.4f sampled %.4f"),
+                            exactTemplates[k].classLabel,
+                            isMatch ? TEXT("same template") :
+                            TEXT("different template"),
+                            exactTemplates[k].trainingMu,
+                            sampledTemplates[k].trainingMu));
+
+    if (sampledTemplates[k].trainingMu <
+        exactTemplates[k].trainingMu * (1 - 1.0e-5f)) {
+      AddError(FString::Printf(TEXT(
+                                 "Class %d: the sampled template is closer to its class than the exact one"),
+                               exactTemplates[k].classLabel));
+      succeeded = false;
+    }
+  }
+
+  const float matchRate = float(numMatches) / NUM_CLASSES;
+
+  AddInfo(FString::Printf(TEXT(
+                            "%d of %d sampled templates match the exact ones (%.0f%%), exact %.1f ms, sampled %.1f ms"),
+                          numMatches, NUM_CLASSES, matchRate * 100,
+                          exactTime * 1.0e3, sampledTime * 1.0e3));
+
+  if (matchRate < MINIMUM_MATCH_RATE) {
+    AddError(FString::Printf(TEXT(
+                               "Only %.0f%% of the sampled templates match the exact ones"),
+                             matchRate * 100));
+    succeeded = false;
+  }
+
+  // With the fewest reference samples some samples have no estimate, which
+  // must not stop the templates being found
+  GRT::DTW fewest(false, true, 2.0f);
+
+  fewest.setTemplateSelectionMethod(GRT::DTW::SAMPLED_TEMPLATE_SELECTION, 2, 1);
+
+  if (!TestTrue(TEXT("A model using 2 reference samples was trained"),
+                fewest.train(data))) return false;
+
+  const Vector<DTWTemplate> fewestTemplates = fewest.getModels();
+
+  for (uint32 k = 0; k < NUM_CLASSES; k++) {
+    if ((fewestTemplates[k].timeSeries.getNumRows() == 0) ||
+        grt_isnan(fewestTemplates[k].trainingMu) ||
+        grt_isnan(fewestTemplates[k].trainingSigma)) {
+      AddError(FString::Printf(TEXT(
+                                 "Class %d: no valid template was found with 2 reference samples"),
+                               fewestTemplates[k].classLabel));
+      succeeded = false;
+    }
+  }
+  return succeeded;
+}
+
+#endif // WITH_DEV_AUTOMATION_TESTS
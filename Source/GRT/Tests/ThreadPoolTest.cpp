@@ -0,0 +1,153 @@
+﻿#include "../GRT.h"
+#include "../Utility/ThreadPool.h"
+#include "Misc/AutomationTest.h"
+#include <atomic>
+
+#if WITH_DEV_AUTOMATION_TESTS
+
+namespace {
+using namespace GRT;
+
+// The number of tasks timed for each measurement
+const uint32 NUM_TIMED_TASKS = 20000;
+
+// Spins for roughly the given number of microseconds
+void spinFor(const double microseconds) {
+  const double endTime = FPlatformTime::Seconds() + microseconds * 1.0e-6;
+
+  while (FPlatformTime::Seconds() < endTime) {}
+}
+
+// Times the pool in its current mode, and adds the results to the test
+bool measureScheduling(FAutomationTestBase& test,
+                       ThreadPool         & pool,
+                       const TCHAR         *modeName) {
+  // The cost of running empty tasks through a TaskGroup, from the first
+  // run to the end of the wait
+  {
+    std::atomic<uint32> numRun(0);
+    TaskGroup group(&pool);
+    const double startTime = FPlatformTime::Seconds();
+
+    for (uint32 i = 0; i < NUM_TIMED_TASKS; i++) {
+      group.run([&numRun]() {
+        numRun++;
+      });
+    }
+
+    const double submitTime = FPlatformTime::Seconds();
+    group.wait();
+    const double endTime = FPlatformTime::Seconds();
+
+    test.AddInfo(FString::Printf(TEXT(
+                                   "%s: TaskGroup run %.3f us/task, run and wait %.3f us/task"),
+                                 modeName,
+                                 (submitTime - startTime) * 1.0e6 /
+                                 NUM_TIMED_TASKS,
+                                 (endTime - startTime) * 1.0e6 /
+                                 NUM_TIMED_TASKS));
+
+    if (numRun != NUM_TIMED_TASKS) {
+      test.AddError(FString::Printf(TEXT("%s: only %d of %d tasks were run"),
+                                    modeName, (uint32)numRun,
+                                    NUM_TIMED_TASKS));
+      return false;
+    }
+  }
+
+  // The cost of each chunk of a parallelFor with an empty body
+  {
+    std::atomic<uint32> numRun(0);
+    const double startTime = FPlatformTime::Seconds();
+    pool.parallelFor(NUM_TIMED_TASKS, [&numRun](uint32 i) {
+      numRun++;
+    }, 1);
+    const double endTime = FPlatformTime::Seconds();
+
+    test.AddInfo(FString::Printf(TEXT("%s: parallelFor %.3f us/chunk"),
+                                 modeName,
+                                 (endTime - startTime) * 1.0e6 /
+                                 NUM_TIMED_TASKS));
+
+    if (numRun != NUM_TIMED_TASKS) {
+      test.AddError(FString::Printf(TEXT(
+                                      "%s: parallelFor only ran %d of %d indexs"),
+                                    modeName, (uint32)numRun,
+                                    NUM_TIMED_TASKS));
+      return false;
+    }
+  }
+
+  // Uneven work: a few tasks each start a nested group of small tasks and
+  // wait for it, as training does inside cross validation.  The waits must
+  // not stall even when every thread of the pool is waiting, and the small
+  // tasks should be spread over the threads
+  {
+    const uint32 numOuterTasks = 8;
+    const uint32 numInnerTasks = 64;
+    const double innerMicroseconds = 50;
+    std::atomic<uint32> numRun(0);
+    TaskGroup group(&pool);
+    const double startTime = FPlatformTime::Seconds();
+
+    for (uint32 i = 0; i < numOuterTasks; i++) {
+      group.run([&pool, &numRun, i, numInnerTasks, innerMicroseconds]() {
+        TaskGroup inner(&pool);
+        const uint32 numTasks = i == 0 ? numInnerTasks * 4 : numInnerTasks;
+
+        for (uint32 j = 0; j < numTasks; j++) {
+          inner.run([&numRun, innerMicroseconds]() {
+            spinFor(innerMicroseconds);
+            numRun++;
+          });
+        }
+        inner.wait();
+      });
+    }
+    group.wait();
+
+    const double endTime  = FPlatformTime::Seconds();
+    const uint32 expected = numInnerTasks * (numOuterTasks + 3);
+    const double serialTime = expected * innerMicroseconds * 1.0e-6;
+
+    test.AddInfo(FString::Printf(TEXT(
+                                   "%s: nested uneven groups %.2f ms, %.2fx faster than serial"),
+                                 modeName, (endTime - startTime) * 1.0e3,
+                                 serialTime / (endTime - startTime)));
+
+    if (numRun != expected) {
+      test.AddError(FString::Printf(TEXT(
+                                      "%s: only %d of %d nested tasks were run"),
+                                    modeName, (uint32)numRun, expected));
+      return false;
+    }
+  }
+  return true;
+}
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FGRTThreadPoolSchedulingTest,
+                                 "GRT.ThreadPool.Scheduling",
+                                 EAutomationTestFlags::ApplicationContextMask |
+                                 EAutomationTestFlags::PerfFilter)
+
+bool FGRTThreadPoolSchedulingTest::RunTest(const FString& Parameters) {
+  GRT::ThreadPool& pool = GRT::ThreadPool::getInstance();
+  const bool useEngineTaskGraph = pool.getUseEngineTaskGraph();
+  bool succeeded = true;
+
+#if GRT_USE_ENGINE_TASK_GRAPH
+
+  // The engine task graph is measured first, as it is the default
+  pool.setUseEngineTaskGraph(true);
+  succeeded = measureScheduling(*this, pool, TEXT("Task graph")) && succeeded;
+#endif // GRT_USE_ENGINE_TASK_GRAPH
+
+  pool.setUseEngineTaskGraph(false);
+  succeeded = measureScheduling(*this, pool, TEXT("Own threads")) && succeeded;
+
+  pool.setUseEngineTaskGraph(useEngineTaskGraph);
+  return succeeded;
+}
+
+#endif // WITH_DEV_AUTOMATION_TESTS
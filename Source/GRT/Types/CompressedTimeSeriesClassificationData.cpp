@@ -0,0 +1,601 @@
+﻿#include "../GRT.h"
+#include "CompressedTimeSeriesClassificationData.h"
+#include "TimeSeriesClassificationData.h"
+#include "../Utility/ThreadPool.h"
+#include "Misc/Compression.h"
+#include <fstream>
+#include <string>
+
+// The compressed dataset archive (see
+// CompressedTimeSeriesClassificationData::write).  The header, the strings and
+// the columns follow the layout of the binary dataset format, the samples are
+// stored as one encoded block each
+#define GRT_DATASET_ARCHIVE_MAGIC "GRTTSCZ"
+#define GRT_DATASET_ARCHIVE_VERSION 1
+#define GRT_DATASET_ARCHIVE_BYTE_ORDER 0x01020304
+#define GRT_DATASET_ARCHIVE_ALIGNMENT 64
+#define GRT_DATASET_ARCHIVE_DELTA 1    // Rows are stored as differences
+#define GRT_DATASET_ARCHIVE_QUANTIZE 2 // Values are quantized to 16 bits
+
+struct DatasetArchiveHeader {
+  char   magic[8];              // GRT_DATASET_ARCHIVE_MAGIC
+  uint32 version;               // GRT_DATASET_ARCHIVE_VERSION
+  uint32 byteOrder;             // GRT_DATASET_ARCHIVE_BYTE_ORDER as written
+  uint32 numDimensions;
+  uint32 numSamples;
+  uint32 numClasses;
+  uint32 useExternalRanges;
+  uint32 allowNullGestureClass;
+  uint32 numRanges;
+  uint32 encoding;              // GRT_DATASET_ARCHIVE_DELTA and QUANTIZE flags
+  uint32 reserved;
+  uint64 stringsOffset;         // The dataset name, the info text and the class
+                                // names as UTF-8, each ending with a 0
+  uint64 stringsSize;
+  uint64 classTableOffset;      // uint32 [numClasses 2] labels and counters
+  uint64 rangesOffset;          // float [numRanges 2]
+  uint64 quantizationOffset;    // float [numDimensions 2] minimums and steps
+  uint64 labelsOffset;          // uint32 [numSamples]
+  uint64 lengthsOffset;         // uint32 [numSamples]
+  uint64 blockTableOffset;      // uint64 [numSamples 2] offsets and sizes in
+                                // bytes from dataOffset
+  uint64 dataOffset;            // The encoded samples
+  uint64 dataSize;
+  uint64 fileSize;
+};
+static_assert(sizeof(DatasetArchiveHeader) == 136,
+              "DatasetArchiveHeader must not contain padding");
+
+namespace GRT {
+static const ECompressionFlags archiveCompressionFlags =
+  (ECompressionFlags)(COMPRESS_ZLIB | COMPRESS_BiasSpeed);
+
+static uint64 alignArchiveOffset(const uint64 offset) {
+  return (offset + GRT_DATASET_ARCHIVE_ALIGNMENT - 1) /
+         GRT_DATASET_ARCHIVE_ALIGNMENT * GRT_DATASET_ARCHIVE_ALIGNMENT;
+}
+
+static void writeArchivePadding(std::fstream& file, const uint64 offset) {
+  const char zeros[GRT_DATASET_ARCHIVE_ALIGNMENT] = { 0 };
+  const uint64 position = (uint64)file.tellp();
+
+  if (offset > position) file.write(zeros, (std::streamsize)(offset - position));
+}
+
+// Returns true if the section [offset offset+size) is inside the file
+static bool archiveSectionIsValid(const uint64 offset,
+                                  const uint64 size,
+                                  const uint64 fileSize) {
+  return (offset % GRT_DATASET_ARCHIVE_ALIGNMENT == 0) &&
+         (offset <= fileSize) && (size <= fileSize - offset);
+}
+
+// Encodes one sample into a block, quantization is NULL for lossless samples
+static bool encodeArchiveSample(const MatrixFloat& sample,
+                                const uint32       numDimensions,
+                                const bool         useDeltaEncoding,
+                                const float       *quantization,
+                                Vector<char>     & block) {
+  const uint32 N           = sample.getNumRows() * numDimensions;
+  const uint32 valueSize   = quantization != NULL ? 2 : 4;
+  const uint32 rawSize     = N * valueSize;
+  Vector<uint32> values(N);
+
+  block.clear();
+
+  if (N == 0) return true;
+
+  // Quantize the values, or take the bits of the floats
+  for (uint32 i = 0; i < sample.getNumRows(); i++) {
+    const float *row = sample[i];
+    uint32 *dst      = &values[i * numDimensions];
+
+    for (uint32 j = 0; j < numDimensions; j++) {
+      if (quantization != NULL) {
+        const double minValue = quantization[2 * j];
+        const double step     = quantization[2 * j + 1];
+        const double q        = step > 0 ? floor((row[j] - minValue) / step + 0.5) :
+                                0;
+        dst[j] = q <= 0 ? 0 : (q >= 65535 ? 65535 : (uint32)q);
+      }
+      else {
+        memcpy(&dst[j], &row[j], sizeof(uint32));
+      }
+    }
+  }
+
+  // Replace each row with its difference from the previous row
+  if (useDeltaEncoding) {
+    for (uint32 k = N - 1; k >= numDimensions; k--) {
+      if (quantization != NULL) {
+        // Zigzag the 16 bit difference, so small steps down also have a zero
+        // high byte
+        const uint32 previous = values[k - numDimensions];
+        const int16  delta    = (int16)(uint16)(values[k] - previous);
+        values[k] = (uint16)(((uint16)delta << 1) ^ (uint16)(delta >> 15));
+      }
+      else {
+        values[k] ^= values[k - numDimensions];
+      }
+    }
+  }
+
+  // Split the values into byte planes
+  Vector<char> planes(rawSize);
+
+  for (uint32 b = 0; b < valueSize; b++) {
+    char *plane = &planes[b * N];
+
+    for (uint32 k = 0; k < N; k++) plane[k] = (char)(values[k] >> (8 * b));
+  }
+
+  // Store the planes as they are if they do not compress
+  int32 compressedSize = FCompression::CompressMemoryBound(
+    archiveCompressionFlags, (int32)rawSize);
+  block.resize(compressedSize);
+
+  if (!FCompression::CompressMemory(archiveCompressionFlags, &block[0],
+                                    compressedSize, &planes[0],
+                                    (int32)rawSize) ||
+      (compressedSize >= (int32)rawSize)) {
+    block = planes;
+    return true;
+  }
+
+  block.resize(compressedSize);
+  return true;
+}
+
+// Decodes one block into a [numRows numDimensions] sample
+static bool decodeArchiveSample(const char  *block,
+                                const uint64 blockSize,
+                                const uint32 numRows,
+                                const uint32 numDimensions,
+                                const bool   useDeltaEncoding,
+                                const float *quantization,
+                                MatrixFloat& sample) {
+  const uint32 N         = numRows * numDimensions;
+  const uint32 valueSize = quantization != NULL ? 2 : 4;
+  const uint32 rawSize   = N * valueSize;
+
+  if (N == 0) {
+    sample.clear();
+    return blockSize == 0;
+  }
+
+  Vector<char> planes(rawSize);
+
+  if (blockSize == rawSize) {
+    memcpy(&planes[0], block, rawSize);
+  }
+  else if (!FCompression::UncompressMemory(archiveCompressionFlags,
+                                           &planes[0], (int32)rawSize,
+                                           block, (int32)blockSize)) {
+    return false;
+  }
+
+  // Join the byte planes
+  Vector<uint32> values(N, 0);
+
+  for (uint32 b = 0; b < valueSize; b++) {
+    const unsigned char *plane = (const unsigned char *)&planes[b * N];
+
+    for (uint32 k = 0; k < N; k++) values[k] |= (uint32)plane[k] << (8 * b);
+  }
+
+  if (useDeltaEncoding) {
+    for (uint32 k = numDimensions; k < N; k++) {
+      if (quantization != NULL) {
+        const uint32 delta = (values[k] >> 1) ^ (0u - (values[k] & 1));
+        values[k] = (delta + values[k - numDimensions]) & 0xFFFF;
+      }
+      else {
+        values[k] ^= values[k - numDimensions];
+      }
+    }
+  }
+
+  if ((sample.getNumRows() != numRows) || (sample.getNumCols() != numDimensions)) {
+    if (!sample.resize(numRows, numDimensions)) return false;
+  }
+
+  for (uint32 i = 0; i < numRows; i++) {
+    float *row        = sample[i];
+    const uint32 *src = &values[i * numDimensions];
+
+    for (uint32 j = 0; j < numDimensions; j++) {
+      if (quantization != NULL) {
+        row[j] = quantization[2 * j] + src[j] * quantization[2 * j + 1];
+      }
+      else {
+        memcpy(&row[j], &src[j], sizeof(float));
+      }
+    }
+  }
+
+  return true;
+}
+
+CompressedTimeSeriesClassificationData::CompressedTimeSeriesClassificationData()
+{
+  numDimensions         = 0;
+  numSamples            = 0;
+  allowNullGestureClass = true;
+  useExternalRanges     = false;
+  useDeltaEncoding      = false;
+  useQuantization       = false;
+  quantization          = NULL;
+  labels                = NULL;
+  lengths               = NULL;
+  blocks                = NULL;
+  blockData             = NULL;
+  blockDataSize         = 0;
+}
+
+CompressedTimeSeriesClassificationData::~CompressedTimeSeriesClassificationData()
+{
+  close();
+}
+
+void CompressedTimeSeriesClassificationData::close() {
+  file.close();
+  datasetName           = "";
+  infoText              = "";
+  numDimensions         = 0;
+  numSamples            = 0;
+  allowNullGestureClass = true;
+  useExternalRanges     = false;
+  useDeltaEncoding      = false;
+  useQuantization       = false;
+  externalRanges.clear();
+  classTracker.clear();
+  quantization  = NULL;
+  labels        = NULL;
+  lengths       = NULL;
+  blocks        = NULL;
+  blockData     = NULL;
+  blockDataSize = 0;
+}
+
+bool CompressedTimeSeriesClassificationData::isCompressedDatasetFile(
+  const FString& filename) {
+  std::fstream file;
+
+  file.open(TCHAR_TO_UTF8(*filename), std::ios::in | std::ios::binary);
+
+  if (!file.is_open()) return false;
+
+  char magic[8] = { 0 };
+  file.read(magic, sizeof(magic));
+
+  return file.gcount() == sizeof(magic) &&
+         memcmp(magic, GRT_DATASET_ARCHIVE_MAGIC, sizeof(magic)) == 0;
+}
+
+bool CompressedTimeSeriesClassificationData::open(const FString& filename) {
+  close();
+
+  if (!file.open(filename)) {
+    UE_LOG(GRTModule, Error,
+           TEXT("open(FString filename) - Failed to open file!"));
+    return false;
+  }
+
+  const char  *base     = file.getData();
+  const uint64 fileSize = file.getSize();
+
+  if (fileSize < sizeof(DatasetArchiveHeader)) {
+    UE_LOG(GRTModule, Error,
+           TEXT("open(FString filename) - The file is too small!"));
+    close();
+    return false;
+  }
+
+  DatasetArchiveHeader header;
+  memcpy(&header, base, sizeof(header));
+
+  if (memcmp(header.magic, GRT_DATASET_ARCHIVE_MAGIC, sizeof(header.magic)) != 0) {
+    UE_LOG(GRTModule, Error,
+           TEXT("open(FString filename) - Failed to find file header!"));
+    close();
+    return false;
+  }
+
+  if (header.byteOrder != GRT_DATASET_ARCHIVE_BYTE_ORDER) {
+    UE_LOG(GRTModule, Error,
+           TEXT(
+             "open(FString filename) - The file was saved with a different byte order!"));
+    close();
+    return false;
+  }
+
+  if (header.version != GRT_DATASET_ARCHIVE_VERSION) {
+    UE_LOG(GRTModule, Error,
+           TEXT("open(FString filename) - Unknown file version %u!"),
+           header.version);
+    close();
+    return false;
+  }
+
+  const uint64 N = header.numSamples;
+  const bool   quantized = (header.encoding & GRT_DATASET_ARCHIVE_QUANTIZE) != 0;
+  const uint64 numQuantizationValues = quantized ?
+                                       2ull * header.numDimensions : 0;
+
+  if ((header.fileSize != fileSize) ||
+      !archiveSectionIsValid(header.stringsOffset, header.stringsSize,
+                             fileSize) ||
+      !archiveSectionIsValid(header.classTableOffset,
+                             2 * sizeof(uint32) * (uint64)header.numClasses,
+                             fileSize) ||
+      !archiveSectionIsValid(header.rangesOffset,
+                             2 * sizeof(float) * (uint64)header.numRanges,
+                             fileSize) ||
+      !archiveSectionIsValid(header.quantizationOffset,
+                             sizeof(float) * numQuantizationValues, fileSize) ||
+      !archiveSectionIsValid(header.labelsOffset, sizeof(uint32) * N,
+                             fileSize) ||
+      !archiveSectionIsValid(header.lengthsOffset, sizeof(uint32) * N,
+                             fileSize) ||
+      !archiveSectionIsValid(header.blockTableOffset, 2 * sizeof(uint64) * N,
+                             fileSize) ||
+      !archiveSectionIsValid(header.dataOffset, header.dataSize, fileSize)) {
+    UE_LOG(GRTModule, Error,
+           TEXT("open(FString filename) - The file is corrupt or truncated!"));
+    close();
+    return false;
+  }
+
+  numDimensions         = header.numDimensions;
+  numSamples            = header.numSamples;
+  useExternalRanges     = header.useExternalRanges != 0;
+  allowNullGestureClass = header.allowNullGestureClass != 0;
+  useDeltaEncoding      = (header.encoding & GRT_DATASET_ARCHIVE_DELTA) != 0;
+  useQuantization       = quantized;
+  quantization          = quantized ? (const float *)(base +
+                                                   header.quantizationOffset) :
+                          NULL;
+  labels        = (const uint32 *)(base + header.labelsOffset);
+  lengths       = (const uint32 *)(base + header.lengthsOffset);
+  blocks        = (const uint64 *)(base + header.blockTableOffset);
+  blockData     = base + header.dataOffset;
+  blockDataSize = header.dataSize;
+
+  // Check that every block is inside the data and that every decoded sample
+  // fits the compression interface, so getSample does not have to
+  const uint64 valueSize = quantized ? 2 : 4;
+
+  for (uint32 i = 0; i < numSamples; i++) {
+    const uint64 offset  = blocks[2 * i];
+    const uint64 size    = blocks[2 * i + 1];
+    const uint64 rawSize = (uint64)lengths[i] * numDimensions * valueSize;
+
+    if ((offset > blockDataSize) || (size > blockDataSize - offset) ||
+        (rawSize > 0x7FFFFFFF) || (size > rawSize)) {
+      UE_LOG(GRTModule, Error,
+             TEXT("open(FString filename) - Sample %u is corrupt!"), i);
+      close();
+      return false;
+    }
+  }
+
+  // Read the strings, each one must end inside the string section
+  const char *strings     = base + header.stringsOffset;
+  const char *stringsEnd  = strings + header.stringsSize;
+  const uint32 numStrings = 2 + header.numClasses;
+  Vector<FString> values(numStrings);
+
+  for (uint32 k = 0; k < numStrings; k++) {
+    const char *end = (const char *)memchr(strings, 0, stringsEnd - strings);
+
+    if (end == NULL) {
+      UE_LOG(GRTModule, Error,
+             TEXT("open(FString filename) - Failed to read the strings!"));
+      close();
+      return false;
+    }
+    values[k] = FString(UTF8_TO_TCHAR(strings));
+    strings   = end + 1;
+  }
+  datasetName = values[0];
+  infoText    = values[1];
+
+  const uint32 *classTable = (const uint32 *)(base + header.classTableOffset);
+  classTracker.resize(header.numClasses);
+
+  for (uint32 k = 0; k < header.numClasses; k++) {
+    classTracker[k].classLabel = classTable[2 * k];
+    classTracker[k].counter    = classTable[2 * k + 1];
+    classTracker[k].className  = values[2 + k];
+  }
+
+  const float *ranges = (const float *)(base + header.rangesOffset);
+  externalRanges.resize(header.numRanges);
+
+  for (uint32 j = 0; j < header.numRanges; j++) {
+    externalRanges[j].minValue = ranges[2 * j];
+    externalRanges[j].maxValue = ranges[2 * j + 1];
+  }
+
+  return true;
+}
+
+bool CompressedTimeSeriesClassificationData::getSample(const uint32 i,
+                                                       MatrixFloat& sample)
+const {
+  if (i >= numSamples) {
+    UE_LOG(GRTModule, Error,
+           TEXT("getSample(...) - Index %u is out of bounds!"), i);
+    return false;
+  }
+
+  if (!decodeArchiveSample(blockData + blocks[2 * i], blocks[2 * i + 1],
+                           lengths[i], numDimensions, useDeltaEncoding,
+                           quantization, sample)) {
+    UE_LOG(GRTModule, Error,
+           TEXT("getSample(...) - Failed to decode sample %u!"), i);
+    return false;
+  }
+  return true;
+}
+
+bool CompressedTimeSeriesClassificationData::write(
+  const TimeSeriesClassificationData& dataset,
+  const FString& filename,
+  const bool useDeltaEncoding,
+  const bool useQuantization) {
+  const uint32 N       = dataset.getNumSamples();
+  const uint32 numDims = dataset.getNumDimensions();
+  const Vector<ClassTracker> tracker = dataset.getClassTracker();
+  const Vector<MinMax>& ranges = dataset.getExternalRanges();
+  const uint32 valueSize = useQuantization ? 2 : 4;
+
+  for (uint32 i = 0; i < N; i++) {
+    if ((uint64)dataset[i].getLength() * numDims * valueSize > 0x7FFFFFFF) {
+      UE_LOG(GRTModule, Error,
+             TEXT("write(...) - Sample %u is too large to compress!"), i);
+      return false;
+    }
+  }
+
+  // The quantization step of each dimension covers the range of the data
+  Vector<float> quantization;
+
+  if (useQuantization) {
+    const Vector<MinMax> dataRanges = dataset.getRanges();
+    quantization.resize(2 * numDims);
+
+    for (uint32 j = 0; j < numDims; j++) {
+      quantization[2 * j]     = dataRanges[j].minValue;
+      quantization[2 * j + 1] = (dataRanges[j].maxValue -
+                                 dataRanges[j].minValue) / 65535.0f;
+    }
+  }
+
+  // Encode the samples in parallel
+  Vector<Vector<char> > encoded(N);
+
+  ThreadPool::getInstance().parallelFor(N, [&](uint32 i) {
+    encodeArchiveSample(dataset[i].getData(), numDims, useDeltaEncoding,
+                        useQuantization ? &quantization[0] : NULL, encoded[i]);
+  });
+
+  // Build the string section
+  std::string strings;
+  strings += TCHAR_TO_UTF8(*dataset.getDatasetName());
+  strings.push_back('\0');
+  strings += TCHAR_TO_UTF8(*dataset.getInfoText());
+  strings.push_back('\0');
+
+  for (uint32 k = 0; k < tracker.getSize(); k++) {
+    strings += TCHAR_TO_UTF8(*tracker[k].className);
+    strings.push_back('\0');
+  }
+
+  // Build the columns
+  Vector<uint32> labelColumn(N);
+  Vector<uint32> lengthColumn(N);
+  Vector<uint64> blockTable(2 * N);
+  uint64 dataSize = 0;
+
+  for (uint32 i = 0; i < N; i++) {
+    labelColumn[i]       = dataset[i].getClassLabel();
+    lengthColumn[i]      = dataset[i].getLength();
+    blockTable[2 * i]     = dataSize;
+    blockTable[2 * i + 1] = encoded[i].size();
+    dataSize             += encoded[i].size();
+  }
+
+  DatasetArchiveHeader header;
+  memset(&header, 0, sizeof(header));
+  memcpy(header.magic, GRT_DATASET_ARCHIVE_MAGIC, sizeof(header.magic));
+  header.version               = GRT_DATASET_ARCHIVE_VERSION;
+  header.byteOrder             = GRT_DATASET_ARCHIVE_BYTE_ORDER;
+  header.numDimensions         = numDims;
+  header.numSamples            = N;
+  header.numClasses            = tracker.getSize();
+  header.useExternalRanges     = dataset.getUseExternalRanges() ? 1 : 0;
+  header.allowNullGestureClass = dataset.getAllowNullGestureClass() ? 1 : 0;
+  header.numRanges             = ranges.getSize();
+  header.encoding              =
+    (useDeltaEncoding ? GRT_DATASET_ARCHIVE_DELTA : 0) |
+    (useQuantization ? GRT_DATASET_ARCHIVE_QUANTIZE : 0);
+  header.stringsOffset    = alignArchiveOffset(sizeof(header));
+  header.stringsSize      = strings.size();
+  header.classTableOffset = alignArchiveOffset(header.stringsOffset +
+                                               header.stringsSize);
+  header.rangesOffset = alignArchiveOffset(header.classTableOffset +
+                                           2 * sizeof(uint32) *
+                                           header.numClasses);
+  header.quantizationOffset = alignArchiveOffset(header.rangesOffset +
+                                                 2 * sizeof(float) *
+                                                 header.numRanges);
+  header.labelsOffset = alignArchiveOffset(header.quantizationOffset +
+                                           sizeof(float) * quantization.size());
+  header.lengthsOffset = alignArchiveOffset(header.labelsOffset +
+                                            sizeof(uint32) * (uint64)N);
+  header.blockTableOffset = alignArchiveOffset(header.lengthsOffset +
+                                               sizeof(uint32) * (uint64)N);
+  header.dataOffset = alignArchiveOffset(header.blockTableOffset +
+                                         2 * sizeof(uint64) * (uint64)N);
+  header.dataSize = dataSize;
+  header.fileSize = header.dataOffset + dataSize;
+
+  std::fstream file;
+  file.open(TCHAR_TO_UTF8(*filename),
+            std::ios::out | std::ios::binary | std::ios::trunc);
+
+  if (!file.is_open()) {
+    UE_LOG(GRTModule, Error,
+           TEXT("write(FString filename) - Failed to open file!"));
+    return false;
+  }
+
+  file.write((const char *)&header, sizeof(header));
+  writeArchivePadding(file, header.stringsOffset);
+  file.write(strings.data(), (std::streamsize)strings.size());
+  writeArchivePadding(file, header.classTableOffset);
+
+  for (uint32 k = 0; k < tracker.getSize(); k++) {
+    const uint32 entry[2] = { tracker[k].classLabel, tracker[k].counter };
+    file.write((const char *)entry, sizeof(entry));
+  }
+  writeArchivePadding(file, header.rangesOffset);
+
+  for (uint32 j = 0; j < header.numRanges; j++) {
+    const float range[2] = { ranges[j].minValue, ranges[j].maxValue };
+    file.write((const char *)range, sizeof(range));
+  }
+  writeArchivePadding(file, header.quantizationOffset);
+
+  if (quantization.size() > 0) {
+    file.write((const char *)&quantization[0],
+               sizeof(float) * quantization.size());
+  }
+
+  if (N > 0) {
+    writeArchivePadding(file, header.labelsOffset);
+    file.write((const char *)&labelColumn[0], sizeof(uint32) * N);
+    writeArchivePadding(file, header.lengthsOffset);
+    file.write((const char *)&lengthColumn[0], sizeof(uint32) * N);
+    writeArchivePadding(file, header.blockTableOffset);
+    file.write((const char *)&blockTable[0], 2 * sizeof(uint64) * N);
+  }
+  writeArchivePadding(file, header.dataOffset);
+
+  for (uint32 i = 0; i < N; i++) {
+    if (encoded[i].size() > 0) {
+      file.write(&encoded[i][0], (std::streamsize)encoded[i].size());
+    }
+  }
+
+  const bool ok = !file.fail();
+  file.close();
+
+  if (!ok) {
+    UE_LOG(GRTModule, Error,
+           TEXT("write(FString filename) - Failed to write the file!"));
+  }
+  return ok;
+}
+}
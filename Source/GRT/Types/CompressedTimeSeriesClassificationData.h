@@ -0,0 +1,183 @@
+﻿#pragma once
+
+#include "../GRT.h"
+#include "MatrixFloat.h"
+#include "../Utility/ClassTracker.h"
+#include "../Utility/MinMax.h"
+#include "../Utility/MappedFile.h"
+
+namespace GRT {
+class TimeSeriesClassificationData;
+
+/**
+   @brief The CompressedTimeSeriesClassificationData class reads and writes
+      compressed time series dataset archives, for storing and shipping large
+      recordings.
+
+   Each sample is encoded on its own, so samples can be decoded one at a time
+      (for streaming) or in parallel.  A sample is encoded in three stages:
+      - the values are optionally quantized to 16 bits per value, using the
+        range of each dimension from TimeSeriesClassificationData::getRanges
+      - each value is optionally replaced by its difference from the value of
+        the same dimension in the previous row (an exclusive or of the bits
+        for unquantized floats), so slowly changing signals become mostly
+        zeros
+      - the bytes are split into planes (all the low bytes, then the next
+        bytes and so on) and compressed with zlib
+      Without quantization the archive is lossless.
+ */
+class GRT_API CompressedTimeSeriesClassificationData {
+public:
+
+  /**
+     Default Constructor
+   */
+  CompressedTimeSeriesClassificationData();
+
+  /**
+     Default Destructor, closes the file if it is open
+   */
+  ~CompressedTimeSeriesClassificationData();
+
+  /**
+     Opens and validates a compressed dataset archive, closing any file that
+        was previously open.  Only the header and the sample index are read.
+
+     @param filename: the name of the file to open
+     @return returns true if the file was opened, false otherwise
+   */
+  bool open(const FString& filename);
+
+  /**
+     Closes the file.
+   */
+  void close();
+
+  /**
+     Decodes one sample.  This only reads the file, so several samples can be
+        decoded at the same time from different threads.
+
+     @param i: the index of the sample, should be in the range [0
+        numSamples-1]
+     @param sample: returns the [length numDimensions] sample
+     @return returns true if the sample was decoded, false otherwise
+   */
+  bool getSample(const uint32 i, MatrixFloat& sample) const;
+
+  /**
+     Returns true if the file starts with the compressed archive header, this
+        only reads the first few bytes of the file.
+
+     @param filename: the name of the file to check
+     @return returns true if the file is a compressed dataset archive
+   */
+  static bool isCompressedDatasetFile(const FString& filename);
+
+  /**
+     Writes a dataset to a compressed archive.  The samples are encoded in
+        parallel.
+
+     @param dataset: the dataset to write
+     @param filename: the name of the file the dataset will be written to
+     @param useDeltaEncoding: if true each row is stored as the difference
+        from the previous row
+     @param useQuantization: if true the values are quantized to 16 bits, which
+        makes the archive lossy
+     @return returns true if the file was written, false otherwise
+   */
+  static bool write(const TimeSeriesClassificationData& dataset,
+                    const FString& filename,
+                    const bool useDeltaEncoding = true,
+                    const bool useQuantization = false);
+
+  /**
+     Gets the class label of the sample at index i.
+
+     @param i: the index of the sample, should be in the range [0
+        numSamples-1]
+     @return returns the class label of the sample
+   */
+  inline uint32 getClassLabel(const uint32 i) const {
+    return labels[i];
+  }
+
+  /**
+     Gets the length of the sample at index i.
+
+     @param i: the index of the sample, should be in the range [0
+        numSamples-1]
+     @return returns the number of rows in the sample
+   */
+  inline uint32 getLength(const uint32 i) const {
+    return lengths[i];
+  }
+
+  bool getIsOpen() const {
+    return file.getIsOpen();
+  }
+
+  bool getUseDeltaEncoding() const {
+    return useDeltaEncoding;
+  }
+
+  bool getUseQuantization() const {
+    return useQuantization;
+  }
+
+  uint32 getNumDimensions() const {
+    return numDimensions;
+  }
+
+  uint32 getNumSamples() const {
+    return numSamples;
+  }
+
+  uint32 getNumClasses() const {
+    return (uint32)classTracker.size();
+  }
+
+  FString getDatasetName() const {
+    return datasetName;
+  }
+
+  FString getInfoText() const {
+    return infoText;
+  }
+
+  bool getAllowNullGestureClass() const {
+    return allowNullGestureClass;
+  }
+
+  bool getUseExternalRanges() const {
+    return useExternalRanges;
+  }
+
+  const Vector<MinMax>& getExternalRanges() const {
+    return externalRanges;
+  }
+
+  const Vector<ClassTracker>& getClassTracker() const {
+    return classTracker;
+  }
+
+protected:
+
+  MappedFile     file;
+  FString        datasetName;
+  FString        infoText;
+  uint32         numDimensions;
+  uint32         numSamples;
+  bool           allowNullGestureClass;
+  bool           useExternalRanges;
+  bool           useDeltaEncoding;
+  bool           useQuantization;
+  Vector<MinMax> externalRanges;
+  Vector<ClassTracker> classTracker;
+  const float   *quantization; ///< The minimum and step of each dimension
+  const uint32  *labels;       ///< The class label column, in the mapping
+  const uint32  *lengths;      ///< The length column, in the mapping
+  const uint64  *blocks;       ///< The offset and size of each sample
+  const char    *blockData;    ///< The encoded samples, in the mapping
+  uint64         blockDataSize;
+};
+}
@@ -0,0 +1,416 @@
+﻿#include "../GRT.h"
+#include "ContiguousTimeSeriesClassificationData.h"
+#include "TimeSeriesClassificationData.h"
+#include "MappedTimeSeriesClassificationData.h"
+#include "../Utility/Util.h"
+
+namespace GRT {
+ContiguousTimeSeriesClassificationData::ContiguousTimeSeriesClassificationData(
+  uint32  numDimensions,
+  FString datasetName,
+  FString infoText) {
+  this->numDimensions = numDimensions;
+  this->datasetName   = datasetName;
+  this->infoText      = infoText;
+  useExternalRanges   = false;
+  arena               = std::make_shared<Arena>();
+}
+
+ContiguousTimeSeriesClassificationData::ContiguousTimeSeriesClassificationData(
+  const TimeSeriesClassificationData& rhs) {
+  numDimensions = rhs.getNumDimensions();
+  datasetName   = rhs.getDatasetName();
+  infoText      = rhs.getInfoText();
+  arena         = std::make_shared<Arena>();
+
+  // The ranges are part of the data, so training uses the same ranges
+  // whichever class holds it
+  useExternalRanges = rhs.getUseExternalRanges();
+  externalRanges    = rhs.getExternalRanges();
+
+  // Size the arena once, then copy each sample into place
+  const uint32 N = rhs.getNumSamples();
+  uint64 numRows = 0;
+
+  for (uint32 i = 0; i < N; i++) numRows += rhs[i].getLength();
+
+  reserve(N, numRows);
+
+  for (uint32 i = 0; i < N; i++) {
+    addSample(rhs[i].getClassLabel(), rhs[i].getData());
+  }
+
+  // Keep the class order and names of the original dataset
+  classTracker = rhs.getClassTracker();
+}
+
+ContiguousTimeSeriesClassificationData::ContiguousTimeSeriesClassificationData(
+  const ContiguousTimeSeriesClassificationData& rhs) {
+  *this = rhs;
+}
+
+ContiguousTimeSeriesClassificationData::~ContiguousTimeSeriesClassificationData()
+{}
+
+ContiguousTimeSeriesClassificationData&
+ContiguousTimeSeriesClassificationData::operator=(
+  const ContiguousTimeSeriesClassificationData& rhs) {
+  if (this != &rhs) {
+    this->datasetName   = rhs.datasetName;
+    this->infoText      = rhs.infoText;
+    this->numDimensions     = rhs.numDimensions;
+    this->useExternalRanges = rhs.useExternalRanges;
+    this->externalRanges    = rhs.externalRanges;
+    this->arena             = rhs.arena;
+    this->indices       = rhs.indices;
+    this->classTracker  = rhs.classTracker;
+  }
+  return *this;
+}
+
+void ContiguousTimeSeriesClassificationData::clear() {
+  // Other datasets may still be using the arena, so start a new one
+  arena = std::make_shared<Arena>();
+  indices.clear();
+  classTracker.clear();
+}
+
+bool ContiguousTimeSeriesClassificationData::setNumDimensions(
+  const uint32 l_numDimensions) {
+  if (l_numDimensions == 0) {
+    UE_LOG(GRTModule, Error,
+           TEXT(
+             "setNumDimensions(uint32 numDimensions) - The number of dimensions of the dataset must be greater than zero!"));
+    return false;
+  }
+
+  clear();
+  numDimensions     = l_numDimensions;
+  useExternalRanges = false;
+  externalRanges.clear();
+  return true;
+}
+
+bool ContiguousTimeSeriesClassificationData::setDatasetName(
+  const FString l_datasetName) {
+  // Make sure there are no spaces in the FString
+  if (!l_datasetName.Contains(" ")) {
+    datasetName = l_datasetName;
+    return true;
+  }
+
+  UE_LOG(GRTModule, Error,
+         TEXT(
+           "setDatasetName(FString datasetName) - The dataset name cannot contain any spaces!"));
+  return false;
+}
+
+bool ContiguousTimeSeriesClassificationData::setInfoText(
+  const FString l_infoText) {
+  infoText = l_infoText;
+  return true;
+}
+
+bool ContiguousTimeSeriesClassificationData::setExternalRanges(
+  const Vector<MinMax>& l_externalRanges,
+  const bool            l_useExternalRanges) {
+  if (l_externalRanges.size() != numDimensions) return false;
+
+  this->externalRanges    = l_externalRanges;
+  this->useExternalRanges = l_useExternalRanges;
+
+  return true;
+}
+
+bool ContiguousTimeSeriesClassificationData::enableExternalRangeScaling(
+  const bool l_useExternalRanges) {
+  if (externalRanges.size() == numDimensions) {
+    this->useExternalRanges = l_useExternalRanges;
+    return true;
+  }
+  return false;
+}
+
+bool ContiguousTimeSeriesClassificationData::reserve(const uint32 numSamples,
+                                                     const uint64 numRows) {
+  makeArenaUnique();
+  arena->values.reserve((size_t)(numRows * numDimensions));
+  arena->offsets.reserve(numSamples);
+  arena->lengths.reserve(numSamples);
+  arena->labels.reserve(numSamples);
+  indices.reserve(numSamples);
+  return true;
+}
+
+bool ContiguousTimeSeriesClassificationData::addSample(
+  const uint32      classLabel,
+  const MatrixView& sample) {
+  if ((sample.getNumCols() != numDimensions) && !sample.getIsEmpty()) {
+    UE_LOG(GRTModule, Error,
+           TEXT(
+             "addSample(uint32 classLabel, MatrixView sample) - The dimensionality of the sample ( %d ) does not match that of the dataset ( %d )"),
+           sample.getNumCols(), numDimensions);
+    return false;
+  }
+
+  makeArenaUnique();
+
+  const uint32 length = sample.getNumRows();
+  const uint64 offset = arena->values.size();
+
+  arena->values.resize((size_t)(offset + (uint64)length * numDimensions));
+
+  for (uint32 i = 0; i < length; i++) {
+    memcpy(&arena->values[offset + (uint64)i * numDimensions], sample[i],
+           sizeof(float) * numDimensions);
+  }
+
+  indices.push_back((uint32)arena->labels.size());
+  arena->offsets.push_back(offset);
+  arena->lengths.push_back(length);
+  arena->labels.push_back(classLabel);
+
+  // Update the class tracker
+  for (uint32 k = 0; k < classTracker.size(); k++) {
+    if (classTracker[k].classLabel == classLabel) {
+      classTracker[k].counter++;
+      return true;
+    }
+  }
+  classTracker.push_back(ClassTracker(classLabel, 1));
+  return true;
+}
+
+bool ContiguousTimeSeriesClassificationData::loadDatasetFromBinaryFile(
+  const FString filename) {
+  MappedTimeSeriesClassificationData file;
+
+  if (!file.open(filename)) {
+    UE_LOG(GRTModule, Error,
+           TEXT(
+             "loadDatasetFromBinaryFile(FString filename) - Failed to open file!"));
+    return false;
+  }
+
+  const uint32 N = file.getNumSamples();
+
+  clear();
+  datasetName       = file.getDatasetName();
+  infoText          = file.getInfoText();
+  numDimensions     = file.getNumDimensions();
+  classTracker      = file.getClassTracker();
+  useExternalRanges = false;
+  externalRanges.clear();
+
+  // The file stores the samples back to back, so its data block becomes the
+  // arena in a single copy
+  arena->values.resize((size_t)file.getDataSize());
+  arena->offsets.resize(N);
+  arena->lengths.resize(N);
+  arena->labels.resize(N);
+  indices.resize(N);
+
+  if (file.getDataSize() > 0) {
+    memcpy(&arena->values[0], file.getData(),
+           sizeof(float) * (size_t)file.getDataSize());
+  }
+
+  for (uint32 i = 0; i < N; i++) {
+    arena->offsets[i] = file.getSampleOffset(i);
+    arena->lengths[i] = file.getLength(i);
+    arena->labels[i]  = file.getClassLabel(i);
+    indices[i]        = i;
+  }
+
+  return true;
+}
+
+ContiguousTimeSeriesClassificationData
+ContiguousTimeSeriesClassificationData::getSubset(
+  const Vector<uint32>& sampleIndices) const {
+  ContiguousTimeSeriesClassificationData subset(numDimensions, datasetName,
+                                                infoText);
+
+  subset.useExternalRanges = useExternalRanges;
+  subset.externalRanges    = externalRanges;
+  subset.arena             = arena;
+  subset.classTracker      = classTracker;
+  subset.indices.resize(sampleIndices.size());
+
+  for (uint32 i = 0; i < sampleIndices.size(); i++) {
+    subset.indices[i] = indices[sampleIndices[i]];
+  }
+  subset.updateClassTracker();
+  return subset;
+}
+
+ContiguousTimeSeriesClassificationData
+ContiguousTimeSeriesClassificationData::getClassData(
+  const uint32 classLabel) const {
+  ContiguousTimeSeriesClassificationData classData(numDimensions, datasetName,
+                                                   infoText);
+
+  classData.useExternalRanges = useExternalRanges;
+  classData.externalRanges    = externalRanges;
+  classData.arena             = arena;
+  classData.classTracker      = classTracker;
+
+  for (uint32 i = 0; i < indices.size(); i++) {
+    if (arena->labels[indices[i]] == classLabel) {
+      classData.indices.push_back(indices[i]);
+    }
+  }
+  classData.updateClassTracker();
+  return classData;
+}
+
+bool ContiguousTimeSeriesClassificationData::copyTo(
+  TimeSeriesClassificationData& data) const {
+  data.setNumDimensions(numDimensions);
+  data.setDatasetName(datasetName);
+  data.setInfoText(infoText);
+
+  if (externalRanges.size() == numDimensions) {
+    data.setExternalRanges(externalRanges, useExternalRanges);
+  }
+
+  MatrixFloat sample;
+
+  for (uint32 i = 0; i < indices.size(); i++) {
+    const TimeSeriesSampleView view = (*this)[i];
+
+    view.getData().copyTo(sample);
+
+    if (!data.addSample(view.getClassLabel(), sample)) return false;
+  }
+
+  for (uint32 k = 0; k < classTracker.size(); k++) {
+    data.setClassNameForCorrespondingClassLabel(classTracker[k].className,
+                                                classTracker[k].classLabel);
+  }
+  return true;
+}
+
+Vector<MinMax> ContiguousTimeSeriesClassificationData::getRanges() const {
+  if (useExternalRanges) return externalRanges;
+
+  Vector<MinMax> ranges(numDimensions);
+  bool initialized = false;
+
+  for (uint32 x = 0; x < indices.size(); x++) {
+    const TimeSeriesSampleView sample = (*this)[x];
+
+    for (uint32 i = 0; i < sample.getLength(); i++) {
+      const float *row = sample[i];
+
+      // Start the ranges from the first row
+      if (!initialized) {
+        for (uint32 j = 0; j < numDimensions; j++) {
+          ranges[j] = MinMax(row[j], row[j]);
+        }
+        initialized = true;
+      }
+
+      for (uint32 j = 0; j < numDimensions; j++) ranges[j].updateMinMax(row[j]);
+    }
+  }
+  return ranges;
+}
+
+uint64 ContiguousTimeSeriesClassificationData::getHash() const {
+  const uint32 numSamples = (uint32)indices.size();
+  uint64 hash             = Util::hash(&numDimensions, sizeof(numDimensions));
+
+  hash = Util::hash(&numSamples, sizeof(numSamples), hash);
+
+  for (uint32 i = 0; i < numSamples; i++) {
+    const uint32 x          = indices[i];
+    const uint32 classLabel = arena->labels[x];
+    const uint32 length     = arena->lengths[x];
+
+    hash = Util::hash(&classLabel, sizeof(classLabel), hash);
+    hash = Util::hash(&length, sizeof(length), hash);
+
+    if (length > 0) {
+      hash = Util::hash(&arena->values[arena->offsets[x]],
+                        sizeof(float) * length * numDimensions, hash);
+    }
+  }
+
+  if (useExternalRanges) {
+    for (uint32 j = 0; j < externalRanges.size(); j++) {
+      hash = Util::hash(&externalRanges[j].minValue, sizeof(float), hash);
+      hash = Util::hash(&externalRanges[j].maxValue, sizeof(float), hash);
+    }
+  }
+  return hash;
+}
+
+void ContiguousTimeSeriesClassificationData::makeArenaUnique() {
+  if (arena.use_count() <= 1) return;
+
+  // Pack the samples of this dataset into a new arena
+  std::shared_ptr<Arena> packed = std::make_shared<Arena>();
+  const uint32 N = (uint32)indices.size();
+  uint64 numValues = 0;
+
+  for (uint32 i = 0; i < N; i++) {
+    numValues += (uint64)arena->lengths[indices[i]] * numDimensions;
+  }
+
+  packed->values.resize((size_t)numValues);
+  packed->offsets.resize(N);
+  packed->lengths.resize(N);
+  packed->labels.resize(N);
+
+  uint64 offset = 0;
+
+  for (uint32 i = 0; i < N; i++) {
+    const uint32 x    = indices[i];
+    const uint64 size = (uint64)arena->lengths[x] * numDimensions;
+
+    if (size > 0) {
+      memcpy(&packed->values[offset], &arena->values[arena->offsets[x]],
+             sizeof(float) * size);
+    }
+    packed->offsets[i] = offset;
+    packed->lengths[i] = arena->lengths[x];
+    packed->labels[i]  = arena->labels[x];
+    indices[i]         = i;
+    offset            += size;
+  }
+
+  arena = packed;
+}
+
+void ContiguousTimeSeriesClassificationData::updateClassTracker() {
+  // Recount the classes, keeping any class names from the current tracker
+  const Vector<ClassTracker> names = classTracker;
+
+  classTracker.clear();
+
+  for (uint32 i = 0; i < indices.size(); i++) {
+    const uint32 classLabel = arena->labels[indices[i]];
+    bool labelFound         = false;
+
+    for (uint32 k = 0; k < classTracker.size(); k++) {
+      if (classTracker[k].classLabel == classLabel) {
+        classTracker[k].counter++;
+        labelFound = true;
+        break;
+      }
+    }
+
+    if (labelFound) continue;
+
+    classTracker.push_back(ClassTracker(classLabel, 1));
+
+    for (uint32 k = 0; k < names.size(); k++) {
+      if (names[k].classLabel == classLabel) {
+        classTracker.back().className = names[k].className;
+        break;
+      }
+    }
+  }
+}
+}
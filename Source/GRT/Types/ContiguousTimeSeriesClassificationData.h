@@ -0,0 +1,358 @@
+﻿#pragma once
+
+#include "../GRT.h"
+#include "MatrixView.h"
+#include "../Utility/ClassTracker.h"
+#include "../Utility/MinMax.h"
+#include <memory>
+
+namespace GRT {
+class TimeSeriesClassificationData;
+
+/**
+   @brief The TimeSeriesSampleView class is a lightweight, read only view of
+      one labelled time series stored in a ContiguousTimeSeriesClassificationData.
+ */
+class TimeSeriesSampleView {
+public:
+
+  TimeSeriesSampleView(const uint32      classLabel = 0,
+                       const MatrixView& data = MatrixView()) :
+    classLabel(classLabel), data(data) {}
+
+  inline const float * operator[](const uint32 i) const {
+    return data[i];
+  }
+
+  inline uint32 getClassLabel() const {
+    return classLabel;
+  }
+
+  inline uint32 getLength() const {
+    return data.getNumRows();
+  }
+
+  inline uint32 getNumDimensions() const {
+    return data.getNumCols();
+  }
+
+  inline const MatrixView& getData() const {
+    return data;
+  }
+
+protected:
+
+  uint32     classLabel;
+  MatrixView data;
+};
+
+/**
+   @brief The ContiguousTimeSeriesClassificationData class stores a labelled
+      time series dataset in one contiguous block of memory (the arena), with
+      a table of the offset, length and class label of each sample.
+
+   A dataset is a list of sample indices into an arena, and datasets share
+      their arena, so copying a dataset or taking a subset of it (see
+      getSubset and getClassData) only copies the indices.  Samples are read
+      through TimeSeriesSampleView, which points straight into the arena.
+
+   Adding a sample appends it to the arena.  If the arena is shared with
+      another dataset the samples of this dataset are first copied into a new
+      arena (copy on write), so the other datasets are never changed.  Like
+      the elements of a Vector, views of a dataset may be invalidated when a
+      sample is added to it.
+
+   The samples can not be changed in place, so a classifier trained with this
+      dataset (see MLBase::train_) leaves it as it was.  This lets
+      cross validation and parameter searches train each fold or setting from
+      a subset of one arena instead of a copy of the data.
+ */
+class GRT_API ContiguousTimeSeriesClassificationData {
+public:
+
+  /**
+     Constructor, sets the number of dimensions of the training data.
+     The name of the dataset should not contain any spaces.
+
+     @param numDimensions: the number of dimensions of the training data,
+        should be an unsigned integer greater than 0
+     @param datasetName: the name of the dataset, should not contain any
+        spaces
+     @param infoText: some info about the data in this dataset, this can
+        contain spaces
+   */
+  ContiguousTimeSeriesClassificationData(uint32  numDimensions = 0,
+                                         FString datasetName = "NOT_SET",
+                                         FString infoText = "");
+
+  /**
+     Copies a TimeSeriesClassificationData into a single arena.
+
+     @param rhs: the dataset to copy
+   */
+  explicit ContiguousTimeSeriesClassificationData(
+    const TimeSeriesClassificationData& rhs);
+
+  /**
+     Copy Constructor, shares the arena of the rhs instance and copies its
+        sample indices.
+
+     @param rhs: another instance of the ContiguousTimeSeriesClassificationData
+        class
+   */
+  ContiguousTimeSeriesClassificationData(
+    const ContiguousTimeSeriesClassificationData& rhs);
+
+  /**
+     Default Destructor
+   */
+  ~ContiguousTimeSeriesClassificationData();
+
+  /**
+     Sets the equals operator, shares the arena of the rhs instance and copies
+        its sample indices.
+
+     @param rhs: another instance of the ContiguousTimeSeriesClassificationData
+        class
+     @return a reference to this instance
+   */
+  ContiguousTimeSeriesClassificationData& operator=(
+    const ContiguousTimeSeriesClassificationData& rhs);
+
+  /**
+     Gets a view of the sample at index i.
+
+     @param i: the index of the sample, should be in the range [0
+        numSamples-1]
+     @return returns a view of the i'th sample
+   */
+  inline TimeSeriesSampleView operator[](const uint32 i) const {
+    const uint32 x = indices[i];
+
+    return TimeSeriesSampleView(arena->labels[x],
+                                MatrixView(arena->values.empty() ? NULL :
+                                           &arena->values[0] + arena->offsets[x],
+                                           arena->lengths[x], numDimensions));
+  }
+
+  /**
+     Removes all the samples, keeping the number of dimensions.
+   */
+  void clear();
+
+  /**
+     Sets the number of dimensions of the dataset, this will clear any samples
+        in the dataset.
+
+     @param numDimensions: the number of dimensions, should be greater than 0
+     @return returns true if the number of dimensions was set, false otherwise
+   */
+  bool setNumDimensions(const uint32 numDimensions);
+
+  /**
+     Sets the name of the dataset, the name should not contain any spaces.
+
+     @param datasetName: the name of the dataset
+     @return returns true if the name was set, false otherwise
+   */
+  bool setDatasetName(const FString datasetName);
+
+  /**
+     Sets the info text of the dataset.
+
+     @param infoText: some info about the dataset
+     @return returns true if the info text was set
+   */
+  bool setInfoText(const FString infoText);
+
+  /**
+     Sets the external ranges of the dataset, also sets if the dataset should be
+        scaled using these values.
+     The dimensionality of the externalRanges vector should match the number of
+        dimensions of this dataset.
+
+     @param externalRanges: an N dimensional vector containing the min and max
+        values of the expected ranges of the dataset.
+     @param useExternalRanges: sets if these ranges should be used to scale the
+        dataset, default value is false.
+     @return returns true if the external ranges were set, false otherwise
+   */
+  bool setExternalRanges(const Vector<MinMax>& externalRanges,
+                         const bool            useExternalRanges = false);
+
+  /**
+     Sets if the dataset should be scaled using an external range (if
+        useExternalRanges == true) or the ranges of the dataset (if false).
+     The external ranges need to be set FIRST before calling this function,
+        otherwise it will return false.
+
+     @param useExternalRanges: sets if these ranges should be used to scale the
+        dataset
+     @return returns true if the useExternalRanges variable was set, false
+        otherwise
+   */
+  bool enableExternalRangeScaling(const bool useExternalRanges);
+
+  /**
+     Reserves space in the arena, so adding samples does not reallocate it.
+
+     @param numSamples: the number of samples the arena should hold
+     @param numRows: the total number of rows of all the samples
+     @return returns true if the space was reserved
+   */
+  bool reserve(const uint32 numSamples, const uint64 numRows);
+
+  /**
+     Adds a sample to the dataset, copying it to the end of the arena.
+
+     @param classLabel: the class label of the sample
+     @param sample: the [length numDimensions] time series to add
+     @return returns true if the sample was added, false otherwise
+   */
+  bool addSample(const uint32 classLabel, const MatrixView& sample);
+
+  /**
+     Loads a dataset saved with
+        TimeSeriesClassificationData::saveDatasetToBinaryFile.  The sample data
+        of the file is copied into the arena as one block.
+
+     @param filename: the name of the file the data will be loaded from
+     @return returns true if the data was loaded successfully, false otherwise
+   */
+  bool loadDatasetFromBinaryFile(const FString filename);
+
+  /**
+     Gets a dataset with the samples at the given indices.  The arena is
+        shared, so only the indices are copied.
+
+     @param sampleIndices: the indices of the samples, each in the range [0
+        numSamples-1]
+     @return returns the subset
+   */
+  ContiguousTimeSeriesClassificationData getSubset(
+    const Vector<uint32>& sampleIndices) const;
+
+  /**
+     Gets a dataset with all the samples of one class.  The arena is shared,
+        so only the indices are copied.
+
+     @param classLabel: the class label of the samples
+     @return returns the samples of the class
+   */
+  ContiguousTimeSeriesClassificationData getClassData(
+    const uint32 classLabel) const;
+
+  /**
+     Copies the samples into a TimeSeriesClassificationData.
+
+     @param data: returns the copy of the dataset
+     @return returns true if the dataset was copied
+   */
+  bool copyTo(TimeSeriesClassificationData& data) const;
+
+  /**
+     Gets the ranges of the dataset: the external ranges if they are used,
+        otherwise the minimum and maximum value of each dimension over all the
+        samples.
+
+     @return returns the ranges of the dataset
+   */
+  Vector<MinMax> getRanges() const;
+
+  /**
+     Gets a hash of the samples, their class labels and any external ranges
+        used.  The hash is the same as TimeSeriesClassificationData::getHash
+        gives for the same samples, so it can key data cached by either class.
+
+     @return returns the hash of the dataset
+   */
+  uint64 getHash() const;
+
+  /**
+     Gets the ranges set by setExternalRanges.
+
+     @return a vector of minimum and maximum values for each dimension
+   */
+  const Vector<MinMax>& getExternalRanges() const {
+    return externalRanges;
+  }
+
+  /**
+     Gets if the dataset should be scaled using the external ranges.
+
+     @return returns true if the external ranges are used
+   */
+  bool getUseExternalRanges() const {
+    return useExternalRanges;
+  }
+
+  FString getDatasetName() const {
+    return datasetName;
+  }
+
+  FString getInfoText() const {
+    return infoText;
+  }
+
+  uint32 getNumDimensions() const {
+    return numDimensions;
+  }
+
+  uint32 getNumSamples() const {
+    return (uint32)indices.size();
+  }
+
+  uint32 getNumClasses() const {
+    return (uint32)classTracker.size();
+  }
+
+  const Vector<ClassTracker>& getClassTracker() const {
+    return classTracker;
+  }
+
+  /**
+     Gets the index of each sample in the arena.
+
+     @return returns the sample indices
+   */
+  const Vector<uint32>& getSampleIndices() const {
+    return indices;
+  }
+
+  /**
+     Gets the number of floats stored in the arena, which is shared with any
+        copies and subsets of the dataset.
+
+     @return returns the size of the arena
+   */
+  uint64 getArenaSize() const {
+    return arena->values.size();
+  }
+
+protected:
+
+  /// The samples of a dataset, one after another
+  struct Arena {
+    Vector<float>  values;  ///< The data of all the samples
+    Vector<uint64> offsets; ///< The first value of each sample
+    Vector<uint32> lengths; ///< The number of rows of each sample
+    Vector<uint32> labels;  ///< The class label of each sample
+  };
+
+  // Copies the samples of this dataset into a new arena that only this
+  // dataset uses
+  void makeArenaUnique();
+
+  // Counts the samples of each class
+  void updateClassTracker();
+
+  FString        datasetName;
+  FString        infoText;
+  uint32         numDimensions;
+  bool           useExternalRanges;   ///< Scale with the externalRanges
+  Vector<MinMax> externalRanges;      ///< The ranges set by setExternalRanges
+  std::shared_ptr<Arena> arena;       ///< The arena, shared by copies
+  Vector<uint32> indices;             ///< The samples of this dataset
+  Vector<ClassTracker> classTracker;  ///< The number of samples in each class
+};
+}
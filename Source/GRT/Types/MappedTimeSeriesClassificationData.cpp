@@ -0,0 +1,380 @@
+﻿#include "../GRT.h"
+#include "MappedTimeSeriesClassificationData.h"
+#include "TimeSeriesClassificationData.h"
+#include <fstream>
+#include <string>
+
+// The binary dataset format (see MappedTimeSeriesClassificationData::write).
+// All sections start on a GRT_DATASET_BINARY_ALIGNMENT byte boundary so the
+// columns and the sample data can be used in place once the file is mapped
+#define GRT_DATASET_BINARY_MAGIC "GRTTSCD"
+#define GRT_DATASET_BINARY_VERSION 1
+#define GRT_DATASET_BINARY_BYTE_ORDER 0x01020304
+#define GRT_DATASET_BINARY_ALIGNMENT 64
+
+struct DatasetBinaryHeader {
+  char   magic[8];              // GRT_DATASET_BINARY_MAGIC
+  uint32 version;               // GRT_DATASET_BINARY_VERSION
+  uint32 byteOrder;             // GRT_DATASET_BINARY_BYTE_ORDER as written
+  uint32 numDimensions;
+  uint32 numSamples;
+  uint32 numClasses;
+  uint32 useExternalRanges;
+  uint32 allowNullGestureClass;
+  uint32 numRanges;
+  uint64 stringsOffset;         // The dataset name, the info text and the class
+                                // names as UTF-8, each ending with a 0
+  uint64 stringsSize;
+  uint64 classTableOffset;      // uint32 [numClasses 2] labels and counters
+  uint64 rangesOffset;          // float [numRanges 2]
+  uint64 labelsOffset;          // uint32 [numSamples]
+  uint64 lengthsOffset;         // uint32 [numSamples]
+  uint64 sampleOffsetsOffset;   // uint64 [numSamples], in floats from dataOffset
+  uint64 dataOffset;            // float [dataSize]
+  uint64 dataSize;
+  uint64 fileSize;
+};
+static_assert(sizeof(DatasetBinaryHeader) == 120,
+              "DatasetBinaryHeader must not contain padding");
+
+namespace GRT {
+static uint64 alignDatasetOffset(const uint64 offset) {
+  return (offset + GRT_DATASET_BINARY_ALIGNMENT - 1) /
+         GRT_DATASET_BINARY_ALIGNMENT * GRT_DATASET_BINARY_ALIGNMENT;
+}
+
+static void writeDatasetPadding(std::fstream& file, const uint64 offset) {
+  const char zeros[GRT_DATASET_BINARY_ALIGNMENT] = { 0 };
+  const uint64 position = (uint64)file.tellp();
+
+  if (offset > position) file.write(zeros, (std::streamsize)(offset - position));
+}
+
+// Returns true if the section [offset offset+size) is inside the file
+static bool datasetSectionIsValid(const uint64 offset,
+                                  const uint64 size,
+                                  const uint64 fileSize) {
+  return (offset % GRT_DATASET_BINARY_ALIGNMENT == 0) && (offset <= fileSize) &&
+         (size <= fileSize - offset);
+}
+
+MappedTimeSeriesClassificationData::MappedTimeSeriesClassificationData() {
+  numDimensions         = 0;
+  numSamples            = 0;
+  dataSize              = 0;
+  allowNullGestureClass = true;
+  useExternalRanges     = false;
+  labels                = NULL;
+  lengths               = NULL;
+  sampleOffsets         = NULL;
+  samples               = NULL;
+}
+
+MappedTimeSeriesClassificationData::~MappedTimeSeriesClassificationData() {
+  close();
+}
+
+void MappedTimeSeriesClassificationData::close() {
+  file.close();
+  datasetName           = "";
+  infoText              = "";
+  numDimensions         = 0;
+  numSamples            = 0;
+  dataSize              = 0;
+  allowNullGestureClass = true;
+  useExternalRanges     = false;
+  externalRanges.clear();
+  classTracker.clear();
+  labels        = NULL;
+  lengths       = NULL;
+  sampleOffsets = NULL;
+  samples       = NULL;
+}
+
+bool MappedTimeSeriesClassificationData::isBinaryDatasetFile(
+  const FString& filename) {
+  std::fstream file;
+
+  file.open(TCHAR_TO_UTF8(*filename), std::ios::in | std::ios::binary);
+
+  if (!file.is_open()) return false;
+
+  char magic[8] = { 0 };
+  file.read(magic, sizeof(magic));
+
+  return file.gcount() == sizeof(magic) &&
+         memcmp(magic, GRT_DATASET_BINARY_MAGIC, sizeof(magic)) == 0;
+}
+
+bool MappedTimeSeriesClassificationData::open(const FString& filename) {
+  close();
+
+  if (!file.open(filename)) {
+    UE_LOG(GRTModule, Error,
+           TEXT("open(FString filename) - Failed to open file!"));
+    return false;
+  }
+
+  const char  *base     = file.getData();
+  const uint64 fileSize = file.getSize();
+
+  if (fileSize < sizeof(DatasetBinaryHeader)) {
+    UE_LOG(GRTModule, Error,
+           TEXT("open(FString filename) - The file is too small!"));
+    close();
+    return false;
+  }
+
+  DatasetBinaryHeader header;
+  memcpy(&header, base, sizeof(header));
+
+  if (memcmp(header.magic, GRT_DATASET_BINARY_MAGIC, sizeof(header.magic)) != 0) {
+    UE_LOG(GRTModule, Error,
+           TEXT("open(FString filename) - Failed to find file header!"));
+    close();
+    return false;
+  }
+
+  if (header.byteOrder != GRT_DATASET_BINARY_BYTE_ORDER) {
+    UE_LOG(GRTModule, Error,
+           TEXT(
+             "open(FString filename) - The file was saved with a different byte order!"));
+    close();
+    return false;
+  }
+
+  if (header.version != GRT_DATASET_BINARY_VERSION) {
+    UE_LOG(GRTModule, Error,
+           TEXT("open(FString filename) - Unknown file version %u!"),
+           header.version);
+    close();
+    return false;
+  }
+
+  const uint64 N         = header.numSamples;
+  const uint64 numRanges = header.numRanges;
+
+  if ((header.fileSize != fileSize) ||
+      !datasetSectionIsValid(header.stringsOffset, header.stringsSize,
+                             fileSize) ||
+      !datasetSectionIsValid(header.classTableOffset,
+                             2 * sizeof(uint32) * (uint64)header.numClasses,
+                             fileSize) ||
+      !datasetSectionIsValid(header.rangesOffset,
+                             2 * sizeof(float) * numRanges, fileSize) ||
+      !datasetSectionIsValid(header.labelsOffset, sizeof(uint32) * N,
+                             fileSize) ||
+      !datasetSectionIsValid(header.lengthsOffset, sizeof(uint32) * N,
+                             fileSize) ||
+      !datasetSectionIsValid(header.sampleOffsetsOffset, sizeof(uint64) * N,
+                             fileSize) ||
+      (header.dataSize > fileSize) ||
+      !datasetSectionIsValid(header.dataOffset, sizeof(float) * header.dataSize,
+                             fileSize)) {
+    UE_LOG(GRTModule, Error,
+           TEXT("open(FString filename) - The file is corrupt or truncated!"));
+    close();
+    return false;
+  }
+
+  numDimensions         = header.numDimensions;
+  numSamples            = header.numSamples;
+  dataSize              = header.dataSize;
+  useExternalRanges     = header.useExternalRanges != 0;
+  allowNullGestureClass = header.allowNullGestureClass != 0;
+  labels                = (const uint32 *)(base + header.labelsOffset);
+  lengths               = (const uint32 *)(base + header.lengthsOffset);
+  sampleOffsets         = (const uint64 *)(base + header.sampleOffsetsOffset);
+  samples               = (const float *)(base + header.dataOffset);
+
+  // Check that every sample is inside the data block here, so getSample does
+  // not have to
+  for (uint32 i = 0; i < numSamples; i++) {
+    const uint64 sampleSize = (uint64)lengths[i] * numDimensions;
+
+    if ((sampleOffsets[i] > dataSize) ||
+        (sampleSize > dataSize - sampleOffsets[i])) {
+      UE_LOG(GRTModule, Error,
+             TEXT("open(FString filename) - Sample %u is outside the data!"),
+             i);
+      close();
+      return false;
+    }
+  }
+
+  // Read the strings, each one must end inside the string section
+  const char *strings    = base + header.stringsOffset;
+  const char *stringsEnd = strings + header.stringsSize;
+  const uint32 numStrings = 2 + header.numClasses;
+  Vector<FString> values(numStrings);
+
+  for (uint32 k = 0; k < numStrings; k++) {
+    const char *end = (const char *)memchr(strings, 0, stringsEnd - strings);
+
+    if (end == NULL) {
+      UE_LOG(GRTModule, Error,
+             TEXT("open(FString filename) - Failed to read the strings!"));
+      close();
+      return false;
+    }
+    values[k] = FString(UTF8_TO_TCHAR(strings));
+    strings   = end + 1;
+  }
+  datasetName = values[0];
+  infoText    = values[1];
+
+  const uint32 *classTable = (const uint32 *)(base + header.classTableOffset);
+  classTracker.resize(header.numClasses);
+
+  for (uint32 k = 0; k < header.numClasses; k++) {
+    classTracker[k].classLabel = classTable[2 * k];
+    classTracker[k].counter    = classTable[2 * k + 1];
+    classTracker[k].className  = values[2 + k];
+  }
+
+  const float *ranges = (const float *)(base + header.rangesOffset);
+  externalRanges.resize(numRanges);
+
+  for (uint32 j = 0; j < numRanges; j++) {
+    externalRanges[j].minValue = ranges[2 * j];
+    externalRanges[j].maxValue = ranges[2 * j + 1];
+  }
+
+  return true;
+}
+
+bool MappedTimeSeriesClassificationData::write(
+  const TimeSeriesClassificationData& dataset,
+  const FString& filename) {
+  const uint32 N = dataset.getNumSamples();
+  const uint32 numDims = dataset.getNumDimensions();
+  const Vector<ClassTracker> tracker = dataset.getClassTracker();
+  const Vector<MinMax>& ranges = dataset.getExternalRanges();
+  const uint32 numRanges = ranges.getSize();
+
+  // Build the string section
+  std::string strings;
+  strings += TCHAR_TO_UTF8(*dataset.getDatasetName());
+  strings.push_back('\0');
+  strings += TCHAR_TO_UTF8(*dataset.getInfoText());
+  strings.push_back('\0');
+
+  for (uint32 k = 0; k < tracker.getSize(); k++) {
+    strings += TCHAR_TO_UTF8(*tracker[k].className);
+    strings.push_back('\0');
+  }
+
+  // Build the columns
+  Vector<uint32> labelColumn(N);
+  Vector<uint32> lengthColumn(N);
+  Vector<uint64> offsetColumn(N);
+  uint64 dataSize = 0;
+
+  for (uint32 i = 0; i < N; i++) {
+    labelColumn[i]  = dataset[i].getClassLabel();
+    lengthColumn[i] = dataset[i].getLength();
+    offsetColumn[i] = dataSize;
+    dataSize       += (uint64)lengthColumn[i] * numDims;
+  }
+
+  DatasetBinaryHeader header;
+  memset(&header, 0, sizeof(header));
+  memcpy(header.magic, GRT_DATASET_BINARY_MAGIC, sizeof(header.magic));
+  header.version               = GRT_DATASET_BINARY_VERSION;
+  header.byteOrder             = GRT_DATASET_BINARY_BYTE_ORDER;
+  header.numDimensions         = numDims;
+  header.numSamples            = N;
+  header.numClasses            = tracker.getSize();
+  header.useExternalRanges     = dataset.getUseExternalRanges() ? 1 : 0;
+  header.numRanges             = numRanges;
+  header.allowNullGestureClass = dataset.getAllowNullGestureClass() ? 1 : 0;
+  header.stringsOffset         = alignDatasetOffset(sizeof(header));
+  header.stringsSize           = strings.size();
+  header.classTableOffset      = alignDatasetOffset(header.stringsOffset +
+                                                    header.stringsSize);
+  header.rangesOffset = alignDatasetOffset(header.classTableOffset +
+                                           2 * sizeof(uint32) *
+                                           header.numClasses);
+  header.labelsOffset = alignDatasetOffset(header.rangesOffset +
+                                           2 * sizeof(float) * numRanges);
+  header.lengthsOffset = alignDatasetOffset(header.labelsOffset +
+                                            sizeof(uint32) * (uint64)N);
+  header.sampleOffsetsOffset = alignDatasetOffset(header.lengthsOffset +
+                                                  sizeof(uint32) * (uint64)N);
+  header.dataOffset = alignDatasetOffset(header.sampleOffsetsOffset +
+                                         sizeof(uint64) * (uint64)N);
+  header.dataSize = dataSize;
+  header.fileSize = header.dataOffset + sizeof(float) * dataSize;
+
+  std::fstream file;
+  file.open(TCHAR_TO_UTF8(*filename),
+            std::ios::out | std::ios::binary | std::ios::trunc);
+
+  if (!file.is_open()) {
+    UE_LOG(GRTModule, Error,
+           TEXT("write(FString filename) - Failed to open file!"));
+    return false;
+  }
+
+  file.write((const char *)&header, sizeof(header));
+  writeDatasetPadding(file, header.stringsOffset);
+  file.write(strings.data(), (std::streamsize)strings.size());
+  writeDatasetPadding(file, header.classTableOffset);
+
+  for (uint32 k = 0; k < tracker.getSize(); k++) {
+    const uint32 entry[2] = { tracker[k].classLabel, tracker[k].counter };
+    file.write((const char *)entry, sizeof(entry));
+  }
+  writeDatasetPadding(file, header.rangesOffset);
+
+  for (uint32 j = 0; j < numRanges; j++) {
+    const float range[2] = { ranges[j].minValue, ranges[j].maxValue };
+    file.write((const char *)range, sizeof(range));
+  }
+
+  if (N > 0) {
+    writeDatasetPadding(file, header.labelsOffset);
+    file.write((const char *)&labelColumn[0], sizeof(uint32) * N);
+    writeDatasetPadding(file, header.lengthsOffset);
+    file.write((const char *)&lengthColumn[0], sizeof(uint32) * N);
+    writeDatasetPadding(file, header.sampleOffsetsOffset);
+    file.write((const char *)&offsetColumn[0], sizeof(uint64) * N);
+  }
+  writeDatasetPadding(file, header.dataOffset);
+
+  for (uint32 i = 0; i < N; i++) {
+    const MatrixFloat& sample = dataset[i].getData();
+
+    if (lengthColumn[i] > 0) {
+      file.write((const char *)sample.getData(),
+                 (std::streamsize)(sizeof(float) * lengthColumn[i] * numDims));
+    }
+  }
+
+  // The last sections may be empty, so pad the file out to fileSize
+  writeDatasetPadding(file, header.fileSize);
+
+  const bool ok = !file.fail();
+  file.close();
+
+  if (!ok) {
+    UE_LOG(GRTModule, Error,
+           TEXT("write(FString filename) - Failed to write the file!"));
+  }
+  return ok;
+}
+
+bool MappedTimeSeriesClassificationData::convertTextFile(
+  const FString& textFilename,
+  const FString& binaryFilename) {
+  TimeSeriesClassificationData dataset;
+
+  if (!dataset.loadDatasetFromFile(textFilename)) {
+    UE_LOG(GRTModule, Error,
+           TEXT("convertTextFile(...) - Failed to load the text file!"));
+    return false;
+  }
+
+  return write(dataset, binaryFilename);
+}
+}
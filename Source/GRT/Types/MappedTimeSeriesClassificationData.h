@@ -0,0 +1,205 @@
+﻿#pragma once
+
+#include "../GRT.h"
+#include "MatrixView.h"
+#include "../Utility/ClassTracker.h"
+#include "../Utility/MinMax.h"
+#include "../Utility/MappedFile.h"
+
+namespace GRT {
+class TimeSeriesClassificationData;
+
+/**
+   @brief The MappedTimeSeriesClassificationData class gives read only access
+      to a binary dataset file written by
+      TimeSeriesClassificationData::saveDatasetToBinaryFile.
+
+   The file is stored by column: the class labels, the lengths and the data
+      offsets of all the samples are each stored as one array, followed by
+      one aligned block holding the data of every sample back to back.
+
+   The file is memory mapped (see MappedFile) and each sample is returned as a
+      MatrixView into the mapping, so opening a dataset only reads the header
+      and the sample index.  The views stay valid until the file is closed.
+      Use TimeSeriesClassificationData::loadDatasetFromBinaryFile to get an
+      editable copy of the dataset.
+ */
+class GRT_API MappedTimeSeriesClassificationData {
+public:
+
+  /**
+     Default Constructor
+   */
+  MappedTimeSeriesClassificationData();
+
+  /**
+     Default Destructor, closes the file if it is open
+   */
+  ~MappedTimeSeriesClassificationData();
+
+  /**
+     Opens and validates a binary dataset file, closing any file that was
+        previously open.
+
+     @param filename: the name of the file to open
+     @return returns true if the file was opened, false otherwise
+   */
+  bool open(const FString& filename);
+
+  /**
+     Closes the file, invalidating any views returned by getSample.
+   */
+  void close();
+
+  /**
+     Returns true if the file starts with the binary dataset header, this
+        only reads the first few bytes of the file.
+
+     @param filename: the name of the file to check
+     @return returns true if the file is a binary dataset file
+   */
+  static bool isBinaryDatasetFile(const FString& filename);
+
+  /**
+     Writes a dataset to a file in the binary format.
+
+     @param dataset: the dataset to write
+     @param filename: the name of the file the dataset will be written to
+     @return returns true if the file was written, false otherwise
+   */
+  static bool write(const TimeSeriesClassificationData& dataset,
+                    const FString& filename);
+
+  /**
+     Converts a dataset file in the
+        GRT_LABELLED_TIME_SERIES_CLASSIFICATION_DATA_FILE_V1.0 text format to
+        the binary format.
+
+     @param textFilename: the name of the text file to read
+     @param binaryFilename: the name of the binary file to write
+     @return returns true if the file was converted, false otherwise
+   */
+  static bool convertTextFile(const FString& textFilename,
+                              const FString& binaryFilename);
+
+  /**
+     Gets the sample at index i as a view into the mapped file.
+
+     @param i: the index of the sample, should be in the range [0
+        numSamples-1]
+     @return returns a [length numDimensions] view of the sample
+   */
+  inline MatrixView getSample(const uint32 i) const {
+    return MatrixView(samples + sampleOffsets[i], lengths[i], numDimensions);
+  }
+
+  /**
+     Gets the class label of the sample at index i.
+
+     @param i: the index of the sample, should be in the range [0
+        numSamples-1]
+     @return returns the class label of the sample
+   */
+  inline uint32 getClassLabel(const uint32 i) const {
+    return labels[i];
+  }
+
+  /**
+     Gets the length of the sample at index i.
+
+     @param i: the index of the sample, should be in the range [0
+        numSamples-1]
+     @return returns the number of rows in the sample
+   */
+  inline uint32 getLength(const uint32 i) const {
+    return lengths[i];
+  }
+
+  bool getIsOpen() const {
+    return file.getIsOpen();
+  }
+
+  uint32 getNumDimensions() const {
+    return numDimensions;
+  }
+
+  uint32 getNumSamples() const {
+    return numSamples;
+  }
+
+  uint32 getNumClasses() const {
+    return (uint32)classTracker.size();
+  }
+
+  FString getDatasetName() const {
+    return datasetName;
+  }
+
+  FString getInfoText() const {
+    return infoText;
+  }
+
+  bool getAllowNullGestureClass() const {
+    return allowNullGestureClass;
+  }
+
+  bool getUseExternalRanges() const {
+    return useExternalRanges;
+  }
+
+  const Vector<MinMax>& getExternalRanges() const {
+    return externalRanges;
+  }
+
+  const Vector<ClassTracker>& getClassTracker() const {
+    return classTracker;
+  }
+
+  /**
+     Gets the offset of the sample at index i from the start of the sample
+        data block.
+
+     @param i: the index of the sample, should be in the range [0
+        numSamples-1]
+     @return returns the offset of the sample in floats
+   */
+  inline uint64 getSampleOffset(const uint32 i) const {
+    return sampleOffsets[i];
+  }
+
+  /**
+     Gets the sample data block, which holds the data of all the samples.
+
+     @return returns a pointer to the first float of the block
+   */
+  const float * getData() const {
+    return samples;
+  }
+
+  /**
+     Gets the total number of floats in the sample data block.
+
+     @return returns the size of the sample data
+   */
+  uint64 getDataSize() const {
+    return dataSize;
+  }
+
+protected:
+
+  MappedFile     file;
+  FString        datasetName;
+  FString        infoText;
+  uint32         numDimensions;
+  uint32         numSamples;
+  uint64         dataSize;
+  bool           allowNullGestureClass;
+  bool           useExternalRanges;
+  Vector<MinMax> externalRanges;
+  Vector<ClassTracker> classTracker;
+  const uint32  *labels;        ///< The class label column, in the mapping
+  const uint32  *lengths;       ///< The length column, in the mapping
+  const uint64  *sampleOffsets; ///< The offset column, in the mapping
+  const float   *samples;       ///< The sample data, in the mapping
+};
+}
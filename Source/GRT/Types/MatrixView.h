@@ -0,0 +1,210 @@
+﻿#pragma once
+
+#include "../GRT.h"
+#include "MatrixFloat.h"
+
+namespace GRT {
+/**
+   @brief The MatrixView class provides a lightweight, non-owning view of a
+      row-major block of float data.  A view is described by a pointer to the
+      first element, the number of rows and columns, and a row stride (the
+      number of floats between the start of two consecutive rows).
+
+   A view never allocates or frees memory, so the memory it points to must
+      outlive the view.  Views can be built from a MatrixFloat, from a window of
+      a TimeSeriesCircularBuffer or from a raw float array (for example a sensor
+      buffer owned by the engine), and can be narrowed to a sub-range of rows or
+      columns without copying any data.
+ */
+class GRT_API MatrixView {
+public:
+
+  /**
+     Default Constructor, creates an empty view
+   */
+  MatrixView() {
+    dataPtr = NULL;
+    rows    = 0;
+    cols    = 0;
+    stride  = 0;
+  }
+
+  /**
+     Constructor, creates a view over a raw float array
+
+     @param data: a pointer to the first element of the data
+     @param rows: the number of rows in the view
+     @param cols: the number of columns in the view
+     @param stride: the number of floats between the start of two consecutive
+        rows, if zero then the rows are assumed to be tightly packed (stride =
+        cols)
+   */
+  MatrixView(const float *data,
+             const uint32 rows,
+             const uint32 cols,
+             const uint32 stride = 0) {
+    this->dataPtr = data;
+    this->rows    = rows;
+    this->cols    = cols;
+    this->stride  = stride == 0 ? cols : stride;
+  }
+
+  /**
+     Constructor, creates a view over the entire matrix.  The matrix must not
+        be resized or destroyed while the view is in use.
+
+     @param matrix: the matrix the view will point to
+   */
+  MatrixView(const Matrix<float>& matrix) {
+    this->dataPtr = matrix.getData();
+    this->rows    = matrix.getNumRows();
+    this->cols    = matrix.getNumCols();
+    this->stride  = matrix.getNumCols();
+  }
+
+  /**
+     Default Destructor, the view does not own any memory
+   */
+  ~MatrixView() {}
+
+  /**
+     Returns a const pointer to the data at row r
+
+     @param r: the index of the row you want, should be in the range [0 rows-1]
+     @return a const pointer to the data at row r
+   */
+  inline const float * operator[](const uint32 r) const {
+    return dataPtr + (size_t)r * stride;
+  }
+
+  /**
+     Returns a new view containing the rows [startRow startRow+numRows-1] of
+        this view.  No data is copied.
+
+     @param startRow: the first row of the sub-range
+     @param numRows: the number of rows in the sub-range
+     @return returns the sub-range view, or an empty view if the range is
+        invalid
+   */
+  MatrixView getRows(const uint32 startRow, const uint32 numRows) const {
+    if ((startRow + numRows > rows) || (numRows == 0)) return MatrixView();
+
+    return MatrixView((*this)[startRow], numRows, cols, stride);
+  }
+
+  /**
+     Returns a new view containing the columns [startCol startCol+numCols-1] of
+        this view.  No data is copied.
+
+     @param startCol: the first column of the sub-range
+     @param numCols: the number of columns in the sub-range
+     @return returns the sub-range view, or an empty view if the range is
+        invalid
+   */
+  MatrixView getCols(const uint32 startCol, const uint32 numCols) const {
+    if ((startCol + numCols > cols) || (numCols == 0)) return MatrixView();
+
+    return MatrixView(dataPtr + startCol, rows, numCols, stride);
+  }
+
+  /**
+     Gets a row vector [1 cols] from the view at the row index r
+
+     @param r: the index of the row, this should be in the range [0 rows-1]
+     @return returns a copy of the row at the row index r
+   */
+  VectorFloat getRow(const uint32 r) const {
+    VectorFloat rowVector(cols);
+    const float *row = (*this)[r];
+
+    for (uint32 c = 0; c < cols; c++) rowVector[c] = row[c];
+    return rowVector;
+  }
+
+  /**
+     Copies the data in the view into the matrix, resizing the matrix if needed.
+
+     @param matrix: the matrix the data will be copied to
+     @return returns true if the data was copied, false otherwise
+   */
+  bool copyTo(MatrixFloat& matrix) const {
+    if (getIsEmpty()) {
+      matrix.clear();
+      return false;
+    }
+
+    if ((matrix.getNumRows() != rows) || (matrix.getNumCols() != cols)) {
+      if (!matrix.resize(rows, cols)) return false;
+    }
+
+    for (uint32 i = 0; i < rows; i++) {
+      const float *src = (*this)[i];
+      float *dst       = matrix[i];
+
+      for (uint32 j = 0; j < cols; j++) dst[j] = src[j];
+    }
+    return true;
+  }
+
+  /**
+     Gets the number of rows in the view
+
+     @return returns the number of rows in the view
+   */
+  inline uint32 getNumRows() const {
+    return rows;
+  }
+
+  /**
+     Gets the number of columns in the view
+
+     @return returns the number of columns in the view
+   */
+  inline uint32 getNumCols() const {
+    return cols;
+  }
+
+  /**
+     Gets the row stride of the view (the number of floats between two rows)
+
+     @return returns the row stride of the view
+   */
+  inline uint32 getStride() const {
+    return stride;
+  }
+
+  /**
+     Gets a pointer to the first element of the view
+
+     @return returns a pointer to the raw data
+   */
+  inline const float * getData() const {
+    return dataPtr;
+  }
+
+  /**
+     Returns true if the view does not point to any data
+
+     @return returns true if the view is empty, false otherwise
+   */
+  inline bool getIsEmpty() const {
+    return (dataPtr == NULL) || (rows == 0) || (cols == 0);
+  }
+
+  /**
+     Returns true if the rows of the view are tightly packed in memory
+
+     @return returns true if stride == cols, false otherwise
+   */
+  inline bool getIsContiguous() const {
+    return stride == cols;
+  }
+
+protected:
+
+  const float *dataPtr; ///< A pointer to the first element, not owned
+  uint32 rows;          ///< The number of rows in the view
+  uint32 cols;          ///< The number of columns in the view
+  uint32 stride;        ///< The number of floats between two consecutive rows
+};
+}
@@ -1,5 +1,12 @@
 ﻿#include "../GRT.h"
 #include "TimeSeriesClassificationData.h"
+#include "MappedTimeSeriesClassificationData.h"
+#include "CompressedTimeSeriesClassificationData.h"
+#include "../Utility/MappedFile.h"
+#include "../Utility/TextTokenizer.h"
+#include "../Utility/ThreadPool.h"
+#include "HAL/FileManager.h"
+#include "Misc/Paths.h"
 
 namespace GRT {
 TimeSeriesClassificationData::TimeSeriesClassificationData(
@@ -10,6 +17,8 @@ TimeSeriesClassificationData::TimeSeriesClassificationData(
   this->datasetName     = datasetName;
   this->infoText        = infoText;
   totalNumSamples       = 0;
+  statsOutOfDate        = false;
+  statsMomentsOutOfDate = true;
   crossValidationSetup  = false;
   useExternalRanges     = false;
   allowNullGestureClass = true;
@@ -39,6 +48,12 @@ TimeSeriesClassificationData& TimeSeriesClassificationData::operator=(
     this->totalNumSamples       = rhs.totalNumSamples;
     this->data                  = rhs.data;
     this->classTracker          = rhs.classTracker;
+    this->classIndexMap         = rhs.classIndexMap;
+    this->classSampleIndexs     = rhs.classSampleIndexs;
+    this->stats                 = rhs.stats;
+    this->rowStatistics         = rhs.rowStatistics;
+    this->statsOutOfDate        = rhs.statsOutOfDate;
+    this->statsMomentsOutOfDate = rhs.statsMomentsOutOfDate;
     this->externalRanges        = rhs.externalRanges;
   }
   return *this;
@@ -48,6 +63,12 @@ void TimeSeriesClassificationData::clear() {
   totalNumSamples = 0;
   data.clear();
   classTracker.clear();
+  classIndexMap.clear();
+  classSampleIndexs.clear();
+  stats = DatasetStats();
+  rowStatistics.clear();
+  statsOutOfDate        = false;
+  statsMomentsOutOfDate = true;
 }
 
 bool TimeSeriesClassificationData::setNumDimensions(const uint32 l_numDimensions)
@@ -92,14 +113,12 @@ bool TimeSeriesClassificationData::setInfoText(const FString l_infoText) {
 bool TimeSeriesClassificationData::setClassNameForCorrespondingClassLabel(
   const FString className,
   const uint32  classLabel) {
-  for (uint32 i = 0; i < classTracker.size(); i++) {
-    if (classTracker[i].classLabel == classLabel) {
-      classTracker[i].className = className;
-      return true;
-    }
-  }
+  const auto iter = classIndexMap.find(classLabel);
 
-  return false;
+  if (iter == classIndexMap.end()) return false;
+
+  classTracker[iter->second].className = className;
+  return true;
 }
 
 bool TimeSeriesClassificationData::setAllowNullGestureClass(
@@ -131,57 +150,49 @@ bool TimeSeriesClassificationData::addSample(const uint32       classLabel,
   data.push_back(newSample);
   totalNumSamples++;
 
-  if (classTracker.size() == 0) {
-    ClassTracker tracker(classLabel, 1);
-    classTracker.push_back(tracker);
-  }
-  else {
-    bool labelFound = false;
+  if (!statsOutOfDate) addSampleToStats(trainingSample);
 
-    for (uint32 i = 0; i < classTracker.size(); i++) {
-      if (classLabel == classTracker[i].classLabel) {
-        classTracker[i].counter++;
-        labelFound = true;
-        break;
-      }
-    }
+  const auto iter = classIndexMap.find(classLabel);
 
-    if (!labelFound) {
-      ClassTracker tracker(classLabel, 1);
-      classTracker.push_back(tracker);
-    }
+  if (iter != classIndexMap.end()) {
+    classTracker[iter->second].counter++;
+    classSampleIndexs[iter->second].push_back(totalNumSamples - 1);
+  }
+  else {
+    classIndexMap[classLabel] = (uint32)classTracker.size();
+    classTracker.push_back(ClassTracker(classLabel, 1));
+    classSampleIndexs.push_back(Vector<uint32>(1, totalNumSamples - 1));
   }
   return true;
 }
 
 uint32 TimeSeriesClassificationData::eraseAllSamplesWithClassLabel(
   const uint32 classLabel) {
-  uint32 numExamplesRemoved  = 0;
-  uint32 numExamplesToRemove = 0;
+  const auto iter = classIndexMap.find(classLabel);
 
-  // Find out how many training examples we need to remove
-  for (uint32 i = 0; i < classTracker.size(); i++) {
-    if (classTracker[i].classLabel == classLabel) {
-      numExamplesToRemove = classTracker[i].counter;
-      classTracker.erase(classTracker.begin() + i);
-      break;
-    }
-  }
+  if (iter == classIndexMap.end()) return 0;
 
-  // Remove the samples with the matching class ID
-  if (numExamplesToRemove > 0) {
-    uint32 i = 0;
+  // Remove the samples with the matching class ID, moving the remaining
+  // samples down in a single pass
+  const Vector<uint32>& classIndexs = classSampleIndexs[iter->second];
+  const uint32 numExamplesRemoved   = (uint32)classIndexs.size();
+  uint32 next                       = 0;
+  uint32 k                          = 0;
 
-    while (numExamplesRemoved < numExamplesToRemove) {
-      if (data[i].getClassLabel() == classLabel) {
-        data.erase(data.begin() + i);
-        numExamplesRemoved++;
-      }
-      else if (++i == data.size()) break;
+  for (uint32 i = 0; i < totalNumSamples; i++) {
+    if ((k < numExamplesRemoved) && (classIndexs[k] == i)) {
+      k++;
+      continue;
     }
+
+    if (next != i) data[next] = data[i];
+    next++;
   }
+  data.resize(next);
 
+  classTracker.erase(classTracker.begin() + iter->second);
   totalNumSamples = (uint32)data.size();
+  updateClassIndexs();
 
   return numExamplesRemoved;
 }
@@ -195,14 +206,13 @@ bool TimeSeriesClassificationData::removeLastSample() {
     data.erase(data.end() - 1);
 
     totalNumSamples = (uint32)data.size();
+    statsOutOfDate  = true;
 
-    // Remove the value from the counter
-    for (uint32 i = 0; i < classTracker.size(); i++) {
-      if (classTracker[i].classLabel == classLabel) {
-        classTracker[i].counter--;
-        break;
-      }
-    }
+    // Remove the value from the counter, the last sample is always the last
+    // index of its class
+    const uint32 k = classIndexMap[classLabel];
+    classTracker[k].counter--;
+    classSampleIndexs[k].pop_back();
 
     return true;
   }
@@ -212,53 +222,40 @@ bool TimeSeriesClassificationData::removeLastSample() {
 bool TimeSeriesClassificationData::relabelAllSamplesWithClassLabel(
   const uint32 oldClassLabel,
   const uint32 newClassLabel) {
-  bool   oldClassLabelFound          = false;
-  bool   newClassLabelAllReadyExists = false;
-  uint32 indexOfOldClassLabel        = 0;
-  uint32 indexOfNewClassLabel        = 0;
-
-  // Find out how many training examples we need to relabel
-  for (uint32 i = 0; i < classTracker.size(); i++) {
-    if (classTracker[i].classLabel == oldClassLabel) {
-      indexOfOldClassLabel = i;
-      oldClassLabelFound   = true;
-    }
-
-    if (classTracker[i].classLabel == newClassLabel) {
-      indexOfNewClassLabel        = i;
-      newClassLabelAllReadyExists = true;
-    }
-  }
+  const auto oldIter = classIndexMap.find(oldClassLabel);
 
   // If the old class label was not found then we can't do anything
-  if (!oldClassLabelFound) {
+  if (oldIter == classIndexMap.end()) {
     return false;
   }
 
+  const uint32 indexOfOldClassLabel = oldIter->second;
+  const auto   newIter              = classIndexMap.find(newClassLabel);
+
   // Relabel the old class labels
-  for (uint32 i = 0; i < totalNumSamples; i++) {
-    if (data[i].getClassLabel() == oldClassLabel) {
-      data[i].setTrainingSample(newClassLabel, data[i].getData());
-    }
+  const Vector<uint32>& classIndexs = classSampleIndexs[indexOfOldClassLabel];
+
+  for (uint32 i = 0; i < classIndexs.size(); i++) {
+    data[classIndexs[i]].setTrainingSample(newClassLabel,
+                                           data[classIndexs[i]].getData());
   }
 
   // Update the class label counters
-  if (newClassLabelAllReadyExists) {
+  if (newIter != classIndexMap.end()) {
     // Add the old sample count to the new sample count
-    classTracker[indexOfNewClassLabel].counter +=
+    classTracker[newIter->second].counter +=
       classTracker[indexOfOldClassLabel].counter;
 
     // Erase the old class tracker
     classTracker.erase(classTracker.begin() + indexOfOldClassLabel);
   }
   else {
-    // Create a new class tracker
-    classTracker.push_back(ClassTracker(newClassLabel,
-                                        classTracker[indexOfOldClassLabel].counter,
-                                        classTracker[indexOfOldClassLabel].
-                                        className));
+    // The old class tracker becomes the tracker of the new class label
+    classTracker[indexOfOldClassLabel].classLabel = newClassLabel;
   }
 
+  updateClassIndexs();
+
   return true;
 }
 
@@ -293,6 +290,8 @@ bool TimeSeriesClassificationData::scale(const Vector<MinMax>& ranges,
                                          const float           maxTarget) {
   if (ranges.size() != numDimensions) return false;
 
+  statsOutOfDate = true;
+
   // Scale the training data
   for (uint32 i = 0; i < totalNumSamples; i++) {
     for (uint32 x = 0; x < data[i].getLength(); x++) {
@@ -315,8 +314,17 @@ bool TimeSeriesClassificationData::save(const FString& filename) const {
 }
 
 bool TimeSeriesClassificationData::load(const FString& filename) {
+  if (MappedTimeSeriesClassificationData::isBinaryDatasetFile(filename)) {
+    return loadDatasetFromBinaryFile(filename);
+  }
+
+  if (CompressedTimeSeriesClassificationData::isCompressedDatasetFile(filename))
+  {
+    return loadDatasetFromCompressedFile(filename);
+  }
+
   // load it as a custom GRT file
-  return loadDatasetFromFile(filename);
+  return parseDatasetFromFile(filename);
 }
 
 bool TimeSeriesClassificationData::saveDatasetToFile(const FString fileName)
@@ -595,6 +603,348 @@ bool TimeSeriesClassificationData::loadDatasetFromFile(const FString filename)
   }
 
   file.close();
+  updateClassIndexs();
+  return true;
+}
+
+bool TimeSeriesClassificationData::parseDatasetFromFile(
+  const FString filename,
+  const bool    useMultipleThreads) {
+  clear();
+
+  MappedFile file;
+
+  if (!file.open(filename)) {
+    UE_LOG(GRTModule, Error,
+           TEXT("parseDatasetFromFile(FString filename) - FILE NOT OPEN!"));
+    return false;
+  }
+
+  const char *text    = file.getData();
+  const char *textEnd = text + file.getSize();
+  TextTokenizer tokenizer(text, textEnd);
+  const char   *word;
+  uint32        length;
+  uint32        numClasses = 0;
+  uint32        useRanges  = 0;
+
+  // Parse the header, this follows loadDatasetFromFile word by word
+  if (!tokenizer.matchWord(
+        "GRT_LABELLED_TIME_SERIES_CLASSIFICATION_DATA_FILE_V1.0")) {
+    UE_LOG(GRTModule, Error,
+           TEXT(
+             "parseDatasetFromFile(FString filename) - Failed to find file header!"));
+    return false;
+  }
+
+  if (!tokenizer.matchWord("DatasetName:") ||
+      !tokenizer.nextWord(word, length)) {
+    UE_LOG(GRTModule, Error,
+           TEXT(
+             "parseDatasetFromFile(FString filename) - failed to find DatasetName!"));
+    return false;
+  }
+  datasetName = FString(std::string(word, length).c_str());
+
+  if (!tokenizer.matchWord("InfoText:")) {
+    UE_LOG(GRTModule, Error,
+           TEXT(
+             "parseDatasetFromFile(FString filename) - failed to find InfoText!"));
+    return false;
+  }
+
+  // Load the info text
+  std::string std_infoText;
+
+  while (true) {
+    if (!tokenizer.nextWord(word, length)) {
+      clear();
+      UE_LOG(GRTModule, Error,
+             TEXT(
+               "parseDatasetFromFile(FString filename) - Failed to find NumDimensions!"));
+      return false;
+    }
+
+    if ((length == 14) && (memcmp(word, "NumDimensions:", length) == 0)) break;
+
+    std_infoText.append(word, length);
+    std_infoText.push_back(' ');
+  }
+  infoText = FString(std_infoText.c_str());
+
+  if (!tokenizer.parseUint(numDimensions) ||
+      !tokenizer.matchWord("TotalNumTrainingExamples:") ||
+      !tokenizer.parseUint(totalNumSamples)) {
+    clear();
+    UE_LOG(GRTModule, Error,
+           TEXT(
+             "parseDatasetFromFile(FString filename) - Failed to find TotalNumTrainingExamples!"));
+    return false;
+  }
+
+  if (!tokenizer.matchWord("NumberOfClasses:") ||
+      !tokenizer.parseUint(numClasses) ||
+      !tokenizer.matchWord("ClassIDsAndCounters:")) {
+    clear();
+    UE_LOG(GRTModule, Error,
+           TEXT(
+             "parseDatasetFromFile(FString filename) - Failed to find ClassIDsAndCounters!"));
+    return false;
+  }
+
+  classTracker.resize(numClasses);
+
+  for (uint32 i = 0; i < classTracker.size(); i++) {
+    if (!tokenizer.parseUint(classTracker[i].classLabel) ||
+        !tokenizer.parseUint(classTracker[i].counter)) {
+      clear();
+      UE_LOG(GRTModule, Error,
+             TEXT(
+               "parseDatasetFromFile(FString filename) - Failed to parse the class counters!"));
+      return false;
+    }
+  }
+
+  if (!tokenizer.matchWord("UseExternalRanges:") ||
+      !tokenizer.parseUint(useRanges) || (useRanges > 1)) {
+    clear();
+    UE_LOG(GRTModule, Error,
+           TEXT(
+             "parseDatasetFromFile(FString filename) - Failed to find UseExternalRanges!"));
+    return false;
+  }
+  useExternalRanges = useRanges == 1;
+
+  if (useExternalRanges) {
+    externalRanges.resize(numDimensions);
+
+    for (uint32 i = 0; i < externalRanges.size(); i++) {
+      if (!tokenizer.parseFloat(externalRanges[i].minValue) ||
+          !tokenizer.parseFloat(externalRanges[i].maxValue)) {
+        clear();
+        UE_LOG(GRTModule, Error,
+               TEXT(
+                 "parseDatasetFromFile(FString filename) - Failed to parse the external ranges!"));
+        return false;
+      }
+    }
+  }
+
+  if (!tokenizer.matchWord("LabelledTimeSeriesTrainingData:")) {
+    clear();
+    UE_LOG(GRTModule, Error,
+           TEXT(
+             "parseDatasetFromFile(FString filename) - Failed to find LabelledTimeSeriesTrainingData!"));
+    return false;
+  }
+
+  // Find where each time series starts, so they can be parsed independently
+  const char *timeSeriesHeader = "************TIME_SERIES************";
+  Vector<const char *> timeSeriesStart(totalNumSamples + 1);
+
+  for (uint32 x = 0; x < totalNumSamples; x++) {
+    timeSeriesStart[x] = tokenizer.findWord(timeSeriesHeader);
+
+    if (timeSeriesStart[x] == NULL) {
+      clear();
+      UE_LOG(GRTModule, Error,
+             TEXT(
+               "parseDatasetFromFile(FString filename) - Failed to find TimeSeries Header!"));
+      return false;
+    }
+    tokenizer.setPosition(timeSeriesStart[x] + strlen(timeSeriesHeader));
+  }
+  timeSeriesStart[totalNumSamples] = textEnd;
+
+  // Parse the time series in parallel, each one is written to its own sample
+  data.resize(totalNumSamples, TimeSeriesClassificationSample());
+  Vector<uint8> parsed(totalNumSamples, 0);
+
+  ThreadPool::getInstance().parallelFor(totalNumSamples, [&](uint32 x) {
+    TextTokenizer series(timeSeriesStart[x], timeSeriesStart[x + 1]);
+    uint32 classLabel       = 0;
+    uint32 timeSeriesLength = 0;
+
+    if (!series.matchWord(timeSeriesHeader) ||
+        !series.matchWord("ClassID:") || !series.parseUint(classLabel) ||
+        !series.matchWord("TimeSeriesLength:") ||
+        !series.parseUint(timeSeriesLength) ||
+        !series.matchWord("TimeSeriesData:")) return;
+
+    // Parse the values straight into the sample
+    data[x].setTrainingSample(classLabel, MatrixFloat());
+    MatrixFloat& trainingExample = data[x].getData();
+
+    if ((timeSeriesLength > 0) && (numDimensions > 0) &&
+        !trainingExample.resize(timeSeriesLength, numDimensions)) return;
+
+    for (uint32 i = 0; i < timeSeriesLength; i++) {
+      float *row = trainingExample[i];
+
+      for (uint32 j = 0; j < numDimensions; j++) {
+        if (!series.parseFloat(row[j])) return;
+      }
+    }
+
+    // Anything between two time series means the file does not match the
+    // header, the text after the last one is ignored like loadDatasetFromFile
+    if ((x + 1 < totalNumSamples) && !series.getIsAtEnd()) return;
+
+    parsed[x] = 1;
+  }, 0, useMultipleThreads);
+
+  for (uint32 x = 0; x < totalNumSamples; x++) {
+    if (!parsed[x]) {
+      clear();
+      UE_LOG(GRTModule, Error,
+             TEXT(
+               "parseDatasetFromFile(FString filename) - Failed to parse time series %u!"),
+             x);
+      return false;
+    }
+  }
+
+  updateClassIndexs();
+  return true;
+}
+
+bool TimeSeriesClassificationData::loadDatasetsFromDirectory(
+  const FString directory,
+  const FString extension) {
+  TArray<FString> filenames;
+
+  IFileManager::Get().FindFiles(filenames, *directory, *extension);
+
+  if (filenames.Num() == 0) {
+    UE_LOG(GRTModule, Error,
+           TEXT(
+             "loadDatasetsFromDirectory(FString directory) - No files found in %s!"),
+           *directory);
+    return false;
+  }
+  filenames.Sort();
+
+  // Each file is parsed on one thread, so the files are loaded in parallel
+  const uint32 numFiles = filenames.Num();
+  Vector<TimeSeriesClassificationData> datasets(numFiles);
+  Vector<uint8> loaded(numFiles, 0);
+
+  ThreadPool::getInstance().parallelFor(numFiles, [&](uint32 i) {
+    loaded[i] = datasets[i].parseDatasetFromFile(
+      FPaths::Combine(directory, filenames[i]), false) ? 1 : 0;
+  });
+
+  for (uint32 i = 0; i < numFiles; i++) {
+    if (!loaded[i]) {
+      UE_LOG(GRTModule, Error,
+             TEXT(
+               "loadDatasetsFromDirectory(FString directory) - Failed to load %s!"),
+             *filenames[i]);
+      return false;
+    }
+  }
+
+  *this = datasets[0];
+
+  for (uint32 i = 1; i < numFiles; i++) {
+    if (!merge(datasets[i])) return false;
+  }
+
+  return true;
+}
+
+bool TimeSeriesClassificationData::saveDatasetToBinaryFile(
+  const FString filename) const {
+  return MappedTimeSeriesClassificationData::write(*this, filename);
+}
+
+bool TimeSeriesClassificationData::loadDatasetFromBinaryFile(
+  const FString filename) {
+  clear();
+
+  MappedTimeSeriesClassificationData file;
+
+  if (!file.open(filename)) {
+    UE_LOG(GRTModule, Error,
+           TEXT(
+             "loadDatasetFromBinaryFile(FString filename) - Failed to open file!"));
+    return false;
+  }
+
+  datasetName           = file.getDatasetName();
+  infoText              = file.getInfoText();
+  numDimensions         = file.getNumDimensions();
+  totalNumSamples       = file.getNumSamples();
+  useExternalRanges     = file.getUseExternalRanges();
+  allowNullGestureClass = file.getAllowNullGestureClass();
+  externalRanges        = file.getExternalRanges();
+  classTracker          = file.getClassTracker();
+  crossValidationSetup  = false;
+  crossValidationIndexs.clear();
+
+  // The samples are copied straight from the mapped file, one block each
+  data.resize(totalNumSamples, TimeSeriesClassificationSample());
+
+  for (uint32 x = 0; x < totalNumSamples; x++) {
+    data[x].setTrainingSample(file.getClassLabel(x), MatrixFloat());
+    file.getSample(x).copyTo(data[x].getData());
+  }
+
+  updateClassIndexs();
+  return true;
+}
+
+bool TimeSeriesClassificationData::saveDatasetToCompressedFile(
+  const FString filename,
+  const bool    useDeltaEncoding,
+  const bool    useQuantization) const {
+  return CompressedTimeSeriesClassificationData::write(*this, filename,
+                                                       useDeltaEncoding,
+                                                       useQuantization);
+}
+
+bool TimeSeriesClassificationData::loadDatasetFromCompressedFile(
+  const FString filename,
+  const bool    useMultipleThreads) {
+  clear();
+
+  CompressedTimeSeriesClassificationData file;
+
+  if (!file.open(filename)) {
+    UE_LOG(GRTModule, Error,
+           TEXT(
+             "loadDatasetFromCompressedFile(FString filename) - Failed to open file!"));
+    return false;
+  }
+
+  datasetName           = file.getDatasetName();
+  infoText              = file.getInfoText();
+  numDimensions         = file.getNumDimensions();
+  totalNumSamples       = file.getNumSamples();
+  useExternalRanges     = file.getUseExternalRanges();
+  allowNullGestureClass = file.getAllowNullGestureClass();
+  externalRanges        = file.getExternalRanges();
+  classTracker          = file.getClassTracker();
+  crossValidationSetup  = false;
+  crossValidationIndexs.clear();
+
+  // Decode the samples in parallel, each one straight into its sample
+  data.resize(totalNumSamples, TimeSeriesClassificationSample());
+  Vector<uint8> decoded(totalNumSamples, 0);
+
+  ThreadPool::getInstance().parallelFor(totalNumSamples, [&](uint32 x) {
+    data[x].setTrainingSample(file.getClassLabel(x), MatrixFloat());
+    decoded[x] = file.getSample(x, data[x].getData()) ? 1 : 0;
+  }, 0, useMultipleThreads);
+
+  for (uint32 x = 0; x < totalNumSamples; x++) {
+    if (!decoded[x]) {
+      clear();
+      return false;
+    }
+  }
+
+  updateClassIndexs();
   return true;
 }
 
@@ -654,7 +1004,39 @@ TimeSeriesClassificationData TimeSeriesClassificationData::split(
   TimeSeriesClassificationData testSet(numDimensions);
   trainingSet.setAllowNullGestureClass(allowNullGestureClass);
   testSet.setAllowNullGestureClass(allowNullGestureClass);
-  Vector<uint32> indexs(totalNumSamples);
+  Vector<uint32> trainingIndexs;
+  Vector<uint32> testIndexs;
+
+  getSplitIndexs(trainingSizePercentage, useStratifiedSampling,
+                 trainingIndexs, testIndexs);
+
+  // Add the data to the training and test sets
+  for (uint32 i = 0; i < trainingIndexs.size(); i++) {
+    trainingSet.addSample(data[trainingIndexs[i]].getClassLabel(),
+                          data[trainingIndexs[i]].getData());
+  }
+
+  for (uint32 i = 0; i < testIndexs.size(); i++) {
+    testSet.addSample(data[testIndexs[i]].getClassLabel(),
+                      data[testIndexs[i]].getData());
+  }
+
+  // Overwrite the training data in this instance with the training data of
+  // the trainingSet
+  data            = trainingSet.getClassificationData();
+  totalNumSamples = trainingSet.getNumSamples();
+  updateClassIndexs();
+
+  return testSet;
+}
+
+void TimeSeriesClassificationData::getSplitIndexs(
+  const uint32    trainingSizePercentage,
+  const bool      useStratifiedSampling,
+  Vector<uint32>& trainingIndexs,
+  Vector<uint32>& testIndexs) const {
+  trainingIndexs.clear();
+  testIndexs.clear();
 
   // Create the random partion indexs
   Random random;
@@ -662,12 +1044,7 @@ TimeSeriesClassificationData TimeSeriesClassificationData::split(
 
   if (useStratifiedSampling) {
     // Break the data into seperate classes
-    Vector<Vector<uint32> > classData(getNumClasses());
-
-    // Add the indexs to their respective classes
-    for (uint32 i = 0; i < totalNumSamples; i++) {
-      classData[getClassLabelIndexValue(data[i].getClassLabel())].push_back(i);
-    }
+    Vector<Vector<uint32> > classData = classSampleIndexs;
 
     // Randomize the order of the indexs in each of the class index buffers
     for (uint32 k = 0; k < getNumClasses(); k++) {
@@ -682,33 +1059,26 @@ TimeSeriesClassificationData TimeSeriesClassificationData::split(
       }
     }
 
-    // Loop over each class and add the data to the trainingSet and testSet
+    // Loop over each class and add the indexs to the training and test sets
     for (uint32 k = 0; k < getNumClasses(); k++) {
       uint32 numTrainingExamples = (uint32)floor(float(
                                                    classData[k].size()) / 100.0 *
                                                  float(trainingSizePercentage));
 
-      // Add the data to the training and test sets
       for (uint32 i = 0; i < numTrainingExamples; i++) {
-        trainingSet.addSample(data[classData[k][i]].getClassLabel(),
-                              data[classData[k][i]].getData());
+        trainingIndexs.push_back(classData[k][i]);
       }
 
       for (uint32 i = numTrainingExamples; i < classData[k].size(); i++) {
-        testSet.addSample(data[classData[k][i]].getClassLabel(),
-                          data[classData[k][i]].getData());
+        testIndexs.push_back(classData[k][i]);
       }
     }
-
-    // Overwrite the training data in this instance with the training data of
-    // the trainingSet
-    data            = trainingSet.getClassificationData();
-    totalNumSamples = trainingSet.getNumSamples();
   }
   else {
     const uint32 numTrainingExamples = (uint32)floor(float(
                                                        totalNumSamples) / 100.0 *
                                                      float(trainingSizePercentage));
+    Vector<uint32> indexs(totalNumSamples);
 
     for (uint32 i = 0; i < totalNumSamples; i++) indexs[i] = i;
 
@@ -720,24 +1090,9 @@ TimeSeriesClassificationData TimeSeriesClassificationData::split(
       SWAP(indexs[x], indexs[randomIndex]);
     }
 
-    // Add the data to the training and test sets
-    for (uint32 i = 0; i < numTrainingExamples; i++) {
-      trainingSet.addSample(
-        data[indexs[i]].getClassLabel(), data[indexs[i]].getData());
-    }
-
-    for (uint32 i = numTrainingExamples; i < totalNumSamples; i++) {
-      testSet.addSample(data[indexs[i]].getClassLabel(),
-                        data[indexs[i]].getData());
-    }
-
-    // Overwrite the training data in this instance with the training data of
-    // the trainingSet
-    data            = trainingSet.getClassificationData();
-    totalNumSamples = trainingSet.getNumSamples();
+    trainingIndexs.assign(indexs.begin(), indexs.begin() + numTrainingExamples);
+    testIndexs.assign(indexs.begin() + numTrainingExamples, indexs.end());
   }
-
-  return testSet;
 }
 
 bool TimeSeriesClassificationData::merge(
@@ -822,12 +1177,7 @@ bool TimeSeriesClassificationData::spiltDataIntoKFolds(const uint32 K,
 
   if (useStratifiedSampling) {
     // Break the data into seperate classes
-    Vector<Vector<uint32> > classData(getNumClasses());
-
-    // Add the indexs to their respective classes
-    for (uint32 i = 0; i < totalNumSamples; i++) {
-      classData[getClassLabelIndexValue(data[i].getClassLabel())].push_back(i);
-    }
+    Vector<Vector<uint32> > classData = classSampleIndexs;
 
     // Randomize the order of the indexs in each of the class index buffers
     for (uint32 c = 0; c < getNumClasses(); c++) {
@@ -945,15 +1295,99 @@ TimeSeriesClassificationData TimeSeriesClassificationData::getTestFoldData(
 TimeSeriesClassificationData TimeSeriesClassificationData::getClassData(
   const uint32 classLabel) const {
   TimeSeriesClassificationData classData(numDimensions);
+  const auto iter = classIndexMap.find(classLabel);
 
-  for (uint32 x = 0; x < totalNumSamples; x++) {
-    if (data[x].getClassLabel() == classLabel) {
-      classData.addSample(classLabel, data[x].getData());
-    }
+  if (iter == classIndexMap.end()) return classData;
+
+  const Vector<uint32>& classIndexs = classSampleIndexs[iter->second];
+
+  for (uint32 i = 0; i < classIndexs.size(); i++) {
+    classData.addSample(classLabel, data[classIndexs[i]].getData());
   }
   return classData;
 }
 
+TimeSeriesClassificationDataView TimeSeriesClassificationData::getSubsetView(
+  const Vector<uint32>& sampleIndices) const {
+  return TimeSeriesClassificationDataView(data.empty() ? NULL : &data[0],
+                                          numDimensions, classTracker,
+                                          sampleIndices);
+}
+
+TimeSeriesClassificationDataView TimeSeriesClassificationData::getView() const {
+  Vector<uint32> indexs(totalNumSamples);
+
+  for (uint32 i = 0; i < totalNumSamples; i++) indexs[i] = i;
+
+  return getSubsetView(indexs);
+}
+
+TimeSeriesClassificationDataView TimeSeriesClassificationData::getClassDataView(
+  const uint32 classLabel) const {
+  const auto iter = classIndexMap.find(classLabel);
+
+  if (iter == classIndexMap.end()) return getSubsetView(Vector<uint32>());
+
+  return getSubsetView(classSampleIndexs[iter->second]);
+}
+
+bool TimeSeriesClassificationData::splitViews(
+  const uint32                      partitionPercentage,
+  TimeSeriesClassificationDataView& trainingView,
+  TimeSeriesClassificationDataView& testView,
+  const bool                        useStratifiedSampling) const {
+  if (partitionPercentage > 100) {
+    UE_LOG(GRTModule, Error,
+           TEXT(
+             "splitViews(uint32 partitionPercentage,...) - The partition percentage can not be larger than 100!"));
+    return false;
+  }
+
+  Vector<uint32> trainingIndexs;
+  Vector<uint32> testIndexs;
+
+  getSplitIndexs(partitionPercentage, useStratifiedSampling, trainingIndexs,
+                 testIndexs);
+
+  trainingView = getSubsetView(trainingIndexs);
+  testView     = getSubsetView(testIndexs);
+  return true;
+}
+
+TimeSeriesClassificationDataView TimeSeriesClassificationData::getTrainingFoldView(
+  const uint32 foldIndex) const {
+  if (!crossValidationSetup) {
+    UE_LOG(GRTModule, Error,
+           TEXT(
+             "getTrainingFoldView(uint32 foldIndex) - Cross Validation has not been setup! You need to call the spiltDataIntoKFolds(uint32 K,bool useStratifiedSampling) function first before calling this function!"));
+    return TimeSeriesClassificationDataView();
+  }
+
+  if (foldIndex >= kFoldValue) return TimeSeriesClassificationDataView();
+
+  // The training set is all the data that is NOT in the foldIndex
+  Vector<uint32> indexs;
+  indexs.reserve(totalNumSamples);
+
+  for (uint32 k = 0; k < kFoldValue; k++) {
+    if (k != foldIndex) {
+      indexs.insert(indexs.end(), crossValidationIndexs[k].begin(),
+                    crossValidationIndexs[k].end());
+    }
+  }
+
+  return getSubsetView(indexs);
+}
+
+TimeSeriesClassificationDataView TimeSeriesClassificationData::getTestFoldView(
+  const uint32 foldIndex) const {
+  if (!crossValidationSetup) return TimeSeriesClassificationDataView();
+
+  if (foldIndex >= kFoldValue) return TimeSeriesClassificationDataView();
+
+  return getSubsetView(crossValidationIndexs[foldIndex]);
+}
+
 uint32 TimeSeriesClassificationData::getMinimumClassLabel() const {
   uint32 minClassLabel = 99999;
 
@@ -981,11 +1415,10 @@ uint32 TimeSeriesClassificationData::getMaximumClassLabel() const {
 uint32 TimeSeriesClassificationData::getClassLabelIndexValue(
   const uint32 classLabel)
 const {
-  for (uint32 k = 0; k < classTracker.size(); k++) {
-    if (classTracker[k].classLabel == classLabel) {
-      return k;
-    }
-  }
+  const auto iter = classIndexMap.find(classLabel);
+
+  if (iter != classIndexMap.end()) return iter->second;
+
   UE_LOG(GRTModule, Warning,
          TEXT(
            "getClassLabelIndexValue(uint32 classLabel) - Failed to find class label: %d in class tracker!"),
@@ -995,43 +1428,132 @@ const {
 
 FString TimeSeriesClassificationData::getClassNameForCorrespondingClassLabel(
   const uint32 classLabel) const {
-  for (uint32 i = 0; i < classTracker.size(); i++) {
-    if (classTracker[i].classLabel == classLabel) {
-      return classTracker[i].className;
-    }
-  }
+  const auto iter = classIndexMap.find(classLabel);
+
+  if (iter != classIndexMap.end()) return classTracker[iter->second].className;
+
   return "CLASS_LABEL_NOT_FOUND";
 }
 
 Vector<MinMax>TimeSeriesClassificationData::getRanges() const {
   if (useExternalRanges) return externalRanges;
 
-  Vector<MinMax> ranges(numDimensions);
+  return getStats().ranges;
+}
+
+uint64 TimeSeriesClassificationData::getHash() const {
+  uint64 hash = Util::hash(&numDimensions, sizeof(numDimensions));
+
+  hash = Util::hash(&totalNumSamples, sizeof(totalNumSamples), hash);
+
+  for (uint32 i = 0; i < totalNumSamples; i++) {
+    const MatrixFloat& sample = data[i].getData();
+    const uint32 classLabel   = data[i].getClassLabel();
+    const uint32 length       = sample.getNumRows();
+
+    hash = Util::hash(&classLabel, sizeof(classLabel), hash);
+    hash = Util::hash(&length, sizeof(length), hash);
+
+    if (length > 0) {
+      hash = Util::hash(sample.getData(),
+                        sizeof(float) * length * sample.getNumCols(), hash);
+    }
+  }
+
+  if (useExternalRanges) {
+    for (uint32 j = 0; j < externalRanges.size(); j++) {
+      hash = Util::hash(&externalRanges[j].minValue, sizeof(float), hash);
+      hash = Util::hash(&externalRanges[j].maxValue, sizeof(float), hash);
+    }
+  }
+  return hash;
+}
+
+const DatasetStats& TimeSeriesClassificationData::getStats() const {
+  std::lock_guard<std::mutex> lock(statsMutex);
+
+  if (statsOutOfDate) recomputeStats();
+
+  // The mean and variance are kept as running sums, so they are only
+  // converted when the statistics are read after they have changed
+  if (statsMomentsOutOfDate) {
+    stats.ranges.resize(numDimensions);
+    stats.mean.resize(numDimensions);
+    stats.variance.resize(numDimensions);
+
+    const bool hasRows = rowStatistics.getNumDimensions() == numDimensions;
 
-  if (totalNumSamples > 0) {
     for (uint32 j = 0; j < numDimensions; j++) {
-      ranges[j].minValue = data[0][0][0];
-      ranges[j].maxValue = data[0][0][0];
-
-      for (uint32 x = 0; x < totalNumSamples; x++) {
-        for (uint32 i = 0; i < data[x].getLength(); i++) {
-          if (data[x][i][j] <
-              ranges[j].minValue)  ranges[j].minValue = data[x][i][j];      // Search
-                                                                            // for
-                                                                            // the
-                                                                            // min
-                                                                            // value
-          else if (data[x][i][j] >
-                   ranges[j].maxValue)  ranges[j].maxValue = data[x][i][j]; // Search
-                                                                            // for
-                                                                            // the
-                                                                            // max
-                                                                            // value
-        }
-      }
+      stats.mean[j]     = hasRows ? (float)rowStatistics.getMean(j) : 0;
+      stats.variance[j] = hasRows ? (float)rowStatistics.getVariance(j) : 0;
     }
+    statsMomentsOutOfDate = false;
   }
-  return ranges;
+
+  return stats;
+}
+
+void TimeSeriesClassificationData::invalidateStats() {
+  statsOutOfDate = true;
+}
+
+void TimeSeriesClassificationData::addSampleToStats(
+  const MatrixFloat& sample) const {
+  const uint32 length = sample.getNumRows();
+
+  stats.numSamples++;
+  statsMomentsOutOfDate = true;
+
+  if (stats.lengthHistogram.size() <= length) {
+    stats.lengthHistogram.resize(length + 1, 0);
+  }
+  stats.lengthHistogram[length]++;
+
+  if ((stats.numSamples == 1) || (length < stats.minLength)) {
+    stats.minLength = length;
+  }
+
+  if (length > stats.maxLength) stats.maxLength = length;
+
+  if ((length == 0) || (sample.getNumCols() != numDimensions)) return;
+
+  if (stats.numRows == 0) {
+    // The first rows set the ranges, and the shift of the running statistics
+    // so the sums stay well conditioned
+    stats.ranges.resize(numDimensions);
+
+    for (uint32 j = 0; j < numDimensions; j++) {
+      stats.ranges[j] = MinMax(sample[0][j], sample[0][j]);
+    }
+
+    rowStatistics.resize(numDimensions);
+    rowStatistics.recompute(sample);
+  }
+  else {
+    for (uint32 i = 0; i < length; i++) rowStatistics.push(sample[i]);
+  }
+
+  for (uint32 i = 0; i < length; i++) {
+    const float *row = sample[i];
+
+    for (uint32 j = 0; j < numDimensions; j++) {
+      stats.ranges[j].updateMinMax(row[j]);
+    }
+  }
+
+  stats.numRows += length;
+}
+
+void TimeSeriesClassificationData::recomputeStats() const {
+  stats = DatasetStats();
+  rowStatistics.clear();
+  statsMomentsOutOfDate = true;
+
+  for (uint32 x = 0; x < totalNumSamples; x++) {
+    addSampleToStats(data[x].getData());
+  }
+
+  statsOutOfDate = false;
 }
 
 MatrixFloat TimeSeriesClassificationData::getDataAsMatrixFloat() const {
@@ -1058,4 +1580,59 @@ MatrixFloat TimeSeriesClassificationData::getDataAsMatrixFloat() const {
   }
   return matrixData;
 }
+void TimeSeriesClassificationData::updateClassIndexs() {
+  const Vector<ClassTracker> oldClassTracker = classTracker;
+
+  statsOutOfDate = true;
+
+  classTracker.clear();
+  classIndexMap.clear();
+  classSampleIndexs.clear();
+
+  // Keep the order and names of the existing classes, dropping any class that
+  // no longer has any samples
+  for (uint32 k = 0; k < oldClassTracker.size(); k++) {
+    if (classIndexMap.count(oldClassTracker[k].classLabel) > 0) continue;
+
+    classIndexMap[oldClassTracker[k].classLabel] = (uint32)classTracker.size();
+    classTracker.push_back(ClassTracker(oldClassTracker[k].classLabel, 0,
+                                        oldClassTracker[k].className));
+  }
+  classSampleIndexs.resize(classTracker.size());
+
+  for (uint32 i = 0; i < totalNumSamples; i++) {
+    const uint32 classLabel = data[i].getClassLabel();
+    const auto   iter       = classIndexMap.find(classLabel);
+    uint32 k                = 0;
+
+    if (iter != classIndexMap.end()) k = iter->second;
+    else {
+      k                         = (uint32)classTracker.size();
+      classIndexMap[classLabel] = k;
+      classTracker.push_back(ClassTracker(classLabel, 0));
+      classSampleIndexs.push_back(Vector<uint32>());
+    }
+    classTracker[k].counter++;
+    classSampleIndexs[k].push_back(i);
+  }
+
+  // Remove the classes with no samples
+  uint32 numClasses = 0;
+
+  for (uint32 k = 0; k < classTracker.size(); k++) {
+    if (classTracker[k].counter == 0) {
+      classIndexMap.erase(classTracker[k].classLabel);
+      continue;
+    }
+
+    if (numClasses != k) {
+      classTracker[numClasses] = classTracker[k];
+      classSampleIndexs[numClasses].swap(classSampleIndexs[k]);
+      classIndexMap[classTracker[k].classLabel] = numClasses;
+    }
+    numClasses++;
+  }
+  classTracker.resize(numClasses);
+  classSampleIndexs.resize(numClasses);
+}
 }
@@ -4,9 +4,14 @@
 #include "MatrixFloat.h"
 #include "../Utility/Util.h"
 #include "../Utility/ClassTracker.h"
+#include "../Utility/DatasetStats.h"
+#include "../Utility/RunningStatistics.h"
 #include "TimeSeriesClassificationSample.h"
+#include "TimeSeriesClassificationDataView.h"
 #include <fstream>
+#include <mutex>
 #include <string>
+#include <unordered_map>
 
 namespace GRT {
 class GRT_API TimeSeriesClassificationData {
@@ -58,6 +63,9 @@ public:
      It is up to the user to ensure that i is within the range of [0
         totalNumSamples-1]
 
+     The statistics are not updated if the sample is changed through the
+        reference, call invalidateStats after changing it.
+
      @param i: the index of the training sample you want to access.  Must be
         within the range of [0 totalNumSamples-1]
      @return a reference to the i'th TimeSeriesClassificationSample
@@ -262,7 +270,9 @@ public:
      Load the data from a file.
      If the file format ends in '.csv' then the function will try and load the
         data from a csv format.  If this fails then it will
-     try and load the data as a custom GRT file.
+     try and load the data as a custom GRT file.  Binary files written by
+        saveDatasetToBinaryFile and archives written by
+        saveDatasetToCompressedFile are detected from their header.
 
      @param filename: the name of the file the data will be loaded from
      @return true if the data was loaded successfully, false otherwise
@@ -286,6 +296,80 @@ public:
    */
   bool                         loadDatasetFromFile(const FString filename);
 
+  /**
+     Loads the labelled timeseries classification data from a custom file
+        format, giving exactly the same result as loadDatasetFromFile.
+
+     The whole file is read at once and parsed in place, and the time series
+        are parsed in parallel, which is much faster than loadDatasetFromFile
+        for large files.
+
+     @param filename: the name of the file the data will be loaded from
+     @param useMultipleThreads: if true the time series are parsed in parallel
+     @return true if the data was loaded successfully, false otherwise
+   */
+  bool parseDatasetFromFile(const FString filename,
+                            const bool    useMultipleThreads = true);
+
+  /**
+     Loads all the dataset files with the given extension in a directory and
+        merges them into this dataset.  The files are loaded in parallel and
+        merged in the order of their names, the dataset name and info text are
+        taken from the first file.
+
+     @param directory: the directory containing the files
+     @param extension: the extension of the files to load, such as "grt"
+     @return true if all the files were loaded and merged, false otherwise
+   */
+  bool loadDatasetsFromDirectory(const FString directory,
+                                 const FString extension = "grt");
+
+  /**
+     Saves the labelled timeseries classification data to the binary file
+        format, see MappedTimeSeriesClassificationData.  Binary files are much
+        faster to load than the text format and can also be used in place
+        with MappedTimeSeriesClassificationData.
+
+     @param filename: the name of the file the data will be saved to
+     @return true if the data was saved successfully, false otherwise
+   */
+  bool saveDatasetToBinaryFile(const FString filename) const;
+
+  /**
+     Loads the labelled timeseries classification data from a file saved with
+        saveDatasetToBinaryFile.
+
+     @param filename: the name of the file the data will be loaded from
+     @return true if the data was loaded successfully, false otherwise
+   */
+  bool loadDatasetFromBinaryFile(const FString filename);
+
+  /**
+     Saves the labelled timeseries classification data to a compressed
+        archive, see CompressedTimeSeriesClassificationData.
+
+     @param filename: the name of the file the data will be saved to
+     @param useDeltaEncoding: if true each row is stored as the difference
+        from the previous row, which compresses smooth signals much better
+     @param useQuantization: if true the values are quantized to 16 bits using
+        the ranges from getRanges, which makes the archive lossy
+     @return true if the data was saved successfully, false otherwise
+   */
+  bool saveDatasetToCompressedFile(const FString filename,
+                                   const bool    useDeltaEncoding = true,
+                                   const bool    useQuantization = false) const;
+
+  /**
+     Loads the labelled timeseries classification data from an archive saved
+        with saveDatasetToCompressedFile.
+
+     @param filename: the name of the file the data will be loaded from
+     @param useMultipleThreads: if true the samples are decoded in parallel
+     @return true if the data was loaded successfully, false otherwise
+   */
+  bool loadDatasetFromCompressedFile(const FString filename,
+                                     const bool    useMultipleThreads = true);
+
   /**
      Gets the dataset info (such as its name and infoText) and the stats (such
         as the number of examples, number of dimensions, number of classes,
@@ -384,6 +468,80 @@ public:
    */
   TimeSeriesClassificationData getClassData(const uint32 classLabel) const;
 
+  /**
+     Gets a view of the samples at the given indices.  The view only stores
+        the indices, see TimeSeriesClassificationDataView.
+
+     @param sampleIndices: the indices of the samples, each in the range [0
+        numSamples-1]
+     @return returns a view of the samples
+   */
+  TimeSeriesClassificationDataView getSubsetView(
+    const Vector<uint32>& sampleIndices) const;
+
+  /**
+     Gets a view of all the samples of this dataset.
+
+     @return returns a view of the dataset
+   */
+  TimeSeriesClassificationDataView getView() const;
+
+  /**
+     Gets a view of all the data with the class label set by classLabel, this
+        is the same as getClassData without copying the samples.
+
+     @param classLabel: the class label of the class you want the data for
+     @return returns a view of the samples with the matching classLabel
+   */
+  TimeSeriesClassificationDataView getClassDataView(
+    const uint32 classLabel) const;
+
+  /**
+     Randomly splits the dataset into a training view and a test view, in the
+        same way as split, without copying the samples or changing this
+        dataset.
+
+     @param partitionPercentage: sets the percentage of data which goes into
+        the training view, the remaining data goes into the test view
+     @param trainingView: returns the training view
+     @param testView: returns the test view
+     @param useStratifiedSampling: sets if the dataset should be broken into
+        homogeneous groups first before randomly being spilt, default value is
+        false
+     @return returns true if the dataset was split
+   */
+  bool splitViews(const uint32                      partitionPercentage,
+                  TimeSeriesClassificationDataView& trainingView,
+                  TimeSeriesClassificationDataView& testView,
+                  const bool                        useStratifiedSampling =
+                    false) const;
+
+  /**
+     Returns a view of the training data for the k-th fold, this is the same
+        as getTrainingFoldData without copying the samples.  The
+        spiltDataIntoKFolds function should have been called once before
+        using this function.
+
+     @param foldIndex: the index of the fold you want the training data for,
+        this should be in the range [0 K-1]
+     @return returns a view of the training data, which is empty if the fold
+        is not valid
+   */
+  TimeSeriesClassificationDataView getTrainingFoldView(
+    const uint32 foldIndex) const;
+
+  /**
+     Returns a view of the test data for the k-th fold, this is the same as
+        getTestFoldData without copying the samples.  The spiltDataIntoKFolds
+        function should have been called once before using this function.
+
+     @param foldIndex: the index of the fold you want the test data for, this
+        should be in the range [0 K-1]
+     @return returns a view of the test data, which is empty if the fold is
+        not valid
+   */
+  TimeSeriesClassificationDataView getTestFoldView(const uint32 foldIndex) const;
+
   /**
      Gets the name of the dataset.
 
@@ -468,13 +626,43 @@ public:
     const uint32 classLabel) const;
 
   /**
-     Gets the ranges of the classification data.
+     Gets the ranges of the classification data.  This is taken from getStats,
+        unless the external ranges are used.
 
      @return a vector of minimum and maximum values for each dimension of the
         data
    */
   Vector<MinMax>      getRanges() const;
 
+  /**
+     Gets the statistics of the dataset: the range, mean and variance of each
+        dimension and the histogram of the sample lengths.  The statistics are
+        updated as samples are added, so this is O(numDimensions).  Removing
+        samples makes the next call recompute them from all the data.  This
+        can be called from several threads at once while the dataset is not
+        being changed, the statistics are only recomputed once.
+
+     @return returns the statistics of the dataset
+   */
+  const DatasetStats& getStats() const;
+
+  /**
+     Flags the statistics to be recomputed by the next getStats call.  This
+        must be called after changing samples through the non-const
+        subscript operator.
+   */
+  void invalidateStats();
+
+  /**
+     Gets a 64 bit FNV-1a hash of the samples, their class labels and the
+        external ranges (if they are used).  Two datasets with the same hash
+        can be assumed to hold the same data, which is used to key caches of
+        values computed from a dataset.
+
+     @return returns the hash of the dataset
+   */
+  uint64              getHash() const;
+
   /**
      Gets the class tracker for each class in the dataset.
 
@@ -484,6 +672,33 @@ public:
     return classTracker;
   }
 
+  /**
+     Gets the ranges set by setExternalRanges.
+
+     @return a vector of minimum and maximum values for each dimension
+   */
+  const Vector<MinMax>& getExternalRanges() const {
+    return externalRanges;
+  }
+
+  /**
+     Gets if the dataset should be scaled using the external ranges.
+
+     @return returns true if the external ranges are used
+   */
+  bool getUseExternalRanges() const {
+    return useExternalRanges;
+  }
+
+  /**
+     Gets if samples can be added with the null gesture class label.
+
+     @return returns true if the null gesture class is allowed
+   */
+  bool getAllowNullGestureClass() const {
+    return allowNullGestureClass;
+  }
+
   /**
      Gets the classification data.
 
@@ -504,6 +719,24 @@ public:
 
 protected:
 
+  // Randomly partitions the sample indexs into a training and a test set
+  void getSplitIndexs(const uint32    trainingSizePercentage,
+                      const bool      useStratifiedSampling,
+                      Vector<uint32>& trainingIndexs,
+                      Vector<uint32>& testIndexs) const;
+
+  // Recounts the samples of each class and rebuilds classIndexMap and
+  // classSampleIndexs, this must be called whenever data is changed other
+  // than by addSample or removeLastSample.  It also flags the statistics to
+  // be recomputed
+  void updateClassIndexs();
+
+  // Adds a sample to the dataset statistics
+  void addSampleToStats(const MatrixFloat& sample) const;
+
+  // Recomputes the dataset statistics from all the samples
+  void recomputeStats() const;
+
   FString datasetName;                           ///< The name of the dataset
   FString infoText;                              ///< Some infoText about the
                                                  // dataset
@@ -533,10 +766,27 @@ protected:
                                                  // which keeps track of the
                                                  // number of samples of each
                                                  // class
+  std::unordered_map<uint32, uint32> classIndexMap; ///< Maps each class label
+                                                    // to its index in
+                                                    // classTracker
+  Vector<Vector<uint32> > classSampleIndexs;     ///< The indexs of the samples
+                                                 // of each class, in the same
+                                                 // order as classTracker
   Vector<TimeSeriesClassificationSample> data;   ///< The labelled time series
                                                  // classification data
   Vector<Vector<uint32> > crossValidationIndexs; ///< A vector to hold the
                                                  // indexs of the dataset for
                                                  // the cross validation
+  mutable DatasetStats stats;                    ///< The dataset statistics
+  mutable RunningStatistics rowStatistics;       ///< The mean and variance of
+                                                 // all the rows
+  mutable bool statsOutOfDate;                   ///< A flag to show that stats
+                                                 // must be recomputed
+  mutable bool statsMomentsOutOfDate;            ///< A flag to show that the
+                                                 // mean and variance of stats
+                                                 // must be read from
+                                                 // rowStatistics
+  mutable std::mutex statsMutex;                 ///< Guards the updates made
+                                                 // by getStats
 };
 }
@@ -0,0 +1,91 @@
+﻿#include "../GRT.h"
+#include "TimeSeriesClassificationDataView.h"
+#include "TimeSeriesClassificationData.h"
+#include <unordered_map>
+
+namespace GRT {
+TimeSeriesClassificationDataView::TimeSeriesClassificationDataView() {
+  samples       = NULL;
+  numDimensions = 0;
+}
+
+TimeSeriesClassificationDataView::TimeSeriesClassificationDataView(
+  const TimeSeriesClassificationSample *samples,
+  const uint32                          numDimensions,
+  const Vector<ClassTracker>          & classNames,
+  const Vector<uint32>                & sampleIndices) {
+  this->samples       = samples;
+  this->numDimensions = numDimensions;
+  this->indices       = sampleIndices;
+
+  // Count the samples of each class, keeping the class names of the dataset.
+  // The index of each class in classTracker is looked up by its label, so
+  // counting is O(numSamples) whatever the number of classes
+  std::unordered_map<uint32, uint32> classIndexMap;
+
+  for (uint32 i = 0; i < indices.size(); i++) {
+    const uint32 classLabel = samples[indices[i]].getClassLabel();
+    const auto   iter       = classIndexMap.find(classLabel);
+
+    if (iter != classIndexMap.end()) {
+      classTracker[iter->second].counter++;
+      continue;
+    }
+
+    classIndexMap[classLabel] = (uint32)classTracker.size();
+    classTracker.push_back(ClassTracker(classLabel, 1));
+
+    for (uint32 k = 0; k < classNames.size(); k++) {
+      if (classNames[k].classLabel == classLabel) {
+        classTracker.back().className = classNames[k].className;
+        break;
+      }
+    }
+  }
+}
+
+TimeSeriesClassificationDataView::~TimeSeriesClassificationDataView() {}
+
+TimeSeriesClassificationDataView TimeSeriesClassificationDataView::getSubset(
+  const Vector<uint32>& sampleIndices) const {
+  Vector<uint32> subsetIndices(sampleIndices.size());
+
+  for (uint32 i = 0; i < sampleIndices.size(); i++) {
+    subsetIndices[i] = indices[sampleIndices[i]];
+  }
+
+  return TimeSeriesClassificationDataView(samples, numDimensions,
+                                          classTracker, subsetIndices);
+}
+
+TimeSeriesClassificationDataView TimeSeriesClassificationDataView::getClassData(
+  const uint32 classLabel) const {
+  Vector<uint32> classIndices;
+
+  for (uint32 i = 0; i < indices.size(); i++) {
+    if (samples[indices[i]].getClassLabel() == classLabel) {
+      classIndices.push_back(indices[i]);
+    }
+  }
+
+  return TimeSeriesClassificationDataView(samples, numDimensions,
+                                          classTracker, classIndices);
+}
+
+bool TimeSeriesClassificationDataView::copyTo(
+  TimeSeriesClassificationData& data) const {
+  if (!data.setNumDimensions(numDimensions)) return false;
+
+  for (uint32 i = 0; i < indices.size(); i++) {
+    const TimeSeriesClassificationSample& sample = samples[indices[i]];
+
+    if (!data.addSample(sample.getClassLabel(), sample.getData())) return false;
+  }
+
+  for (uint32 k = 0; k < classTracker.size(); k++) {
+    data.setClassNameForCorrespondingClassLabel(classTracker[k].className,
+                                                classTracker[k].classLabel);
+  }
+  return true;
+}
+}
@@ -0,0 +1,120 @@
+﻿#pragma once
+
+#include "../GRT.h"
+#include "TimeSeriesClassificationSample.h"
+#include "../Utility/ClassTracker.h"
+
+namespace GRT {
+class TimeSeriesClassificationData;
+
+/**
+   @brief The TimeSeriesClassificationDataView class is a read only subset of
+      the samples of a TimeSeriesClassificationData.
+
+   A view only stores the indices of its samples, so class, split and k-fold
+      views (see TimeSeriesClassificationData::getClassDataView,
+      splitViews, getTrainingFoldView and getTestFoldView) do not copy any
+      sample data.  A view points into the samples of the dataset it was
+      made from, so that dataset must not be changed or destroyed while the
+      view is used.
+ */
+class GRT_API TimeSeriesClassificationDataView {
+public:
+
+  /**
+     Default Constructor, makes an empty view.
+   */
+  TimeSeriesClassificationDataView();
+
+  /**
+     Constructor, makes a view of some of the samples of a dataset.
+
+     @param samples: the samples of the dataset
+     @param numDimensions: the number of dimensions of the dataset
+     @param classNames: the class tracker of the dataset, used for the class
+        names of the view
+     @param sampleIndices: the indices of the samples in the view
+   */
+  TimeSeriesClassificationDataView(
+    const TimeSeriesClassificationSample *samples,
+    const uint32                          numDimensions,
+    const Vector<ClassTracker>          & classNames,
+    const Vector<uint32>                & sampleIndices);
+
+  /**
+     Default Destructor
+   */
+  ~TimeSeriesClassificationDataView();
+
+  /**
+     Gets the sample at index i of the view.
+
+     @param i: the index of the sample, should be in the range [0
+        numSamples-1]
+     @return returns a reference to the sample in the dataset
+   */
+  inline const TimeSeriesClassificationSample& operator[](const uint32 i) const {
+    return samples[indices[i]];
+  }
+
+  /**
+     Gets a view with some of the samples of this view.  Only the indices are
+        copied.
+
+     @param sampleIndices: the indices of the samples, each in the range [0
+        numSamples-1]
+     @return returns the subset
+   */
+  TimeSeriesClassificationDataView getSubset(
+    const Vector<uint32>& sampleIndices) const;
+
+  /**
+     Gets a view with all the samples of one class.  Only the indices are
+        copied.
+
+     @param classLabel: the class label of the samples
+     @return returns the samples of the class
+   */
+  TimeSeriesClassificationDataView getClassData(const uint32 classLabel) const;
+
+  /**
+     Copies the samples of the view into a dataset.
+
+     @param data: returns the copy of the samples
+     @return returns true if the samples were copied
+   */
+  bool copyTo(TimeSeriesClassificationData& data) const;
+
+  uint32 getNumDimensions() const {
+    return numDimensions;
+  }
+
+  uint32 getNumSamples() const {
+    return (uint32)indices.size();
+  }
+
+  uint32 getNumClasses() const {
+    return (uint32)classTracker.size();
+  }
+
+  const Vector<ClassTracker>& getClassTracker() const {
+    return classTracker;
+  }
+
+  /**
+     Gets the index of each sample of the view in the dataset.
+
+     @return returns the sample indices
+   */
+  const Vector<uint32>& getSampleIndices() const {
+    return indices;
+  }
+
+protected:
+
+  const TimeSeriesClassificationSample *samples; ///< The samples of the dataset
+  uint32 numDimensions;
+  Vector<uint32> indices;            ///< The samples of this view
+  Vector<ClassTracker> classTracker; ///< The number of samples in each class
+};
+}
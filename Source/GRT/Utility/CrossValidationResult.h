@@ -0,0 +1,60 @@
+﻿#pragma once
+
+#include "../GRT.h"
+#include "EvaluationResult.h"
+
+namespace GRT {
+/**
+   @brief The CrossValidationResult class holds the results of a k-fold cross
+      validation, see Classifier::crossValidate.
+
+   The metrics of each class are the mean over the folds that have samples of
+      that class (as the true or the predicted class), and the variances are
+      the sample variances over the same folds.  The confusion matrix is the
+      sum of the confusion matrices of all the folds.
+ */
+class CrossValidationResult {
+public:
+
+  CrossValidationResult() {
+    clear();
+  }
+
+  ~CrossValidationResult() {}
+
+  /**
+     Resets the results to a cross validation of no folds.
+   */
+  void clear() {
+    numFolds         = 0;
+    cancelled        = false;
+    accuracy         = 0;
+    accuracyVariance = 0;
+    foldResults.clear();
+    classLabels.clear();
+    confusionMatrix.clear();
+    precision.clear();
+    precisionVariance.clear();
+    recall.clear();
+    recallVariance.clear();
+    f1.clear();
+    f1Variance.clear();
+  }
+
+  uint32 numFolds;                      ///< The number of folds
+  bool   cancelled;                     ///< True if the cross validation was
+                                        // cancelled before it finished
+  float  accuracy;                      ///< The mean accuracy of the folds
+  float  accuracyVariance;              ///< The variance of the accuracy
+  Vector<EvaluationResult> foldResults; ///< The evaluation of each fold
+  Vector<uint32> classLabels;           ///< The class label of each row and
+                                        // column
+  MatrixFloat    confusionMatrix;       ///< The confusion matrix of all folds
+  VectorFloat    precision;             ///< The mean precision of each class
+  VectorFloat    precisionVariance;     ///< The variance of the precision
+  VectorFloat    recall;                ///< The mean recall of each class
+  VectorFloat    recallVariance;        ///< The variance of the recall
+  VectorFloat    f1;                    ///< The mean F1 score of each class
+  VectorFloat    f1Variance;            ///< The variance of the F1 score
+};
+}
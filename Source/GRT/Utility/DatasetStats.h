@@ -0,0 +1,34 @@
+﻿#pragma once
+
+#include "../GRT.h"
+#include "../Types/VectorFloat.h"
+#include "MinMax.h"
+
+namespace GRT {
+/**
+   @brief The DatasetStats class holds the summary statistics of a time series
+      dataset, see TimeSeriesClassificationData::getStats.
+ */
+class DatasetStats {
+public:
+
+  DatasetStats() {
+    numSamples = 0;
+    numRows    = 0;
+    minLength  = 0;
+    maxLength  = 0;
+  }
+
+  ~DatasetStats() {}
+
+  uint32 numSamples;             ///< The number of samples
+  uint64 numRows;                ///< The total number of rows of all samples
+  uint32 minLength;              ///< The length of the shortest sample
+  uint32 maxLength;              ///< The length of the longest sample
+  Vector<MinMax> ranges;         ///< The range of each dimension
+  VectorFloat    mean;           ///< The mean of each dimension, over all rows
+  VectorFloat    variance;       ///< The sample variance of each dimension
+  Vector<uint32> lengthHistogram; ///< The number of samples of each length,
+                                 // indexed by length
+};
+}
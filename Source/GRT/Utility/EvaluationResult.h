@@ -0,0 +1,62 @@
+﻿#pragma once
+
+#include "../GRT.h"
+#include "../Types/VectorFloat.h"
+#include "../Types/MatrixFloat.h"
+
+namespace GRT {
+/**
+   @brief The EvaluationResult class holds the results of evaluating a
+      classifier on a test dataset, see Classifier::evaluate.
+
+   The rows of the confusion matrix are the true class labels and the columns
+      are the predicted class labels, both in the order of classLabels.  The
+      precision, recall and F1 score of each class are in the same order.
+      The latencies are the time each prediction took, in milliseconds.
+ */
+class EvaluationResult {
+public:
+
+  EvaluationResult() {
+    clear();
+  }
+
+  ~EvaluationResult() {}
+
+  /**
+     Resets the results to an evaluation of no samples.
+   */
+  void clear() {
+    numSamples    = 0;
+    numCorrect    = 0;
+    accuracy      = 0;
+    meanLatency   = 0;
+    minLatency    = 0;
+    maxLatency    = 0;
+    medianLatency = 0;
+    latency95     = 0;
+    latency99     = 0;
+    classLabels.clear();
+    confusionMatrix.clear();
+    precision.clear();
+    recall.clear();
+    f1.clear();
+  }
+
+  uint32 numSamples;           ///< The number of test samples
+  uint32 numCorrect;           ///< The number of correct predictions
+  float  accuracy;             ///< The ratio of correct predictions, [0 1]
+  float  meanLatency;          ///< The mean prediction time
+  float  minLatency;           ///< The fastest prediction time
+  float  maxLatency;           ///< The slowest prediction time
+  float  medianLatency;        ///< The median prediction time
+  float  latency95;            ///< The 95th percentile of the prediction time
+  float  latency99;            ///< The 99th percentile of the prediction time
+  Vector<uint32> classLabels;  ///< The class label of each row and column
+  MatrixFloat confusionMatrix; ///< The number of samples of each true and
+                               // predicted class label
+  VectorFloat precision;       ///< The precision of each class
+  VectorFloat recall;          ///< The recall of each class
+  VectorFloat f1;              ///< The F1 score of each class
+};
+}
@@ -0,0 +1,141 @@
+﻿#include "../GRT.h"
+#include "MappedFile.h"
+#include <fstream>
+
+#if PLATFORM_WINDOWS
+# include "Windows/AllowWindowsPlatformTypes.h"
+# include <windows.h>
+# include "Windows/HideWindowsPlatformTypes.h"
+#elif PLATFORM_LINUX || PLATFORM_MAC || PLATFORM_ANDROID || PLATFORM_IOS
+# define GRT_POSIX_MAPPED_FILE 1
+# include <sys/mman.h>
+# include <sys/stat.h>
+# include <fcntl.h>
+# include <unistd.h>
+#endif // if PLATFORM_WINDOWS
+
+namespace GRT {
+MappedFile::MappedFile() {
+  data       = NULL;
+  size       = 0;
+  mapped     = false;
+  fileHandle = NULL;
+  mapHandle  = NULL;
+}
+
+MappedFile::~MappedFile() {
+  close();
+}
+
+bool MappedFile::open(const FString& filename) {
+  close();
+
+#if PLATFORM_WINDOWS
+  HANDLE file = CreateFileW(*filename, GENERIC_READ, FILE_SHARE_READ, NULL,
+                            OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+
+  if (file == INVALID_HANDLE_VALUE) return false;
+
+  LARGE_INTEGER fileSize;
+
+  if (!GetFileSizeEx(file, &fileSize) || (fileSize.QuadPart == 0)) {
+    CloseHandle(file);
+    return false;
+  }
+
+  HANDLE mapping = CreateFileMappingW(file, NULL, PAGE_READONLY, 0, 0, NULL);
+
+  if (mapping == NULL) {
+    CloseHandle(file);
+    return false;
+  }
+
+  const void *view = MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+
+  if (view == NULL) {
+    CloseHandle(mapping);
+    CloseHandle(file);
+    return false;
+  }
+
+  fileHandle = file;
+  mapHandle  = mapping;
+  data       = (const char *)view;
+  size       = (uint64)fileSize.QuadPart;
+  mapped     = true;
+  return true;
+
+#elif GRT_POSIX_MAPPED_FILE
+  const int file = ::open(TCHAR_TO_UTF8(*filename), O_RDONLY);
+
+  if (file < 0) return false;
+
+  struct stat fileStat;
+
+  if ((fstat(file, &fileStat) != 0) || (fileStat.st_size == 0)) {
+    ::close(file);
+    return false;
+  }
+
+  void *view = mmap(NULL, (size_t)fileStat.st_size, PROT_READ, MAP_PRIVATE,
+                    file, 0);
+
+  if (view == MAP_FAILED) {
+    ::close(file);
+    return false;
+  }
+
+  fileHandle = (void *)(intptr_t)file;
+  data       = (const char *)view;
+  size       = (uint64)fileStat.st_size;
+  mapped     = true;
+  return true;
+
+#else // if PLATFORM_WINDOWS
+
+  // Memory mapping is not supported, so read the whole file into the buffer
+  std::fstream file;
+  file.open(TCHAR_TO_UTF8(*filename), std::ios::in | std::ios::binary);
+
+  if (!file.is_open()) return false;
+
+  file.seekg(0, std::ios::end);
+  const std::streamoff fileSize = file.tellg();
+  file.seekg(0, std::ios::beg);
+
+  if (fileSize <= 0) return false;
+
+  buffer.resize((size_t)fileSize);
+
+  if (!file.read(&buffer[0], fileSize)) {
+    buffer.clear();
+    return false;
+  }
+
+  data   = &buffer[0];
+  size   = (uint64)fileSize;
+  mapped = false;
+  return true;
+#endif // if PLATFORM_WINDOWS
+}
+
+void MappedFile::close() {
+  if (mapped) {
+#if PLATFORM_WINDOWS
+    UnmapViewOfFile(data);
+    CloseHandle((HANDLE)mapHandle);
+    CloseHandle((HANDLE)fileHandle);
+#elif GRT_POSIX_MAPPED_FILE
+    munmap((void *)data, (size_t)size);
+    ::close((int)(intptr_t)fileHandle);
+#endif // if PLATFORM_WINDOWS
+  }
+
+  buffer.clear();
+  data       = NULL;
+  size       = 0;
+  mapped     = false;
+  fileHandle = NULL;
+  mapHandle  = NULL;
+}
+}
@@ -0,0 +1,95 @@
+﻿#pragma once
+
+#include "../GRT.h"
+#include "../Types/Vector.h"
+
+namespace GRT {
+/**
+   @brief The MappedFile class maps a file into memory as read only, so its
+      contents can be used in place without parsing or copying them.
+
+   On Windows, Linux, Mac, Android and iOS the file is memory mapped, which
+      means pages are only read from disk when they are first touched.  On any
+      other platform the whole file is read into a buffer owned by the
+      MappedFile, so the same code works everywhere.  The data returned by
+      getData stays valid until the file is closed or the MappedFile is
+      destroyed.
+ */
+class GRT_API MappedFile {
+public:
+
+  /**
+     Default Constructor
+   */
+  MappedFile();
+
+  /**
+     Default Destructor, closes the file if it is open
+   */
+  ~MappedFile();
+
+  /**
+     Opens and maps the file, closing any file that was previously open.
+
+     @param filename: the name of the file to open
+     @return returns true if the file was opened, false otherwise
+   */
+  bool open(const FString& filename);
+
+  /**
+     Unmaps and closes the file.
+   */
+  void close();
+
+  /**
+     Returns true if a file is open.
+
+     @return returns true if a file is open, false otherwise
+   */
+  bool getIsOpen() const {
+    return data != NULL;
+  }
+
+  /**
+     Returns true if the file is memory mapped, false if it was read into a
+        buffer.
+
+     @return returns true if the file is memory mapped
+   */
+  bool getIsMapped() const {
+    return mapped;
+  }
+
+  /**
+     Gets a pointer to the start of the file.
+
+     @return returns a pointer to the contents of the file, or NULL if no file
+        is open
+   */
+  const char * getData() const {
+    return data;
+  }
+
+  /**
+     Gets the size of the file in bytes.
+
+     @return returns the size of the file
+   */
+  uint64 getSize() const {
+    return size;
+  }
+
+private:
+
+  // A mapping can not be shared, so the class can not be copied
+  MappedFile(const MappedFile& rhs);
+  MappedFile& operator=(const MappedFile& rhs);
+
+  const char *data;   ///< The start of the mapped file
+  uint64 size;        ///< The size of the file in bytes
+  bool   mapped;      ///< True if data points to a memory mapping
+  void  *fileHandle;  ///< The platform file handle
+  void  *mapHandle;   ///< The platform mapping handle
+  Vector<char> buffer; ///< The contents of the file if it could not be mapped
+};
+}
@@ -0,0 +1,284 @@
+﻿#pragma once
+
+#include "../GRT.h"
+#include <cmath>
+
+namespace GRT {
+/**
+   @brief The MotionSegment class holds a period of motion found by a
+      MotionEnergyGate.
+ */
+class MotionSegment {
+public:
+
+  MotionSegment() {
+    startIndex    = 0;
+    endIndex      = 0;
+    peakEnergy    = 0;
+    classLabel    = 0;
+    maxLikelihood = 0;
+  }
+
+  ~MotionSegment() {}
+
+  /**
+     Gets the number of input samples in the segment.
+
+     @return returns the length of the segment
+   */
+  uint64 getLength() const {
+    return endIndex + 1 - startIndex;
+  }
+
+  uint64 startIndex;   ///< The input sample the motion started at
+  uint64 endIndex;     ///< The last input sample with motion
+  float  peakEnergy;   ///< The largest smoothed energy of the segment
+  uint32 classLabel;   ///< The class the owner of the gate predicted for the
+                       // segment, 0 if it predicted none
+  float  maxLikelihood; ///< The likelihood of that prediction
+};
+
+/**
+   @brief The MotionEnergyGate class follows the motion energy of a stream of
+      N-dimensional samples, and splits the stream into idle periods and
+      segments of motion.  It is used to skip the work of a recognizer while
+      the input is still.
+
+   The energy of a sample is the mean absolute difference from the previous
+      sample over the dimensions, as computed by
+      TimeSeriesClassificationSampleTrimmer, smoothed by an exponential moving
+      average.  A segment starts when the energy rises above startThreshold,
+      and ends once it has stayed below stopThreshold for more than stopDelay
+      samples, so the gate stays open for a short while after the motion.
+      Each update is O(numDimensions).
+
+   A segment that reaches maxSegmentLength is split: it is ended, and a new
+      one is started at the next sample without closing the gate.  A segment
+      shorter than minSegmentLength is discarded rather than ended.
+ */
+class MotionEnergyGate {
+public:
+
+  enum GateEvents { NO_EVENT = 0, SEGMENT_STARTED, SEGMENT_ENDED,
+                    SEGMENT_DISCARDED, SEGMENT_SPLIT };
+
+  /**
+     Default Constructor
+   */
+  MotionEnergyGate() {
+    numDimensions    = 0;
+    startThreshold   = 0;
+    stopThreshold    = 0;
+    smoothingWeight  = 1;
+    stopDelay        = 0;
+    minSegmentLength = 0;
+    maxSegmentLength = 0;
+    reset();
+  }
+
+  /**
+     Default Destructor.
+   */
+  ~MotionEnergyGate() {}
+
+  /**
+     Sets up the gate and resets it.
+
+     @param newNumDimensions: the number of dimensions of each sample, this
+        can be changed later with resize
+     @param startThreshold: the energy above which a segment starts
+     @param stopThreshold: the energy below which a segment can end, this
+        should not be greater than startThreshold
+     @param energyWindow: the time constant in samples of the moving average
+        of the energy, 1 uses the energy of each sample as it is
+     @param stopDelay: the number of samples the gate stays open after the
+        energy has fallen below stopThreshold
+     @param minSegmentLength: segments shorter than this are discarded
+     @param maxSegmentLength: if greater than zero, segments are split at
+        this length
+     @return returns true if the gate was set up, false otherwise
+   */
+  bool setup(const uint32 newNumDimensions,
+             const float  startThreshold,
+             const float  stopThreshold,
+             const uint32 energyWindow,
+             const uint32 stopDelay,
+             const uint32 minSegmentLength,
+             const uint32 maxSegmentLength) {
+    if ((energyWindow == 0) ||
+        !(startThreshold > 0) || (stopThreshold < 0) ||
+        (stopThreshold > startThreshold) ||
+        ((maxSegmentLength > 0) && (maxSegmentLength < minSegmentLength))) {
+      return false;
+    }
+
+    this->startThreshold   = startThreshold;
+    this->stopThreshold    = stopThreshold;
+    this->smoothingWeight  = 1.0f / energyWindow;
+    this->stopDelay        = stopDelay;
+    this->minSegmentLength = minSegmentLength;
+    this->maxSegmentLength = maxSegmentLength;
+    return resize(newNumDimensions);
+  }
+
+  /**
+     Resizes the gate to the number of dimensions and resets it, keeping the
+        other settings.
+
+     @param newNumDimensions: the number of dimensions of each sample
+     @return returns true if the gate was resized, false otherwise
+   */
+  bool resize(const uint32 newNumDimensions) {
+    numDimensions = newNumDimensions;
+    previousSample.resize(numDimensions);
+    reset();
+    return true;
+  }
+
+  /**
+     Resets the energy and closes the gate, keeping the settings.
+   */
+  void reset() {
+    energy            = 0;
+    numQuietSamples   = 0;
+    hasPreviousSample = false;
+    active            = false;
+    segment           = MotionSegment();
+    endedSegment      = MotionSegment();
+  }
+
+  /**
+     Adds a sample to the gate.
+
+     @param sample: a pointer to numDimensions values
+     @param sampleIndex: the index of the sample in the input stream
+     @return returns one of the GateEvents enums, SEGMENT_ENDED and
+        SEGMENT_DISCARDED are returned at the sample that closes the segment,
+        which is stopDelay + 1 samples after its endIndex.  SEGMENT_SPLIT is
+        returned at the last sample of a segment that reached
+        maxSegmentLength, the segment has ended and the next sample is the
+        start of a new one, for which no SEGMENT_STARTED is returned
+   */
+  GateEvents update(const float *sample, const uint64 sampleIndex) {
+    float sampleEnergy = 0;
+
+    if (numDimensions == 0) return NO_EVENT;
+
+    if (hasPreviousSample) {
+      for (uint32 j = 0; j < numDimensions; j++) {
+        sampleEnergy += fabs(sample[j] - previousSample[j]);
+      }
+      sampleEnergy /= numDimensions;
+    }
+
+    for (uint32 j = 0; j < numDimensions; j++) previousSample[j] = sample[j];
+    hasPreviousSample = true;
+    energy           += smoothingWeight * (sampleEnergy - energy);
+
+    if (!active) {
+      if (energy <= startThreshold) return NO_EVENT;
+
+      startSegment(sampleIndex);
+      return SEGMENT_STARTED;
+    }
+
+    if (energy > segment.peakEnergy) segment.peakEnergy = energy;
+
+    if (energy < stopThreshold) numQuietSamples++;
+    else {
+      numQuietSamples  = 0;
+      segment.endIndex = sampleIndex;
+    }
+
+    // Split a long segment, the next sample starts a new one with the gate
+    // still open
+    if ((maxSegmentLength > 0) &&
+        (sampleIndex + 1 - segment.startIndex >= maxSegmentLength) &&
+        (numQuietSamples == 0)) {
+      endedSegment = segment;
+      startSegment(sampleIndex + 1);
+      return SEGMENT_SPLIT;
+    }
+
+    if (numQuietSamples <= stopDelay) return NO_EVENT;
+
+    active       = false;
+    endedSegment = segment;
+    return endedSegment.getLength() >= minSegmentLength ? SEGMENT_ENDED :
+           SEGMENT_DISCARDED;
+  }
+
+  /**
+     Returns true while a segment is open.
+
+     @return returns true if the input is moving, false if it is idle
+   */
+  bool getActive() const {
+    return active;
+  }
+
+  /**
+     Gets the smoothed energy of the newest sample.
+
+     @return returns the energy
+   */
+  float getEnergy() const {
+    return energy;
+  }
+
+  /**
+     Gets the segment that is open, its endIndex is the newest sample with
+        motion.
+
+     @return returns the open segment
+   */
+  const MotionSegment& getSegment() const {
+    return segment;
+  }
+
+  /**
+     Gets the segment that was last ended or discarded.
+
+     @return returns the last closed segment
+   */
+  const MotionSegment& getEndedSegment() const {
+    return endedSegment;
+  }
+
+  /**
+     Gets the number of dimensions.
+
+     @return returns the number of dimensions
+   */
+  uint32 getNumDimensions() const {
+    return numDimensions;
+  }
+
+protected:
+
+  void startSegment(const uint64 sampleIndex) {
+    active             = true;
+    numQuietSamples    = 0;
+    segment            = MotionSegment();
+    segment.startIndex = sampleIndex;
+    segment.endIndex   = sampleIndex;
+    segment.peakEnergy = energy;
+  }
+
+  uint32 numDimensions;
+  float  startThreshold;     ///< The energy that starts a segment
+  float  stopThreshold;      ///< The energy under which a segment can end
+  float  smoothingWeight;    ///< The weight of the newest sample's energy
+  uint32 stopDelay;          ///< The quiet samples needed to end a segment
+  uint32 minSegmentLength;   ///< Shorter segments are discarded
+  uint32 maxSegmentLength;   ///< Longer segments are split, 0 for no limit
+  Vector<float> previousSample; ///< The last sample added to the gate
+  float  energy;             ///< The smoothed energy of the newest sample
+  uint32 numQuietSamples;    ///< The samples since the energy was last above
+                             // stopThreshold
+  bool   hasPreviousSample;  ///< Set once a sample has been added
+  bool   active;             ///< Set while a segment is open
+  MotionSegment segment;     ///< The open segment
+  MotionSegment endedSegment; ///< The last segment that was closed
+};
+}
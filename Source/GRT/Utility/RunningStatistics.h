@@ -0,0 +1,219 @@
+﻿#pragma once
+
+#include "../GRT.h"
+#include "../Types/MatrixView.h"
+
+namespace GRT {
+/**
+   @brief The RunningStatistics class keeps the per dimension mean and
+      variance of a sliding window of N-dimensional samples.  Samples are added
+      with push and removed with pop, each in O(numDimensions), so the
+      statistics of a streaming window never have to be recomputed from
+      scratch.
+
+   The sums are accumulated in double precision relative to a per dimension
+      shift (the shifted data algorithm), which avoids the catastrophic
+      cancellation of a naive sum of squares.  Rounding errors still build up
+      as samples are added and removed, so the owner should call recompute
+      with the current window every so often (for example once per window
+      length, see getNumUpdates), which also moves the shift to the current
+      mean.
+ */
+class RunningStatistics {
+public:
+
+  /**
+     Default Constructor
+   */
+  RunningStatistics() {
+    numDimensions = 0;
+    count         = 0;
+    numUpdates    = 0;
+  }
+
+  /**
+     Default Destructor.
+   */
+  ~RunningStatistics() {}
+
+  /**
+     Resizes the statistics to the number of dimensions and resets them.
+
+     @param newNumDimensions: the number of dimensions of each sample
+     @return returns true if the statistics were resized, false otherwise
+   */
+  bool resize(const uint32 newNumDimensions) {
+    numDimensions = newNumDimensions;
+    shift.resize(numDimensions);
+    sum.resize(numDimensions);
+    sumSquares.resize(numDimensions);
+    reset();
+    return numDimensions > 0;
+  }
+
+  /**
+     Removes all the samples, keeping the number of dimensions.
+   */
+  void reset() {
+    count      = 0;
+    numUpdates = 0;
+
+    for (uint32 j = 0; j < numDimensions; j++) {
+      shift[j]      = 0;
+      sum[j]        = 0;
+      sumSquares[j] = 0;
+    }
+  }
+
+  /**
+     Clears the statistics, setting the number of dimensions to 0.
+   */
+  void clear() {
+    numDimensions = 0;
+    count         = 0;
+    numUpdates    = 0;
+    shift.clear();
+    sum.clear();
+    sumSquares.clear();
+  }
+
+  /**
+     Adds a sample to the statistics.
+
+     @param sample: a pointer to numDimensions values
+   */
+  void push(const float *sample) {
+    for (uint32 j = 0; j < numDimensions; j++) {
+      const double x = sample[j] - shift[j];
+      sum[j]        += x;
+      sumSquares[j] += x * x;
+    }
+    count++;
+    numUpdates++;
+  }
+
+  /**
+     Removes a sample that was previously added to the statistics.
+
+     @param sample: a pointer to numDimensions values
+   */
+  void pop(const float *sample) {
+    if (count == 0) return;
+
+    for (uint32 j = 0; j < numDimensions; j++) {
+      const double x = sample[j] - shift[j];
+      sum[j]        -= x;
+      sumSquares[j] -= x * x;
+    }
+    count--;
+    numUpdates++;
+  }
+
+  /**
+     Recomputes the statistics from scratch using all the rows in the window,
+        and recenters the sums on the mean of the window.
+
+     @param window: the samples the statistics should describe
+     @return returns true if the statistics were recomputed, false otherwise
+   */
+  bool recompute(const MatrixView& window) {
+    if (window.getNumCols() != numDimensions) return false;
+
+    const uint32 M = window.getNumRows();
+
+    // Compute the new shift (the mean of the window)
+    for (uint32 j = 0; j < numDimensions; j++) shift[j] = 0;
+
+    for (uint32 i = 0; i < M; i++) {
+      const float *row = window[i];
+
+      for (uint32 j = 0; j < numDimensions; j++) shift[j] += row[j];
+    }
+
+    for (uint32 j = 0; j < numDimensions; j++) {
+      shift[j]     /= M > 0 ? M : 1;
+      sum[j]        = 0;
+      sumSquares[j] = 0;
+    }
+
+    count      = 0;
+    numUpdates = 0;
+
+    for (uint32 i = 0; i < M; i++) push(window[i]);
+
+    numUpdates = 0;
+    return true;
+  }
+
+  /**
+     Gets the mean of the dimension j.
+
+     @param j: the dimension, should be in the range [0 numDimensions-1]
+     @return returns the mean, or 0 if there are no samples
+   */
+  inline double getMean(const uint32 j) const {
+    return count > 0 ? shift[j] + sum[j] / count : 0;
+  }
+
+  /**
+     Gets the sample variance (normalized by count - 1) of the dimension j.
+
+     @param j: the dimension, should be in the range [0 numDimensions-1]
+     @return returns the variance, or 0 if there are less than 2 samples
+   */
+  inline double getVariance(const uint32 j) const {
+    if (count < 2) return 0;
+
+    const double variance = (sumSquares[j] - (sum[j] * sum[j]) / count) /
+                            (count - 1.0);
+    return variance > 0 ? variance : 0;
+  }
+
+  /**
+     Gets the sample standard deviation of the dimension j.
+
+     @param j: the dimension, should be in the range [0 numDimensions-1]
+     @return returns the standard deviation
+   */
+  inline double getStdDev(const uint32 j) const {
+    return sqrt(getVariance(j));
+  }
+
+  /**
+     Gets the number of samples described by the statistics.
+
+     @return returns the number of samples
+   */
+  uint32 getCount() const {
+    return count;
+  }
+
+  /**
+     Gets the number of push and pop calls since the statistics were last
+        reset or recomputed.
+
+     @return returns the number of updates
+   */
+  uint32 getNumUpdates() const {
+    return numUpdates;
+  }
+
+  /**
+     Gets the number of dimensions.
+
+     @return returns the number of dimensions
+   */
+  uint32 getNumDimensions() const {
+    return numDimensions;
+  }
+
+protected:
+
+  uint32 numDimensions;
+  uint32 count;             ///< The number of samples in the statistics
+  uint32 numUpdates;        ///< The number of updates since the last recompute
+  Vector<double> shift;     ///< The value subtracted from each sample
+  Vector<double> sum;       ///< The sum of the shifted samples
+  Vector<double> sumSquares; ///< The sum of the squared shifted samples
+};
+}
@@ -0,0 +1,97 @@
+﻿#pragma once
+
+#include "../GRT.h"
+#include <atomic>
+#include <memory>
+
+namespace GRT {
+/**
+   @brief The SharedCopyOnWrite class holds a value that is shared by all the
+      copies of the holder, and is only copied when one of them changes it.
+      It is used for large training data that copies made for prediction or
+      evaluation only read, if ever.
+
+   Reading through a holder while another thread copies it is safe, like
+      copying a std::shared_ptr, but the holder itself must not be changed by
+      one thread while another thread reads it.
+ */
+template<class T>
+class SharedCopyOnWrite {
+public:
+
+  /**
+     Default Constructor, holds a default constructed value.
+   */
+  SharedCopyOnWrite() : data(std::make_shared<T>()) {}
+
+  /**
+     Default Destructor.
+   */
+  ~SharedCopyOnWrite() {}
+
+  /**
+     Gets the value for reading.
+
+     @return returns a const reference to the value
+   */
+  const T& get() const {
+    return *data;
+  }
+
+  const T& operator*() const {
+    return *data;
+  }
+
+  const T * operator->() const {
+    return data.get();
+  }
+
+  /**
+     Gets the value for changing it, first copying it if it is shared with
+        another holder.
+
+     @return returns a reference to the value, which is only held by this
+        holder
+   */
+  T& edit() {
+    if (data.use_count() > 1) data = std::make_shared<T>(*data);
+
+    // The other holders may have read the value just before releasing it
+    std::atomic_thread_fence(std::memory_order_acquire);
+    return *data;
+  }
+
+  /**
+     Replaces the value with a default constructed one without copying the
+        old value, which the other holders keep.
+
+     @return returns a reference to the new value
+   */
+  T& reset() {
+    data = std::make_shared<T>();
+    return *data;
+  }
+
+  /**
+     Replaces the value with a copy of the given value.
+
+     @param value: the value to copy
+   */
+  void set(const T& value) {
+    data = std::make_shared<T>(value);
+  }
+
+  /**
+     Returns true if the value is shared with another holder.
+
+     @return returns true if changing the value would copy it
+   */
+  bool isShared() const {
+    return data.use_count() > 1;
+  }
+
+protected:
+
+  std::shared_ptr<T> data; ///< The value, never NULL
+};
+}
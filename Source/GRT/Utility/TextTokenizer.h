@@ -0,0 +1,306 @@
+﻿#pragma once
+
+#include "../GRT.h"
+#include <string>
+#include <cfloat>
+
+namespace GRT {
+/**
+   @brief The TextTokenizer class splits a block of text into whitespace
+      separated words and parses numbers from them, without copying the text.
+
+   It reads the same words as std::istream >> std::string, so it can replace
+      the stream based parsing of the GRT text file formats.  Floats with up
+      to 15 significant digits are converted with a single exactly rounded
+      double operation, any other number (or a result that could round
+      differently) falls back to strtof, so the result always matches
+      reading the value with std::istream >> float.
+ */
+class TextTokenizer {
+public:
+
+  /**
+     Constructor, the text must stay valid while the tokenizer is used.
+
+     @param begin: the start of the text
+     @param end: one past the end of the text
+   */
+  TextTokenizer(const char *begin = NULL, const char *end = NULL) {
+    this->begin    = begin;
+    this->end      = end;
+    this->position = begin;
+  }
+
+  /**
+     Default Destructor.
+   */
+  ~TextTokenizer() {}
+
+  /**
+     Reads the next word.
+
+     @param word: returns the start of the word
+     @param length: returns the length of the word
+     @return returns true if a word was read, false if the end of the text was
+        reached
+   */
+  bool nextWord(const char *& word, uint32& length) {
+    skipWhitespace();
+
+    if (position == end) return false;
+
+    word = position;
+
+    while ((position != end) && !isWhitespace(*position)) position++;
+
+    length = (uint32)(position - word);
+    return true;
+  }
+
+  /**
+     Reads the next word and compares it with the expected word.
+
+     @param expected: the expected word
+     @return returns true if the next word matches, false otherwise
+   */
+  bool matchWord(const char *expected) {
+    const char *word;
+    uint32 length;
+
+    if (!nextWord(word, length)) return false;
+
+    return (strlen(expected) == length) &&
+           (memcmp(word, expected, length) == 0);
+  }
+
+  /**
+     Reads the next word as an unsigned integer.
+
+     @param value: returns the value
+     @return returns true if the word is a valid unsigned integer
+   */
+  bool parseUint(uint32& value) {
+    const char *word;
+    uint32 length;
+
+    if (!nextWord(word, length)) return false;
+
+    const char *p = word;
+    const char *wordEnd = word + length;
+
+    if (*p == '+') p++;
+
+    if (p == wordEnd) return false;
+
+    uint64 result = 0;
+
+    for (; p != wordEnd; p++) {
+      if ((*p < '0') || (*p > '9')) return false;
+
+      result = result * 10 + (uint32)(*p - '0');
+
+      if (result > 0xFFFFFFFFull) return false;
+    }
+    value = (uint32)result;
+    return true;
+  }
+
+  /**
+     Reads the next word as a float.
+
+     @param value: returns the value
+     @return returns true if the word is a valid float
+   */
+  bool parseFloat(float& value) {
+    const char *word;
+    uint32 length;
+
+    if (!nextWord(word, length)) return false;
+
+    return parseFloat(word, length, value);
+  }
+
+  /**
+     Parses a float from a word.
+
+     @param word: the start of the word
+     @param length: the length of the word
+     @param value: returns the value
+     @return returns true if the word is a valid float
+   */
+  static bool parseFloat(const char *word, const uint32 length, float& value) {
+    // Powers of ten that are exactly representable as a double
+    static const double powersOfTen[] = {
+      1e0,  1e1,  1e2,  1e3,  1e4,  1e5,  1e6,  1e7,  1e8,  1e9,  1e10, 1e11,
+      1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22
+    };
+
+    const char *p       = word;
+    const char *wordEnd = word + length;
+    bool   negative     = false;
+    bool   anyDigits    = false;
+    uint64 mantissa     = 0;
+    uint32 numDigits    = 0;
+    int32  exponent     = 0;
+
+    if ((p != wordEnd) && ((*p == '+') || (*p == '-'))) {
+      negative = *p == '-';
+      p++;
+    }
+
+    for (; (p != wordEnd) && (*p >= '0') && (*p <= '9'); p++) {
+      mantissa  = mantissa * 10 + (uint32)(*p - '0');
+      anyDigits = true;
+
+      if ((mantissa > 0) && (++numDigits > 15)) {
+        return parseFloatSlow(word, length, value);
+      }
+    }
+
+    if ((p != wordEnd) && (*p == '.')) {
+      for (p++; (p != wordEnd) && (*p >= '0') && (*p <= '9'); p++) {
+        mantissa  = mantissa * 10 + (uint32)(*p - '0');
+        anyDigits = true;
+        exponent--;
+
+        if ((mantissa > 0) && (++numDigits > 15)) {
+          return parseFloatSlow(word, length, value);
+        }
+      }
+    }
+
+    if (!anyDigits) return false;
+
+    if ((p != wordEnd) && ((*p == 'e') || (*p == 'E'))) {
+      p++;
+      bool negativeExponent = false;
+
+      if ((p != wordEnd) && ((*p == '+') || (*p == '-'))) {
+        negativeExponent = *p == '-';
+        p++;
+      }
+
+      if ((p == wordEnd) || (*p < '0') || (*p > '9')) return false;
+
+      int32 e = 0;
+
+      for (; (p != wordEnd) && (*p >= '0') && (*p <= '9'); p++) {
+        if (e < 100000) e = e * 10 + (*p - '0');
+      }
+      exponent += negativeExponent ? -e : e;
+    }
+
+    if (p != wordEnd) return false;
+
+    if (mantissa == 0) {
+      value = negative ? -0.0f : 0.0f;
+      return true;
+    }
+
+    // The mantissa and the power of ten are both exact, so a single double
+    // multiply or divide gives the correctly rounded double.  Rounding that to
+    // a float gives the correctly rounded float, unless the double landed
+    // exactly half way between two floats (or outside the normal float range)
+    if ((mantissa <= (1ull << 53)) && (exponent >= -22) && (exponent <= 22)) {
+      const double m = (double)mantissa;
+      const double d = exponent < 0 ? m / powersOfTen[-exponent] :
+                       m * powersOfTen[exponent];
+      uint64 bits;
+      memcpy(&bits, &d, sizeof(bits));
+
+      if (((bits & 0x1FFFFFFFull) != 0x10000000ull) && (d >= FLT_MIN) &&
+          (d <= FLT_MAX)) {
+        const float f = (float)d;
+        value = negative ? -f : f;
+        return true;
+      }
+    }
+
+    return parseFloatSlow(word, length, value);
+  }
+
+  /**
+     Skips any whitespace at the current position.
+   */
+  void skipWhitespace() {
+    while ((position != end) && isWhitespace(*position)) position++;
+  }
+
+  /**
+     Gets the current position in the text.
+
+     @return returns a pointer to the next character that will be read
+   */
+  const char * getPosition() const {
+    return position;
+  }
+
+  /**
+     Moves the current position, which should be inside the text.
+
+     @param newPosition: the next character that will be read
+   */
+  void setPosition(const char *newPosition) {
+    position = newPosition;
+  }
+
+  /**
+     Returns true if there are no more words in the text.
+
+     @return returns true if the end of the text was reached
+   */
+  bool getIsAtEnd() {
+    skipWhitespace();
+    return position == end;
+  }
+
+  /**
+     Finds the next occurrence of a whole word, starting at the current
+        position, without moving the current position.
+
+     @param word: the word to find
+     @return returns a pointer to the start of the word, or NULL if it was not
+        found
+   */
+  const char * findWord(const char *word) const {
+    const uint32 length = (uint32)strlen(word);
+    const char  *p      = position;
+
+    while ((uint64)(end - p) >= length) {
+      p = (const char *)memchr(p, word[0], (end - p) - length + 1);
+
+      if (p == NULL) return NULL;
+
+      if ((memcmp(p, word, length) == 0) &&
+          ((p == begin) || isWhitespace(p[-1])) &&
+          ((p + length == end) || isWhitespace(p[length]))) {
+        return p;
+      }
+      p++;
+    }
+    return NULL;
+  }
+
+  static inline bool isWhitespace(const char c) {
+    // ' ', '\t', '\n', '\v', '\f' and '\r', all other characters are above
+    // ' ' or are not whitespace
+    return ((unsigned char)c <= ' ') &&
+           ((c == ' ') || ((c >= '\t') && (c <= '\r')));
+  }
+
+protected:
+
+  static bool parseFloatSlow(const char *word, const uint32 length,
+                             float& value) {
+    const std::string text(word, length);
+    char *parseEnd = NULL;
+
+    value = strtof(text.c_str(), &parseEnd);
+    return parseEnd == text.c_str() + length;
+  }
+
+  const char *begin;    ///< The start of the text
+  const char *end;      ///< One past the end of the text
+  const char *position; ///< The next character that will be read
+};
+}
@@ -0,0 +1,327 @@
+﻿#include "ThreadPool.h"
+#include <algorithm>
+#include <chrono>
+
+#if GRT_USE_ENGINE_TASK_GRAPH
+# include "Async/ParallelFor.h"
+# include "Async/TaskGraphInterfaces.h"
+#endif // GRT_USE_ENGINE_TASK_GRAPH
+
+namespace GRT {
+// The index of the worker running on this thread, or -1 for other threads
+static thread_local int32 currentWorkerIndex = -1;
+
+// The pool the worker running on this thread belongs to
+static thread_local ThreadPool *currentWorkerPool = NULL;
+
+TaskGroup::TaskGroup(ThreadPool *pool) {
+  this->pool = pool ? pool : &ThreadPool::getInstance();
+  numPending = 0;
+  cancelled  = false;
+}
+
+TaskGroup::~TaskGroup() {
+  wait();
+}
+
+void TaskGroup::run(std::function<void()> task) {
+  numPending++;
+
+  ThreadPool::Task poolTask;
+  poolTask.function = std::move(task);
+  poolTask.group    = this;
+  pool->submit(std::move(poolTask));
+}
+
+bool TaskGroup::wait() {
+  while (numPending > 0) {
+    // Help with the queued tasks rather than blocking a thread of the pool.
+    // On the task graph only the tasks of this group are taken, so a nested
+    // wait can't stall and the caller is never handed a long task of another
+    // group
+    if (pool->useEngineTaskGraph ? pool->runEngineTask(this) :
+        pool->runNextTask()) continue;
+
+    std::unique_lock<std::mutex> lock(finishedMutex);
+    finishedCondition.wait_for(lock, std::chrono::milliseconds(1), [this] {
+      return numPending == 0;
+    });
+  }
+
+  // The last task may still hold the lock, so the group can not be destroyed
+  // until it is released
+  std::lock_guard<std::mutex> lock(finishedMutex);
+  return !cancelled;
+}
+
+void TaskGroup::cancel() {
+  cancelled = true;
+}
+
+void TaskGroup::finishTask() {
+  std::lock_guard<std::mutex> lock(finishedMutex);
+
+  if (--numPending == 0) finishedCondition.notify_all();
+}
+
+ThreadPool::ThreadPool(const uint32 numThreads) {
+  useEngineTaskGraph = GRT_USE_ENGINE_TASK_GRAPH != 0;
+  workersStarted     = false;
+  stopping           = false;
+  numQueuedTasks     = 0;
+  nextQueue          = 0;
+  this->numThreads   = 0;
+  setNumThreads(numThreads);
+}
+
+ThreadPool::~ThreadPool() {
+  stopWorkers();
+}
+
+ThreadPool& ThreadPool::getInstance() {
+  static ThreadPool pool;
+
+  return pool;
+}
+
+bool ThreadPool::setNumThreads(const uint32 numThreads) {
+  stopWorkers();
+
+  if (numThreads > 0) this->numThreads = numThreads;
+  else {
+    const uint32 numHardwareThreads = std::thread::hardware_concurrency();
+    this->numThreads = numHardwareThreads > 1 ? numHardwareThreads - 1 : 0;
+  }
+  return true;
+}
+
+bool ThreadPool::setUseEngineTaskGraph(const bool useEngineTaskGraph) {
+#if GRT_USE_ENGINE_TASK_GRAPH
+  this->useEngineTaskGraph = useEngineTaskGraph;
+  return true;
+
+#else // if GRT_USE_ENGINE_TASK_GRAPH
+
+  if (useEngineTaskGraph) {
+    UE_LOG(GRTModule, Error,
+           TEXT(
+             "setUseEngineTaskGraph(...) - The engine task graph is not available in this build!"));
+    return false;
+  }
+  return true;
+#endif // if GRT_USE_ENGINE_TASK_GRAPH
+}
+
+bool ThreadPool::parallelFor(const uint32                       num,
+                             const std::function<void(uint32)>& body,
+                             const uint32                       grainSize,
+                             const bool                         useMultipleThreads,
+                             TaskGroup                         *group) {
+  const bool   useTaskGraph = useEngineTaskGraph;
+  const uint32 numWorkers   = useTaskGraph ?
+                              std::max(std::thread::hardware_concurrency(),
+                                       1u) :
+                              numThreads + 1;
+  const uint32 grain = grainSize > 0 ? grainSize :
+                       std::max(num / (4 * numWorkers), 1u);
+  const uint32 numChunks = num > 0 ? (num - 1) / grain + 1 : 0;
+
+  // Runs one chunk, unless the group has been cancelled
+  auto runChunk = [&](const uint32 chunk) {
+    if (group && group->isCancelled()) return;
+
+    const uint32 begin = chunk * grain;
+    const uint32 end   = std::min(begin + grain, num);
+
+    for (uint32 i = begin; i < end; i++) body(i);
+  };
+
+  if (!useMultipleThreads || (numChunks <= 1) ||
+      (!useTaskGraph && (numThreads == 0))) {
+    for (uint32 chunk = 0; chunk < numChunks; chunk++) runChunk(chunk);
+    return !(group && group->isCancelled());
+  }
+
+#if GRT_USE_ENGINE_TASK_GRAPH
+
+  if (useTaskGraph) {
+    ParallelFor(numChunks, [&](int32 chunk) {
+      runChunk(chunk);
+    });
+    return !(group && group->isCancelled());
+  }
+#endif // GRT_USE_ENGINE_TASK_GRAPH
+
+  // The helpers and this thread take chunks until there are none left, so
+  // a helper that starts late just returns
+  std::atomic<uint32> nextChunk(0);
+  auto runChunks = [&]() {
+    uint32 chunk;
+
+    while ((chunk = nextChunk++) < numChunks) runChunk(chunk);
+  };
+
+  TaskGroup helpers(this);
+  const uint32 numHelpers = std::min(numThreads, numChunks - 1);
+
+  for (uint32 i = 0; i < numHelpers; i++) helpers.run(runChunks);
+
+  runChunks();
+  helpers.wait();
+  return !(group && group->isCancelled());
+}
+
+void ThreadPool::submit(Task task) {
+#if GRT_USE_ENGINE_TASK_GRAPH
+
+  if (useEngineTaskGraph) {
+    // The task is queued where a waiting thread can claim it, and each graph
+    // task runs the oldest task that has not been claimed yet.  Group tasks
+    // can be long (training, loading), so they are run on the background
+    // threads rather than the foreground workers that frame tasks need
+    {
+      std::lock_guard<std::mutex> lock(engineMutex);
+      engineTasks.push_back(std::move(task));
+    }
+    FFunctionGraphTask::CreateAndDispatchWhenReady([this]() {
+      runEngineTask(NULL);
+    }, TStatId(), nullptr, ENamedThreads::AnyBackgroundThreadNormalTask);
+    return;
+  }
+#endif // GRT_USE_ENGINE_TASK_GRAPH
+
+  // Without any workers the task is run straight away
+  if (numThreads == 0) {
+    runTask(task);
+    return;
+  }
+
+  startWorkers();
+
+  // A worker adds to its own queue, other threads share the tasks out.  The
+  // count is raised first so it is never lower than the number of tasks
+  const uint32 queueIndex = (currentWorkerPool == this) ?
+                            (uint32)currentWorkerIndex :
+                            nextQueue++ % numThreads;
+  numQueuedTasks++;
+  {
+    std::lock_guard<std::mutex> lock(queues[queueIndex]->mutex);
+    queues[queueIndex]->tasks.push_back(std::move(task));
+  }
+
+  std::lock_guard<std::mutex> lock(sleepMutex);
+  sleepCondition.notify_one();
+}
+
+bool ThreadPool::runNextTask() {
+  if ((numQueuedTasks == 0) || !workersStarted) return false;
+
+  const bool   isWorker = currentWorkerPool == this;
+  const uint32 first    = isWorker ? (uint32)currentWorkerIndex : 0;
+  Task task;
+
+  // Take the newest task of our own queue, then steal the oldest task of the
+  // other queues
+  for (uint32 i = 0; i < numThreads; i++) {
+    WorkerQueue& queue = *queues[(first + i) % numThreads];
+    std::lock_guard<std::mutex> lock(queue.mutex);
+
+    if (queue.tasks.empty()) continue;
+
+    if (isWorker && (i == 0)) {
+      task = std::move(queue.tasks.back());
+      queue.tasks.pop_back();
+    }
+    else {
+      task = std::move(queue.tasks.front());
+      queue.tasks.pop_front();
+    }
+    numQueuedTasks--;
+    break;
+  }
+
+  if (!task.function) return false;
+
+  runTask(task);
+  return true;
+}
+
+bool ThreadPool::runEngineTask(TaskGroup *group) {
+  Task task;
+
+  {
+    std::lock_guard<std::mutex> lock(engineMutex);
+
+    for (std::deque<Task>::iterator it = engineTasks.begin();
+         it != engineTasks.end(); ++it) {
+      if (group && (it->group != group)) continue;
+
+      task = std::move(*it);
+      engineTasks.erase(it);
+      break;
+    }
+  }
+
+  if (!task.function) return false;
+
+  runTask(task);
+  return true;
+}
+
+void ThreadPool::runTask(Task& task) {
+  if (!task.group->isCancelled()) task.function();
+  task.group->finishTask();
+}
+
+void ThreadPool::workerLoop(const uint32 workerIndex) {
+  currentWorkerIndex = workerIndex;
+  currentWorkerPool  = this;
+
+  while (!stopping) {
+    if (runNextTask()) continue;
+
+    std::unique_lock<std::mutex> lock(sleepMutex);
+    sleepCondition.wait(lock, [this] {
+      return stopping || (numQueuedTasks > 0);
+    });
+  }
+}
+
+void ThreadPool::startWorkers() {
+  if (workersStarted) return;
+
+  std::lock_guard<std::mutex> lock(workersMutex);
+
+  if (workersStarted) return;
+
+  stopping = false;
+  queues.clear();
+
+  for (uint32 i = 0; i < numThreads; i++) {
+    queues.push_back(std::unique_ptr<WorkerQueue>(new WorkerQueue()));
+  }
+
+  for (uint32 i = 0; i < numThreads; i++) {
+    workers.push_back(std::thread(&ThreadPool::workerLoop, this, i));
+  }
+  workersStarted = true;
+}
+
+void ThreadPool::stopWorkers() {
+  std::lock_guard<std::mutex> lock(workersMutex);
+
+  if (!workersStarted) return;
+
+  {
+    std::lock_guard<std::mutex> sleepLock(sleepMutex);
+    stopping = true;
+    sleepCondition.notify_all();
+  }
+
+  for (uint32 i = 0; i < workers.size(); i++) workers[i].join();
+
+  workers.clear();
+  queues.clear();
+  workersStarted = false;
+}
+}
@@ -0,0 +1,285 @@
+﻿#pragma once
+
+#include "../GRT.h"
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// Sets if the thread pool can hand its work to the Unreal task graph, a
+// standalone build should define this as 0 so the pool only uses its own
+// threads
+#ifndef GRT_USE_ENGINE_TASK_GRAPH
+# define GRT_USE_ENGINE_TASK_GRAPH 1
+#endif // GRT_USE_ENGINE_TASK_GRAPH
+
+namespace GRT {
+class ThreadPool;
+
+/**
+   @brief The TaskGroup class runs a group of tasks on a ThreadPool, and waits
+      for them or cancels them together.
+
+   Cancelling a group stops the tasks that have not started yet from running,
+      the tasks that are already running can poll isCancelled to stop early.
+      The destructor waits for all the tasks of the group.
+ */
+class GRT_API TaskGroup {
+public:
+
+  /**
+     Default Constructor
+
+     @param pool: the pool the tasks are run on, by default the shared pool
+   */
+  TaskGroup(ThreadPool *pool = NULL);
+
+  /**
+     Default Destructor, waits for all the tasks of the group
+   */
+  ~TaskGroup();
+
+  /**
+     Adds a task to the group, it is run on one of the threads of the pool.
+
+     @param task: the task to run
+   */
+  void run(std::function<void()> task);
+
+  /**
+     Waits for all the tasks of the group.  The calling thread runs queued
+        tasks of the pool while it waits, so a task can wait for a group of
+        its own.
+
+     @return returns true if all the tasks were run, false if the group was
+        cancelled
+   */
+  bool wait();
+
+  /**
+     Cancels the tasks of the group that have not started yet.
+   */
+  void cancel();
+
+  /**
+     Returns true if the group has been cancelled.
+
+     @return returns true if the group has been cancelled, false otherwise
+   */
+  bool isCancelled() const {
+    return cancelled;
+  }
+
+protected:
+
+  friend class ThreadPool;
+
+  void finishTask();
+
+  ThreadPool *pool;                  // The pool the tasks are run on
+  std::atomic<uint32> numPending;    // The number of tasks still to finish
+  std::atomic<bool>   cancelled;     // Set by cancel
+  std::mutex finishedMutex;          // Guards finishedCondition
+  std::condition_variable finishedCondition; // Notified when numPending
+                                             // reaches zero
+};
+
+/**
+   @brief The ThreadPool class runs the parallel work of GRT (training, batch
+      prediction, cross validation and so on) on one set of threads.
+
+   By default the work is handed to the Unreal task graph, parallelFor maps
+      onto the engine's ParallelFor and the tasks of a TaskGroup run on the
+      engine's background threads, so long jobs such as Classifier::trainAsync
+      don't hold up the foreground workers that the frame needs.  A thread
+      waiting for a group runs the group's tasks that have not started yet
+      itself.  If setUseEngineTaskGraph(false) is
+      called, or GRT_USE_ENGINE_TASK_GRAPH is 0, the pool runs its own worker
+      threads instead.  Each worker has its own queue of tasks: a worker runs
+      the newest task of its own queue first, and when its queue is empty it
+      steals the oldest task of another worker.
+
+   parallelFor splits a range into chunks of grainSize indexs.  Rather than
+      queuing every chunk, one helper task is queued for each worker and the
+      helpers and the calling thread take the next chunk from a shared counter
+      until the range is done, so the cost of scheduling is paid once per
+      worker and not once per chunk.
+
+   parallelReduce splits a range into chunks that only depend on the size of
+      the range and the grain size, and combines the result of each chunk in
+      order, so the result is the same whatever the number of threads.
+ */
+class GRT_API ThreadPool {
+public:
+
+  /**
+     Default Constructor
+
+     @param numThreads: the number of worker threads, 0 uses one less than
+        the number of hardware threads (the calling thread also does work)
+   */
+  ThreadPool(const uint32 numThreads = 0);
+
+  /**
+     Default Destructor, stops the worker threads
+   */
+  ~ThreadPool();
+
+  /**
+     Gets the pool shared by all of GRT.
+
+     @return returns the shared pool
+   */
+  static ThreadPool& getInstance();
+
+  /**
+     Sets the number of worker threads.  This should not be called while the
+        pool is running tasks.
+
+     @param numThreads: the number of worker threads, 0 uses one less than
+        the number of hardware threads
+     @return returns true if the number of threads was set
+   */
+  bool setNumThreads(const uint32 numThreads);
+
+  /**
+     Gets the number of worker threads of the pool.
+
+     @return returns the number of worker threads
+   */
+  uint32 getNumThreads() const {
+    return numThreads;
+  }
+
+  /**
+     Sets if the work should be handed to the Unreal task graph, or run on the
+        pool's own threads.  This should not be called while the pool is
+        running tasks.
+
+     @param useEngineTaskGraph: if true the engine's task graph is used
+     @return returns true if the setting was updated, false if the engine task
+        graph is not available in this build
+   */
+  bool setUseEngineTaskGraph(const bool useEngineTaskGraph);
+
+  /**
+     Gets if the work is handed to the Unreal task graph.
+
+     @return returns true if the engine's task graph is used
+   */
+  bool getUseEngineTaskGraph() const {
+    return useEngineTaskGraph;
+  }
+
+  /**
+     Runs body for each index in [0 num), in parallel.
+
+     @param num: the number of indexs
+     @param body: the function run for each index
+     @param grainSize: the number of indexs run by a thread at a time, 0
+        chooses one from the number of indexs and threads
+     @param useMultipleThreads: if false the indexs are run in order on the
+        calling thread
+     @param group: if not NULL, the chunks that have not started when the
+        group is cancelled are skipped
+     @return returns true if all the indexs were run, false if the group was
+        cancelled
+   */
+  bool parallelFor(const uint32                       num,
+                   const std::function<void(uint32)>& body,
+                   const uint32                       grainSize = 0,
+                   const bool                         useMultipleThreads = true,
+                   TaskGroup                         *group = NULL);
+
+  /**
+     Maps each chunk of [0 num) to a value in parallel, and combines the
+        values of the chunks in order.
+
+     @param num: the number of indexs
+     @param identity: the value of an empty range
+     @param map: returns the value of the indexs [begin end)
+     @param combine: combines two values, the value of the lower indexs is the
+        first argument
+     @param grainSize: the number of indexs in each chunk, 0 splits the range
+        into at most 256 chunks
+     @param useMultipleThreads: if false the chunks are run on the calling
+        thread
+     @return returns the combined value of all the chunks
+   */
+  template<class T, class MapFunction, class CombineFunction>
+  T parallelReduce(const uint32      num,
+                   const T         & identity,
+                   MapFunction       map,
+                   CombineFunction   combine,
+                   const uint32      grainSize = 0,
+                   const bool        useMultipleThreads = true) {
+    const uint32 grain = grainSize > 0 ? grainSize :
+                         (num + MAX_NUM_REDUCE_CHUNKS - 1) /
+                         MAX_NUM_REDUCE_CHUNKS;
+
+    if (num == 0) return identity;
+
+    const uint32 numChunks = (num + grain - 1) / grain;
+    std::vector<T> values(numChunks, identity);
+
+    parallelFor(numChunks, [&](uint32 chunk) {
+      const uint32 begin = chunk * grain;
+      const uint32 end   = begin + grain < num ? begin + grain : num;
+      values[chunk] = map(begin, end);
+    }, 1, useMultipleThreads);
+
+    T value = identity;
+
+    for (uint32 chunk = 0; chunk < numChunks; chunk++) {
+      value = combine(value, values[chunk]);
+    }
+    return value;
+  }
+
+protected:
+
+  friend class TaskGroup;
+
+  struct Task {
+    std::function<void()> function;
+    TaskGroup            *group;
+  };
+
+  struct WorkerQueue {
+    std::mutex       mutex;
+    std::deque<Task> tasks;
+  };
+
+  void submit(Task task);
+  bool runNextTask();
+  bool runEngineTask(TaskGroup *group);
+  void runTask(Task& task);
+  void workerLoop(const uint32 workerIndex);
+  void startWorkers();
+  void stopWorkers();
+
+  static const uint32 MAX_NUM_REDUCE_CHUNKS = 256;
+
+  uint32 numThreads;                // The number of worker threads
+  std::atomic<bool> useEngineTaskGraph; // A flag to check if the work is
+                                        // handed to the Unreal task graph,
+                                        // it is read by the worker threads
+  std::vector<std::unique_ptr<WorkerQueue> > queues; // The queue of each
+                                                     // worker
+  std::vector<std::thread> workers; // The worker threads, started on first use
+  std::mutex workersMutex;          // Guards starting the workers
+  std::atomic<bool>   workersStarted;
+  std::atomic<bool>   stopping;     // Set to stop the workers
+  std::atomic<uint32> numQueuedTasks; // The number of tasks in all the queues
+  std::atomic<uint32> nextQueue;    // The queue of the next external task
+  std::mutex sleepMutex;            // Guards sleepCondition
+  std::condition_variable sleepCondition; // Wakes idle workers
+  std::mutex engineMutex;           // Guards engineTasks
+  std::deque<Task> engineTasks;     // The tasks handed to the task graph that
+                                    // no thread has claimed yet
+};
+}
@@ -0,0 +1,274 @@
+﻿#pragma once
+
+#include "../GRT.h"
+#include "../Types/VectorFloat.h"
+#include "../Types/MatrixView.h"
+
+namespace GRT {
+/**
+   @brief The TimeSeriesCircularBuffer class is a circular buffer of
+      N-dimensional float samples that can always return its contents as a
+      single contiguous MatrixView, ordered from the oldest to the newest
+      sample.
+
+   Unlike a CircularBuffer< VectorFloat >, which stores each sample in its own
+      vector, the samples are stored in one block of memory.  Each sample is
+      written twice, at position writePtr and writePtr + bufferSize, so the
+      window starting at the read pointer is always contiguous.  This costs one
+      extra row copy per push_back, but lets the window be handed to the DTW
+      without copying it into a new matrix.
+ */
+class TimeSeriesCircularBuffer {
+public:
+
+  /**
+     Default Constructor
+   */
+  TimeSeriesCircularBuffer() {
+    bufferSize        = 0;
+    numDimensions     = 0;
+    numValuesInBuffer = 0;
+    readPtr           = 0;
+    writePtr          = 0;
+    bufferInit        = false;
+  }
+
+  /**
+     Init Constructor. Resizes the buffer to hold bufferSize samples with
+        numDimensions dimensions.
+
+     @param bufferSize: sets the number of samples in the buffer
+     @param numDimensions: sets the number of dimensions of each sample
+   */
+  TimeSeriesCircularBuffer(const uint32 bufferSize, const uint32 numDimensions) {
+    bufferInit = false;
+    resize(bufferSize, numDimensions);
+  }
+
+  /**
+     Default Destructor.
+   */
+  ~TimeSeriesCircularBuffer() {}
+
+  /**
+     This is the main access operator and will return a pointer to the sample
+        at index, relative to the current read pointer.
+
+     @param index: the index of the sample you want access to, should be in the
+        range [0 bufferSize-1]
+     @return returns a const pointer to the sample at the index
+   */
+  inline const float * operator[](const uint32 index) const {
+    return &buffer[(size_t)(readPtr + index) * numDimensions];
+  }
+
+  /**
+     Resizes the buffer, which must be greater than zero, and sets all the
+        values to the default value.
+
+     @param newBufferSize: the new number of samples in the buffer
+     @param newNumDimensions: the number of dimensions of each sample
+     @param defaultValue: the default value that will be copied to every element
+     @return returns true if the buffer was resized
+   */
+  bool resize(const uint32 newBufferSize,
+              const uint32 newNumDimensions,
+              const float  defaultValue = 0) {
+    // Cleanup the old memory
+    clear();
+
+    if ((newBufferSize == 0) || (newNumDimensions == 0)) return false;
+
+    bufferSize    = newBufferSize;
+    numDimensions = newNumDimensions;
+    buffer.resize(2 * bufferSize * numDimensions, defaultValue);
+    numValuesInBuffer = 0;
+    readPtr           = 0;
+    writePtr          = 0;
+
+    // Flag that the buffer has been initialized
+    bufferInit = true;
+
+    return true;
+  }
+
+  /**
+     Push a new sample into the end of the buffer, this will move both the read
+        and write pointers.
+
+     @param sample: a pointer to numDimensions values
+     @return returns true if the sample was pushed, false otherwise
+   */
+  bool push_back(const float *sample) {
+    if (!bufferInit) {
+      UE_LOG(GRTModule, Error,
+             TEXT(
+               "Can't push_back sample to time series circular buffer as the buffer has not been initialized!"));
+      return false;
+    }
+
+    // Write the sample into both halves of the buffer
+    float *a = &buffer[(size_t)writePtr * numDimensions];
+    float *b = &buffer[(size_t)(writePtr + bufferSize) * numDimensions];
+
+    for (uint32 j = 0; j < numDimensions; j++) {
+      a[j] = sample[j];
+      b[j] = sample[j];
+    }
+
+    // Update the write pointer
+    writePtr++;
+    writePtr = writePtr % bufferSize;
+
+    // Check if the buffer is full
+    if (++numValuesInBuffer > bufferSize) {
+      numValuesInBuffer = bufferSize;
+
+      // Only update the read pointer if the buffer has been filled
+      readPtr++;
+      readPtr = readPtr % bufferSize;
+    }
+
+    return true;
+  }
+
+  /**
+     Push a new sample into the end of the buffer. The size of the sample must
+        match the number of dimensions of the buffer.
+
+     @param sample: the sample that should be added to the end of the buffer
+     @return returns true if the sample was pushed, false otherwise
+   */
+  bool push_back(const VectorFloat& sample) {
+    if (sample.getSize() != numDimensions) return false;
+
+    return push_back(&sample[0]);
+  }
+
+  /**
+     Resets the numValuesInBuffer, read and write pointers to 0.
+
+     @return returns true if the buffer was reset, false otherwise
+   */
+  bool reset() {
+    numValuesInBuffer = 0;
+    readPtr           = 0;
+    writePtr          = 0;
+    return true;
+  }
+
+  /**
+     Clears the buffer, setting the size to 0.
+   */
+  void clear() {
+    numValuesInBuffer = 0;
+    readPtr           = 0;
+    writePtr          = 0;
+    bufferSize        = 0;
+    numDimensions     = 0;
+    buffer.clear();
+    bufferInit = false;
+  }
+
+  /**
+     Gets a view of the samples currently in the buffer, in order from the
+        oldest to the newest.  The view is invalidated by the next push_back,
+        resize or clear.
+
+     @return returns a MatrixView of size [numValuesInBuffer numDimensions]
+   */
+  MatrixView getView() const {
+    if (!bufferInit || (numValuesInBuffer == 0)) return MatrixView();
+
+    return MatrixView((*this)[0], numValuesInBuffer, numDimensions);
+  }
+
+  /**
+     Gets a view of the most recent numSamples samples in the buffer, in order
+        from the oldest to the newest.
+
+     @param numSamples: the length of the window, must not exceed the number
+        of values in the buffer
+     @return returns a MatrixView of size [numSamples numDimensions], or an
+        empty view if the window is invalid
+   */
+  MatrixView getWindow(const uint32 numSamples) const {
+    if (!bufferInit || (numSamples > numValuesInBuffer)) return MatrixView();
+
+    return getView().getRows(numValuesInBuffer - numSamples, numSamples);
+  }
+
+  /**
+     Gets a copy of the data in the buffer, in order from the oldest to the
+        newest sample.
+
+     @return returns a Vector of VectorFloat with the data in the buffer
+   */
+  Vector<VectorFloat>getData() const {
+    Vector<VectorFloat> data(getNumValuesInBuffer());
+
+    for (uint32 i = 0; i < data.getSize(); i++) {
+      data[i].resize(numDimensions);
+
+      for (uint32 j = 0; j < numDimensions; j++) data[i][j] = (*this)[i][j];
+    }
+    return data;
+  }
+
+  /**
+     Returns true if the buffer has been initialized.
+
+     @return returns true if the buffer has been initialized, false otherwise
+   */
+  bool getInit() const {
+    return bufferInit;
+  }
+
+  /**
+     Returns true if the buffer has been filled. If the buffer has not been
+        initialized then this function will always return false.
+
+     @return returns true if the buffer has been filled, false otherwise
+   */
+  bool getBufferFilled() const {
+    return bufferInit ? numValuesInBuffer == bufferSize : false;
+  }
+
+  /**
+     Returns the number of samples the buffer can hold.
+
+     @return returns the size of the buffer
+   */
+  uint32 getSize() const {
+    return bufferInit ? bufferSize : 0;
+  }
+
+  /**
+     Returns the number of dimensions of each sample.
+
+     @return returns the number of dimensions
+   */
+  uint32 getNumDimensions() const {
+    return bufferInit ? numDimensions : 0;
+  }
+
+  /**
+     Returns the number of samples in the buffer.
+
+     @return returns the number of samples in the buffer
+   */
+  uint32 getNumValuesInBuffer() const {
+    return bufferInit ? numValuesInBuffer : 0;
+  }
+
+protected:
+
+  bool   bufferInit;
+  uint32 bufferSize;
+  uint32 numDimensions;
+  uint32 numValuesInBuffer;
+  uint32 readPtr;
+  uint32 writePtr;
+  Vector<float> buffer;
+};
+}
@@ -13,20 +13,37 @@ TimeSeriesClassificationSampleTrimmer::~TimeSeriesClassificationSampleTrimmer()
 
 bool TimeSeriesClassificationSampleTrimmer::trimTimeSeries(
   TimeSeriesClassificationSample& timeSeries) {
-  const uint32 M = timeSeries.getLength();
-  const uint32 N = timeSeries.getNumDimensions();
+  uint32 firstRow = 0;
+  uint32 numRows  = 0;
+
+  if (!findTrimRange(timeSeries.getData(), firstRow, numRows)) return false;
+
+  MatrixFloat newTimeSeries;
+  MatrixView(timeSeries.getData()).getRows(firstRow,
+                                           numRows).copyTo(newTimeSeries);
+
+  timeSeries.setTrainingSample(timeSeries.getClassLabel(), newTimeSeries);
+  return true;
+}
+
+bool TimeSeriesClassificationSampleTrimmer::findTrimRange(
+  const MatrixView& timeSeries,
+  uint32          & firstRow,
+  uint32          & numRows) const {
+  const uint32 M = timeSeries.getNumRows();
+  const uint32 N = timeSeries.getNumCols();
 
   if (M == 0) {
     UE_LOG(GRTModule, Warning,
            TEXT(
-             "trimTimeSeries(TimeSeriesClassificationSample &timeSeries) - can't trim data, the length of the input time series is 0!"));
+             "findTrimRange(MatrixView timeSeries) - can't trim data, the length of the input time series is 0!"));
     return false;
   }
 
   if (N == 0) {
     UE_LOG(GRTModule, Warning,
            TEXT(
-             "trimTimeSeries(TimeSeriesClassificationSample &timeSeries) - can't trim data, the number of dimensions in the input time series is 0!"));
+             "findTrimRange(MatrixView timeSeries) - can't trim data, the number of dimensions in the input time series is 0!"));
     return false;
   }
 
@@ -93,17 +110,8 @@ bool TimeSeriesClassificationSampleTrimmer::trimTimeSeries(
   float  trimPercentage = (float(newM) / float(M)) * 100.0;
 
   if (100 - trimPercentage <= maximumTrimPercentage) {
-    MatrixFloat newTimeSeries(newM, N);
-    uint32 index = 0;
-
-    for (uint32 i = firstIndex; i < lastIndex; i++) {
-      for (uint32 j = 0; j < N; j++) {
-        newTimeSeries[index][j] = timeSeries[i][j];
-      }
-      index++;
-    }
-
-    timeSeries.setTrainingSample(timeSeries.getClassLabel(), newTimeSeries);
+    firstRow = firstIndex;
+    numRows  = newM;
     return true;
   }
 
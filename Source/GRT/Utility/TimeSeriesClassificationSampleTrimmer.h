@@ -57,6 +57,19 @@ public:
    */
   bool trimTimeSeries(TimeSeriesClassificationSample& timeSeries);
 
+  /**
+     Finds the rows trimTimeSeries would keep, without copying them, so a
+        trimmed view of the time series can be taken with MatrixView::getRows.
+
+     @param timeSeries: the timeseries to be trimmed
+     @param firstRow: returns the first row that would be kept
+     @param numRows: returns the number of rows that would be kept
+     @return returns true if the timeseries can be trimmed, false otherwise
+   */
+  bool findTrimRange(const MatrixView& timeSeries,
+                     uint32          & firstRow,
+                     uint32          & numRows) const;
+
 protected:
 
   float trimThreshold;
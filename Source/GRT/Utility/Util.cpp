@@ -290,6 +290,16 @@ unsigned int Util::getMax(const std::vector<unsigned int>& x) {
   return max;
 }
 
+uint64 Util::hash(const void *data, const uint64 size, const uint64 hash) {
+  const uint8 *bytes = (const uint8 *)data;
+  uint64 result      = hash;
+
+  for (uint64 i = 0; i < size; i++) {
+    result = (result ^ bytes[i]) * 1099511628211ULL;
+  }
+  return result;
+}
+
 void Util::cartToPolar(const float x, const float y, float& r, float& theta) {
 #ifndef PI
   float PI = 3.14159265358979323846;
@@ -342,5 +342,18 @@ public:
                           const float theta,
                           float     & x,
                           float     & y);
+
+  /**
+     Adds a block of bytes to a 64 bit FNV-1a hash.  Hashes of several blocks
+        are built by passing the result of each call to the next one.
+
+     @param data: a pointer to the bytes to hash
+     @param size: the number of bytes to hash
+     @param hash: the hash of any previous blocks
+     @return returns the updated hash
+   */
+  static uint64 hash(const void  *data,
+                     const uint64 size,
+                     const uint64 hash = 14695981039346656037ULL);
 };
 }
@@ -9,7 +9,9 @@ USampleGRTComponent::USampleGRTComponent()
 	// off to improve performance if you don't need them.
 	PrimaryComponentTick.bCanEverTick = true;
 
-	// ...
+	TrainingProgress = 0;
+	PredictedLabel = 0;
+	PredictionDelayFrames = 0;
 }
 
 
@@ -25,17 +27,43 @@ void USampleGRTComponent::BeginPlay()
 	Label = obejctName;
 	print(info);
 
-	// test
+	// Make the data and train the model in the background, so the game thread does not hitch
+	Recognizer = MakeUnique<GRT::StreamingRecognizer>(3);
+	GRT::DTW Settings;
+	TrainingProgress = 0;
+	TrainingTask = Settings.trainAsync(&USampleGRTComponent::GenerateTrainingData);
+}
+
+
+// Called when the game ends
+void USampleGRTComponent::EndPlay(const EEndPlayReason::Type EndPlayReason)
+{
+	// Cancelling stops the training at the next template, the task waits for it when it is released
+	if (TrainingTask.IsValid()) {
+		TrainingTask->cancel();
+		TrainingTask.Reset();
+	}
+	// Waits for the prediction job that is running, if any
+	Recognizer.Reset();
+
+	Super::EndPlay(EndPlayReason);
+}
+
+
+bool USampleGRTComponent::GenerateTrainingData(GRT::TimeSeriesClassificationData& Data)
+{
 	uint32 gestureLabel = 1;
 	GRT::MatrixFloat trainingSample;
 
+	Data.setNumDimensions(3);
+
 	//For now we will just add 10 x 20 random walk data timeseries
 	GRT::Random random;
 	for (uint32 k = 0; k < 10; k++) {//For the number of classes
 		gestureLabel = k + 1;
 
 		//Get the init random walk position for this gesture
-		GRT::VectorFloat startPos(ClassificationData.getNumDimensions());
+		GRT::VectorFloat startPos(Data.getNumDimensions());
 		for (uint32 j = 0; j < startPos.size(); j++) {
 			startPos[j] = random.getRandomNumberUniform(-1.0, 1.0);
 		}
@@ -59,9 +87,10 @@ void USampleGRTComponent::BeginPlay()
 			}
 
 			//Add the training sample to the dataset
-			ClassificationData.addSample(gestureLabel, trainingSample);
+			Data.addSample(gestureLabel, trainingSample);
 		}
 	}
+	return true;
 }
 
 
@@ -70,6 +99,33 @@ void USampleGRTComponent::TickComponent(float DeltaTime, ELevelTick TickType, FA
 {
 	Super::TickComponent(DeltaTime, TickType, ThisTickFunction);
 
-	// ...
-}
+	// Swap in the new model once the background training has finished, polling the task does not block
+	if (TrainingTask.IsValid()) {
+		TrainingProgress = TrainingTask->getProgress();
+
+		if (TrainingTask->isDone()) {
+			GRT::Classifier* trained = TrainingTask->releaseClassifier();
+			if (trained) {
+				Recognizer->setClassifier(trained);
+				print(FString::Printf(TEXT("%s: GRT model trained"), *Label));
+			}
+			else {
+				UE_LOG(LogTemp, Warning, TEXT("%s: GRT training failed"), *Label);
+			}
+			TrainingTask.Reset();
+		}
+	}
+
+	// Queue this frame's sample and read the prediction of an earlier frame, neither blocks on the prediction
+	if (Recognizer.IsValid()) {
+		const FVector Location = GetOwner()->GetActorLocation() / 100.0f;
+		const float Sample[3] = { Location.X, Location.Y, Location.Z };
+		Recognizer->pushSample(Sample, GFrameCounter, FPlatformTime::Seconds());
 
+		const GRT::RecognitionResult& Result = Recognizer->getLatestResult();
+		if (Result.numSamples > 0) {
+			PredictedLabel = Result.predictedClassLabel;
+			PredictionDelayFrames = int32(GFrameCounter - Result.frameNumber);
+		}
+	}
+}
@@ -20,16 +20,34 @@ protected:
 	// Called when the game starts
 	virtual void BeginPlay() override;
 
+	// Called when the game ends, cancels any training and waits for the recognizer to stop
+	virtual void EndPlay(const EEndPlayReason::Type EndPlayReason) override;
+
 public:	
 	// Called every frame
 	virtual void TickComponent(float DeltaTime, ELevelTick TickType, FActorComponentTickFunction* ThisTickFunction) override;
 
 private:
 
+	// Fills Data with random walk gestures, this is run off the game thread
+	static bool GenerateTrainingData(GRT::TimeSeriesClassificationData& Data);
+
 	// indicate if GRT is load properly
 	UPROPERTY(VisibleAnywhere)
 		FString GRTVersion;
 	UPROPERTY(VisibleAnywhere)
 		FString Label;
-	GRT::TimeSeriesClassificationData ClassificationData;
+	// The progress of the background training, from 0 to 1
+	UPROPERTY(VisibleAnywhere)
+		float TrainingProgress;
+	// The class predicted from the movement of the owner, 0 until there is a prediction
+	UPROPERTY(VisibleAnywhere)
+		int32 PredictedLabel;
+	// The number of frames between pushing a sample and reading its prediction
+	UPROPERTY(VisibleAnywhere)
+		int32 PredictionDelayFrames;
+	// Predicts the samples pushed each frame off the game thread, the new model is handed to it once a training finishes
+	TUniquePtr<GRT::StreamingRecognizer> Recognizer;
+	// The training running in the background, null if there is none
+	TSharedPtr<GRT::ClassifierTask, ESPMode::ThreadSafe> TrainingTask;
 };